@@ -0,0 +1,129 @@
+#include "adaptivemodel.h"
+
+#include <algorithm>
+
+// 1) AdaptiveModel Implementation
+AdaptiveModel::AdaptiveModel()
+    : totalCount(0)
+{
+    freq.fill(1);
+    rebuildTree();
+}
+
+void AdaptiveModel::symbolRange(int symbol, uint32_t &cumLow, uint32_t &cumHigh) const
+{
+    // Prefix sum of symbols [0, symbol)
+    uint32_t sum = 0;
+    for (int i = symbol; i > 0; i -= i & -i) {
+        sum += tree[i];
+    }
+    cumLow  = sum;
+    cumHigh = sum + freq[symbol];
+}
+
+int AdaptiveModel::findSymbol(uint32_t target, uint32_t &cumLow, uint32_t &cumHigh) const
+{
+    // Descend the Fenwick tree to the last prefix that does not exceed target
+    int position = 0;
+    uint32_t remaining = target;
+    for (int step = kTreeSize; step > 0; step >>= 1) {
+        const int next = position + step;
+        if (next <= kTreeSize && tree[next] <= remaining) {
+            position = next;
+            remaining -= tree[next];
+        }
+    }
+
+    cumLow  = target - remaining;
+    cumHigh = cumLow + freq[position];
+    return position;
+}
+
+void AdaptiveModel::update(int symbol)
+{
+    freq[symbol] += kIncrement;
+    totalCount   += kIncrement;
+    for (int i = symbol + 1; i <= kTreeSize; i += i & -i) {
+        tree[i] += kIncrement;
+    }
+
+    if (totalCount > kMaxTotal) {
+        // Halve the counts so recent statistics dominate
+        for (uint32_t &f : freq) {
+            f = (f + 1) >> 1;
+        }
+        rebuildTree();
+    }
+}
+
+void AdaptiveModel::weaken(int shift)
+{
+    for (uint32_t &f : freq) {
+        f = std::max<uint32_t>(1, f >> shift);
+    }
+    rebuildTree();
+}
+
+void AdaptiveModel::rebuildTree()
+{
+    tree.fill(0);
+    totalCount = 0;
+    for (int s = 0; s < kSymbolCount; ++s) {
+        tree[s + 1] = freq[s];
+        totalCount += freq[s];
+    }
+    for (int i = 1; i <= kTreeSize; ++i) {
+        const int parent = i + (i & -i);
+        if (parent <= kTreeSize) {
+            tree[parent] += tree[i];
+        }
+    }
+}
+
+// 2) ContextModel Implementation
+namespace {
+const int kOrder2HashBits = 12;
+}
+
+ContextModel::ContextModel(int order)
+    : order(order),
+    history(0)
+{
+    if (order <= 0) {
+        this->order = 0;
+        models.resize(1);
+    } else if (order == 1) {
+        models.resize(256);
+    } else {
+        this->order = 2;
+        models.resize(1u << kOrder2HashBits);
+    }
+}
+
+AdaptiveModel &ContextModel::current()
+{
+    uint32_t index = 0;
+    if (order == 1) {
+        index = history & 0xFF;
+    } else if (order == 2) {
+        index = ((history & 0xFFFF) * 2654435761u) >> (32 - kOrder2HashBits);
+    }
+
+    std::unique_ptr<AdaptiveModel> &model = models[index];
+    if (!model) {
+        model.reset(new AdaptiveModel);
+    }
+    return *model;
+}
+
+void ContextModel::push(uint8_t byte)
+{
+    history = (history << 8) | byte;
+}
+
+void ContextModel::weaken(int shift)
+{
+    for (std::unique_ptr<AdaptiveModel> &model : models) {
+        if (model) model->weaken(shift);
+    }
+}
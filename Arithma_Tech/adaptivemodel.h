@@ -0,0 +1,76 @@
+#ifndef ADAPTIVEMODEL_H
+#define ADAPTIVEMODEL_H
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief AdaptiveModel
+ *        Adaptive frequency model over the 256 byte values plus a dedicated
+ *        end-of-block symbol (requirement 1.1.3). Cumulative counts live in a
+ *        Fenwick tree so lookups and updates are O(log n).
+ */
+class AdaptiveModel
+{
+public:
+    static constexpr int kEofSymbol   = 256;
+    static constexpr int kSymbolCount = 257;
+
+    AdaptiveModel();
+
+    uint32_t total() const { return totalCount; }
+
+    // Interval of a symbol as [cumLow, cumHigh)
+    void symbolRange(int symbol, uint32_t &cumLow, uint32_t &cumHigh) const;
+
+    // Symbol whose interval contains target; also returns its interval
+    int findSymbol(uint32_t target, uint32_t &cumLow, uint32_t &cumHigh) const;
+
+    // Adapt to a coded symbol
+    void update(int symbol);
+
+    // Divide every count by 2^shift, keeping each symbol codable, so what
+    // was learned so far gives way sooner to what follows
+    void weaken(int shift);
+
+private:
+    static const int      kTreeSize  = 512;
+    static const uint32_t kIncrement = 32;
+    static const uint32_t kMaxTotal  = 1u << 16;
+
+    void rebuildTree();
+
+    std::array<uint32_t, kSymbolCount> freq;
+    std::array<uint32_t, kTreeSize + 1> tree;
+    uint32_t totalCount;
+};
+
+/**
+ * @brief ContextModel
+ *        A set of AdaptiveModels selected by the previous order bytes.
+ *        Order 0 and 1 are indexed directly; order 2 is hashed and the
+ *        models are allocated on first use.
+ */
+class ContextModel
+{
+public:
+    explicit ContextModel(int order);
+
+    // Model for the current context
+    AdaptiveModel &current();
+
+    // Shift a coded byte into the context
+    void push(uint8_t byte);
+
+    // AdaptiveModel::weaken() on every model used so far
+    void weaken(int shift);
+
+private:
+    int order;
+    uint32_t history;
+    std::vector<std::unique_ptr<AdaptiveModel>> models;
+};
+
+#endif // ADAPTIVEMODEL_H
@@ -0,0 +1,270 @@
+#include "arithma.h"
+
+#include "codecsession.h"
+#include "container.h"
+#include "typeregistry.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string>
+
+struct arithma_stream
+{
+    std::unique_ptr<CompressionSession>   compressor;
+    std::unique_ptr<DecompressionSession> decompressor;
+    bool        finished = false;
+    std::string error;
+};
+
+namespace {
+
+bool toCodecOptions(const arithma_options *options, CodecOptions &codec)
+{
+    arithma_options merged;
+    arithma_default_options(&merged);
+    if (options) {
+        // Older callers pass a shorter struct; keep defaults for the rest
+        if (options->struct_size < offsetof(arithma_options, level) + sizeof(int)) return false;
+        std::memcpy(&merged, options, std::min(options->struct_size, sizeof(merged)));
+    }
+
+    if (merged.level < CodecEngine::kMinLevel || merged.level > CodecEngine::kMaxLevel
+        || merged.threads < 0 || merged.block_size == 0
+        || merged.backend < ARITHMA_BACKEND_ARITHMETIC || merged.backend > ARITHMA_BACKEND_BINARY
+        || merged.file_type < ARITHMA_TYPE_BINARY || merged.file_type > ARITHMA_TYPE_GIF) {
+        return false;
+    }
+
+    codec.level     = merged.level;
+    codec.threads   = merged.threads;
+    codec.blockSize = merged.block_size;
+    codec.backend   = static_cast<Backend>(merged.backend);
+    codec.fileType  = static_cast<FileType>(merged.file_type);
+    return true;
+}
+
+ByteSink callbackSink(arithma_write_fn write, void *opaque)
+{
+    return [write, opaque](const uint8_t *data, size_t size) {
+        return write(opaque, data, size) == 0;
+    };
+}
+
+// Record a session failure on the stream and map it to a status code
+template <typename Session>
+int failWith(arithma_stream *stream, const Session &session)
+{
+    stream->error = session.errorString();
+    return session.outputFailed() ? ARITHMA_ERROR_OUTPUT : ARITHMA_ERROR_DATA;
+}
+
+}
+
+// 1) General
+unsigned arithma_version(void)
+{
+    return (ARITHMA_VERSION_MAJOR << 16) | ARITHMA_VERSION_MINOR;
+}
+
+const char *arithma_status_string(int status)
+{
+    switch (status) {
+    case ARITHMA_OK:             return "ok";
+    case ARITHMA_ERROR_ARGUMENT: return "invalid argument";
+    case ARITHMA_ERROR_DATA:     return "invalid or truncated compressed data";
+    case ARITHMA_ERROR_OUTPUT:   return "output could not be written";
+    case ARITHMA_ERROR_MEMORY:   return "out of memory";
+    }
+    return "unknown status";
+}
+
+void arithma_default_options(arithma_options *options)
+{
+    if (!options) return;
+    const CodecOptions defaults;
+    options->struct_size = sizeof(arithma_options);
+    options->level       = defaults.level;
+    options->threads     = defaults.threads;
+    options->block_size  = defaults.blockSize;
+    options->backend     = static_cast<int>(defaults.backend);
+    options->file_type   = static_cast<int>(defaults.fileType);
+}
+
+// 2) Streaming
+arithma_stream *arithma_compress_init(const arithma_options *options,
+                                      arithma_write_fn write, void *opaque)
+{
+    CodecOptions codec;
+    if (!write || !toCodecOptions(options, codec)) return nullptr;
+
+    try {
+        std::unique_ptr<arithma_stream> stream(new arithma_stream);
+        stream->compressor.reset(new CompressionSession(codec, callbackSink(write, opaque)));
+        return stream.release();
+    } catch (const std::bad_alloc &) {
+        return nullptr;
+    }
+}
+
+arithma_stream *arithma_decompress_init(int threads, arithma_write_fn write, void *opaque)
+{
+    if (!write || threads < 0) return nullptr;
+
+    try {
+        std::unique_ptr<arithma_stream> stream(new arithma_stream);
+        stream->decompressor.reset(new DecompressionSession(threads, callbackSink(write, opaque)));
+        return stream.release();
+    } catch (const std::bad_alloc &) {
+        return nullptr;
+    }
+}
+
+int arithma_update(arithma_stream *stream, const void *data, size_t size)
+{
+    if (!stream || stream->finished || (!data && size > 0)) return ARITHMA_ERROR_ARGUMENT;
+    if (size == 0) return ARITHMA_OK;
+
+    try {
+        const uint8_t *bytes = static_cast<const uint8_t *>(data);
+        if (stream->compressor) {
+            return stream->compressor->update(bytes, size)
+                       ? ARITHMA_OK : failWith(stream, *stream->compressor);
+        }
+        return stream->decompressor->update(bytes, size)
+                   ? ARITHMA_OK : failWith(stream, *stream->decompressor);
+    } catch (const std::bad_alloc &) {
+        stream->error = "Out of memory";
+        return ARITHMA_ERROR_MEMORY;
+    }
+}
+
+int arithma_finish(arithma_stream *stream)
+{
+    if (!stream || stream->finished) return ARITHMA_ERROR_ARGUMENT;
+    stream->finished = true;
+
+    try {
+        if (stream->compressor) {
+            return stream->compressor->finish() ? ARITHMA_OK : failWith(stream, *stream->compressor);
+        }
+        return stream->decompressor->finish() ? ARITHMA_OK : failWith(stream, *stream->decompressor);
+    } catch (const std::bad_alloc &) {
+        stream->error = "Out of memory";
+        return ARITHMA_ERROR_MEMORY;
+    }
+}
+
+int arithma_stream_stats(const arithma_stream *stream, arithma_stats *stats)
+{
+    if (!stream || !stats || stats->struct_size < sizeof(size_t)) return ARITHMA_ERROR_ARGUMENT;
+
+    const JobStats &job = stream->compressor ? stream->compressor->stats()
+                                             : stream->decompressor->stats();
+    arithma_stats result;
+    result.struct_size  = std::min(stats->struct_size, sizeof(arithma_stats));
+    result.input_bytes  = job.inputBytes;
+    result.output_bytes = job.outputBytes;
+    result.blocks       = job.blocks;
+    result.wall_seconds = job.wallSeconds;
+    std::memcpy(stats, &result, result.struct_size);
+    return ARITHMA_OK;
+}
+
+const char *arithma_stream_error(const arithma_stream *stream)
+{
+    return stream ? stream->error.c_str() : "";
+}
+
+void arithma_stream_free(arithma_stream *stream)
+{
+    delete stream;
+}
+
+// 3) One-shot buffers
+size_t arithma_compress_bound(size_t src_size, const arithma_options *options)
+{
+    CodecOptions codec;
+    if (!toCodecOptions(options, codec)) return 0;
+
+    // Incompressible blocks are stored, so only framing is added, to at
+    // most a few bytes more than the input when the type has a transform
+    const size_t staged = src_size + kMaxTransformGrowth + (src_size >> 20) * kTransformGrowthPerMiB;
+    const size_t blocks = staged / codec.blockSize + 1;
+    const size_t blockHeader = BlockHeader::kSize + BlockHeader::kChecksumSize;
+    return staged + ContainerHeader::kSize + blockHeader + ContainerFooter::kSize
+           + blocks * (blockHeader + BlockIndexEntry::kSize);
+}
+
+int arithma_compress_buffer(const void *src, size_t src_size,
+                            void *dst, size_t dst_capacity, size_t *dst_size,
+                            const arithma_options *options)
+{
+    CodecOptions codec;
+    if ((!src && src_size > 0) || !dst || !dst_size || !toCodecOptions(options, codec)) {
+        return ARITHMA_ERROR_ARGUMENT;
+    }
+
+    try {
+        uint8_t *out = static_cast<uint8_t *>(dst);
+        size_t written = 0;
+        CompressionSession session(codec, [&](const uint8_t *data, size_t size) {
+            if (size > dst_capacity - written) return false;
+            std::memcpy(out + written, data, size);
+            written += size;
+            return true;
+        });
+        if (!session.update(static_cast<const uint8_t *>(src), src_size) || !session.finish()) {
+            return ARITHMA_ERROR_OUTPUT;
+        }
+        *dst_size = written;
+        return ARITHMA_OK;
+    } catch (const std::bad_alloc &) {
+        return ARITHMA_ERROR_MEMORY;
+    }
+}
+
+int arithma_decompressed_size(const void *src, size_t src_size, uint64_t *size)
+{
+    if (!src || !size) return ARITHMA_ERROR_ARGUMENT;
+
+    const uint8_t *bytes = static_cast<const uint8_t *>(src);
+    ContainerHeader header;
+    ContainerFooter footer;
+    if (src_size < ContainerHeader::kSize + ContainerFooter::kSize
+        || !readContainerHeader(bytes, header)
+        || !readContainerFooter(bytes + src_size - ContainerFooter::kSize, footer)) {
+        return ARITHMA_ERROR_DATA;
+    }
+    *size = footer.originalSize;
+    return ARITHMA_OK;
+}
+
+int arithma_decompress_buffer(const void *src, size_t src_size,
+                              void *dst, size_t dst_capacity, size_t *dst_size,
+                              int threads)
+{
+    if (!src || (!dst && dst_capacity > 0) || !dst_size || threads < 0) {
+        return ARITHMA_ERROR_ARGUMENT;
+    }
+
+    try {
+        uint8_t *out = static_cast<uint8_t *>(dst);
+        size_t written = 0;
+        DecompressionSession session(threads, [&](const uint8_t *data, size_t size) {
+            if (size > dst_capacity - written) return false;
+            std::memcpy(out + written, data, size);
+            written += size;
+            return true;
+        });
+        if (!session.update(static_cast<const uint8_t *>(src), src_size) || !session.finish()) {
+            return session.outputFailed() ? ARITHMA_ERROR_OUTPUT : ARITHMA_ERROR_DATA;
+        }
+        *dst_size = written;
+        return ARITHMA_OK;
+    } catch (const std::bad_alloc &) {
+        return ARITHMA_ERROR_MEMORY;
+    }
+}
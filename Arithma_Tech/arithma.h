@@ -0,0 +1,125 @@
+/*
+ * arithma.h - C interface to the Arithma-Tech codec (arithma_core).
+ *
+ * The ABI is stable within a major version: structs are only ever extended
+ * at the end and callers pass their size, functions are never removed.
+ * Every call returns ARITHMA_OK (0) or a negative arithma_status.
+ *
+ * Streaming use:
+ *
+ *     arithma_stream *s = arithma_compress_init(&options, write_fn, ctx);
+ *     while (more input)
+ *         arithma_update(s, chunk, chunk_size);
+ *     arithma_finish(s);
+ *     arithma_stream_free(s);
+ *
+ * Decompression uses arithma_decompress_init() with the same update/finish
+ * calls. Output is delivered through the write callback as it is produced.
+ */
+
+#ifndef ARITHMA_H
+#define ARITHMA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(ARITHMA_CORE_SHARED)
+#  if defined(_WIN32)
+#    if defined(ARITHMA_CORE_BUILD)
+#      define ARITHMA_API __declspec(dllexport)
+#    else
+#      define ARITHMA_API __declspec(dllimport)
+#    endif
+#  else
+#    define ARITHMA_API __attribute__((visibility("default")))
+#  endif
+#else
+#  define ARITHMA_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ARITHMA_VERSION_MAJOR 1
+#define ARITHMA_VERSION_MINOR 0
+
+typedef enum arithma_status
+{
+    ARITHMA_OK              =  0,
+    ARITHMA_ERROR_ARGUMENT  = -1,   /* null pointer, bad option or wrong call order */
+    ARITHMA_ERROR_DATA      = -2,   /* input is not a valid or complete container */
+    ARITHMA_ERROR_OUTPUT    = -3,   /* write callback failed or buffer too small */
+    ARITHMA_ERROR_MEMORY    = -4
+} arithma_status;
+
+typedef enum arithma_backend
+{
+    ARITHMA_BACKEND_ARITHMETIC = 0,
+    ARITHMA_BACKEND_BINARY     = 1
+} arithma_backend;
+
+typedef enum arithma_file_type
+{
+    ARITHMA_TYPE_BINARY = 0,
+    ARITHMA_TYPE_TEXT   = 1,
+    ARITHMA_TYPE_PNG    = 2,
+    ARITHMA_TYPE_JPEG   = 3,
+    ARITHMA_TYPE_BMP    = 4,
+    ARITHMA_TYPE_GIF    = 5
+} arithma_file_type;
+
+typedef struct arithma_options
+{
+    size_t   struct_size;   /* sizeof(arithma_options), set by arithma_default_options */
+    int      level;         /* 1..3 */
+    int      threads;       /* 0 = one per core */
+    uint32_t block_size;    /* bytes per independently coded block */
+    int      backend;       /* arithma_backend */
+    int      file_type;     /* arithma_file_type recorded in the container */
+} arithma_options;
+
+typedef struct arithma_stats
+{
+    size_t   struct_size;   /* caller sets sizeof(arithma_stats) */
+    uint64_t input_bytes;
+    uint64_t output_bytes;
+    uint32_t blocks;
+    double   wall_seconds;
+} arithma_stats;
+
+/* Receives output; return 0 to continue, anything else to abort */
+typedef int (*arithma_write_fn)(void *opaque, const void *data, size_t size);
+
+typedef struct arithma_stream arithma_stream;
+
+ARITHMA_API unsigned    arithma_version(void);   /* (major << 16) | minor */
+ARITHMA_API const char *arithma_status_string(int status);
+ARITHMA_API void        arithma_default_options(arithma_options *options);
+
+/* Streaming; options may be NULL for defaults */
+ARITHMA_API arithma_stream *arithma_compress_init(const arithma_options *options,
+                                                  arithma_write_fn write, void *opaque);
+ARITHMA_API arithma_stream *arithma_decompress_init(int threads,
+                                                    arithma_write_fn write, void *opaque);
+ARITHMA_API int  arithma_update(arithma_stream *stream, const void *data, size_t size);
+ARITHMA_API int  arithma_finish(arithma_stream *stream);
+ARITHMA_API int  arithma_stream_stats(const arithma_stream *stream, arithma_stats *stats);
+ARITHMA_API const char *arithma_stream_error(const arithma_stream *stream);
+ARITHMA_API void arithma_stream_free(arithma_stream *stream);
+
+/* One-shot buffers. compress_bound gives a dst capacity that always fits. */
+ARITHMA_API size_t arithma_compress_bound(size_t src_size, const arithma_options *options);
+ARITHMA_API int arithma_compress_buffer(const void *src, size_t src_size,
+                                        void *dst, size_t dst_capacity, size_t *dst_size,
+                                        const arithma_options *options);
+ARITHMA_API int arithma_decompressed_size(const void *src, size_t src_size, uint64_t *size);
+ARITHMA_API int arithma_decompress_buffer(const void *src, size_t src_size,
+                                          void *dst, size_t dst_capacity, size_t *dst_size,
+                                          int threads);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ARITHMA_H */
@@ -0,0 +1,140 @@
+#include "arithmeticcoder.h"
+
+namespace {
+const uint64_t kTopValue    = 0xFFFFFFFFull;
+const uint64_t kFirstQuarter = 0x40000000ull;
+const uint64_t kHalf         = 0x80000000ull;
+const uint64_t kThirdQuarter = 0xC0000000ull;
+}
+
+// 1) ArithmeticEncoder Implementation
+ArithmeticEncoder::ArithmeticEncoder(std::vector<uint8_t> &output)
+    : out(output),
+    low(0),
+    high(kTopValue),
+    pendingBits(0),
+    bitBuffer(0),
+    bitCount(0)
+{
+}
+
+void ArithmeticEncoder::encode(uint32_t cumLow, uint32_t cumHigh, uint32_t total)
+{
+    const uint64_t range = high - low + 1;
+    high = low + (range * cumHigh) / total - 1;
+    low  = low + (range * cumLow) / total;
+
+    for (;;) {
+        if (high < kHalf) {
+            writeBitPlusPending(0);
+        } else if (low >= kHalf) {
+            writeBitPlusPending(1);
+            low  -= kHalf;
+            high -= kHalf;
+        } else if (low >= kFirstQuarter && high < kThirdQuarter) {
+            // Underflow: remember the bit and expand around the midpoint
+            pendingBits++;
+            low  -= kFirstQuarter;
+            high -= kFirstQuarter;
+        } else {
+            break;
+        }
+        low  = low << 1;
+        high = (high << 1) | 1;
+    }
+}
+
+void ArithmeticEncoder::finish()
+{
+    // Two more bits select the quarter that lies inside the final range
+    pendingBits++;
+    if (low < kFirstQuarter) {
+        writeBitPlusPending(0);
+    } else {
+        writeBitPlusPending(1);
+    }
+
+    // Pad the last byte with zeros
+    if (bitCount > 0) {
+        out.push_back(static_cast<uint8_t>(bitBuffer << (8 - bitCount)));
+        bitBuffer = 0;
+        bitCount = 0;
+    }
+}
+
+void ArithmeticEncoder::writeBit(int bit)
+{
+    bitBuffer = (bitBuffer << 1) | static_cast<uint32_t>(bit);
+    if (++bitCount == 8) {
+        out.push_back(static_cast<uint8_t>(bitBuffer));
+        bitBuffer = 0;
+        bitCount = 0;
+    }
+}
+
+void ArithmeticEncoder::writeBitPlusPending(int bit)
+{
+    writeBit(bit);
+    for (; pendingBits > 0; --pendingBits) {
+        writeBit(!bit);
+    }
+}
+
+// 2) ArithmeticDecoder Implementation
+ArithmeticDecoder::ArithmeticDecoder(const uint8_t *data, size_t size)
+    : data(data),
+    size(size),
+    position(0),
+    low(0),
+    high(kTopValue),
+    value(0),
+    bitBuffer(0),
+    bitCount(0)
+{
+    for (int i = 0; i < 32; ++i) {
+        value = (value << 1) | static_cast<uint64_t>(readBit());
+    }
+}
+
+uint32_t ArithmeticDecoder::decodeTarget(uint32_t total)
+{
+    const uint64_t range = high - low + 1;
+    return static_cast<uint32_t>(((value - low + 1) * total - 1) / range);
+}
+
+void ArithmeticDecoder::consume(uint32_t cumLow, uint32_t cumHigh, uint32_t total)
+{
+    const uint64_t range = high - low + 1;
+    high = low + (range * cumHigh) / total - 1;
+    low  = low + (range * cumLow) / total;
+
+    for (;;) {
+        if (high < kHalf) {
+            // nothing to subtract
+        } else if (low >= kHalf) {
+            value -= kHalf;
+            low   -= kHalf;
+            high  -= kHalf;
+        } else if (low >= kFirstQuarter && high < kThirdQuarter) {
+            value -= kFirstQuarter;
+            low   -= kFirstQuarter;
+            high  -= kFirstQuarter;
+        } else {
+            break;
+        }
+        low   = low << 1;
+        high  = (high << 1) | 1;
+        value = (value << 1) | static_cast<uint64_t>(readBit());
+    }
+}
+
+int ArithmeticDecoder::readBit()
+{
+    if (bitCount == 0) {
+        bitBuffer = position < size ? data[position] : 0;
+        position++;
+        bitCount = 8;
+    }
+    bitCount--;
+    return (bitBuffer >> bitCount) & 1;
+}
@@ -0,0 +1,66 @@
+#ifndef ARITHMETICCODER_H
+#define ARITHMETICCODER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief ArithmeticEncoder
+ *        Integer arithmetic encoder after Witten, Neal & Cleary (CACM 1987).
+ *        Uses 32-bit code values and rescales the range whenever it narrows
+ *        around the midpoint so it never underflows (requirement 1.3).
+ */
+class ArithmeticEncoder
+{
+public:
+    explicit ArithmeticEncoder(std::vector<uint8_t> &output);
+
+    // Narrow the range to [cumLow, cumHigh) out of total
+    void encode(uint32_t cumLow, uint32_t cumHigh, uint32_t total);
+
+    // Flush the final bits; must be called once after the last symbol
+    void finish();
+
+private:
+    void writeBit(int bit);
+    void writeBitPlusPending(int bit);
+
+    std::vector<uint8_t> &out;
+    uint64_t low;
+    uint64_t high;
+    uint32_t pendingBits;
+    uint32_t bitBuffer;
+    int      bitCount;
+};
+
+/**
+ * @brief ArithmeticDecoder
+ *        Mirror of ArithmeticEncoder reading from a memory buffer.
+ *        Reading past the end of the buffer yields zero bits.
+ */
+class ArithmeticDecoder
+{
+public:
+    ArithmeticDecoder(const uint8_t *data, size_t size);
+
+    // Cumulative count of the next symbol, in [0, total)
+    uint32_t decodeTarget(uint32_t total);
+
+    // Consume the symbol whose interval is [cumLow, cumHigh)
+    void consume(uint32_t cumLow, uint32_t cumHigh, uint32_t total);
+
+private:
+    int readBit();
+
+    const uint8_t *data;
+    size_t         size;
+    size_t         position;
+    uint64_t       low;
+    uint64_t       high;
+    uint64_t       value;
+    uint32_t       bitBuffer;
+    int            bitCount;
+};
+
+#endif // ARITHMETICCODER_H
@@ -0,0 +1,201 @@
+#include "artifactstore.h"
+
+#include <QFile>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QVariant>
+
+namespace {
+// Bytes per read or write when hashing and copying
+const qint64 kCopyChunk = 1 << 20;
+
+QByteArray hashBytes(const Hash128 &hash)
+{
+    QByteArray bytes(16, '\0');
+    for (int i = 0; i < 8; ++i) {
+        bytes[i]     = char(hash.high >> (56 - 8 * i));
+        bytes[8 + i] = char(hash.low >> (56 - 8 * i));
+    }
+    return bytes;
+}
+
+// Copy length bytes from in's current position to out, hashing them
+bool copyChunks(QFile &in, QFile &out, qint64 length, ContentHasher &hasher)
+{
+    QByteArray chunk;
+    while (length > 0) {
+        chunk = in.read(qMin(length, kCopyChunk));
+        if (chunk.isEmpty() || out.write(chunk) != chunk.size()) return false;
+        hasher.update(chunk.constData(), size_t(chunk.size()));
+        length -= chunk.size();
+    }
+    return true;
+}
+}
+
+// 1) ArtifactStore Implementation
+ArtifactStore::ArtifactStore()
+{
+}
+
+bool ArtifactStore::open(const QSqlDatabase &database, const QString &packPath)
+{
+    db = database;
+    pack.clear();
+    QFile file(packPath);
+    if (!file.open(QIODevice::ReadWrite)) {
+        return fail("Could not open the artifact pack " + packPath + ": " + file.errorString());
+    }
+    pack = packPath;
+    return true;
+}
+
+bool ArtifactStore::hashFile(const QString &path, Hash128 &hash, quint64 &size)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return fail("Could not open " + path);
+    }
+
+    ContentHasher hasher;
+    QByteArray chunk;
+    while (!(chunk = file.read(kCopyChunk)).isEmpty()) {
+        hasher.update(chunk.constData(), size_t(chunk.size()));
+    }
+    if (file.error() != QFileDevice::NoError) {
+        return fail("Could not read " + path + ": " + file.errorString());
+    }
+    size = hasher.length();
+    hash = hasher.finish();
+    return true;
+}
+
+qint64 ArtifactStore::find(const Hash128 &content, const CodecOptions &options)
+{
+    QSqlQuery query(db);
+    query.prepare("SELECT id FROM artifacts WHERE content_hash = :hash AND level = :level "
+                  "AND backend = :backend AND file_type = :type AND block_size = :block "
+                  "AND container_flags = :flags");
+    query.bindValue(":hash", hashBytes(content));
+    query.bindValue(":level", options.level);
+    query.bindValue(":backend", int(options.backend));
+    query.bindValue(":type", int(options.fileType));
+    query.bindValue(":block", options.blockSize);
+    query.bindValue(":flags", containerFlags(options));
+    if (!query.exec()) {
+        fail("Artifact lookup failed: " + query.lastError().text());
+        return 0;
+    }
+    return query.next() ? query.value(0).toLongLong() : 0;
+}
+
+bool ArtifactStore::restore(qint64 artifactId, const QString &outputPath, quint64 &packedSize)
+{
+    QSqlQuery query(db);
+    query.prepare("SELECT pack_offset, packed_size, container_hash FROM artifacts WHERE id = :id");
+    query.bindValue(":id", artifactId);
+    if (!query.exec() || !query.next()) {
+        return fail("Artifact " + QString::number(artifactId) + " is not in the store");
+    }
+    const qint64 offset = query.value(0).toLongLong();
+    const qint64 length = query.value(1).toLongLong();
+    const QByteArray stored = query.value(2).toByteArray();
+
+    QFile in(pack);
+    QFile out(outputPath);
+    if (!in.open(QIODevice::ReadOnly) || !in.seek(offset)) {
+        return fail("Could not read the artifact pack " + pack);
+    }
+    if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return fail("Could not create " + outputPath);
+    }
+    ContentHasher hasher;
+    if (!copyChunks(in, out, length, hasher) || !out.flush()) {
+        out.close();
+        out.remove();
+        return fail("Could not restore artifact " + QString::number(artifactId) + " to " + outputPath);
+    }
+    if (stored.isEmpty() || hashBytes(hasher.finish()) != stored) {
+        out.close();
+        out.remove();
+        return fail("Artifact " + QString::number(artifactId) + " does not match its stored hash");
+    }
+    packedSize = quint64(length);
+    return true;
+}
+
+bool ArtifactStore::discard(qint64 artifactId)
+{
+    QSqlQuery query(db);
+    query.prepare("DELETE FROM artifacts WHERE id = :id");
+    query.bindValue(":id", artifactId);
+    if (!query.exec()) {
+        return fail("Could not remove artifact " + QString::number(artifactId) + ": "
+                    + query.lastError().text());
+    }
+    return true;
+}
+
+qint64 ArtifactStore::add(const Hash128 &content, quint64 originalSize, const CodecOptions &options,
+                          const QString &containerPath)
+{
+    const qint64 existing = find(content, options);
+    if (existing > 0) return existing;
+
+    // Append first and index after: a crash in between leaves unreferenced
+    // bytes in the pack, never a row pointing at missing data
+    QFile in(containerPath);
+    QFile out(pack);
+    if (!in.open(QIODevice::ReadOnly)) {
+        fail("Could not open " + containerPath);
+        return 0;
+    }
+    // Indexed under the flags the container really has, not the expected ones
+    const QByteArray head = in.peek(ContainerHeader::kSize);
+    ContainerHeader header;
+    if (head.size() < int(ContainerHeader::kSize)
+        || !readContainerHeader(reinterpret_cast<const uint8_t *>(head.constData()), header)) {
+        fail(containerPath + " is not an Arithma-Tech container");
+        return 0;
+    }
+    if (!out.open(QIODevice::ReadWrite | QIODevice::Append)) {
+        fail("Could not open the artifact pack " + pack);
+        return 0;
+    }
+    const qint64 offset = out.size();
+    const qint64 length = in.size();
+    ContentHasher hasher;
+    if (!copyChunks(in, out, length, hasher) || !out.flush()) {
+        out.resize(offset);
+        fail("Could not append to the artifact pack " + pack);
+        return 0;
+    }
+
+    QSqlQuery query(db);
+    query.prepare("INSERT INTO artifacts ("
+                  "content_hash, original_size, level, backend, file_type, block_size,"
+                  "pack_offset, packed_size, container_hash, container_flags"
+                  ") VALUES ("
+                  ":hash, :original, :level, :backend, :type, :block, :offset, :packed, :container, :flags)");
+    query.bindValue(":hash", hashBytes(content));
+    query.bindValue(":original", originalSize);
+    query.bindValue(":level", options.level);
+    query.bindValue(":backend", int(options.backend));
+    query.bindValue(":type", int(options.fileType));
+    query.bindValue(":block", options.blockSize);
+    query.bindValue(":offset", offset);
+    query.bindValue(":packed", length);
+    query.bindValue(":container", hashBytes(hasher.finish()));
+    query.bindValue(":flags", header.flags);
+    if (!query.exec()) {
+        fail("Could not index the artifact: " + query.lastError().text());
+        return 0;
+    }
+    return query.lastInsertId().toLongLong();
+}
+
+bool ArtifactStore::fail(const QString &message)
+{
+    error = message;
+    return false;
+}
@@ -0,0 +1,60 @@
+#ifndef ARTIFACTSTORE_H
+#define ARTIFACTSTORE_H
+
+#include "codecengine.h"
+#include "contenthash.h"
+
+#include <QSqlDatabase>
+#include <QString>
+
+/**
+ * @brief ArtifactStore
+ *        Content-addressed store of compressed outputs (requirement 3.2).
+ *        Containers are appended to a sidecar pack file and indexed in the
+ *        artifacts table by the 128-bit hash of their input plus the codec
+ *        settings and container flags (primer set, transform version), so
+ *        identical inputs are stored once and a repeat compress is a file
+ *        copy. Data moves through fixed-size chunks; an artifact is never
+ *        held in memory whole. The table itself is created by HistoryStore's
+ *        migrations. Calls return false (or 0) on failure and leave a
+ *        message in errorString().
+ */
+class ArtifactStore
+{
+public:
+    ArtifactStore();
+
+    bool open(const QSqlDatabase &database, const QString &packPath);
+    bool isOpen() const { return !pack.isEmpty(); }
+
+    // Hash a file's contents without reading it whole
+    bool hashFile(const QString &path, Hash128 &hash, quint64 &size);
+
+    // Artifact holding content coded with options, or 0 if there is none
+    qint64 find(const Hash128 &content, const CodecOptions &options);
+
+    // Write an artifact's container to outputPath; packedSize is its length.
+    // Fails, leaving no output, when the copy does not match the hash taken
+    // when it was stored, so the pack is trusted without decoding it.
+    bool restore(qint64 artifactId, const QString &outputPath, quint64 &packedSize);
+
+    // Forget an artifact that could not be restored; its bytes stay in the
+    // pack unreferenced
+    bool discard(qint64 artifactId);
+
+    // Append the container at containerPath, which holds content coded with
+    // options; returns the artifact id, an existing one for a duplicate
+    qint64 add(const Hash128 &content, quint64 originalSize, const CodecOptions &options,
+               const QString &containerPath);
+
+    const QString &errorString() const { return error; }
+
+private:
+    bool fail(const QString &message);
+
+    QSqlDatabase db;
+    QString      pack;
+    QString      error;
+};
+
+#endif // ARTIFACTSTORE_H
@@ -0,0 +1,474 @@
+// arithma_bench: end-to-end benchmark of every backend and level against a
+// canonical Huffman baseline (non-functional requirement 1). Runs on a
+// generated corpus by default so it needs no files or network access.
+
+#include "blockcodec.h"
+#include "codecengine.h"
+#include "corpus.h"
+#include "huffman.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+const char *const kUsage =
+    "Usage: arithma_bench [options]\n"
+    "\n"
+    "Options:\n"
+    "  --size N               Bytes per generated corpus file (default 262144)\n"
+    "  --seed N               Corpus seed (default 1)\n"
+    "  --corpus DIR           Benchmark the files in DIR instead\n"
+    "  --write-corpus DIR     Save the generated corpus to DIR and exit\n"
+    "  --repeat N             Runs per measurement, fastest is kept (default 1)\n"
+    "  -T, --threads N        Worker threads, 0 = one per core (default 1)\n"
+    "  --json PATH            Write results as JSON, - for stdout\n"
+    "  --baseline PATH        Compare against a JSON file from an earlier run\n"
+    "  --tolerance PCT        Allowed growth in compressed size (default 0.5)\n"
+    "  --speed-tolerance PCT  Also flag throughput drops beyond PCT (default off)\n"
+    "  --perf                 Collect hardware counters for each run (Linux)\n"
+    "  -h, --help             Show this help\n";
+
+struct Mode
+{
+    std::string name;
+    bool    huffman = false;
+    Backend backend = Backend::Arithmetic;
+    int     level   = 0;
+};
+
+struct Result
+{
+    std::string file;
+    std::string type;
+    std::string mode;
+    uint64_t inputBytes  = 0;
+    uint64_t outputBytes = 0;
+    double   compressMBps   = 0.0;
+    double   decompressMBps = 0.0;
+    uint64_t peakRssKB = 0;
+    bool     verified  = false;
+    PerfStats compressPerf;
+    PerfStats decompressPerf;
+
+    double ratio() const { return inputBytes ? double(outputBytes) / inputBytes : 1.0; }
+};
+
+std::vector<Mode> allModes()
+{
+    std::vector<Mode> modes;
+    for (Backend backend : {Backend::Arithmetic, Backend::Binary}) {
+        for (int level = CodecEngine::kMinLevel; level <= CodecEngine::kMaxLevel; ++level) {
+            Mode mode;
+            mode.name    = std::string(backendName(backend)) + "-" + std::to_string(level);
+            mode.backend = backend;
+            mode.level   = level;
+            modes.push_back(mode);
+        }
+    }
+    Mode huffman;
+    huffman.name    = "huffman";
+    huffman.huffman = true;
+    modes.push_back(huffman);
+    return modes;
+}
+
+// 1) Peak memory. Linux lets us reset the high-water mark between modes;
+// elsewhere the figure is the peak of the whole process so far.
+void resetPeakRss()
+{
+#ifdef __linux__
+    std::ofstream clear("/proc/self/clear_refs");
+    clear << "5";
+#endif
+}
+
+uint64_t peakRssKB()
+{
+#ifdef __linux__
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) return std::strtoull(line.c_str() + 6, nullptr, 10);
+    }
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) return static_cast<uint64_t>(usage.ru_maxrss);
+#endif
+    return 0;
+}
+
+// 2) Measurement
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+double megabytesPerSecond(uint64_t bytes, double seconds)
+{
+    return seconds > 0 ? bytes / seconds / (1024.0 * 1024.0) : 0.0;
+}
+
+bool runOne(const CorpusFile &file, const Mode &mode, int threads, int repeat, bool perf, Result &result)
+{
+    result.file = file.name;
+    result.type = fileTypeName(file.type);
+    result.mode = mode.name;
+    result.inputBytes = file.data.size();
+
+    CodecOptions options;
+    options.level    = mode.level;
+    options.threads  = threads;
+    options.backend  = mode.backend;
+    options.fileType = file.type;
+    options.perfCounters = perf;
+    CodecEngine engine(options);
+
+    std::vector<uint8_t> packed, restored;
+    double compressSeconds = 1e30, decompressSeconds = 1e30;
+    resetPeakRss();
+    for (int run = 0; run < repeat; ++run) {
+        // The engine collects its own counters; Huffman gets a job-wide recorder
+        std::unique_ptr<PerfRecorder> recorder(perf && mode.huffman ? new PerfRecorder : nullptr);
+        packed.clear();
+        auto start = std::chrono::steady_clock::now();
+        if (mode.huffman) huffmanCompress(file.data.data(), file.data.size(), packed);
+        else if (!engine.compress(file.data, packed)) return false;
+        compressSeconds = std::min(compressSeconds, secondsSince(start));
+        result.compressPerf = recorder ? recorder->stats() : engine.stats().perf;
+
+        recorder.reset(perf && mode.huffman ? new PerfRecorder : nullptr);
+        restored.clear();
+        start = std::chrono::steady_clock::now();
+        if (mode.huffman) {
+            if (!huffmanDecompress(packed.data(), packed.size(), restored)) return false;
+        } else if (!engine.decompress(packed, restored)) {
+            return false;
+        }
+        decompressSeconds = std::min(decompressSeconds, secondsSince(start));
+        result.decompressPerf = recorder ? recorder->stats() : engine.stats().perf;
+    }
+
+    result.outputBytes    = packed.size();
+    result.compressMBps   = megabytesPerSecond(result.inputBytes, compressSeconds);
+    result.decompressMBps = megabytesPerSecond(result.inputBytes, decompressSeconds);
+    result.peakRssKB      = peakRssKB();
+    result.verified       = restored == file.data;
+    return true;
+}
+
+// 3) Reporting
+void printTable(const std::vector<Result> &results)
+{
+    std::printf("%-14s %-6s %-12s %10s %10s %7s %9s %9s %9s\n", "file", "type", "mode",
+                "input", "output", "ratio", "comp MB/s", "dec MB/s", "peak MB");
+    for (const Result &r : results) {
+        std::printf("%-14s %-6s %-12s %10llu %10llu %6.2f%% %9.2f %9.2f %9.1f%s\n",
+                    r.file.c_str(), r.type.c_str(), r.mode.c_str(),
+                    static_cast<unsigned long long>(r.inputBytes),
+                    static_cast<unsigned long long>(r.outputBytes), r.ratio() * 100.0,
+                    r.compressMBps, r.decompressMBps, r.peakRssKB / 1024.0,
+                    r.verified ? "" : "  MISMATCH");
+    }
+}
+
+// Counters per byte of input, "-" where the kernel gave us nothing
+void printCounters(const std::vector<Result> &results)
+{
+    std::printf("\n%-14s %-12s %-4s %9s %6s %10s %10s %10s %9s\n", "file", "mode", "dir",
+                "cycles/B", "IPC", "L1d/KB", "LLC/KB", "brmiss/KB", "cpu ms");
+    auto cell = [](bool present, double value, const char *format) {
+        char text[32] = "-";
+        if (present) std::snprintf(text, sizeof(text), format, value);
+        return std::string(text);
+    };
+    for (const Result &r : results) {
+        for (int direction = 0; direction < 2; ++direction) {
+            const PerfStats &perf = direction ? r.decompressPerf : r.compressPerf;
+            if (!perf.available) continue;
+            const PerfCounts &c = perf.job;
+            const double kb = r.inputBytes / 1024.0;
+            const bool cycles = (perf.available & PerfRecorder::Cycles) && c.cycles > 0;
+            std::printf("%-14s %-12s %-4s %9s", r.file.c_str(), r.mode.c_str(), direction ? "dec" : "comp",
+                        cell(cycles, c.cycles / double(r.inputBytes), "%.1f").c_str());
+            std::printf(" %6s", cell(cycles && (perf.available & PerfRecorder::Instructions),
+                                     double(c.instructions) / c.cycles, "%.2f").c_str());
+            std::printf(" %10s", cell(perf.available & PerfRecorder::L1dMisses, c.l1dMisses / kb, "%.1f").c_str());
+            std::printf(" %10s", cell(perf.available & PerfRecorder::LlcMisses, c.llcMisses / kb, "%.2f").c_str());
+            std::printf(" %10s", cell(perf.available & PerfRecorder::BranchMisses, c.branchMisses / kb, "%.1f").c_str());
+            std::printf(" %9s\n", cell(perf.available & PerfRecorder::TaskClock, c.taskClockNs / 1e6, "%.2f").c_str());
+        }
+    }
+}
+
+std::string jsonEscape(const std::string &text)
+{
+    std::string out;
+    for (char c : text) {
+        if (c == '"' || c == '\\') out += '\\';
+        if (static_cast<unsigned char>(c) >= 0x20) out += c;
+    }
+    return out;
+}
+
+// One result object per line, which is all readBaseline() has to parse
+void writeJson(std::ostream &out, const std::vector<Result> &results, size_t corpusSize)
+{
+    out << "{\n  \"corpus_size\": " << corpusSize << ",\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result &r = results[i];
+        char numbers[256];
+        std::snprintf(numbers, sizeof(numbers),
+                      "\"input\": %llu, \"output\": %llu, \"ratio\": %.6f, "
+                      "\"compress_mbps\": %.3f, \"decompress_mbps\": %.3f, "
+                      "\"peak_rss_kb\": %llu, \"verified\": %s",
+                      static_cast<unsigned long long>(r.inputBytes),
+                      static_cast<unsigned long long>(r.outputBytes), r.ratio(),
+                      r.compressMBps, r.decompressMBps,
+                      static_cast<unsigned long long>(r.peakRssKB), r.verified ? "true" : "false");
+        out << "    {\"file\": \"" << jsonEscape(r.file) << "\", \"type\": \"" << r.type
+            << "\", \"mode\": \"" << r.mode << "\", " << numbers;
+        // Compression counters, only those the kernel provided
+        const PerfStats &perf = r.compressPerf;
+        const struct { uint32_t bit; const char *key; uint64_t value; } counters[] = {
+            {PerfRecorder::Cycles,       "cycles",        perf.job.cycles},
+            {PerfRecorder::Instructions, "instructions",  perf.job.instructions},
+            {PerfRecorder::L1dMisses,    "l1d_misses",    perf.job.l1dMisses},
+            {PerfRecorder::LlcMisses,    "llc_misses",    perf.job.llcMisses},
+            {PerfRecorder::BranchMisses, "branch_misses", perf.job.branchMisses},
+            {PerfRecorder::TaskClock,    "cpu_ns",        perf.job.taskClockNs},
+        };
+        for (const auto &counter : counters) {
+            if (perf.available & counter.bit) out << ", \"" << counter.key << "\": " << counter.value;
+        }
+        out << "}" << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+}
+
+std::string stringField(const std::string &line, const std::string &key)
+{
+    const std::string marker = "\"" + key + "\": \"";
+    const size_t start = line.find(marker);
+    if (start == std::string::npos) return std::string();
+    const size_t end = line.find('"', start + marker.size());
+    return line.substr(start + marker.size(), end - start - marker.size());
+}
+
+double numberField(const std::string &line, const std::string &key)
+{
+    const std::string marker = "\"" + key + "\": ";
+    const size_t start = line.find(marker);
+    return start == std::string::npos ? 0.0 : std::strtod(line.c_str() + start + marker.size(), nullptr);
+}
+
+bool readBaseline(const std::string &path, std::map<std::string, Result> &baseline)
+{
+    std::ifstream in(path);
+    if (!in) return false;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.find("\"mode\"") == std::string::npos) continue;
+        Result r;
+        r.file           = stringField(line, "file");
+        r.mode           = stringField(line, "mode");
+        r.inputBytes     = static_cast<uint64_t>(numberField(line, "input"));
+        r.outputBytes    = static_cast<uint64_t>(numberField(line, "output"));
+        r.compressMBps   = numberField(line, "compress_mbps");
+        r.decompressMBps = numberField(line, "decompress_mbps");
+        baseline[r.file + "/" + r.mode] = r;
+    }
+    return true;
+}
+
+// Count results that got worse than the baseline allows
+int compareWithBaseline(const std::vector<Result> &results, const std::map<std::string, Result> &baseline,
+                        double tolerance, double speedTolerance)
+{
+    int regressions = 0, compared = 0;
+    for (const Result &r : results) {
+        const auto found = baseline.find(r.file + "/" + r.mode);
+        if (found == baseline.end() || found->second.inputBytes != r.inputBytes) continue;
+        const Result &base = found->second;
+        ++compared;
+
+        if (r.outputBytes > base.outputBytes * (1.0 + tolerance / 100.0)) {
+            std::printf("REGRESSION %s %s: %llu bytes, baseline %llu\n", r.file.c_str(), r.mode.c_str(),
+                        static_cast<unsigned long long>(r.outputBytes),
+                        static_cast<unsigned long long>(base.outputBytes));
+            ++regressions;
+        }
+        if (speedTolerance > 0) {
+            const double floor = 1.0 - speedTolerance / 100.0;
+            if (r.compressMBps < base.compressMBps * floor || r.decompressMBps < base.decompressMBps * floor) {
+                std::printf("REGRESSION %s %s: %.2f/%.2f MB/s, baseline %.2f/%.2f MB/s\n",
+                            r.file.c_str(), r.mode.c_str(), r.compressMBps, r.decompressMBps,
+                            base.compressMBps, base.decompressMBps);
+                ++regressions;
+            }
+        }
+    }
+    std::printf("Baseline: %d results compared, %d regressions\n", compared, regressions);
+    return regressions;
+}
+
+bool parseNumber(const char *text, double &value)
+{
+    char *end = nullptr;
+    value = std::strtod(text, &end);
+    return end != text && *end == '\0' && value >= 0;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    double size = 256 * 1024, seed = 1, repeat = 1, threads = 1;
+    double tolerance = 0.5, speedTolerance = 0;
+    std::string corpusDir, writeDir, jsonPath, baselinePath;
+    bool perf = false;
+
+    // 1) Arguments
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        auto number = [&](double &value) {
+            return hasValue && parseNumber(argv[++i], value);
+        };
+        bool ok = true;
+        if (arg == "-h" || arg == "--help") {
+            std::cout << kUsage;
+            return 0;
+        } else if (arg == "--size") {
+            ok = number(size) && size >= 1;
+        } else if (arg == "--seed") {
+            ok = number(seed);
+        } else if (arg == "--repeat") {
+            ok = number(repeat) && repeat >= 1;
+        } else if (arg == "-T" || arg == "--threads") {
+            ok = number(threads);
+        } else if (arg == "--tolerance") {
+            ok = number(tolerance);
+        } else if (arg == "--speed-tolerance") {
+            ok = number(speedTolerance);
+        } else if (arg == "--perf") {
+            perf = true;
+        } else if (arg == "--corpus" && hasValue) {
+            corpusDir = argv[++i];
+        } else if (arg == "--write-corpus" && hasValue) {
+            writeDir = argv[++i];
+        } else if (arg == "--json" && hasValue) {
+            jsonPath = argv[++i];
+        } else if (arg == "--baseline" && hasValue) {
+            baselinePath = argv[++i];
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            std::cerr << "arithma_bench: bad argument " << arg << "\n\n" << kUsage;
+            return 2;
+        }
+    }
+
+    // 2) Corpus
+    std::vector<CorpusFile> corpus;
+    if (!corpusDir.empty()) {
+        if (!loadCorpus(corpusDir, corpus) || corpus.empty()) {
+            std::cerr << "arithma_bench: cannot read corpus " << corpusDir << "\n";
+            return 1;
+        }
+    } else {
+        corpus = generateCorpus(static_cast<size_t>(size), static_cast<uint32_t>(seed));
+    }
+
+    if (!writeDir.empty()) {
+        std::error_code error;
+        std::filesystem::create_directories(writeDir, error);
+        if (error) {
+            std::cerr << "arithma_bench: cannot create " << writeDir << ": " << error.message() << "\n";
+            return 1;
+        }
+        for (const CorpusFile &file : corpus) {
+            std::ofstream out(writeDir + "/" + file.name, std::ios::binary);
+            out.write(reinterpret_cast<const char *>(file.data.data()), file.data.size());
+            if (!out) {
+                std::cerr << "arithma_bench: cannot write " << writeDir << "/" << file.name << "\n";
+                return 1;
+            }
+        }
+        return 0;
+    }
+
+    // 3) Runs
+    const std::vector<Mode> modes = allModes();
+    std::vector<Result> results;
+    bool allVerified = true;
+    for (const Mode &mode : modes) {
+        for (const CorpusFile &file : corpus) {
+            Result result;
+            if (!runOne(file, mode, static_cast<int>(threads), static_cast<int>(repeat), perf, result)) {
+                std::cerr << "arithma_bench: " << mode.name << " failed on " << file.name << "\n";
+                return 1;
+            }
+            allVerified = allVerified && result.verified;
+            results.push_back(result);
+        }
+    }
+    printTable(results);
+    if (perf) printCounters(results);
+
+    // 4) Summary: mean ratio per mode, the figure requirement 1 is stated in
+    std::printf("\n%-12s %10s\n", "mode", "mean ratio");
+    std::map<std::string, double> meanRatio;
+    for (const Mode &mode : modes) {
+        double sum = 0;
+        for (const Result &r : results) {
+            if (r.mode == mode.name) sum += r.ratio();
+        }
+        meanRatio[mode.name] = sum / corpus.size();
+        std::printf("%-12s %9.2f%%\n", mode.name.c_str(), meanRatio[mode.name] * 100.0);
+    }
+    int failures = allVerified ? 0 : 1;
+    for (const Mode &mode : modes) {
+        if (!mode.huffman && meanRatio[mode.name] >= meanRatio["huffman"]) {
+            std::printf("Requirement 1: %s does not beat Huffman on average\n", mode.name.c_str());
+            ++failures;
+        }
+    }
+
+    if (!jsonPath.empty()) {
+        if (jsonPath == "-") {
+            writeJson(std::cout, results, corpusDir.empty() ? static_cast<size_t>(size) : 0);
+        } else {
+            std::ofstream out(jsonPath);
+            writeJson(out, results, corpusDir.empty() ? static_cast<size_t>(size) : 0);
+            if (!out) {
+                std::cerr << "arithma_bench: cannot write " << jsonPath << "\n";
+                return 1;
+            }
+        }
+    }
+
+    if (!baselinePath.empty()) {
+        std::map<std::string, Result> baseline;
+        if (!readBaseline(baselinePath, baseline)) {
+            std::cerr << "arithma_bench: cannot read baseline " << baselinePath << "\n";
+            return 1;
+        }
+        failures += compareWithBaseline(results, baseline, tolerance, speedTolerance);
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,756 @@
+#include "corpus.h"
+
+#include "typeregistry.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <unordered_map>
+
+#ifdef ARITHMA_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace {
+
+// 1) Helpers
+struct Random
+{
+    explicit Random(uint32_t seed) : state(seed * 2654435761u + 0x9e3779b9u) {}
+
+    uint32_t next()
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    uint32_t below(uint32_t limit) { return next() % limit; }
+
+    uint32_t state;
+};
+
+void put16le(std::vector<uint8_t> &out, uint32_t value)
+{
+    out.push_back(static_cast<uint8_t>(value));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+}
+
+void put32le(std::vector<uint8_t> &out, uint32_t value)
+{
+    put16le(out, value & 0xFFFF);
+    put16le(out, value >> 16);
+}
+
+void put16be(std::vector<uint8_t> &out, uint32_t value)
+{
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+void put32be(std::vector<uint8_t> &out, uint32_t value)
+{
+    put16be(out, value >> 16);
+    put16be(out, value & 0xFFFF);
+}
+
+uint8_t clampByte(double value)
+{
+    return static_cast<uint8_t>(std::min(255.0, std::max(0.0, value + 0.5)));
+}
+
+// Photo-like RGB scene: smooth gradients, a few flat discs and mild noise
+std::vector<uint8_t> makeScene(int width, int height, uint32_t seed)
+{
+    Random random(seed);
+    struct Disc { int x, y, r; uint8_t rgb[3]; };
+    std::vector<Disc> discs(6);
+    for (Disc &disc : discs) {
+        disc.x = random.below(width);
+        disc.y = random.below(height);
+        disc.r = 4 + random.below(std::max(8, std::min(width, height) / 4));
+        for (uint8_t &c : disc.rgb) c = static_cast<uint8_t>(random.below(256));
+    }
+
+    std::vector<uint8_t> rgb(static_cast<size_t>(width) * height * 3);
+    const double phase = seed * 0.37;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            double r = 128 + 90 * std::sin(x * 0.02 + phase) * std::cos(y * 0.015);
+            double g = 30 + 200.0 * y / height;
+            double b = 255 - 200.0 * x / width;
+            for (const Disc &disc : discs) {
+                const int dx = x - disc.x, dy = y - disc.y;
+                if (dx * dx + dy * dy <= disc.r * disc.r) {
+                    r = disc.rgb[0]; g = disc.rgb[1]; b = disc.rgb[2];
+                }
+            }
+            const int noise = static_cast<int>(random.below(9)) - 4;
+            uint8_t *p = &rgb[(static_cast<size_t>(y) * width + x) * 3];
+            p[0] = clampByte(r + noise);
+            p[1] = clampByte(g + noise);
+            p[2] = clampByte(b + noise);
+        }
+    }
+    return rgb;
+}
+
+// 6x6x6 colour cube plus a grey ramp, as an indexed-image palette
+std::vector<uint8_t> cubePalette()
+{
+    std::vector<uint8_t> palette;
+    for (int r = 0; r < 6; ++r)
+        for (int g = 0; g < 6; ++g)
+            for (int b = 0; b < 6; ++b) {
+                palette.push_back(static_cast<uint8_t>(r * 51));
+                palette.push_back(static_cast<uint8_t>(g * 51));
+                palette.push_back(static_cast<uint8_t>(b * 51));
+            }
+    for (int i = 0; i < 40; ++i) {
+        const uint8_t grey = static_cast<uint8_t>(8 + i * 6);
+        palette.insert(palette.end(), {grey, grey, grey});
+    }
+    return palette;
+}
+
+uint8_t cubeIndex(const uint8_t *rgb)
+{
+    return static_cast<uint8_t>((rgb[0] + 25) / 51 * 36 + (rgb[1] + 25) / 51 * 6 + (rgb[2] + 25) / 51);
+}
+
+const std::array<uint32_t, 256> &crcTable()
+{
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t n = 0; n < 256; ++n) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[n] = c;
+        }
+        return t;
+    }();
+    return table;
+}
+
+uint32_t crc32(const uint8_t *data, size_t size)
+{
+    uint32_t c = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; ++i) c = crcTable()[(c ^ data[i]) & 0xFF] ^ (c >> 8);
+    return c ^ 0xFFFFFFFFu;
+}
+
+void pngChunk(std::vector<uint8_t> &out, const char *type, const std::vector<uint8_t> &data)
+{
+    put32be(out, static_cast<uint32_t>(data.size()));
+    const size_t start = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+    put32be(out, crc32(&out[start], out.size() - start));
+}
+
+// zlib stream of the filtered scanlines, at the fast level screenshot and
+// web tools use. At the default level deflate's matches on the scene's
+// shared per-pixel noise beat the PNG transform, which then stores the file.
+std::vector<uint8_t> zlibWrap(const std::vector<uint8_t> &raw)
+{
+#ifdef ARITHMA_HAVE_ZLIB
+    uLongf size = compressBound(static_cast<uLong>(raw.size()));
+    std::vector<uint8_t> out(size);
+    compress2(out.data(), &size, raw.data(), static_cast<uLong>(raw.size()), Z_BEST_SPEED);
+    out.resize(size);
+    return out;
+#else
+    // Stored deflate blocks
+    std::vector<uint8_t> out = {0x78, 0x01};
+    size_t pos = 0;
+    do {
+        const size_t n = std::min<size_t>(65535, raw.size() - pos);
+        out.push_back(pos + n == raw.size() ? 1 : 0);
+        put16le(out, static_cast<uint32_t>(n));
+        put16le(out, static_cast<uint32_t>(~n & 0xFFFF));
+        out.insert(out.end(), raw.begin() + pos, raw.begin() + pos + n);
+        pos += n;
+    } while (pos < raw.size());
+    uint32_t a = 1, b = 0;
+    for (uint8_t byte : raw) {
+        a = (a + byte) % 65521;
+        b = (b + a) % 65521;
+    }
+    put32be(out, (b << 16) | a);
+    return out;
+#endif
+}
+
+int paeth(int a, int b, int c)
+{
+    const int p = a + b - c;
+    const int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc) return a;
+    return pb <= pc ? b : c;
+}
+
+// 2) JPEG tables (ITU T.81 Annex K)
+const uint8_t kZigzag[64] = {
+     0,  1,  8, 16,  9,  2,  3, 10, 17, 24, 32, 25, 18, 11,  4,  5,
+    12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13,  6,  7, 14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63
+};
+
+const uint8_t kLumaQuant[64] = {
+    16, 11, 10, 16,  24,  40,  51,  61,  12, 12, 14, 19,  26,  58,  60,  55,
+    14, 13, 16, 24,  40,  57,  69,  56,  14, 17, 22, 29,  51,  87,  80,  62,
+    18, 22, 37, 56,  68, 109, 103,  77,  24, 35, 55, 64,  81, 104, 113,  92,
+    49, 64, 78, 87, 103, 121, 120, 101,  72, 92, 95, 98, 112, 100, 103,  99
+};
+
+const uint8_t kChromaQuant[64] = {
+    17, 18, 24, 47, 99, 99, 99, 99,  18, 21, 26, 66, 99, 99, 99, 99,
+    24, 26, 56, 99, 99, 99, 99, 99,  47, 66, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,  99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,  99, 99, 99, 99, 99, 99, 99, 99
+};
+
+const uint8_t kDcLumaBits[16]   = {0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0};
+const uint8_t kDcChromaBits[16] = {0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0};
+const uint8_t kDcValues[12]     = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+
+const uint8_t kAcLumaBits[16] = {0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7d};
+const uint8_t kAcLumaValues[162] = {
+    0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07,
+    0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08, 0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0,
+    0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+    0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+    0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+    0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7,
+    0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5,
+    0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2,
+    0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+    0xf9, 0xfa
+};
+
+const uint8_t kAcChromaBits[16] = {0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77};
+const uint8_t kAcChromaValues[162] = {
+    0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71,
+    0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xa1, 0xb1, 0xc1, 0x09, 0x23, 0x33, 0x52, 0xf0,
+    0x15, 0x62, 0x72, 0xd1, 0x0a, 0x16, 0x24, 0x34, 0xe1, 0x25, 0xf1, 0x17, 0x18, 0x19, 0x1a, 0x26,
+    0x27, 0x28, 0x29, 0x2a, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48,
+    0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68,
+    0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+    0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5,
+    0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3,
+    0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+    0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+    0xf9, 0xfa
+};
+
+struct HuffmanTable
+{
+    std::array<uint16_t, 256> code{};
+    std::array<uint8_t, 256>  length{};
+};
+
+HuffmanTable buildTable(const uint8_t *bits, const uint8_t *values)
+{
+    HuffmanTable table;
+    uint16_t code = 0;
+    int k = 0;
+    for (int len = 1; len <= 16; ++len) {
+        for (int i = 0; i < bits[len - 1]; ++i, ++k) {
+            table.code[values[k]] = code++;
+            table.length[values[k]] = static_cast<uint8_t>(len);
+        }
+        code <<= 1;
+    }
+    return table;
+}
+
+void putTable(std::vector<uint8_t> &out, int classAndId, const uint8_t *bits, const uint8_t *values)
+{
+    int count = 0;
+    for (int i = 0; i < 16; ++i) count += bits[i];
+    out.insert(out.end(), {0xFF, 0xC4});
+    put16be(out, 2 + 1 + 16 + count);
+    out.push_back(static_cast<uint8_t>(classAndId));
+    out.insert(out.end(), bits, bits + 16);
+    out.insert(out.end(), values, values + count);
+}
+
+class JpegBitWriter
+{
+public:
+    explicit JpegBitWriter(std::vector<uint8_t> &out) : out(out) {}
+
+    void put(uint32_t value, int count)
+    {
+        for (int i = count - 1; i >= 0; --i) {
+            accumulator = static_cast<uint8_t>((accumulator << 1) | ((value >> i) & 1));
+            if (++filled == 8) emit();
+        }
+    }
+
+    void flush()
+    {
+        while (filled != 0) {
+            accumulator = static_cast<uint8_t>((accumulator << 1) | 1);
+            if (++filled == 8) emit();
+        }
+    }
+
+private:
+    void emit()
+    {
+        out.push_back(accumulator);
+        if (accumulator == 0xFF) out.push_back(0x00);
+        accumulator = 0;
+        filled = 0;
+    }
+
+    std::vector<uint8_t> &out;
+    uint8_t accumulator = 0;
+    int     filled = 0;
+};
+
+int magnitudeCategory(int value)
+{
+    int magnitude = std::abs(value), category = 0;
+    while (magnitude) {
+        ++category;
+        magnitude >>= 1;
+    }
+    return category;
+}
+
+uint32_t magnitudeBits(int value, int category)
+{
+    return value >= 0 ? static_cast<uint32_t>(value)
+                      : static_cast<uint32_t>(value + (1 << category) - 1);
+}
+
+// Forward DCT, quantisation and entropy coding of one 8x8 block
+void encodeJpegBlock(JpegBitWriter &bits, const float *samples, const int *quant, int &previousDc,
+                     const HuffmanTable &dc, const HuffmanTable &ac)
+{
+    static const std::array<float, 64> cosines = [] {
+        std::array<float, 64> c{};
+        for (int x = 0; x < 8; ++x)
+            for (int u = 0; u < 8; ++u)
+                c[x * 8 + u] = static_cast<float>(std::cos((2 * x + 1) * u * 3.14159265358979 / 16));
+        return c;
+    }();
+
+    float rows[64];
+    for (int y = 0; y < 8; ++y) {
+        for (int u = 0; u < 8; ++u) {
+            float sum = 0;
+            for (int x = 0; x < 8; ++x) sum += (samples[y * 8 + x] - 128.0f) * cosines[x * 8 + u];
+            rows[y * 8 + u] = sum;
+        }
+    }
+
+    int coefficients[64];
+    for (int v = 0; v < 8; ++v) {
+        for (int u = 0; u < 8; ++u) {
+            float sum = 0;
+            for (int y = 0; y < 8; ++y) sum += rows[y * 8 + u] * cosines[y * 8 + v];
+            const float cu = u ? 1.0f : 0.70710678f, cv = v ? 1.0f : 0.70710678f;
+            const float value = 0.25f * cu * cv * sum / quant[v * 8 + u];
+            coefficients[v * 8 + u] = static_cast<int>(std::lround(value));
+        }
+    }
+
+    const int diff = coefficients[0] - previousDc;
+    previousDc = coefficients[0];
+    int category = magnitudeCategory(diff);
+    bits.put(dc.code[category], dc.length[category]);
+    bits.put(magnitudeBits(diff, category), category);
+
+    int run = 0;
+    for (int k = 1; k < 64; ++k) {
+        const int value = coefficients[kZigzag[k]];
+        if (value == 0) {
+            ++run;
+            continue;
+        }
+        while (run > 15) {
+            bits.put(ac.code[0xF0], ac.length[0xF0]);
+            run -= 16;
+        }
+        category = magnitudeCategory(value);
+        const int symbol = (run << 4) | category;
+        bits.put(ac.code[symbol], ac.length[symbol]);
+        bits.put(magnitudeBits(value, category), category);
+        run = 0;
+    }
+    if (run > 0) bits.put(ac.code[0x00], ac.length[0x00]);
+}
+
+// 3) GIF
+void putLzwImage(std::vector<uint8_t> &out, const std::vector<uint8_t> &indices)
+{
+    const int minCodeSize = 8;
+    const int clearCode = 1 << minCodeSize, endCode = clearCode + 1;
+    std::unordered_map<uint32_t, int> dictionary;
+    int codeSize = minCodeSize + 1, next = endCode + 1;
+
+    std::vector<uint8_t> packed;
+    uint32_t accumulator = 0;
+    int filled = 0;
+    auto emit = [&](int code) {
+        accumulator |= static_cast<uint32_t>(code) << filled;
+        filled += codeSize;
+        while (filled >= 8) {
+            packed.push_back(static_cast<uint8_t>(accumulator));
+            accumulator >>= 8;
+            filled -= 8;
+        }
+    };
+
+    emit(clearCode);
+    int prefix = indices.empty() ? -1 : indices[0];
+    for (size_t i = 1; i < indices.size(); ++i) {
+        const uint32_t key = (static_cast<uint32_t>(prefix) << 8) | indices[i];
+        const auto found = dictionary.find(key);
+        if (found != dictionary.end()) {
+            prefix = found->second;
+            continue;
+        }
+        emit(prefix);
+        if (next < 4096) {
+            const int code = next++;
+            dictionary.emplace(key, code);
+            if (code == (1 << codeSize) && codeSize < 12) ++codeSize;
+        } else {
+            emit(clearCode);
+            dictionary.clear();
+            codeSize = minCodeSize + 1;
+            next = endCode + 1;
+        }
+        prefix = indices[i];
+    }
+    if (prefix >= 0) emit(prefix);
+    emit(endCode);
+    if (filled > 0) packed.push_back(static_cast<uint8_t>(accumulator));
+
+    out.push_back(minCodeSize);
+    for (size_t pos = 0; pos < packed.size(); pos += 255) {
+        const size_t n = std::min<size_t>(255, packed.size() - pos);
+        out.push_back(static_cast<uint8_t>(n));
+        out.insert(out.end(), packed.begin() + pos, packed.begin() + pos + n);
+    }
+    out.push_back(0);
+}
+
+int sideFor(size_t pixels)
+{
+    return std::max(16, static_cast<int>(std::sqrt(static_cast<double>(pixels))));
+}
+
+}
+
+// 4) Generators
+std::vector<uint8_t> generateText(size_t targetSize, uint32_t seed)
+{
+    static const char *const words[] = {
+        "the", "of", "and", "to", "in", "a", "is", "that", "for", "it", "as", "was", "with",
+        "be", "by", "on", "not", "he", "this", "are", "or", "his", "from", "at", "which",
+        "but", "have", "an", "had", "they", "you", "were", "their", "one", "all", "we",
+        "can", "her", "has", "there", "been", "if", "more", "when", "will", "would", "who",
+        "so", "no", "data", "file", "model", "symbol", "interval", "probability", "encoder",
+        "decoder", "context", "frequency", "compression", "arithmetic", "adaptive", "block",
+        "stream", "history", "window", "range", "output", "input", "bits", "byte", "table"
+    };
+    const size_t wordCount = sizeof(words) / sizeof(words[0]);
+
+    Random random(seed);
+    std::vector<uint8_t> text;
+    text.reserve(targetSize + 64);
+    size_t sentence = 0, line = 0;
+    while (text.size() < targetSize) {
+        // Roughly Zipfian: small indices are much more likely
+        const uint32_t r = random.below(1u << 16);
+        const size_t index = std::min(wordCount - 1, static_cast<size_t>(wordCount * (r / 65536.0) * (r / 65536.0)));
+        std::string word = words[index];
+        if (sentence == 0) word[0] = static_cast<char>(word[0] - 'a' + 'A');
+        text.insert(text.end(), word.begin(), word.end());
+        line += word.size() + 1;
+
+        if (++sentence > 6 + random.below(10)) {
+            text.push_back('.');
+            sentence = 0;
+        } else if (random.below(12) == 0) {
+            text.push_back(',');
+        }
+        if (line > 72) {
+            text.push_back('\n');
+            line = 0;
+        } else {
+            text.push_back(' ');
+        }
+    }
+    text.resize(targetSize);
+    return text;
+}
+
+std::vector<uint8_t> generateBmp(int width, int height, int bitsPerPixel, uint32_t seed)
+{
+    const std::vector<uint8_t> rgb = makeScene(width, height, seed);
+    const bool indexed = bitsPerPixel == 8;
+    const uint32_t stride = (width * (indexed ? 1 : 3) + 3) & ~3u;
+    const uint32_t paletteSize = indexed ? 256 * 4 : 0;
+    const uint32_t dataOffset = 14 + 40 + paletteSize;
+
+    std::vector<uint8_t> out;
+    out.reserve(dataOffset + stride * height);
+    out.insert(out.end(), {'B', 'M'});
+    put32le(out, dataOffset + stride * height);
+    put32le(out, 0);
+    put32le(out, dataOffset);
+
+    put32le(out, 40);
+    put32le(out, width);
+    put32le(out, height);
+    put16le(out, 1);
+    put16le(out, indexed ? 8 : 24);
+    put32le(out, 0);
+    put32le(out, stride * height);
+    put32le(out, 2835);
+    put32le(out, 2835);
+    put32le(out, indexed ? 256 : 0);
+    put32le(out, 0);
+
+    if (indexed) {
+        const std::vector<uint8_t> palette = cubePalette();
+        for (size_t i = 0; i < 256; ++i) {
+            out.insert(out.end(), {palette[i * 3 + 2], palette[i * 3 + 1], palette[i * 3], 0});
+        }
+    }
+
+    // Rows are stored bottom-up, pixels as BGR
+    for (int y = height - 1; y >= 0; --y) {
+        const size_t rowStart = out.size();
+        for (int x = 0; x < width; ++x) {
+            const uint8_t *p = &rgb[(static_cast<size_t>(y) * width + x) * 3];
+            if (indexed) out.push_back(cubeIndex(p));
+            else out.insert(out.end(), {p[2], p[1], p[0]});
+        }
+        out.resize(rowStart + stride, 0);
+    }
+    return out;
+}
+
+std::vector<uint8_t> generatePng(int width, int height, uint32_t seed)
+{
+    const std::vector<uint8_t> rgb = makeScene(width, height, seed);
+    const size_t stride = static_cast<size_t>(width) * 3;
+
+    // Per-row filter choice by smallest sum of absolute residuals, as libpng does
+    std::vector<uint8_t> filtered;
+    filtered.reserve((stride + 1) * height);
+    std::vector<uint8_t> candidate(stride), best(stride);
+    const std::vector<uint8_t> zeroRow(stride, 0);
+    for (int y = 0; y < height; ++y) {
+        const uint8_t *row = &rgb[y * stride];
+        const uint8_t *up = y ? &rgb[(y - 1) * stride] : zeroRow.data();
+        uint64_t bestCost = UINT64_MAX;
+        int bestFilter = 0;
+        for (int filter = 0; filter < 5; ++filter) {
+            uint64_t cost = 0;
+            for (size_t i = 0; i < stride; ++i) {
+                const int a = i >= 3 ? row[i - 3] : 0, b = up[i], c = i >= 3 ? up[i - 3] : 0;
+                int predicted = 0;
+                switch (filter) {
+                case 1: predicted = a; break;
+                case 2: predicted = b; break;
+                case 3: predicted = (a + b) / 2; break;
+                case 4: predicted = paeth(a, b, c); break;
+                }
+                candidate[i] = static_cast<uint8_t>(row[i] - predicted);
+                cost += std::abs(static_cast<int8_t>(candidate[i]));
+            }
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestFilter = filter;
+                best.swap(candidate);
+            }
+        }
+        filtered.push_back(static_cast<uint8_t>(bestFilter));
+        filtered.insert(filtered.end(), best.begin(), best.end());
+    }
+
+    std::vector<uint8_t> out = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    std::vector<uint8_t> header;
+    put32be(header, width);
+    put32be(header, height);
+    header.insert(header.end(), {8, 2, 0, 0, 0});
+    pngChunk(out, "IHDR", header);
+    pngChunk(out, "IDAT", zlibWrap(filtered));
+    pngChunk(out, "IEND", {});
+    return out;
+}
+
+std::vector<uint8_t> generateJpeg(int width, int height, int quality, uint32_t seed)
+{
+    const std::vector<uint8_t> rgb = makeScene(width, height, seed);
+
+    // Quality scaling as in the IJG reference encoder
+    quality = std::min(100, std::max(1, quality));
+    const int scale = quality < 50 ? 5000 / quality : 200 - quality * 2;
+    int lumaQuant[64], chromaQuant[64];
+    for (int i = 0; i < 64; ++i) {
+        lumaQuant[i]   = std::min(255, std::max(1, (kLumaQuant[i] * scale + 50) / 100));
+        chromaQuant[i] = std::min(255, std::max(1, (kChromaQuant[i] * scale + 50) / 100));
+    }
+
+    std::vector<uint8_t> out = {0xFF, 0xD8, 0xFF, 0xE0, 0x00, 0x10, 'J', 'F', 'I', 'F', 0,
+                                1, 1, 0, 0, 1, 0, 1, 0, 0};
+    for (int table = 0; table < 2; ++table) {
+        out.insert(out.end(), {0xFF, 0xDB, 0x00, 0x43, static_cast<uint8_t>(table)});
+        for (int k = 0; k < 64; ++k) {
+            out.push_back(static_cast<uint8_t>((table ? chromaQuant : lumaQuant)[kZigzag[k]]));
+        }
+    }
+    out.insert(out.end(), {0xFF, 0xC0, 0x00, 0x11, 8});
+    put16be(out, height);
+    put16be(out, width);
+    out.insert(out.end(), {3, 1, 0x22, 0, 2, 0x11, 1, 3, 0x11, 1});
+    putTable(out, 0x00, kDcLumaBits, kDcValues);
+    putTable(out, 0x10, kAcLumaBits, kAcLumaValues);
+    putTable(out, 0x01, kDcChromaBits, kDcValues);
+    putTable(out, 0x11, kAcChromaBits, kAcChromaValues);
+    out.insert(out.end(), {0xFF, 0xDA, 0x00, 0x0C, 3, 1, 0x00, 2, 0x11, 3, 0x11, 0, 63, 0});
+
+    const HuffmanTable dcLuma = buildTable(kDcLumaBits, kDcValues);
+    const HuffmanTable acLuma = buildTable(kAcLumaBits, kAcLumaValues);
+    const HuffmanTable dcChroma = buildTable(kDcChromaBits, kDcValues);
+    const HuffmanTable acChroma = buildTable(kAcChromaBits, kAcChromaValues);
+
+    // Colour conversion with edge replication out to whole 16x16 MCUs
+    auto sample = [&](int x, int y, int component) {
+        const uint8_t *p = &rgb[(static_cast<size_t>(std::min(y, height - 1)) * width
+                                 + std::min(x, width - 1)) * 3];
+        switch (component) {
+        case 0:  return 0.299f * p[0] + 0.587f * p[1] + 0.114f * p[2];
+        case 1:  return -0.168736f * p[0] - 0.331264f * p[1] + 0.5f * p[2] + 128.0f;
+        default: return 0.5f * p[0] - 0.418688f * p[1] - 0.081312f * p[2] + 128.0f;
+        }
+    };
+
+    JpegBitWriter bits(out);
+    int previousDc[3] = {0, 0, 0};
+    float block[64];
+    for (int my = 0; my < (height + 15) / 16; ++my) {
+        for (int mx = 0; mx < (width + 15) / 16; ++mx) {
+            for (int b = 0; b < 4; ++b) {
+                const int bx = mx * 16 + (b & 1) * 8, by = my * 16 + (b >> 1) * 8;
+                for (int i = 0; i < 64; ++i) block[i] = sample(bx + i % 8, by + i / 8, 0);
+                encodeJpegBlock(bits, block, lumaQuant, previousDc[0], dcLuma, acLuma);
+            }
+            for (int component = 1; component < 3; ++component) {
+                for (int i = 0; i < 64; ++i) {
+                    const int x = mx * 16 + (i % 8) * 2, y = my * 16 + (i / 8) * 2;
+                    block[i] = (sample(x, y, component) + sample(x + 1, y, component)
+                                + sample(x, y + 1, component) + sample(x + 1, y + 1, component)) / 4;
+                }
+                encodeJpegBlock(bits, block, chromaQuant, previousDc[component], dcChroma, acChroma);
+            }
+        }
+    }
+    bits.flush();
+    out.insert(out.end(), {0xFF, 0xD9});
+    return out;
+}
+
+std::vector<uint8_t> generateGif(int width, int height, int frames, uint32_t seed)
+{
+    const std::vector<uint8_t> palette = cubePalette();
+    const std::vector<uint8_t> background = makeScene(width, height, seed);
+
+    std::vector<uint8_t> out = {'G', 'I', 'F', '8', '9', 'a'};
+    put16le(out, width);
+    put16le(out, height);
+    out.insert(out.end(), {0xF7, 0, 0});
+    out.insert(out.end(), palette.begin(), palette.end());
+    out.resize(out.size() + (256 * 3 - palette.size()), 0);
+
+    // Loop forever
+    out.insert(out.end(), {0x21, 0xFF, 0x0B, 'N', 'E', 'T', 'S', 'C', 'A', 'P', 'E',
+                           '2', '.', '0', 0x03, 0x01, 0x00, 0x00, 0x00});
+
+    // A sprite moves across a static background between frames
+    const int sprite = std::max(4, std::min(width, height) / 5);
+    std::vector<uint8_t> indices(static_cast<size_t>(width) * height);
+    for (int frame = 0; frame < frames; ++frame) {
+        const int sx = (frame * width) / std::max(1, frames), sy = height / 3;
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                const bool inSprite = x >= sx && x < sx + sprite && y >= sy && y < sy + sprite;
+                indices[static_cast<size_t>(y) * width + x] = inSprite
+                    ? static_cast<uint8_t>(216 + ((x - sx + y - sy) / 4) % 40)
+                    : cubeIndex(&background[(static_cast<size_t>(y) * width + x) * 3]);
+            }
+        }
+        out.insert(out.end(), {0x21, 0xF9, 0x04, 0x00, 10, 0, 0, 0});
+        out.push_back(0x2C);
+        put16le(out, 0);
+        put16le(out, 0);
+        put16le(out, width);
+        put16le(out, height);
+        out.push_back(0);
+        putLzwImage(out, indices);
+    }
+    out.push_back(0x3B);
+    return out;
+}
+
+std::vector<CorpusFile> generateCorpus(size_t targetSize, uint32_t seed)
+{
+    std::vector<CorpusFile> files;
+    files.push_back({"text.txt", FileType::Text, generateText(targetSize, seed)});
+
+    const int rgbSide = sideFor(targetSize / 3);
+    files.push_back({"photo24.bmp", FileType::Bmp, generateBmp(rgbSide, rgbSide, 24, seed)});
+    const int indexedSide = sideFor(targetSize);
+    files.push_back({"indexed8.bmp", FileType::Bmp, generateBmp(indexedSide, indexedSide, 8, seed)});
+    files.push_back({"photo.png", FileType::Png, generatePng(rgbSide, rgbSide, seed)});
+
+    // JPEG and GIF are already compressed, so use more pixels to reach the size
+    const int jpegSide = sideFor(targetSize * 6);
+    files.push_back({"photo.jpg", FileType::Jpeg, generateJpeg(jpegSide, jpegSide, 85, seed)});
+    const int gifSide = sideFor(targetSize / 2);
+    files.push_back({"anim.gif", FileType::Gif, generateGif(gifSide, gifSide, 8, seed)});
+
+    Random random(seed);
+    std::vector<uint8_t> noise(targetSize);
+    for (uint8_t &byte : noise) byte = static_cast<uint8_t>(random.next() >> 24);
+    files.push_back({"random.bin", FileType::Binary, noise});
+    files.push_back({"zeros.bin", FileType::Binary, std::vector<uint8_t>(targetSize, 0)});
+    return files;
+}
+
+bool loadCorpus(const std::string &directory, std::vector<CorpusFile> &files)
+{
+    std::error_code error;
+    std::vector<std::filesystem::path> paths;
+    for (const auto &entry : std::filesystem::directory_iterator(directory, error)) {
+        if (entry.is_regular_file()) paths.push_back(entry.path());
+    }
+    if (error) return false;
+    std::sort(paths.begin(), paths.end());
+
+    for (const std::filesystem::path &path : paths) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) return false;
+        CorpusFile file;
+        file.name = path.filename().string();
+        file.data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        file.type = detectFileType(file.data.data(), file.data.size());
+        files.push_back(std::move(file));
+    }
+    return true;
+}
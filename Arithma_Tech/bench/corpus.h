@@ -0,0 +1,38 @@
+#ifndef CORPUS_H
+#define CORPUS_H
+
+#include "container.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief CorpusFile
+ *        One benchmark input. Generated files are deterministic for a given
+ *        size and seed so ratios can be compared across runs and machines.
+ */
+struct CorpusFile
+{
+    std::string name;
+    FileType    type = FileType::Binary;
+    std::vector<uint8_t> data;
+};
+
+// Text, BMP (24-bit and indexed), PNG, JPEG, animated GIF, random and zeros,
+// each roughly targetSize bytes. Needs no files or network access.
+std::vector<CorpusFile> generateCorpus(size_t targetSize, uint32_t seed = 1);
+
+// Individual generators, also used by the priming and codec tools
+std::vector<uint8_t> generateText(size_t targetSize, uint32_t seed);
+std::vector<uint8_t> generateBmp(int width, int height, int bitsPerPixel, uint32_t seed);
+std::vector<uint8_t> generatePng(int width, int height, uint32_t seed);
+std::vector<uint8_t> generateJpeg(int width, int height, int quality, uint32_t seed);
+std::vector<uint8_t> generateGif(int width, int height, int frames, uint32_t seed);
+
+// Every regular file in a directory, sorted by name and typed by content;
+// false if unreadable
+bool loadCorpus(const std::string &directory, std::vector<CorpusFile> &files);
+
+#endif // CORPUS_H
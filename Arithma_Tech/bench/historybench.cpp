@@ -0,0 +1,226 @@
+// arithma_historybench: history inserts per second, comparing the old
+// per-row path (rollback journal, statement prepared per row, autocommit)
+// with HistoryStore one row per commit, in batched transactions and
+// through HistoryWriter's thread. Point --dir at the disk the app runs
+// from; fsync cost is what is measured.
+
+#include "historystore.h"
+#include "historywriter.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QSqlError>
+#include <QSqlQuery>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace {
+
+const char *const kUsage =
+    "Usage: arithma_historybench [options]\n"
+    "\n"
+    "Options:\n"
+    "  --rows N       Rows inserted per mode (default 5000)\n"
+    "  --batch N      Rows per transaction in batched mode (default 1000)\n"
+    "  --dir DIR      Directory for the scratch databases (default .)\n"
+    "  -h, --help     Show this help\n";
+
+struct Timing
+{
+    const char *mode;
+    int         rows = 0;
+    double      seconds = 0.0;
+};
+
+HistoryRecord sampleRecord(int i)
+{
+    HistoryRecord record;
+    record.name      = QString("photo_%1.png").arg(i);
+    record.operation = "Compress";
+    record.dataType  = "File";
+    record.filePath  = QString("C:/Users/demo/Pictures/photo_%1.png").arg(i);
+    record.hasStats  = true;
+    record.stats.inputBytes  = 400000 + (i % 1000) * 37;
+    record.stats.outputBytes = record.stats.inputBytes * 2 / 3;
+    record.stats.blocks      = 1;
+    record.stats.wallSeconds = 0.05;
+    record.stats.cpuSeconds  = 0.05;
+    record.stats.peakRssKB   = 20000;
+    record.stats.level       = 2;
+    return record;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Create an empty, migrated database at path
+bool createDatabase(const QString &path)
+{
+    QFile::remove(path);
+    QFile::remove(path + "-wal");
+    QFile::remove(path + "-shm");
+    HistoryStore store;
+    if (!store.open(path, "historybench-setup")) {
+        std::cerr << "arithma_historybench: " << store.errorString().toStdString() << "\n";
+        return false;
+    }
+    return true;
+}
+
+// The pre-HistoryStore insert: default journaling, a fresh statement and
+// an implicit transaction (one fsync or more) for every row
+bool runLegacy(const QString &path, int rows, Timing &timing)
+{
+    if (!createDatabase(path)) return false;
+    bool ok = true;
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", "historybench-legacy");
+        db.setDatabaseName(path);
+        ok = db.open();
+        QSqlQuery setup(db);
+        ok = ok && setup.exec("PRAGMA journal_mode = DELETE") && setup.exec("PRAGMA synchronous = FULL");
+
+        const auto started = std::chrono::steady_clock::now();
+        for (int i = 0; ok && i < rows; ++i) {
+            const HistoryRecord record = sampleRecord(i);
+            QSqlQuery query(db);
+            query.prepare("INSERT INTO file_history ("
+                          "name, operation, data_type, file_path, text_content"
+                          ") VALUES ("
+                          ":name, :operation, :data_type, :file_path, :text_content)");
+            query.bindValue(":name", record.name);
+            query.bindValue(":operation", record.operation);
+            query.bindValue(":data_type", record.dataType);
+            query.bindValue(":file_path", record.filePath);
+            query.bindValue(":text_content", QString());
+            ok = query.exec();
+            if (!ok) std::cerr << "arithma_historybench: " << query.lastError().text().toStdString() << "\n";
+        }
+        timing.seconds = secondsSince(started);
+        db.close();
+    }
+    QSqlDatabase::removeDatabase("historybench-legacy");
+    timing.rows = rows;
+    return ok;
+}
+
+// HistoryStore with batch rows per transaction; 1 means autocommit
+bool runStore(const QString &path, int rows, int batch, Timing &timing)
+{
+    if (!createDatabase(path)) return false;
+    HistoryStore store;
+    if (!store.open(path, "historybench-store")) {
+        std::cerr << "arithma_historybench: " << store.errorString().toStdString() << "\n";
+        return false;
+    }
+
+    bool ok = true;
+    const auto started = std::chrono::steady_clock::now();
+    for (int i = 0; ok && i < rows; ++i) {
+        if (batch > 1 && i % batch == 0) ok = store.beginBatch();
+        ok = ok && store.insert(sampleRecord(i));
+        if (ok && batch > 1 && (i % batch == batch - 1 || i == rows - 1)) ok = store.commitBatch();
+    }
+    timing.seconds = secondsSince(started);
+    timing.rows = rows;
+    if (!ok) std::cerr << "arithma_historybench: " << store.errorString().toStdString() << "\n";
+    return ok;
+}
+
+// HistoryWriter as the GUI uses it: the caller only queues, and the time
+// it spends doing so is what a finished job waits on
+bool runWriter(const QString &path, int rows, Timing &timing, double &queueSeconds)
+{
+    if (!createDatabase(path)) return false;
+    HistoryWriter writer;
+    if (!writer.startWriting(path)) {
+        std::cerr << "arithma_historybench: " << writer.errorString().toStdString() << "\n";
+        return false;
+    }
+
+    bool ok = true;
+    const auto started = std::chrono::steady_clock::now();
+    for (int i = 0; ok && i < rows; ++i) ok = writer.insert(sampleRecord(i));
+    queueSeconds = secondsSince(started);
+    writer.stopWriting();   // returns once every row is committed
+    timing.seconds = secondsSince(started);
+    timing.rows = rows;
+    if (!ok) std::cerr << "arithma_historybench: " << writer.errorString().toStdString() << "\n";
+    return ok;
+}
+
+bool parseCount(const char *text, int &value)
+{
+    char *end = nullptr;
+    const long parsed = std::strtol(text, &end, 10);
+    value = static_cast<int>(parsed);
+    return end != text && *end == '\0' && parsed >= 1 && parsed <= 100000000;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);   // Qt loads the SQLite driver as a plugin
+    int rows = 5000, batch = 1000;
+    QString dir = ".";
+
+    // 1) Arguments
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        bool ok = true;
+        if (arg == "-h" || arg == "--help") {
+            std::cout << kUsage;
+            return 0;
+        } else if (arg == "--rows") {
+            ok = hasValue && parseCount(argv[++i], rows);
+        } else if (arg == "--batch") {
+            ok = hasValue && parseCount(argv[++i], batch);
+        } else if (arg == "--dir" && hasValue) {
+            dir = QString::fromLocal8Bit(argv[++i]);
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            std::cerr << "arithma_historybench: bad argument " << arg << "\n\n" << kUsage;
+            return 2;
+        }
+    }
+
+    // 2) Runs
+    const QString path = QDir(dir).filePath("arithma_historybench.db");
+    Timing timings[4];
+    timings[0].mode = "legacy";
+    timings[1].mode = "wal";
+    timings[2].mode = "wal+batch";
+    timings[3].mode = "writer";
+    double queueSeconds = 0.0;
+    const bool ok = runLegacy(path, rows, timings[0])
+                    && runStore(path, rows, 1, timings[1])
+                    && runStore(path, rows, batch, timings[2])
+                    && runWriter(path, rows, timings[3], queueSeconds);
+    QFile::remove(path);
+    QFile::remove(path + "-wal");
+    QFile::remove(path + "-shm");
+    if (!ok) return 1;
+
+    // 3) Report
+    std::printf("%-10s %10s %10s %14s %9s\n", "mode", "rows", "seconds", "rows/s", "speedup");
+    const double legacyRate = timings[0].seconds > 0 ? timings[0].rows / timings[0].seconds : 0.0;
+    for (const Timing &t : timings) {
+        const double rate = t.seconds > 0 ? t.rows / t.seconds : 0.0;
+        std::printf("%-10s %10d %10.3f %14.0f %8.1fx\n", t.mode, t.rows, t.seconds, rate,
+                    legacyRate > 0 ? rate / legacyRate : 0.0);
+    }
+    std::printf("batch size %d; writer callers waited %.2f us per row\n", batch,
+                rows > 0 ? queueSeconds * 1e6 / rows : 0.0);
+    return 0;
+}
@@ -0,0 +1,156 @@
+#include "huffman.h"
+
+#include <algorithm>
+#include <array>
+#include <queue>
+
+namespace {
+
+const int kMaxCodeLength = 15;
+
+// Code lengths from symbol counts; rescales counts until no code is too long
+std::array<uint8_t, 256> buildLengths(const std::array<uint64_t, 256> &counts)
+{
+    std::array<uint8_t, 256> lengths{};
+    std::array<uint64_t, 256> scaled = counts;
+
+    for (;;) {
+        struct Node { uint64_t weight; int left; int right; };
+        std::vector<Node> nodes;
+        using Entry = std::pair<uint64_t, int>;
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> heap;
+
+        for (int s = 0; s < 256; ++s) {
+            if (scaled[s] > 0) {
+                nodes.push_back({scaled[s], -1 - s, 0});
+                heap.push({scaled[s], static_cast<int>(nodes.size()) - 1});
+            }
+        }
+        if (nodes.empty()) return lengths;
+        if (nodes.size() == 1) {
+            lengths[-1 - nodes[0].left] = 1;
+            return lengths;
+        }
+
+        while (heap.size() > 1) {
+            const Entry a = heap.top(); heap.pop();
+            const Entry b = heap.top(); heap.pop();
+            nodes.push_back({a.first + b.first, a.second, b.second});
+            heap.push({a.first + b.first, static_cast<int>(nodes.size()) - 1});
+        }
+
+        // Walk the tree to assign depths
+        lengths.fill(0);
+        int deepest = 0;
+        std::vector<std::pair<int, int>> stack = {{heap.top().second, 0}};
+        while (!stack.empty()) {
+            const std::pair<int, int> item = stack.back();
+            stack.pop_back();
+            const Node &node = nodes[item.first];
+            if (node.left < 0) {
+                lengths[-1 - node.left] = static_cast<uint8_t>(item.second);
+                deepest = std::max(deepest, item.second);
+            } else {
+                stack.push_back({node.left, item.second + 1});
+                stack.push_back({node.right, item.second + 1});
+            }
+        }
+        if (deepest <= kMaxCodeLength) return lengths;
+
+        // Flatten the distribution and try again
+        for (uint64_t &c : scaled) {
+            if (c > 0) c = (c >> 1) | 1;
+        }
+    }
+}
+
+// Canonical codes: shorter first, then by symbol value
+std::array<uint32_t, 256> assignCodes(const std::array<uint8_t, 256> &lengths)
+{
+    std::array<uint32_t, 256> codes{};
+    uint32_t code = 0;
+    for (int len = 1; len <= kMaxCodeLength; ++len) {
+        for (int s = 0; s < 256; ++s) {
+            if (lengths[s] == len) codes[s] = code++;
+        }
+        code <<= 1;
+    }
+    return codes;
+}
+
+}
+
+void huffmanCompress(const uint8_t *data, size_t size, std::vector<uint8_t> &out)
+{
+    std::array<uint64_t, 256> counts{};
+    for (size_t i = 0; i < size; ++i) counts[data[i]]++;
+
+    const std::array<uint8_t, 256> lengths = buildLengths(counts);
+    const std::array<uint32_t, 256> codes = assignCodes(lengths);
+
+    for (int i = 0; i < 8; ++i) out.push_back(static_cast<uint8_t>(uint64_t(size) >> (8 * i)));
+    out.insert(out.end(), lengths.begin(), lengths.end());
+
+    uint64_t bits = 0;
+    int count = 0;
+    for (size_t i = 0; i < size; ++i) {
+        bits = (bits << lengths[data[i]]) | codes[data[i]];
+        count += lengths[data[i]];
+        while (count >= 8) {
+            count -= 8;
+            out.push_back(static_cast<uint8_t>(bits >> count));
+        }
+    }
+    if (count > 0) out.push_back(static_cast<uint8_t>(bits << (8 - count)));
+}
+
+bool huffmanDecompress(const uint8_t *data, size_t size, std::vector<uint8_t> &out)
+{
+    if (size < 8 + 256) return false;
+    uint64_t original = 0;
+    for (int i = 0; i < 8; ++i) original |= uint64_t(data[i]) << (8 * i);
+
+    std::array<uint8_t, 256> lengths;
+    std::copy(data + 8, data + 8 + 256, lengths.begin());
+
+    // Per length: first canonical code, count, and offset into the symbol list
+    std::array<uint32_t, kMaxCodeLength + 2> firstCode{};
+    std::array<uint32_t, kMaxCodeLength + 2> lengthCount{};
+    std::array<uint32_t, kMaxCodeLength + 2> firstIndex{};
+    std::vector<uint8_t> symbols;
+    for (int len = 1; len <= kMaxCodeLength; ++len) {
+        firstIndex[len] = static_cast<uint32_t>(symbols.size());
+        for (int s = 0; s < 256; ++s) {
+            if (lengths[s] > kMaxCodeLength) return false;
+            if (lengths[s] == len) symbols.push_back(static_cast<uint8_t>(s));
+        }
+        lengthCount[len] = static_cast<uint32_t>(symbols.size()) - firstIndex[len];
+    }
+    uint32_t code = 0;
+    for (int len = 1; len <= kMaxCodeLength; ++len) {
+        firstCode[len] = code;
+        code = (code + lengthCount[len]) << 1;
+    }
+
+    out.clear();
+    out.reserve(original);
+    size_t position = 8 + 256;
+    int bitIndex = 8;
+    uint8_t current = 0;
+    while (out.size() < original) {
+        uint32_t value = 0;
+        int len = 0;
+        for (;;) {
+            if (bitIndex == 8) {
+                if (position >= size) return false;
+                current = data[position++];
+                bitIndex = 0;
+            }
+            value = (value << 1) | ((current >> (7 - bitIndex++)) & 1);
+            if (++len > kMaxCodeLength) return false;
+            if (value - firstCode[len] < lengthCount[len]) break;
+        }
+        out.push_back(symbols[firstIndex[len] + (value - firstCode[len])]);
+    }
+    return true;
+}
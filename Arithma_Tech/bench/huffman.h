@@ -0,0 +1,21 @@
+#ifndef HUFFMAN_H
+#define HUFFMAN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Canonical Huffman coder used as the benchmark baseline (non-functional
+ * requirement 1). Static per buffer: a 256-byte table of code lengths
+ * (limited to 15 bits) followed by the MSB-first bitstream.
+ *
+ *   u64 original size | 256 x u8 code length | bits
+ */
+
+void huffmanCompress(const uint8_t *data, size_t size, std::vector<uint8_t> &out);
+
+// False if the input is not a well-formed Huffman stream
+bool huffmanDecompress(const uint8_t *data, size_t size, std::vector<uint8_t> &out);
+
+#endif // HUFFMAN_H
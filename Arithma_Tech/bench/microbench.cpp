@@ -0,0 +1,470 @@
+// arithma_microbench: per-stage timings for the coder and model primitives,
+// in nanoseconds per symbol, bit or byte. Each stage is timed warm (state
+// already cached, long run) and cold (caches flushed before short bursts),
+// which is the pair of numbers an optimisation has to move.
+
+#include "adaptivemodel.h"
+#include "arithmeticcoder.h"
+#include "binarycoder.h"
+#include "blockcodec.h"
+#include "codecengine.h"
+#include "codecsession.h"
+#include "corpus.h"
+#include "mixingmodel.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char *const kUsage =
+    "Usage: arithma_microbench [options]\n"
+    "\n"
+    "Options:\n"
+    "  --filter TEXT      Only run stages whose name contains TEXT\n"
+    "  --ops N            Operations per warm measurement (default 1048576)\n"
+    "  --cold-bursts N    Cache-flushed bursts per cold measurement (default 64)\n"
+    "  --burst N          Operations per cold burst (default 256)\n"
+    "  --evict-mb N       Bytes written to flush the caches, in MiB (default 32)\n"
+    "  -h, --help         Show this help\n";
+
+// Folded into the output so the optimiser cannot drop the measured work
+volatile uint64_t sink;
+
+/**
+ * @brief Stage
+ *        One measured primitive. run(count) performs count operations,
+ *        carrying on from where the previous call stopped and wrapping
+ *        its input when it runs out.
+ */
+struct Stage
+{
+    std::string name;
+    const char *unit;
+    std::function<void(size_t count)> run;
+};
+
+struct Timing
+{
+    double warm = 0.0;
+    double cold = 0.0;
+};
+
+double nanosecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Write a buffer larger than the last-level cache so stage state is evicted
+void evictCaches(std::vector<uint8_t> &scratch)
+{
+    for (size_t i = 0; i < scratch.size(); i += 64) scratch[i]++;
+    sink = sink + scratch[scratch.size() / 2];
+}
+
+Timing measure(const Stage &stage, size_t ops, size_t bursts, size_t burst, std::vector<uint8_t> &scratch)
+{
+    // An untimed run of the same length warms the caches and lets stages that
+    // prepare input per length do so outside the measurement
+    Timing timing;
+    stage.run(ops);
+    auto start = std::chrono::steady_clock::now();
+    stage.run(ops);
+    timing.warm = nanosecondsSince(start) / ops;
+
+    stage.run(burst);
+    double total = 0.0;
+    for (size_t i = 0; i < bursts; ++i) {
+        evictCaches(scratch);
+        start = std::chrono::steady_clock::now();
+        stage.run(burst);
+        total += nanosecondsSince(start);
+    }
+    timing.cold = total / (bursts * burst);
+    return timing;
+}
+
+// 1) Inputs shared by the stages
+const size_t kInputSize = 1 << 20;
+
+const std::vector<uint8_t> &textInput()
+{
+    static const std::vector<uint8_t> text = generateText(kInputSize, 7);
+    return text;
+}
+
+// Bits of the text input, most significant first, with a varied probability for each
+struct BitInput
+{
+    std::vector<uint8_t>  bits;
+    std::vector<uint16_t> probabilities;
+};
+
+const BitInput &bitInput()
+{
+    static const BitInput input = [] {
+        BitInput in;
+        uint32_t state = 12345;
+        for (size_t i = 0; i < kInputSize / 8; ++i) {
+            for (int k = 7; k >= 0; --k) {
+                in.bits.push_back((textInput()[i] >> k) & 1);
+                state = state * 1664525u + 1013904223u;
+                in.probabilities.push_back(static_cast<uint16_t>(1 + (state >> 20) % 4094));
+            }
+        }
+        return in;
+    }();
+    return input;
+}
+
+// 2) Stages
+void addCoderStages(std::vector<Stage> &stages)
+{
+    const std::vector<uint8_t> &text = textInput();
+
+    // Static intervals keep the model out of the figure. A 99% symbol almost
+    // never shifts; a uniform byte always shifts 8 bits, so the difference
+    // divided by 8 is the cost of one renormalisation step.
+    struct AcEncodeState
+    {
+        std::vector<uint8_t> out;
+        std::unique_ptr<ArithmeticEncoder> encoder;
+        size_t position = 0;
+    };
+    for (bool uniform : {false, true}) {
+        auto state = std::make_shared<AcEncodeState>();
+        stages.push_back({uniform ? "ac encode, uniform byte" : "ac encode, p=0.99", "symbol",
+                          [state, uniform, &text](size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                if (!state->encoder || state->position == text.size()) {
+                    state->out.clear();
+                    state->encoder.reset(new ArithmeticEncoder(state->out));
+                    state->position = 0;
+                }
+                const uint32_t b = text[state->position++];
+                if (uniform) state->encoder->encode(b * 256, b * 256 + 256, 65536);
+                else state->encoder->encode(0, 64880, 65536);
+            }
+            sink = sink + state->out.size();
+        }});
+    }
+
+    struct AcDecodeState
+    {
+        std::vector<uint8_t> coded;
+        std::unique_ptr<ArithmeticDecoder> decoder;
+        size_t position = 0;
+    };
+    auto acDecode = std::make_shared<AcDecodeState>();
+    {
+        ArithmeticEncoder encoder(acDecode->coded);
+        for (uint8_t b : text) encoder.encode(b * 256, b * 256 + 256, 65536);
+        encoder.finish();
+    }
+    stages.push_back({"ac decode, uniform byte", "symbol", [acDecode, &text](size_t count) {
+        uint64_t sum = 0;
+        for (size_t i = 0; i < count; ++i) {
+            if (!acDecode->decoder || acDecode->position == text.size()) {
+                acDecode->decoder.reset(new ArithmeticDecoder(acDecode->coded.data(), acDecode->coded.size()));
+                acDecode->position = 0;
+            }
+            const uint32_t b = acDecode->decoder->decodeTarget(65536) / 256;
+            acDecode->decoder->consume(b * 256, b * 256 + 256, 65536);
+            acDecode->position++;
+            sum += b;
+        }
+        sink = sink + sum;
+    }});
+
+    const BitInput &bits = bitInput();
+    struct BcEncodeState
+    {
+        std::vector<uint8_t> out;
+        std::unique_ptr<BinaryEncoder> encoder;
+        size_t position = 0;
+    };
+    auto bcEncode = std::make_shared<BcEncodeState>();
+    stages.push_back({"bc encode", "bit", [bcEncode, &bits](size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            if (!bcEncode->encoder || bcEncode->position == bits.bits.size()) {
+                bcEncode->out.clear();
+                bcEncode->encoder.reset(new BinaryEncoder(bcEncode->out));
+                bcEncode->position = 0;
+            }
+            const size_t k = bcEncode->position++;
+            bcEncode->encoder->encode(bits.bits[k], bits.probabilities[k]);
+        }
+        sink = sink + bcEncode->out.size();
+    }});
+
+    struct BcDecodeState
+    {
+        std::vector<uint8_t> coded;
+        std::unique_ptr<BinaryDecoder> decoder;
+        size_t position = 0;
+    };
+    auto bcDecode = std::make_shared<BcDecodeState>();
+    {
+        BinaryEncoder encoder(bcDecode->coded);
+        for (size_t k = 0; k < bits.bits.size(); ++k) encoder.encode(bits.bits[k], bits.probabilities[k]);
+        encoder.finish();
+    }
+    stages.push_back({"bc decode", "bit", [bcDecode, &bits](size_t count) {
+        uint64_t sum = 0;
+        for (size_t i = 0; i < count; ++i) {
+            if (!bcDecode->decoder || bcDecode->position == bits.bits.size()) {
+                bcDecode->decoder.reset(new BinaryDecoder(bcDecode->coded.data(), bcDecode->coded.size()));
+                bcDecode->position = 0;
+            }
+            sum += bcDecode->decoder->decode(bits.probabilities[bcDecode->position++]);
+        }
+        sink = sink + sum;
+    }});
+}
+
+void addModelStages(std::vector<Stage> &stages)
+{
+    const std::vector<uint8_t> &text = textInput();
+
+    auto order0 = std::make_shared<AdaptiveModel>();
+    auto cursor = std::make_shared<size_t>(0);
+    stages.push_back({"order-0 lookup (symbolRange)", "symbol", [order0, cursor, &text](size_t count) {
+        uint64_t sum = 0;
+        uint32_t low, high;
+        for (size_t i = 0; i < count; ++i) {
+            order0->symbolRange(text[(*cursor)++ % text.size()], low, high);
+            sum += low;
+        }
+        sink = sink + sum;
+    }});
+    stages.push_back({"order-0 lookup (findSymbol)", "symbol", [order0, cursor](size_t count) {
+        uint64_t sum = 0;
+        uint32_t low, high;
+        const uint32_t total = order0->total();
+        for (size_t i = 0; i < count; ++i) {
+            sum += order0->findSymbol(static_cast<uint32_t>((*cursor)++ * 2654435761u) % total, low, high);
+        }
+        sink = sink + sum;
+    }});
+    stages.push_back({"order-0 update", "symbol", [order0, cursor, &text](size_t count) {
+        for (size_t i = 0; i < count; ++i) order0->update(text[(*cursor)++ % text.size()]);
+        sink = sink + order0->total();
+    }});
+
+    for (int order : {1, 2}) {
+        auto model = std::make_shared<ContextModel>(order);
+        stages.push_back({"order-" + std::to_string(order) + " context lookup+update", "symbol",
+                          [model, cursor, &text](size_t count) {
+            uint64_t sum = 0;
+            uint32_t low, high;
+            for (size_t i = 0; i < count; ++i) {
+                const uint8_t b = text[(*cursor)++ % text.size()];
+                AdaptiveModel &current = model->current();
+                current.symbolRange(b, low, high);
+                current.update(b);
+                model->push(b);
+                sum += low;
+            }
+            sink = sink + sum;
+        }});
+    }
+
+    // Eight stretched inputs, one weight set chosen per bit as the predictor does
+    const BitInput &bits = bitInput();
+    auto mixer = std::make_shared<Mixer>(8, 256);
+    stages.push_back({"mixer dot product (8 inputs) + train", "bit", [mixer, cursor, &bits](size_t count) {
+        uint64_t sum = 0;
+        for (size_t i = 0; i < count; ++i) {
+            const size_t k = (*cursor)++ % bits.bits.size();
+            for (int j = 0; j < 8; ++j) mixer->add(stretch(bits.probabilities[(k + j * 977) % bits.bits.size()]));
+            sum += mixer->mix(static_cast<int>(k & 255));
+            mixer->update(bits.bits[k]);
+        }
+        sink = sink + sum;
+    }});
+
+    for (int level = CodecEngine::kMinLevel; level <= CodecEngine::kMaxLevel; ++level) {
+        auto predictor = std::make_shared<MixingPredictor>(level, kInputSize);
+        stages.push_back({"mixing predictor L" + std::to_string(level) + " predict+update", "bit",
+                          [predictor, cursor, &bits](size_t count) {
+            uint64_t sum = 0;
+            for (size_t i = 0; i < count; ++i) {
+                sum += predictor->predict();
+                predictor->update(bits.bits[(*cursor)++ % bits.bits.size()]);
+            }
+            sink = sink + sum;
+        }});
+    }
+}
+
+// Whole blocks through each backend and the container I/O paths, per byte
+void addBlockStages(std::vector<Stage> &stages)
+{
+    const std::vector<uint8_t> &text = textInput();
+    const size_t blockSize = 64 * 1024;
+
+    for (Backend backend : {Backend::Arithmetic, Backend::Binary}) {
+        const std::string name = backendName(backend);
+        auto encodeCursor = std::make_shared<size_t>(0);
+        stages.push_back({name + " block encode, level 2", "byte",
+                          [backend, encodeCursor, &text, blockSize](size_t count) {
+            std::vector<uint8_t> out;
+            while (count > 0) {
+                const size_t n = std::min(count, blockSize);
+                const size_t offset = (*encodeCursor)++ % (text.size() / blockSize) * blockSize;
+                out.clear();
+                encodeBlock(backend, 2, Primer(), text.data() + offset, n, out);
+                count -= n;
+            }
+            sink = sink + out.size();
+        }});
+
+        // Payloads are made once per block length, on the untimed first call
+        auto payloads = std::make_shared<std::map<size_t, std::vector<uint8_t>>>();
+        stages.push_back({name + " block decode, level 2", "byte",
+                          [backend, payloads, &text, blockSize](size_t count) {
+            std::vector<uint8_t> out(blockSize);
+            while (count > 0) {
+                const size_t n = std::min(count, blockSize);
+                std::vector<uint8_t> &payload = (*payloads)[n];
+                if (payload.empty()) encodeBlock(backend, 2, Primer(), text.data(), n, payload);
+                decodeBlock(backend, 2, Primer(), payload.data(), payload.size(), out.data(), n);
+                count -= n;
+            }
+            sink = sink + out[0];
+        }});
+    }
+
+    // Encoder output path: one byte at a time into a growing buffer
+    auto output = std::make_shared<std::vector<uint8_t>>();
+    stages.push_back({"output buffer push_back", "byte", [output](size_t count) {
+        if (output->size() > kInputSize) output->clear();
+        for (size_t i = 0; i < count; ++i) output->push_back(static_cast<uint8_t>(i));
+        sink = sink + output->size();
+    }});
+
+    // Container framing and sink delivery with no entropy coding: random
+    // data is stored, so decoding it is parsing plus copying
+    auto containers = std::make_shared<std::map<size_t, std::vector<uint8_t>>>();
+    auto storedContainer = [containers, blockSize](size_t size) -> const std::vector<uint8_t> & {
+        std::vector<uint8_t> &container = (*containers)[size];
+        if (container.empty()) {
+            std::vector<uint8_t> noise(size);
+            uint32_t state = 99;
+            for (uint8_t &b : noise) {
+                state = state * 1664525u + 1013904223u;
+                b = static_cast<uint8_t>(state >> 24);
+            }
+            CodecOptions options;
+            options.level = 1;
+            options.threads = 1;
+            options.blockSize = static_cast<uint32_t>(blockSize);
+            CodecEngine(options).compress(noise, container);
+        }
+        return container;
+    };
+    for (size_t chunk : {size_t(4096), size_t(65536)}) {
+        stages.push_back({"session decode stored, " + std::to_string(chunk / 1024) + "K chunks", "byte",
+                          [storedContainer, chunk](size_t count) {
+            const std::vector<uint8_t> &stored = storedContainer(std::min(count, kInputSize));
+            uint64_t delivered = 0;
+            while (delivered < count) {
+                DecompressionSession session(1, [&](const uint8_t *, size_t size) {
+                    delivered += size;
+                    return true;
+                });
+                for (size_t pos = 0; pos < stored.size(); pos += chunk) {
+                    session.update(stored.data() + pos, std::min(chunk, stored.size() - pos));
+                }
+                session.finish();
+            }
+            sink = sink + delivered;
+        }});
+    }
+    stages.push_back({"stream decompress stored (istream)", "byte", [storedContainer](size_t count) {
+        const std::vector<uint8_t> &stored = storedContainer(std::min(count, kInputSize));
+        CodecOptions options;
+        options.threads = 1;
+        CodecEngine engine(options);
+        uint64_t delivered = 0;
+        while (delivered < count) {
+            std::istringstream in(std::string(stored.begin(), stored.end()));
+            std::ostringstream out;
+            engine.decompressStream(in, out);
+            delivered += engine.stats().outputBytes;
+        }
+        sink = sink + delivered;
+    }});
+}
+
+bool parseCount(const char *text, size_t &value)
+{
+    char *end = nullptr;
+    const unsigned long long parsed = std::strtoull(text, &end, 10);
+    value = static_cast<size_t>(parsed);
+    return end != text && *end == '\0' && parsed > 0;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    std::string filter;
+    size_t ops = 1 << 20, bursts = 64, burst = 256, evictMB = 32;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        bool ok = true;
+        if (arg == "-h" || arg == "--help") {
+            std::cout << kUsage;
+            return 0;
+        } else if (arg == "--filter" && hasValue) {
+            filter = argv[++i];
+        } else if (arg == "--ops" && hasValue) {
+            ok = parseCount(argv[++i], ops);
+        } else if (arg == "--cold-bursts" && hasValue) {
+            ok = parseCount(argv[++i], bursts);
+        } else if (arg == "--burst" && hasValue) {
+            ok = parseCount(argv[++i], burst);
+        } else if (arg == "--evict-mb" && hasValue) {
+            ok = parseCount(argv[++i], evictMB);
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            std::cerr << "arithma_microbench: bad argument " << arg << "\n\n" << kUsage;
+            return 2;
+        }
+    }
+
+    std::vector<Stage> stages;
+    addCoderStages(stages);
+    addModelStages(stages);
+    addBlockStages(stages);
+
+    std::vector<uint8_t> scratch(evictMB * 1024 * 1024);
+    std::printf("%-40s %-7s %12s %12s\n", "stage", "per", "warm ns", "cold ns");
+    double skewed = 0.0, uniform = 0.0;
+    for (const Stage &stage : stages) {
+        if (!filter.empty() && stage.name.find(filter) == std::string::npos) continue;
+        const Timing timing = measure(stage, ops, bursts, burst, scratch);
+        std::printf("%-40s %-7s %12.2f %12.2f\n", stage.name.c_str(), stage.unit, timing.warm, timing.cold);
+        if (stage.name == "ac encode, p=0.99") skewed = timing.warm;
+        if (stage.name == "ac encode, uniform byte") uniform = timing.warm;
+    }
+    if (skewed > 0 && uniform > 0) {
+        std::printf("%-40s %-7s %12.2f %12s\n", "ac renormalisation (derived)", "shift",
+                    (uniform - skewed) / 8, "-");
+    }
+    return 0;
+}
@@ -0,0 +1,319 @@
+// arithma_primetrain: builds the per-type primers (see primer.h) and writes
+// them as a primerset<N>.inc for primer.cpp, or measures what the
+// compiled-in set gains on small files. Files come from corpus.h's
+// generators, so a shipped set is reproducible from the tree and holds
+// nothing the project does not own; --corpus points at local files
+// instead, one subdirectory per type: text, bmp, png, jpeg, gif.
+
+#include "blockcodec.h"
+#include "codecengine.h"
+#include "corpus.h"
+#include "primer.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char *const kUsage =
+    "Usage: arithma_primetrain [options]\n"
+    "\n"
+    "Options:\n"
+    "  --corpus DIR    Use local files, one subdirectory per type\n"
+    "                  (text, bmp, png, jpeg, gif), instead of the\n"
+    "                  generated ones shipped sets are trained on\n"
+    "  --out PATH      Write the trained set to PATH (default primerset.inc)\n"
+    "  --set N         Set number the arrays are named after (default 1)\n"
+    "  --measure       Compare the compiled-in set against unprimed coding\n"
+    "                  instead of training\n"
+    "  -h, --help      Show this help\n";
+
+// Priming pays off on small inputs; larger ones soon learn the same
+const size_t kSmallInput = 64 * 1024;
+
+// Generated files per type; each one's size and content follow its index
+const uint32_t kGeneratedFiles = 64;
+
+// Candidate shapes: the first headBytes of each training file, appended
+// until the primer reaches budget bytes
+const size_t kHeadBytes[] = {64, 256, 1024, 4096};
+const size_t kBudgets[]   = {1024, 2048, 4096, 8192, 16384};
+
+struct TypeDir
+{
+    const char *directory;
+    FileType    type;
+    const char *enumerator;   // as spelled in the generated source
+};
+
+const TypeDir kTypes[] = {
+    {"text", FileType::Text, "Text"},
+    {"bmp",  FileType::Bmp,  "Bmp"},
+    {"png",  FileType::Png,  "Png"},
+    {"jpeg", FileType::Jpeg, "Jpeg"},
+    {"gif",  FileType::Gif,  "Gif"},
+};
+
+// Files are dealt round-robin: two of every four train, the third picks
+// the candidate, the fourth is only used to report the gain
+struct Split
+{
+    std::vector<CorpusFile> train;
+    std::vector<CorpusFile> validate;
+    std::vector<CorpusFile> test;
+};
+
+// Small files of dir's type in a spread of sizes, from corpus.h's generators
+std::vector<CorpusFile> generateType(const TypeDir &dir)
+{
+    std::vector<CorpusFile> files;
+    for (uint32_t i = 0; i < kGeneratedFiles; ++i) {
+        const uint32_t seed = 1000 + i;
+        const int side = 16 + static_cast<int>(i * 37 % 176);
+        CorpusFile file;
+        file.name = std::string(dir.directory) + "_" + std::to_string(i);
+        switch (dir.type) {
+        case FileType::Text:
+            file.data = generateText(512 + i * 1657 % 30000, seed);
+            break;
+        case FileType::Bmp:
+            file.data = generateBmp(side, side * 3 / 4, i % 2 ? 8 : 24, seed);
+            break;
+        case FileType::Png:
+            file.data = generatePng(side, side * 3 / 4, seed);
+            break;
+        case FileType::Jpeg:
+            file.data = generateJpeg(side * 2, side * 3 / 2, 60 + static_cast<int>(i * 7 % 36), seed);
+            break;
+        case FileType::Gif:
+            file.data = generateGif(side / 2, side / 2, 2 + static_cast<int>(i % 6), seed);
+            break;
+        default:
+            break;
+        }
+        files.push_back(std::move(file));
+    }
+    return files;
+}
+
+// An empty corpusDir means generated files
+bool loadType(const std::string &corpusDir, const TypeDir &dir, Split &split)
+{
+    std::vector<CorpusFile> files;
+    if (corpusDir.empty()) {
+        files = generateType(dir);
+    } else if (!loadCorpus(corpusDir + "/" + dir.directory, files)) {
+        return false;
+    }
+    for (size_t i = 0; i < files.size(); ++i) {
+        files[i].type = dir.type;   // the directory decides, not detection
+        if (i % 4 == 2) {
+            if (files[i].data.size() < kSmallInput) split.validate.push_back(std::move(files[i]));
+        } else if (i % 4 == 3) {
+            if (files[i].data.size() < kSmallInput) split.test.push_back(std::move(files[i]));
+        } else {
+            split.train.push_back(std::move(files[i]));
+        }
+    }
+    return true;
+}
+
+std::vector<uint8_t> buildPrimer(const std::vector<CorpusFile> &train, size_t headBytes, size_t budget)
+{
+    std::vector<uint8_t> primer;
+    for (const CorpusFile &file : train) {
+        if (primer.size() >= budget) break;
+        const size_t n = std::min({headBytes, file.data.size(), budget - primer.size()});
+        primer.insert(primer.end(), file.data.begin(), file.data.begin() + n);
+    }
+    return primer;
+}
+
+// Block payload bytes for every file, coded as one block each
+uint64_t codedSize(const std::vector<CorpusFile> &files, Backend backend, const Primer &primer)
+{
+    uint64_t total = 0;
+    std::vector<uint8_t> out;
+    for (const CorpusFile &file : files) {
+        out.clear();
+        encodeBlock(backend, 2, primer, file.data.data(), file.data.size(), out);
+        total += out.size();
+    }
+    return total;
+}
+
+struct TrainedPrimer
+{
+    const TypeDir *dir;
+    std::vector<uint8_t> data;
+};
+
+bool writeSet(const std::string &path, int set, const std::vector<TrainedPrimer> &primers)
+{
+    std::ofstream out(path);
+    const std::string prefix = "kPrimerSet" + std::to_string(set);
+    out << "// Primer set " << set << ", generated by arithma_primetrain.\n"
+        << "// Do not edit: containers written with this set must keep decoding.\n";
+    for (const TrainedPrimer &entry : primers) {
+        out << "\nconst uint8_t " << prefix << entry.dir->enumerator << "[] = {";
+        for (size_t i = 0; i < entry.data.size(); ++i) {
+            char hex[8];
+            std::snprintf(hex, sizeof hex, "0x%02x,", entry.data[i]);
+            out << (i % 16 == 0 ? "\n    " : " ") << hex;
+        }
+        out << "\n};\n";
+    }
+    out << "\nconst PrimerEntry " << prefix << "[] = {\n";
+    for (const TrainedPrimer &entry : primers) {
+        const std::string name = prefix + entry.dir->enumerator;
+        out << "    {FileType::" << entry.dir->enumerator << ", " << name
+            << ", sizeof(" << name << ")},\n";
+    }
+    out << "};\n";
+    return bool(out);
+}
+
+// 1) Training
+int train(const std::string &corpusDir, const std::string &outPath, int set)
+{
+    std::vector<TrainedPrimer> primers;
+    for (const TypeDir &dir : kTypes) {
+        Split split;
+        if (!loadType(corpusDir, dir, split) || split.train.empty() || split.validate.empty()) {
+            std::cerr << "arithma_primetrain: no usable " << dir.directory << " files\n";
+            return 1;
+        }
+
+        // Both backends must gain, so the two are scored together
+        const uint64_t unprimed = codedSize(split.validate, Backend::Arithmetic, Primer())
+                                  + codedSize(split.validate, Backend::Binary, Primer());
+        uint64_t best = unprimed;
+        std::vector<uint8_t> chosen;
+        for (size_t budget : kBudgets) {
+            for (size_t headBytes : kHeadBytes) {
+                std::vector<uint8_t> candidate = buildPrimer(split.train, headBytes, budget);
+                Primer primer;
+                primer.data = candidate.data();
+                primer.size = candidate.size();
+                const uint64_t size = codedSize(split.validate, Backend::Arithmetic, primer)
+                                      + codedSize(split.validate, Backend::Binary, primer);
+                // A bigger primer has to earn its place
+                if (size < best && (chosen.empty() || candidate.size() <= chosen.size()
+                                    || size + size / 200 < best)) {
+                    best = size;
+                    chosen.swap(candidate);
+                }
+            }
+        }
+        std::printf("%-5s %zu bytes  validation %llu -> %llu bytes\n", dir.directory, chosen.size(),
+                    static_cast<unsigned long long>(unprimed), static_cast<unsigned long long>(best));
+        if (!chosen.empty()) primers.push_back({&dir, std::move(chosen)});
+    }
+
+    if (primers.empty() || !writeSet(outPath, set, primers)) {
+        std::cerr << "arithma_primetrain: cannot write " << outPath << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+// 2) Measurement
+bool containerSize(const CorpusFile &file, Backend backend, bool usePrimers, uint64_t &size)
+{
+    CodecOptions options;
+    options.threads    = 1;
+    options.fileType   = file.type;
+    options.backend    = backend;
+    options.usePrimers = usePrimers;
+    CodecEngine engine(options);
+    std::vector<uint8_t> packed, restored;
+    if (!engine.compress(file.data, packed) || !engine.decompress(packed, restored)
+        || restored != file.data) {
+        return false;
+    }
+    size = packed.size();
+    return true;
+}
+
+int measure(const std::string &corpusDir)
+{
+    std::printf("Primer set %d, held-out files under %zu KB, level 2\n",
+                currentPrimerSet(), kSmallInput / 1024);
+    std::printf("%-5s %5s %10s  %-10s %10s %10s %8s\n",
+                "type", "files", "input", "backend", "unprimed", "primed", "gain");
+    for (const TypeDir &dir : kTypes) {
+        Split split;
+        if (!loadType(corpusDir, dir, split)) {
+            std::cerr << "arithma_primetrain: cannot read " << corpusDir << "/" << dir.directory << "\n";
+            return 1;
+        }
+        uint64_t input = 0;
+        for (const CorpusFile &file : split.test) input += file.data.size();
+
+        for (Backend backend : {Backend::Arithmetic, Backend::Binary}) {
+            uint64_t unprimed = 0, primed = 0;
+            for (const CorpusFile &file : split.test) {
+                uint64_t plain = 0, trained = 0;
+                if (!containerSize(file, backend, false, plain)
+                    || !containerSize(file, backend, true, trained)) {
+                    std::cerr << "arithma_primetrain: round trip failed on " << file.name << "\n";
+                    return 1;
+                }
+                unprimed += plain;
+                primed   += trained;
+            }
+            const double gain = unprimed ? 100.0 * (double(unprimed) - double(primed)) / unprimed : 0.0;
+            std::printf("%-5s %5zu %10llu  %-10s %10llu %10llu %7.1f%%\n", dir.directory,
+                        split.test.size(), static_cast<unsigned long long>(input), backendName(backend),
+                        static_cast<unsigned long long>(unprimed), static_cast<unsigned long long>(primed),
+                        gain);
+        }
+    }
+    return 0;
+}
+
+bool parseNumber(const char *text, double &value)
+{
+    char *end = nullptr;
+    value = std::strtod(text, &end);
+    return end != text && *end == '\0' && value >= 0;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    std::string corpusDir, outPath = "primerset.inc";
+    double set = 1;
+    bool measuring = false;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        bool ok = true;
+        if (arg == "-h" || arg == "--help") {
+            std::cout << kUsage;
+            return 0;
+        } else if (arg == "--corpus" && hasValue) {
+            corpusDir = argv[++i];
+        } else if (arg == "--out" && hasValue) {
+            outPath = argv[++i];
+        } else if (arg == "--set") {
+            ok = hasValue && parseNumber(argv[++i], set) && set >= 1 && set <= 255;
+        } else if (arg == "--measure") {
+            measuring = true;
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            std::cerr << "arithma_primetrain: bad argument " << arg << "\n\n" << kUsage;
+            return 2;
+        }
+    }
+    return measuring ? measure(corpusDir) : train(corpusDir, outPath, static_cast<int>(set));
+}
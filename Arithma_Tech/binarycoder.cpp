@@ -0,0 +1,70 @@
+#include "binarycoder.h"
+
+// 1) BinaryEncoder Implementation
+BinaryEncoder::BinaryEncoder(std::vector<uint8_t> &output)
+    : out(output),
+    x1(0),
+    x2(0xFFFFFFFFu)
+{
+}
+
+void BinaryEncoder::encode(int bit, uint32_t probability)
+{
+    const uint32_t xmid = x1 + ((x2 - x1) >> 12) * probability;
+    if (bit) {
+        x2 = xmid;
+    } else {
+        x1 = xmid + 1;
+    }
+
+    // Shift out leading bytes once both ends agree on them
+    while (((x1 ^ x2) & 0xFF000000u) == 0) {
+        out.push_back(static_cast<uint8_t>(x2 >> 24));
+        x1 <<= 8;
+        x2 = (x2 << 8) | 0xFF;
+    }
+}
+
+void BinaryEncoder::finish()
+{
+    out.push_back(static_cast<uint8_t>(x1 >> 24));
+    out.push_back(0xFF);
+    out.push_back(0xFF);
+    out.push_back(0xFF);
+    x1 = 0;
+    x2 = 0xFFFFFFFFu;
+}
+
+// 2) BinaryDecoder Implementation
+BinaryDecoder::BinaryDecoder(const uint8_t *data, size_t size)
+    : data(data),
+    size(size),
+    position(0),
+    x1(0),
+    x2(0xFFFFFFFFu),
+    x(0)
+{
+    for (int i = 0; i < 4; ++i) {
+        x = (x << 8) | nextByte();
+    }
+}
+
+int BinaryDecoder::decode(uint32_t probability)
+{
+    const uint32_t xmid = x1 + ((x2 - x1) >> 12) * probability;
+    int bit;
+    if (x <= xmid) {
+        bit = 1;
+        x2 = xmid;
+    } else {
+        bit = 0;
+        x1 = xmid + 1;
+    }
+
+    while (((x1 ^ x2) & 0xFF000000u) == 0) {
+        x1 <<= 8;
+        x2 = (x2 << 8) | 0xFF;
+        x  = (x << 8) | nextByte();
+    }
+    return bit;
+}
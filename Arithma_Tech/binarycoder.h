@@ -0,0 +1,52 @@
+#ifndef BINARYCODER_H
+#define BINARYCODER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief BinaryEncoder
+ *        Carry-less binary arithmetic encoder. Each call codes one bit
+ *        with a 12-bit probability that the bit is 1.
+ */
+class BinaryEncoder
+{
+public:
+    explicit BinaryEncoder(std::vector<uint8_t> &output);
+
+    void encode(int bit, uint32_t probability);
+
+    // Flush enough bytes to pin down the final interval; the encoder then
+    // starts a new stream, decoded on its own, after them
+    void finish();
+
+private:
+    std::vector<uint8_t> &out;
+    uint32_t x1;
+    uint32_t x2;
+};
+
+/**
+ * @brief BinaryDecoder
+ *        Mirror of BinaryEncoder; reading past the end yields zero bytes.
+ */
+class BinaryDecoder
+{
+public:
+    BinaryDecoder(const uint8_t *data, size_t size);
+
+    int decode(uint32_t probability);
+
+private:
+    uint8_t nextByte() { return position < size ? data[position++] : 0; }
+
+    const uint8_t *data;
+    size_t         size;
+    size_t         position;
+    uint32_t       x1;
+    uint32_t       x2;
+    uint32_t       x;
+};
+
+#endif // BINARYCODER_H
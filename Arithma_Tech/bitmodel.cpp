@@ -0,0 +1,10 @@
+#include "bitmodel.h"
+
+BitModelTables::BitModelTables()
+{
+    for (int n = 0; n <= kBitModelRateLimit; ++n) rate[n] = static_cast<int>(65536 / (n + 1.5));
+    length[0] = 0;
+    for (int value = 1; value < 2048; ++value) length[value] = static_cast<uint8_t>(length[value >> 1] + 1);
+}
+
+const BitModelTables kBitModelTables;
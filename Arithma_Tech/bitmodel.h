@@ -0,0 +1,108 @@
+#ifndef BITMODEL_H
+#define BITMODEL_H
+
+#include "binarycoder.h"
+
+#include <algorithm>
+#include <cstdint>
+
+/**
+ * @brief BitModel
+ *        Adaptive probability of a 1 for one context: a running average
+ *        whose step shrinks from 1/2 to 1/kBitModelRateLimit as the context
+ *        gets used. The type transforms that code their own data build
+ *        their context models out of these.
+ */
+struct BitModel
+{
+    uint16_t p = 1 << 15;   // 16 bits
+    uint8_t  n = 0;         // updates so far, up to kBitModelRateLimit
+};
+
+constexpr int kBitModelRateLimit = 60;
+
+struct BitModelTables
+{
+    BitModelTables();
+
+    int     rate[kBitModelRateLimit + 1];   // 65536 / (n + 1.5)
+    uint8_t length[2048];                   // bit lengths of small values
+};
+
+extern const BitModelTables kBitModelTables;
+
+inline uint32_t probabilityOf(const BitModel &model)
+{
+    return std::min<uint32_t>(4095, std::max<uint32_t>(1, model.p >> 4));
+}
+
+inline void adapt(BitModel &model, int bit)
+{
+    const int target = bit ? 65535 : 0;
+    model.p = static_cast<uint16_t>(model.p + (((target - model.p) * kBitModelTables.rate[model.n]) >> 16));
+    if (model.n < kBitModelRateLimit) ++model.n;
+}
+
+// Number of bits in value, 0 for 0
+inline int bitLength(uint32_t value)
+{
+    if (value < 2048) return kBitModelTables.length[value];
+    int length = 11;
+    while (value >> length) ++length;
+    return length;
+}
+
+// The two directions behind one interface, so a model is written once as
+// a template: code() takes the bit when encoding and returns the bit
+struct ModelEncoder
+{
+    BinaryEncoder coder;
+
+    int code(int bit, BitModel &model)
+    {
+        coder.encode(bit, probabilityOf(model));
+        adapt(model, bit);
+        return bit;
+    }
+
+    // With a 12-bit probability from elsewhere, such as a Mixer
+    int code(int bit, uint32_t probability)
+    {
+        coder.encode(bit, probability);
+        return bit;
+    }
+};
+
+struct ModelDecoder
+{
+    BinaryDecoder coder;
+
+    int code(int, BitModel &model)
+    {
+        const int bit = coder.decode(probabilityOf(model));
+        adapt(model, bit);
+        return bit;
+    }
+
+    int code(int, uint32_t probability)
+    {
+        return coder.decode(probability);
+    }
+};
+
+// Magnitude >= 1 as its bit length in unary, then the bits below the
+// leading one; value is ignored when decoding
+template <typename Coder>
+int codeMagnitude(Coder &coder, int value, BitModel *exponent, BitModel (*mantissa)[15])
+{
+    const int bits = bitLength(static_cast<uint32_t>(value));
+    int length = 1;
+    while (length < 15 && coder.code(length < bits, exponent[length - 1])) ++length;
+    int result = 1;
+    for (int j = length - 2; j >= 0; --j) {
+        result = result << 1 | coder.code((value >> j) & 1, mantissa[length][j]);
+    }
+    return result;
+}
+
+#endif // BITMODEL_H
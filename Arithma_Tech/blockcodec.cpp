@@ -0,0 +1,222 @@
+#include "blockcodec.h"
+
+#include "adaptivemodel.h"
+#include "arithmeticcoder.h"
+#include "binarycoder.h"
+#include "mixingmodel.h"
+#include "trace.h"
+
+#include <algorithm>
+
+namespace {
+
+// 1) Arithmetic backend: one AdaptiveModel per context, level = order + 1
+int contextOrderForLevel(int level)
+{
+    return std::max(1, std::min(3, level)) - 1;
+}
+
+// Primer counts are divided by 2^this once replayed
+const int kPrimerWeakenShift = 4;
+
+// Learn from the primer as if it had been coded just before the block
+void primeArithmetic(ContextModel &context, const Primer &primer)
+{
+    for (size_t i = 0; i < primer.size; ++i) {
+        context.current().update(primer.data[i]);
+        context.push(primer.data[i]);
+    }
+    // At full strength a few KB of other files outvote the block's own
+    // early statistics; a sixteenth keeps their shape but not their weight
+    context.weaken(kPrimerWeakenShift);
+}
+
+void encodeArithmetic(const uint8_t *data, size_t size, int level, const Primer &primer,
+                      std::vector<uint8_t> &out)
+{
+    TraceScope setup("model", "model setup");
+    ContextModel context(contextOrderForLevel(level));
+    primeArithmetic(context, primer);
+    setup.close();
+    ArithmeticEncoder encoder(out);
+    uint32_t cumLow, cumHigh;
+
+    for (size_t i = 0; i < size; ++i) {
+        AdaptiveModel &model = context.current();
+        model.symbolRange(data[i], cumLow, cumHigh);
+        encoder.encode(cumLow, cumHigh, model.total());
+        model.update(data[i]);
+        context.push(data[i]);
+    }
+
+    AdaptiveModel &model = context.current();
+    model.symbolRange(AdaptiveModel::kEofSymbol, cumLow, cumHigh);
+    encoder.encode(cumLow, cumHigh, model.total());
+    encoder.finish();
+}
+
+bool decodeArithmetic(const uint8_t *payload, size_t size, int level, const Primer &primer,
+                      uint8_t *out, size_t rawSize)
+{
+    TraceScope setup("model", "model setup");
+    ContextModel context(contextOrderForLevel(level));
+    primeArithmetic(context, primer);
+    setup.close();
+    ArithmeticDecoder decoder(payload, size);
+    uint32_t cumLow, cumHigh;
+
+    for (size_t produced = 0; ; ++produced) {
+        AdaptiveModel &model = context.current();
+        const uint32_t total = model.total();
+        const int symbol = model.findSymbol(decoder.decodeTarget(total), cumLow, cumHigh);
+        decoder.consume(cumLow, cumHigh, total);
+
+        if (symbol == AdaptiveModel::kEofSymbol) {
+            return produced == rawSize;
+        }
+        if (produced == rawSize) {
+            return false;
+        }
+        out[produced] = static_cast<uint8_t>(symbol);
+        model.update(symbol);
+        context.push(static_cast<uint8_t>(symbol));
+    }
+}
+
+// 2) Binary backend: each byte is preceded by an adaptive "end of block" bit
+class EndFlag
+{
+public:
+    int probability() const { return std::max(1, p >> 4); }
+    void update(int bit) { p += ((bit << 16) - bit - p) >> 5; }
+
+private:
+    int p = 1 << 11;
+};
+
+// Primer bytes are ordinary (not end) bytes to both models
+void primeBinary(MixingPredictor &predictor, EndFlag &end, const Primer &primer)
+{
+    for (size_t i = 0; i < primer.size; ++i) {
+        end.update(0);
+        for (int b = 7; b >= 0; --b) {
+            predictor.predict();
+            predictor.update((primer.data[i] >> b) & 1);
+        }
+    }
+}
+
+void encodeBinary(const uint8_t *data, size_t size, int level, const Primer &primer,
+                  std::vector<uint8_t> &out)
+{
+    TraceScope setup("model", "model setup");
+    MixingPredictor predictor(level, size + primer.size);
+    EndFlag end;
+    primeBinary(predictor, end, primer);
+    setup.close();
+    BinaryEncoder encoder(out);
+
+    for (size_t i = 0; i < size; ++i) {
+        encoder.encode(0, end.probability());
+        end.update(0);
+        for (int b = 7; b >= 0; --b) {
+            const int bit = (data[i] >> b) & 1;
+            encoder.encode(bit, predictor.predict());
+            predictor.update(bit);
+        }
+    }
+    encoder.encode(1, end.probability());
+    encoder.finish();
+}
+
+bool decodeBinary(const uint8_t *payload, size_t size, int level, const Primer &primer,
+                  uint8_t *out, size_t rawSize)
+{
+    TraceScope setup("model", "model setup");
+    MixingPredictor predictor(level, rawSize + primer.size);
+    EndFlag end;
+    primeBinary(predictor, end, primer);
+    setup.close();
+    BinaryDecoder decoder(payload, size);
+
+    for (size_t produced = 0; ; ++produced) {
+        const int atEnd = decoder.decode(end.probability());
+        end.update(atEnd);
+        if (atEnd) {
+            return produced == rawSize;
+        }
+        if (produced == rawSize) {
+            return false;
+        }
+
+        int byte = 0;
+        for (int b = 0; b < 8; ++b) {
+            const int bit = decoder.decode(predictor.predict());
+            predictor.update(bit);
+            byte = (byte << 1) | bit;
+        }
+        out[produced] = static_cast<uint8_t>(byte);
+    }
+}
+
+}
+
+// 3) Dispatch
+void encodeBlock(Backend backend, int level, const Primer &primer,
+                 const uint8_t *data, size_t size, std::vector<uint8_t> &out)
+{
+    const size_t start = out.size();
+    switch (backend) {
+    case Backend::Binary:
+        encodeBinary(data, size, level, primer, out);
+        break;
+    case Backend::Arithmetic:
+    default:
+        encodeArithmetic(data, size, level, primer, out);
+        break;
+    }
+
+    if (out.size() - start >= size) {
+        out.resize(start);
+        out.insert(out.end(), data, data + size);
+    }
+}
+
+bool decodeBlock(Backend backend, int level, const Primer &primer,
+                 const uint8_t *payload, size_t size, uint8_t *out, size_t rawSize)
+{
+    if (size == rawSize) {
+        std::copy(payload, payload + size, out);
+        return true;
+    }
+
+    switch (backend) {
+    case Backend::Arithmetic:
+        return decodeArithmetic(payload, size, level, primer, out, rawSize);
+    case Backend::Binary:
+        return decodeBinary(payload, size, level, primer, out, rawSize);
+    }
+    return false;
+}
+
+const char *backendName(Backend backend)
+{
+    switch (backend) {
+    case Backend::Arithmetic: return "arithmetic";
+    case Backend::Binary:     return "binary";
+    }
+    return "unknown";
+}
+
+bool backendFromName(const std::string &name, Backend &backend)
+{
+    if (name == "arithmetic" || name == "ac") {
+        backend = Backend::Arithmetic;
+        return true;
+    }
+    if (name == "binary" || name == "cm") {
+        backend = Backend::Binary;
+        return true;
+    }
+    return false;
+}
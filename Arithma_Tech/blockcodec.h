@@ -0,0 +1,36 @@
+#ifndef BLOCKCODEC_H
+#define BLOCKCODEC_H
+
+#include "container.h"
+#include "primer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * Entropy coding of a single block. Every backend ends a block with an
+ * explicit end-of-block mark (requirement 1.1.3), so a decoder that runs out
+ * of symbols early or late reports the block as corrupt.
+ *
+ * A block that would not shrink is stored verbatim instead; a payload the
+ * same size as the raw data always means a stored block.
+ *
+ * Both sides replay the same primer (possibly empty) through the model
+ * before the first byte; it must be the one the container header names.
+ */
+
+// Append the coded form of data to out
+void encodeBlock(Backend backend, int level, const Primer &primer,
+                 const uint8_t *data, size_t size, std::vector<uint8_t> &out);
+
+// Decode exactly rawSize bytes into out; false if the payload is corrupt
+bool decodeBlock(Backend backend, int level, const Primer &primer,
+                 const uint8_t *payload, size_t size, uint8_t *out, size_t rawSize);
+
+// Command-line and display names ("arithmetic", "binary")
+const char *backendName(Backend backend);
+bool backendFromName(const std::string &name, Backend &backend);
+
+#endif // BLOCKCODEC_H
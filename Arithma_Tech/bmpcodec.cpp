@@ -0,0 +1,644 @@
+#include "bmpcodec.h"
+
+#include "blockcodec.h"
+#include "imagemodel.h"
+#include "parallel.h"
+#include "primer.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+// 1) Bytes
+uint32_t get16le(const uint8_t *p)
+{
+    return uint32_t(p[0]) | uint32_t(p[1]) << 8;
+}
+
+uint32_t get32le(const uint8_t *p)
+{
+    return get16le(p) | get16le(p + 2) << 16;
+}
+
+// Whether the varint at p ends before end, or more input is needed
+bool varintComplete(const uint8_t *p, const uint8_t *end)
+{
+    for (; p < end; ++p) {
+        if (!(*p & 0x80)) return true;
+    }
+    return false;
+}
+
+// Headers whose pixel data starts later, and rows longer than this, are
+// passed through
+const size_t kMaxHeader = size_t(1) << 16;
+const uint64_t kMaxRow = uint64_t(1) << 24;
+
+// Smaller images code better as bytes, under the BMP primer
+const uint64_t kMinPixelBytes = 4096;
+
+// Rows per band come to about this many bytes
+const size_t kBandBytes = size_t(1) << 20;
+
+// Bigger images share tables this size, so the model stays at 16 MB
+const size_t kMaxModelBytes = size_t(1) << 19;
+
+// Images of kMinStripedBytes and more are cut into up to kMaxStrips
+// strips of whole pixels at least kMinStripBytes wide, each with its own
+// model, so the strips of a band code in parallel. Their number depends on
+// the image alone. Smaller tables cost more than the strips gain, so each
+// keeps a full model's, and kStripedModelBytes bounds them all: two
+// models keep the transform well under 64 MB.
+const uint64_t kMinStripedBytes = uint64_t(1) << 23;
+const size_t   kMinStripBytes = 1536;
+const size_t   kStripedModelBytes = kMaxModelBytes * 2;
+const size_t   kMaxStrips = kStripedModelBytes / kMaxModelBytes;
+
+// 2) Header
+/**
+ * @brief BmpLayout
+ *        Where the pixels are and how the rows that hold them are laid out.
+ */
+struct BmpLayout
+{
+    size_t   pixelOffset = 0;    // the header's size
+    uint64_t rows = 0;
+    size_t   rowBytes = 0;       // pixel bytes in a row
+    size_t   stride = 0;         // with the padding to 4 bytes
+    int      bitsPerPixel = 0;
+};
+
+// The file and DIB headers at the start of file; false for layouts the
+// transform does not code. size must cover the header.
+bool readHeader(const uint8_t *file, size_t size, BmpLayout &layout)
+{
+    if (size < 26 || file[0] != 'B' || file[1] != 'M') return false;
+    const size_t pixelOffset = get32le(file + 10);
+    const size_t dibSize = get32le(file + 14);
+
+    int64_t width = 0, height = 0;
+    uint32_t bits = 0, compression = 0;
+    if (dibSize == 12) {
+        // OS/2 core header: unsigned 16-bit sizes, always bottom-up
+        width  = get16le(file + 18);
+        height = get16le(file + 20);
+        bits   = get16le(file + 24);
+    } else if (dibSize >= 40 && size >= 14 + dibSize) {
+        width       = int32_t(get32le(file + 18));
+        height      = int32_t(get32le(file + 22));
+        bits        = get16le(file + 28);
+        compression = get32le(file + 30);
+    } else {
+        return false;
+    }
+    if (pixelOffset < 14 + dibSize || pixelOffset > size || width <= 0 || height == 0) return false;
+
+    // BI_RGB, or BI_BITFIELDS and BI_ALPHABITFIELDS, which only move channels
+    switch (bits) {
+    case 1: case 2: case 4: case 8: case 24:
+        if (compression != 0) return false;
+        break;
+    case 16: case 32:
+        if (compression != 0 && compression != 3 && compression != 6) return false;
+        break;
+    default:
+        return false;
+    }
+    const uint64_t rowBits = uint64_t(width) * bits;
+    const uint64_t stride = (rowBits + 31) / 32 * 4;
+    const uint64_t rows = uint64_t(height < 0 ? -height : height);
+    if (stride > kMaxRow || stride * rows < kMinPixelBytes) return false;
+
+    layout.pixelOffset  = pixelOffset;
+    layout.rows         = rows;
+    layout.rowBytes     = static_cast<size_t>((rowBits + 7) / 8);
+    layout.stride       = static_cast<size_t>(stride);
+    layout.bitsPerPixel = static_cast<int>(bits);
+    return true;
+}
+
+// RGB triples of the colour table of an indexed bitmap; header holds the
+// layout's header
+std::vector<uint8_t> paletteOf(const uint8_t *header, const BmpLayout &layout)
+{
+    std::vector<uint8_t> palette;
+    if (layout.bitsPerPixel > 8) return palette;
+    const size_t dibSize = get32le(header + 14);
+    const size_t entry = dibSize == 12 ? 3 : 4;
+    const size_t start = 14 + dibSize;
+    size_t colors = dibSize >= 40 ? get32le(header + 46) : 0;
+    if (colors == 0 || colors > 256) colors = size_t(1) << layout.bitsPerPixel;
+    colors = std::min(colors, (layout.pixelOffset - start) / entry);
+    for (size_t i = 0; i < colors; ++i) {
+        const uint8_t *bgr = header + start + i * entry;
+        palette.insert(palette.end(), {bgr[2], bgr[1], bgr[0]});
+    }
+    return palette;
+}
+
+/**
+ * @brief Strip
+ *        A column of the bitmap: the bytes of each row from offset, and
+ *        for the last strip the row padding too, laid out as a bitmap of
+ *        their own.
+ */
+struct Strip
+{
+    size_t    offset = 0;
+    BmpLayout layout;
+    size_t    modelBytes = 0;
+};
+
+// Strips of the layout in the given transform version; version 1 kept
+// every bitmap in one
+std::vector<Strip> stripsOf(const BmpLayout &layout, uint8_t version)
+{
+    const size_t unit = layout.bitsPerPixel >= 8 ? static_cast<size_t>(layout.bitsPerPixel / 8) : 1;
+    const size_t units = layout.rowBytes / unit;
+    size_t count = 1;
+    if (version >= 2 && layout.rows * layout.rowBytes >= kMinStripedBytes) {
+        count = std::max<size_t>(1, std::min(kMaxStrips, layout.rowBytes / kMinStripBytes));
+    }
+
+    std::vector<Strip> strips(count);
+    for (size_t s = 0; s < count; ++s) {
+        const size_t end = s + 1 == count ? layout.rowBytes : units * (s + 1) / count * unit;
+        strips[s].offset = units * s / count * unit;
+        strips[s].layout = layout;
+        strips[s].layout.rowBytes = end - strips[s].offset;
+        strips[s].layout.stride = strips[s].layout.rowBytes + (s + 1 == count ? layout.stride - layout.rowBytes : 0);
+        strips[s].modelBytes = static_cast<size_t>(std::min<uint64_t>(layout.rows * strips[s].layout.rowBytes,
+                                                                       kMaxModelBytes));
+    }
+    return strips;
+}
+
+// The header is coded as bytes, from the container's primer since version
+// 3 and from set 1's before
+Primer headerPrimer(uint8_t version, const Primer &primer)
+{
+    return version < 3 ? findPrimer(1, FileType::Bmp) : primer;
+}
+
+// 3) Rows
+/**
+ * @brief BitmapRowCoder
+ *        Codes the rows of one bitmap with their padding, which is almost
+ *        always zero. Encoding reads each row from row() and pad(),
+ *        decoding writes it there.
+ */
+template <typename Coder>
+class BitmapRowCoder
+{
+public:
+    BitmapRowCoder(Coder &coder, const BmpLayout &layout, size_t modelBytes, const PaletteOrder *order)
+        : coder(coder),
+        pixels(coder, modelBytes, layout.bitsPerPixel / 8, layout.bitsPerPixel >= 24,
+               layout.bitsPerPixel >= 24, true),
+        padding(layout.stride - layout.rowBytes),
+        rowBytes(layout.rowBytes)
+    {
+        pixels.setOrder(order);
+        pixels.start(layout.rowBytes);
+    }
+
+    uint8_t *row() { return pixels.row(); }
+    uint8_t *pad() { return padding.data(); }
+    const uint8_t *above() const { return pixels.above(); }
+
+    // Takes row as the one above without coding it, for a fresh coder
+    // that follows rows kept as they are
+    void seed(const uint8_t *above)
+    {
+        std::memcpy(pixels.row(), above, rowBytes);
+        pixels.next();
+    }
+
+    void code()
+    {
+        pixels.code();
+        for (size_t i = 0; i < padding.size(); ++i) {
+            int node = 1;
+            for (int b = 7; b >= 0; --b) node = node << 1 | coder.code((padding[i] >> b) & 1, paddingModels[node]);
+            padding[i] = static_cast<uint8_t>(node);
+        }
+    }
+
+    void next() { pixels.next(); }
+
+private:
+    Coder &coder;
+    RowCoder<Coder> pixels;
+    std::vector<uint8_t> padding;
+    size_t   rowBytes;
+    BitModel paddingModels[256];
+};
+
+// 4) Transforms
+enum : uint8_t { kModeStored = 0, kModeCoded = 1, kModeOrdered = 2 };
+
+/**
+ * @brief BmpEncoder
+ *        Holds input back only until the header and then a band of rows
+ *        are complete: the first band is the sample that picks a palette
+ *        order, and each band is coded and written once it is full,
+ *        its strips side by side on up to threads workers.
+ */
+class BmpEncoder : public TypeTransform
+{
+public:
+    BmpEncoder(const Primer &primer, int threads)
+        : primer(headerPrimer(kBmpTransformVersion, primer)),
+        threads(threads)
+    {
+    }
+
+    bool update(const uint8_t *data, size_t size, std::vector<uint8_t> &out) override
+    {
+        if (state == State::Header) {
+            header.insert(header.end(), data, data + size);
+            if (!headerReady()) return true;
+            start(out);
+            data = header.data() + layout.pixelOffset;
+            size = header.size() - layout.pixelOffset;
+        }
+        feed(data, size, out);
+        header.resize(state == State::Rows && !headerWritten ? layout.pixelOffset : 0);
+        return true;
+    }
+
+    bool finish(std::vector<uint8_t> &out) override
+    {
+        ARITHMA_TRACE_SCOPE("transform", "bmp encode");
+        if (state == State::Header) {
+            state = State::Raw;
+            out.push_back(kModeStored);
+            out.insert(out.end(), header.begin(), header.end());
+        } else if (state == State::Rows) {
+            // The file ends inside a row, or a row short
+            endBands(out);
+            out.insert(out.end(), bandRaw.begin(), bandRaw.end());
+        }
+        return true;
+    }
+
+    bool entropyCoded() const override { return coded; }
+
+private:
+    enum class State { Header, Rows, Raw };
+
+    // Whether enough of the file has arrived to decide how to code it
+    bool headerReady() const
+    {
+        if (header.size() < 26) return false;
+        const size_t pixelOffset = get32le(header.data() + 10);
+        return header.size() >= std::min(pixelOffset, kMaxHeader + 1);
+    }
+
+    void start(std::vector<uint8_t> &out)
+    {
+        if (!readHeader(header.data(), header.size(), layout)) {
+            state = State::Raw;
+            out.push_back(kModeStored);
+            layout.pixelOffset = 0;
+            return;
+        }
+        state = State::Rows;
+        coded = true;
+        strips = stripsOf(layout, kBmpTransformVersion);
+        bandRows = std::max<size_t>(1, kBandBytes * strips.size() / layout.stride);
+        streams.resize(strips.size());
+        for (std::vector<uint8_t> &stream : streams) encoders.emplace_back(new PixelEncoder{{BinaryEncoder(stream)}});
+    }
+
+    // Writes the header, and the palette order the rows of the first band
+    // pick, ahead of that band
+    void writeHeader(std::vector<uint8_t> &out)
+    {
+        if (layout.bitsPerPixel <= 8) {
+            order = choosePaletteOrder(bandRaw.data(), layout.stride, layout.rowBytes, rowsInBand,
+                                       layout.bitsPerPixel, paletteOf(header.data(), layout), true);
+        }
+        const bool ordered = order.method() != PaletteOrder::kAsIs;
+        out.push_back(ordered ? kModeOrdered : kModeCoded);
+        putVarint(out, layout.pixelOffset);
+        std::vector<uint8_t> packed;
+        encodeBlock(Backend::Arithmetic, 2, primer, header.data(), layout.pixelOffset, packed);
+        if (packed.size() < layout.pixelOffset) {
+            putVarint(out, packed.size());
+            out.insert(out.end(), packed.begin(), packed.end());
+        } else {
+            putVarint(out, 0);
+            out.insert(out.end(), header.begin(), header.begin() + layout.pixelOffset);
+        }
+        if (ordered) order.write(out);
+        headerWritten = true;
+        ordering = ordered ? &order : nullptr;
+        rows.resize(strips.size());
+        for (size_t s = 0; s < strips.size(); ++s) restart(s);
+    }
+
+    void restart(size_t s)
+    {
+        rows[s].reset(new BitmapRowCoder<PixelEncoder>(*encoders[s], strips[s].layout, strips[s].modelBytes,
+                                                       ordering));
+    }
+
+    void feed(const uint8_t *data, size_t size, std::vector<uint8_t> &out)
+    {
+        while (size > 0 && state == State::Rows) {
+            const size_t take = std::min(size, layout.stride - filled);
+            bandRaw.insert(bandRaw.end(), data, data + take);
+            filled += take;
+            data += take;
+            size -= take;
+            if (filled < layout.stride) continue;
+
+            filled = 0;
+            ++rowsDone;
+            if (++rowsInBand == bandRows || rowsDone == layout.rows) closeBand(out);
+            if (rowsDone == layout.rows) endBands(out);
+        }
+        out.insert(out.end(), data, data + size);
+    }
+
+    // Codes the band's strips and writes them, each as it is when coding
+    // does not shrink it. A partial row stays behind.
+    void closeBand(std::vector<uint8_t> &out)
+    {
+        ARITHMA_TRACE_SCOPE("transform", "bmp band");
+        if (!headerWritten) writeHeader(out);
+        if (rowsInBand == 0) return;
+        const size_t rawSize = rowsInBand * layout.stride;
+        parallelFor(strips.size(), threads, [&](size_t s) {
+            const Strip &strip = strips[s];
+            const size_t padding = strip.layout.stride - strip.layout.rowBytes;
+            for (const uint8_t *row = bandRaw.data() + strip.offset; row < bandRaw.data() + rawSize;
+                 row += layout.stride) {
+                std::memcpy(rows[s]->row(), row, strip.layout.rowBytes);
+                if (padding) std::memcpy(rows[s]->pad(), row + strip.layout.rowBytes, padding);
+                rows[s]->code();
+                rows[s]->next();
+            }
+            encoders[s]->coder.finish();
+        });
+
+        putVarint(out, rowsInBand);
+        for (size_t s = 0; s < strips.size(); ++s) {
+            putVarint(out, streams[s].size() < rowsInBand * strips[s].layout.stride ? streams[s].size() : 0);
+        }
+        for (size_t s = 0; s < strips.size(); ++s) {
+            const Strip &strip = strips[s];
+            if (streams[s].size() < rowsInBand * strip.layout.stride) {
+                out.insert(out.end(), streams[s].begin(), streams[s].end());
+            } else {
+                // The model learned from rows the decoder will not model, so
+                // both sides go on with a fresh one
+                for (size_t i = 0; i < rowsInBand; ++i) {
+                    const uint8_t *row = bandRaw.data() + i * layout.stride + strip.offset;
+                    out.insert(out.end(), row, row + strip.layout.stride);
+                }
+                restart(s);
+                rows[s]->seed(bandRaw.data() + rawSize - layout.stride + strip.offset);
+            }
+            streams[s].clear();
+        }
+        bandRaw.erase(bandRaw.begin(), bandRaw.begin() + rawSize);
+        rowsInBand = 0;
+    }
+
+    void endBands(std::vector<uint8_t> &out)
+    {
+        closeBand(out);
+        putVarint(out, 0);
+        state = State::Raw;
+    }
+
+    State     state = State::Header;
+    BmpLayout layout;
+    PaletteOrder order;
+    const PaletteOrder *ordering = nullptr;   // null when coded as they are
+    std::vector<Strip> strips;
+    std::vector<uint8_t> header;    // input until the layout is known
+    std::vector<uint8_t> bandRaw;   // rows of the band being coded
+    std::vector<std::vector<uint8_t>> streams;   // and a stream per strip
+    std::vector<std::unique_ptr<PixelEncoder>> encoders;
+    std::vector<std::unique_ptr<BitmapRowCoder<PixelEncoder>>> rows;
+    Primer   primer;                // for the header
+    int      threads;
+    size_t   bandRows = 0;
+    size_t   rowsInBand = 0;
+    uint64_t rowsDone = 0;
+    size_t   filled = 0;            // bytes of the current row so far
+    bool     headerWritten = false;
+    bool     coded = false;
+};
+
+/**
+ * @brief BmpDecoder
+ *        Holds input back until the next part, the header or a band, is
+ *        complete, and rebuilds it, a band's strips side by side on up
+ *        to threads workers.
+ */
+class BmpDecoder : public TypeTransform
+{
+public:
+    BmpDecoder(uint8_t version, const Primer &primer, int threads)
+        : version(version),
+        primer(headerPrimer(version, primer)),
+        threads(threads)
+    {
+    }
+
+    bool update(const uint8_t *data, size_t size, std::vector<uint8_t> &out) override
+    {
+        if (state == State::Raw) {
+            out.insert(out.end(), data, data + size);
+            return true;
+        }
+        pending.insert(pending.end(), data, data + size);
+        const uint8_t *p = pending.data();
+        const bool ok = step(p, pending.data() + pending.size(), out);
+        pending.erase(pending.begin(), pending.begin() + (p - pending.data()));
+        return ok;
+    }
+
+    bool finish(std::vector<uint8_t> &) override
+    {
+        ARITHMA_TRACE_SCOPE("transform", "bmp decode");
+        return state == State::Raw;
+    }
+
+    bool moreOutput() const override { return more; }
+
+    std::string errorString() const override { return "BMP data could not be rebuilt"; }
+
+private:
+    enum class State { Mode, Header, Bands, Raw };
+
+    // Rebuilds the parts that are complete in [p, end), a few megabytes at
+    // most, and moves p past them
+    bool step(const uint8_t *&p, const uint8_t *end, std::vector<uint8_t> &out)
+    {
+        const size_t start = out.size();
+        more = false;
+        if (state == State::Mode && p < end) {
+            const uint8_t mode = *p++;
+            if (mode > kModeOrdered) return false;
+            state = mode == kModeStored ? State::Raw : State::Header;
+            ordered = mode == kModeOrdered;
+        }
+        if (state == State::Header && !readHeaderPart(p, end, out)) return false;
+        while (state == State::Bands) {
+            if (out.size() - start >= kBandBytes) {
+                more = true;
+                break;
+            }
+            const uint8_t *q = p;
+            uint64_t count = 0;
+            if (!varintComplete(q, end)) break;
+            if (!getVarint(q, end, count)) return false;
+            if (count == 0) {
+                p = q;
+                state = State::Raw;
+                break;
+            }
+            // A strip is coded only when that shrinks it, which bounds what is held
+            if (count > std::min<uint64_t>(bandRows, layout.rows - rowsDone)) return false;
+            bool complete = true;
+            uint64_t total = 0;
+            for (size_t s = 0; s < strips.size() && complete; ++s) {
+                const uint64_t rawSize = count * strips[s].layout.stride;
+                complete = varintComplete(q, end);
+                if (complete && (!getVarint(q, end, sizes[s]) || sizes[s] >= rawSize)) return false;
+                total += sizes[s] ? sizes[s] : rawSize;
+            }
+            if (!complete || uint64_t(end - q) < total) break;
+            decodeBand(q, static_cast<size_t>(count), out);
+            p = q + total;
+        }
+        if (state == State::Raw) {
+            out.insert(out.end(), p, end);
+            p = end;
+        }
+        return true;
+    }
+
+    bool readHeaderPart(const uint8_t *&p, const uint8_t *end, std::vector<uint8_t> &out)
+    {
+        const uint8_t *q = p;
+        uint64_t size = 0, packedSize = 0;
+        if (!varintComplete(q, end)) return true;
+        if (!getVarint(q, end, size) || size > kMaxHeader) return false;
+        if (!varintComplete(q, end)) return true;
+        if (!getVarint(q, end, packedSize) || packedSize > kMaxHeader) return false;
+        const uint64_t stored = packedSize ? packedSize : size;
+        if (uint64_t(end - q) < stored) return true;
+
+        std::vector<uint8_t> file(static_cast<size_t>(size));
+        if (packedSize == 0) {
+            std::memcpy(file.data(), q, file.size());
+        } else if (!decodeBlock(Backend::Arithmetic, 2, primer, q, static_cast<size_t>(packedSize),
+                                file.data(), file.size())) {
+            return false;
+        }
+        if (!readHeader(file.data(), file.size(), layout) || layout.pixelOffset != file.size()) return false;
+        q += stored;
+        if (ordered) {
+            // At most 258 bytes, so a shorter rest may just be cut short
+            const uint8_t *start = q;
+            if (layout.bitsPerPixel > 8) return false;
+            if (!order.read(q, end, paletteOf(file.data(), layout), layout.bitsPerPixel)) return end - start < 258;
+            ordering = &order;
+        }
+        out.insert(out.end(), file.begin(), file.end());
+        p = q;
+
+        state = State::Bands;
+        strips = stripsOf(layout, version);
+        bandRows = std::max<size_t>(1, kBandBytes * strips.size() / layout.stride);
+        sizes.resize(strips.size());
+        rows.resize(strips.size());
+        for (size_t s = 0; s < strips.size(); ++s) {
+            decoders.emplace_back(new PixelDecoder{{BinaryDecoder(nullptr, 0)}});
+            restart(s);
+        }
+        return true;
+    }
+
+    void restart(size_t s)
+    {
+        rows[s].reset(new BitmapRowCoder<PixelDecoder>(*decoders[s], strips[s].layout, strips[s].modelBytes,
+                                                       ordering));
+    }
+
+    // Rebuilds count rows from the strips at p, whose sizes were read
+    void decodeBand(const uint8_t *p, size_t count, std::vector<uint8_t> &out)
+    {
+        ARITHMA_TRACE_SCOPE("transform", "bmp band");
+        std::vector<const uint8_t *> streams(strips.size());
+        for (size_t s = 0; s < strips.size(); ++s) {
+            streams[s] = p;
+            p += sizes[s] ? sizes[s] : count * strips[s].layout.stride;
+        }
+
+        const size_t start = out.size();
+        out.resize(start + count * layout.stride);
+        uint8_t *band = out.data() + start;
+        parallelFor(strips.size(), threads, [&](size_t s) {
+            const Strip &strip = strips[s];
+            const size_t padding = strip.layout.stride - strip.layout.rowBytes;
+            if (sizes[s] == 0) {
+                for (size_t i = 0; i < count; ++i) {
+                    std::memcpy(band + i * layout.stride + strip.offset, streams[s] + i * strip.layout.stride,
+                                strip.layout.stride);
+                }
+                restart(s);
+                rows[s]->seed(band + (count - 1) * layout.stride + strip.offset);
+                return;
+            }
+            decoders[s]->coder = BinaryDecoder(streams[s], static_cast<size_t>(sizes[s]));
+            for (size_t i = 0; i < count; ++i) {
+                uint8_t *row = band + i * layout.stride + strip.offset;
+                rows[s]->code();
+                std::memcpy(row, rows[s]->row(), strip.layout.rowBytes);
+                if (padding) std::memcpy(row + strip.layout.rowBytes, rows[s]->pad(), padding);
+                rows[s]->next();
+            }
+        });
+        rowsDone += count;
+    }
+
+    State     state = State::Mode;
+    BmpLayout layout;
+    std::vector<uint8_t> pending;   // input not yet rebuilt
+    std::vector<Strip> strips;
+    std::vector<uint64_t> sizes;    // of each strip of the next band, 0 when kept as it is
+    std::vector<std::unique_ptr<PixelDecoder>> decoders;
+    std::vector<std::unique_ptr<BitmapRowCoder<PixelDecoder>>> rows;
+    PaletteOrder order;
+    const PaletteOrder *ordering = nullptr;
+    bool     ordered = false;
+    size_t   bandRows = 0;
+    uint64_t rowsDone = 0;
+    uint8_t  version;
+    Primer   primer;
+    int      threads;
+    bool     more = false;
+};
+
+}
+
+std::unique_ptr<TypeTransform> newBmpEncoder(const Primer &primer, int threads)
+{
+    return std::unique_ptr<TypeTransform>(new BmpEncoder(primer, threads));
+}
+
+std::unique_ptr<TypeTransform> newBmpDecoder(uint8_t version, const Primer &primer, int threads)
+{
+    return std::unique_ptr<TypeTransform>(new BmpDecoder(version, primer, threads));
+}
@@ -0,0 +1,49 @@
+#ifndef BMPCODEC_H
+#define BMPCODEC_H
+
+#include "typeregistry.h"
+
+#include <cstdint>
+#include <memory>
+
+/*
+ * BMP transform, version 3. The header is coded from the container's
+ * block primer, or from none when it is unprimed; versions 1 and 2 always
+ * used set 1's BMP primer. Version 1 also had no strips, every bitmap
+ * coded as one. The decoder still reads both.
+ *
+ * Uncompressed bitmaps are coded a row at a time as they stream in, in the
+ * order the file stores them, so bottom-up and top-down images alike need
+ * only the row being coded and the one before it. 24- and 32-bit pixels
+ * are coded as samples from a median edge predictor, palette and other
+ * packed pixels under hashes of their neighbours, and a run of repeated
+ * pixels as its length. Rows are cut into bands of about a megabyte a
+ * strip, so neither direction holds more than one band. Bitmaps of 8 MB
+ * and more are also cut into two strips, columns of whole pixels at least
+ * 1536 bytes wide that each keep a model of their own, so the strips of a
+ * band are coded in parallel; their number depends only on the image's
+ * size, and their models together stay within 32 MB.
+ *
+ *   u8 mode   0: the original bytes follow unchanged
+ *             1: varint header size, varint coded header size (0 when
+ *                the header is kept as it is), the header, bands, the
+ *                rest of the file unchanged
+ *             2: as 1, with the palette order after the header
+ *
+ * The header is everything before the pixel data. Each band is varint row
+ * count, varint stream size of each strip, then the streams; the last
+ * strip also codes the padding at the end of each row. A row count of 0
+ * ends the bands. A strip coding does not shrink has stream size 0 and
+ * its part of the rows follows as it is, and in the band after it that
+ * strip starts from a fresh model that takes the last of those rows as
+ * the one above. A last row the file cuts short is kept with the rest.
+ * RLE, JPEG and PNG compressed bitmaps, and bitmaps under 4 KB, use mode
+ * 0. Palette bitmaps use mode 2 when the first band says reordering the
+ * indices pays.
+ */
+constexpr uint8_t kBmpTransformVersion = 3;
+
+std::unique_ptr<TypeTransform> newBmpEncoder(const Primer &primer, int threads);
+std::unique_ptr<TypeTransform> newBmpDecoder(uint8_t version, const Primer &primer, int threads);
+
+#endif // BMPCODEC_H
@@ -0,0 +1,521 @@
+// arithma: headless command-line front end to the Arithma-Tech engine.
+// Shares CodecEngine with the GUI but links no Qt, so it starts instantly
+// and can sit in shell pipelines.
+
+#include "blockcodec.h"
+#include "codecengine.h"
+#include "container.h"
+#include "typeregistry.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+namespace {
+
+const char *const kArchiveSuffix = ".atc";
+
+const char *const kUsage =
+    "Usage: arithma <command> [options] [file...]\n"
+    "\n"
+    "Commands:\n"
+    "  compress, c      Compress files, or stdin to stdout\n"
+    "  decompress, d    Restore .atc files, or stdin to stdout\n"
+    "  test, t          Decode .atc files and check them without writing output\n"
+    "  list, l          Show container details (-v adds the seek index)\n"
+    "  range, r         Write bytes [--offset, --offset + --length) of the original\n"
+    "                   data, decoding only the blocks that cover them (transformed\n"
+    "                   files decode from the start up to the range's end)\n"
+    "\n"
+    "Options:\n"
+    "  -1 .. -3, --level N     Compression level (default: by file type, mostly 2)\n"
+    "  -b, --backend NAME      arithmetic or binary (default: by file type)\n"
+    "  -T, --threads N         Worker threads, 0 = one per core (default)\n"
+    "  -B, --block-size SIZE   Block size such as 256K or 4M (default 1M)\n"
+    "  -o, --output PATH       Output path for a single input, - for stdout\n"
+    "  -c, --stdout            Write results to stdout\n"
+    "  -f, --force             Overwrite existing output files\n"
+    "  -v, --verbose           Print statistics for each file\n"
+    "      --verify            After compressing to a file, decode it and check\n"
+    "                          every block's checksum\n"
+    "      --no-prime          Start every block from an empty model instead of\n"
+    "                          the trained one for its file type\n"
+    "      --no-transform      Code files as they are, without their type's\n"
+    "                          preprocessing (such as JPEG recompression)\n"
+    "      --perf              Print hardware counters per stage (Linux)\n"
+    "      --offset N          First byte for range (default 0)\n"
+    "      --length N          Byte count for range (default: to the end)\n"
+    "  -h, --help              Show this help\n";
+
+struct CliOptions
+{
+    std::string command;
+    std::vector<std::string> inputs;
+    std::string output;
+    CodecOptions codec;
+    bool levelGiven   = false;   // otherwise the detected type's default
+    bool backendGiven = false;
+    bool toStdout = false;
+    bool force    = false;
+    bool verbose  = false;
+    bool perf     = false;
+    uint64_t offset = 0;
+    uint64_t length = UINT64_MAX;
+};
+
+// Discards everything written to it; used by the test command
+class NullBuffer : public std::streambuf
+{
+protected:
+    int overflow(int c) override { return traits_type::not_eof(c); }
+    std::streamsize xsputn(const char *, std::streamsize n) override { return n; }
+};
+
+// Hands out head, then whatever is left in source; lets stdin be typed
+// from its first bytes and still be coded whole
+class PrefixedBuffer : public std::streambuf
+{
+public:
+    PrefixedBuffer(std::vector<char> head, std::streambuf *source)
+        : head(std::move(head)), source(source)
+    {
+        setg(this->head.data(), this->head.data(), this->head.data() + this->head.size());
+    }
+
+protected:
+    int_type underflow() override
+    {
+        const std::streamsize got = source->sgetn(chunk, sizeof(chunk));
+        if (got <= 0) return traits_type::eof();
+        setg(chunk, chunk, chunk + got);
+        return traits_type::to_int_type(*gptr());
+    }
+
+    // Bulk reads go straight to source once the held bytes run out
+    std::streamsize xsgetn(char *s, std::streamsize n) override
+    {
+        const std::streamsize held = std::min<std::streamsize>(n, egptr() - gptr());
+        if (held > 0) {
+            std::memcpy(s, gptr(), size_t(held));
+            gbump(static_cast<int>(held));
+        }
+        return held + (n > held ? source->sgetn(s + held, n - held) : 0);
+    }
+
+private:
+    std::vector<char> head;
+    std::streambuf   *source;
+    char              chunk[4096];
+};
+
+int usageError(const std::string &message)
+{
+    std::cerr << "arithma: " << message << "\n\n" << kUsage;
+    return 2;
+}
+
+// The engine would clamp any other level to the nearest one without a word
+bool validLevel(uint64_t level)
+{
+    return level >= uint64_t(CodecEngine::kMinLevel) && level <= uint64_t(CodecEngine::kMaxLevel);
+}
+
+int levelError()
+{
+    return usageError("level must be between " + std::to_string(CodecEngine::kMinLevel) + " and "
+                      + std::to_string(CodecEngine::kMaxLevel));
+}
+
+bool parseSize(const std::string &text, uint64_t &value)
+{
+    if (text.empty()) return false;
+    char *end = nullptr;
+    const unsigned long long number = std::strtoull(text.c_str(), &end, 10);
+    if (end == text.c_str()) return false;
+
+    uint64_t scale = 1;
+    const std::string suffix(end);
+    if (suffix == "K" || suffix == "k") {
+        scale = 1ull << 10;
+    } else if (suffix == "M" || suffix == "m") {
+        scale = 1ull << 20;
+    } else if (suffix == "G" || suffix == "g") {
+        scale = 1ull << 30;
+    } else if (!suffix.empty()) {
+        return false;
+    }
+    value = number * scale;
+    return true;
+}
+
+bool fileExists(const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    return static_cast<bool>(file);
+}
+
+bool hasArchiveSuffix(const std::string &path)
+{
+    const size_t n = std::char_traits<char>::length(kArchiveSuffix);
+    return path.size() > n && path.compare(path.size() - n, n, kArchiveSuffix) == 0;
+}
+
+void printStats(const std::string &name, const JobStats &stats, bool compressing)
+{
+    const uint64_t raw    = compressing ? stats.inputBytes : stats.outputBytes;
+    const uint64_t packed = compressing ? stats.outputBytes : stats.inputBytes;
+    const double ratio = raw ? 100.0 * double(packed) / double(raw) : 0.0;
+    const double mbps  = stats.wallSeconds > 0 ? double(raw) / stats.wallSeconds / 1e6 : 0.0;
+    std::fprintf(stderr, "%s: %llu -> %llu bytes (%.2f%%), %u blocks, %.3f s (%.3f s cpu), %.2f MB/s\n",
+                 name.c_str(),
+                 static_cast<unsigned long long>(compressing ? raw : packed),
+                 static_cast<unsigned long long>(compressing ? packed : raw),
+                 ratio, stats.blocks, stats.wallSeconds, stats.cpuSeconds, mbps);
+    if (stats.verifySeconds > 0) {
+        std::fprintf(stderr, "%s: verified in %.3f s\n", name.c_str(), stats.verifySeconds);
+    }
+    if (!stats.frameSeconds.empty()) {
+        double total = 0.0, slowest = 0.0;
+        size_t slowestFrame = 0;
+        for (size_t i = 0; i < stats.frameSeconds.size(); ++i) {
+            total += stats.frameSeconds[i];
+            if (stats.frameSeconds[i] > slowest) {
+                slowest = stats.frameSeconds[i];
+                slowestFrame = i;
+            }
+        }
+        std::fprintf(stderr, "%s: %zu frames, %.3f ms each on average, slowest %.3f ms (frame %zu)\n",
+                     name.c_str(), stats.frameSeconds.size(), 1e3 * total / double(stats.frameSeconds.size()),
+                     1e3 * slowest, slowestFrame);
+    }
+    if (stats.unchangedPixels > 0) {
+        std::fprintf(stderr, "%s: %llu of %llu pixels (%.1f%%) repeated the frame before\n", name.c_str(),
+                     static_cast<unsigned long long>(stats.unchangedPixels),
+                     static_cast<unsigned long long>(stats.framePixels),
+                     100.0 * double(stats.unchangedPixels) / double(stats.framePixels));
+    }
+}
+
+// Silent when counters were unavailable
+void printCounters(const std::string &name, const JobStats &stats)
+{
+    const std::string table = formatPerfStats(stats.perf);
+    if (!table.empty()) std::fprintf(stderr, "%s: counters\n%s", name.c_str(), table.c_str());
+}
+
+// 1) compress / decompress / test
+int runCodec(const CliOptions &options)
+{
+    const bool compressing = options.command == "compress";
+    const bool testing     = options.command == "test";
+
+    std::vector<std::string> inputs = options.inputs;
+    if (inputs.empty()) {
+        if (testing) return usageError("test needs at least one file");
+        inputs.push_back("-");
+    }
+    if (!options.output.empty() && inputs.size() > 1) {
+        return usageError("--output takes a single input");
+    }
+
+    int status = 0;
+    for (const std::string &input : inputs) {
+        const bool fromStdin = input == "-";
+
+        std::string outputPath = options.output;
+        if (options.toStdout || fromStdin) {
+            if (outputPath.empty()) outputPath = "-";
+        } else if (outputPath.empty() && !testing) {
+            if (compressing) {
+                outputPath = input + kArchiveSuffix;
+            } else if (hasArchiveSuffix(input)) {
+                outputPath = input.substr(0, input.size() - std::char_traits<char>::length(kArchiveSuffix));
+            } else {
+                std::cerr << "arithma: " << input << ": unknown suffix, use -o or -c\n";
+                status = 1;
+                continue;
+            }
+        }
+
+        if (!testing && outputPath != "-" && !options.force && fileExists(outputPath)) {
+            std::cerr << "arithma: " << outputPath << " already exists, use -f to overwrite\n";
+            status = 1;
+            continue;
+        }
+
+        std::ifstream inFile;
+        if (!fromStdin) {
+            inFile.open(input, std::ios::binary);
+            if (!inFile) {
+                std::cerr << "arithma: cannot open " << input << "\n";
+                status = 1;
+                continue;
+            }
+        }
+
+        // The type comes from the content. stdin cannot be peeked, so its
+        // first bytes are read ahead and handed back before the rest.
+        FileType type = FileType::Binary;
+        std::vector<char> head;
+        if (compressing && fromStdin) {
+            head.resize(kDetectBytes);
+            const std::streamsize got = std::cin.rdbuf()->sgetn(head.data(), std::streamsize(head.size()));
+            head.resize(size_t(std::max<std::streamsize>(got, 0)));
+            type = detectFileType(reinterpret_cast<const uint8_t *>(head.data()), head.size());
+        } else if (compressing) {
+            type = detectFileType(input);
+        }
+        PrefixedBuffer stdinBuffer(std::move(head), std::cin.rdbuf());
+        std::istream stdinStream(&stdinBuffer);
+        std::istream &in = fromStdin ? stdinStream : inFile;
+
+        NullBuffer nullBuffer;
+        std::ostream nullStream(&nullBuffer);
+        std::ofstream outFile;
+        if (!testing && outputPath != "-") {
+            outFile.open(outputPath, std::ios::binary | std::ios::trunc);
+            if (!outFile) {
+                std::cerr << "arithma: cannot create " << outputPath << "\n";
+                status = 1;
+                continue;
+            }
+        }
+        std::ostream &out = testing ? nullStream : (outputPath == "-" ? std::cout : outFile);
+
+        CodecOptions codec = options.codec;
+        if (compressing) {
+            applyTypeDefaults(type, codec);
+            if (options.levelGiven) codec.level = options.codec.level;
+            if (options.backendGiven) codec.backend = options.codec.backend;
+        }
+        CodecEngine engine(codec);
+        bool ok = compressing ? engine.compressStream(in, out) : engine.decompressStream(in, out);
+        out.flush();
+
+        // A stream cannot be read back, so only file outputs are verified
+        if (ok && compressing && codec.verifyAfterWrite && outFile.is_open()) {
+            outFile.close();
+            ok = !outFile.fail() && engine.verifyFile(outputPath);
+        }
+
+        const std::string name = fromStdin ? "(stdin)" : input;
+        if (!ok) {
+            std::cerr << "arithma: " << name << ": " << engine.errorString() << "\n";
+            if (!testing && outputPath != "-") {
+                outFile.close();
+                std::remove(outputPath.c_str());
+            }
+            status = 1;
+            continue;
+        }
+        if (testing) {
+            std::cerr << name << ": OK\n";
+        }
+        if (options.verbose) {
+            printStats(name, engine.stats(), compressing);
+        }
+        if (options.perf) {
+            printCounters(name, engine.stats());
+        }
+    }
+    return status;
+}
+
+// 2) list
+int runList(const CliOptions &options)
+{
+    if (options.inputs.empty()) return usageError("list needs at least one file");
+
+    int status = 0;
+    for (const std::string &input : options.inputs) {
+        ContainerReader reader;
+        if (!reader.open(input)) {
+            std::cerr << "arithma: " << input << ": " << reader.errorString() << "\n";
+            status = 1;
+            continue;
+        }
+
+        const ContainerHeader &header = reader.header();
+        const ContainerFooter &footer = reader.footer();
+        std::ifstream sizeProbe(input, std::ios::binary | std::ios::ate);
+        const uint64_t packed = static_cast<uint64_t>(sizeProbe.tellg());
+        const double ratio = footer.originalSize ? 100.0 * double(packed) / double(footer.originalSize) : 0.0;
+
+        std::printf("%s\n", input.c_str());
+        std::printf("  type %s, backend %s, level %u, block size %u, primer set %u",
+                    fileTypeName(header.fileType), backendName(header.backend),
+                    unsigned(header.level), header.blockSize, unsigned(primerSet(header)));
+        if (transformVersion(header)) std::printf(", transform %u", unsigned(transformVersion(header)));
+        std::printf("\n");
+        std::printf("  %llu -> %llu bytes (%.2f%%), %u blocks\n",
+                    static_cast<unsigned long long>(footer.originalSize),
+                    static_cast<unsigned long long>(packed), ratio, footer.blockCount);
+
+        if (options.verbose) {
+            std::printf("  %8s %14s %10s %14s %10s\n", "block", "raw offset", "raw size",
+                        "file offset", "payload");
+            for (uint32_t i = 0; i < footer.blockCount; ++i) {
+                BlockIndexEntry entry;
+                if (!reader.readIndexEntry(i, entry)) {
+                    std::cerr << "arithma: " << input << ": " << reader.errorString() << "\n";
+                    status = 1;
+                    break;
+                }
+                std::printf("  %8u %14llu %10u %14llu %10u\n", i,
+                            static_cast<unsigned long long>(entry.rawOffset), entry.rawSize,
+                            static_cast<unsigned long long>(entry.blockOffset), entry.payloadSize);
+            }
+        }
+    }
+    return status;
+}
+
+// 3) range
+int runRange(const CliOptions &options)
+{
+    if (options.inputs.size() != 1) return usageError("range takes exactly one file");
+
+    CodecEngine engine(options.codec);
+    std::vector<uint8_t> data;
+    if (!engine.decompressRange(options.inputs.front(), options.offset, options.length, data)) {
+        std::cerr << "arithma: " << options.inputs.front() << ": " << engine.errorString() << "\n";
+        return 1;
+    }
+
+    std::ofstream outFile;
+    if (!options.output.empty() && options.output != "-") {
+        outFile.open(options.output, std::ios::binary | std::ios::trunc);
+        if (!outFile) {
+            std::cerr << "arithma: cannot create " << options.output << "\n";
+            return 1;
+        }
+    }
+    std::ostream &out = outFile.is_open() ? outFile : std::cout;
+    out.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+    out.flush();
+
+    if (options.verbose) {
+        printStats(options.inputs.front(), engine.stats(), false);
+    }
+    if (options.perf) {
+        printCounters(options.inputs.front(), engine.stats());
+    }
+    return out ? 0 : 1;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+#ifdef _WIN32
+    _setmode(_fileno(stdin), _O_BINARY);
+    _setmode(_fileno(stdout), _O_BINARY);
+#endif
+    std::ios::sync_with_stdio(false);
+
+    if (argc < 2) {
+        std::cerr << kUsage;
+        return 2;
+    }
+
+    CliOptions options;
+    const std::string command = argv[1];
+    if (command == "compress" || command == "c") {
+        options.command = "compress";
+    } else if (command == "decompress" || command == "d") {
+        options.command = "decompress";
+    } else if (command == "test" || command == "t") {
+        options.command = "test";
+    } else if (command == "list" || command == "l") {
+        options.command = "list";
+    } else if (command == "range" || command == "r") {
+        options.command = "range";
+    } else if (command == "-h" || command == "--help" || command == "help") {
+        std::cout << kUsage;
+        return 0;
+    } else {
+        return usageError("unknown command '" + command + "'");
+    }
+
+    for (int i = 2; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto value = [&](std::string &out) {
+            if (i + 1 >= argc) return false;
+            out = argv[++i];
+            return true;
+        };
+        std::string text;
+        uint64_t number = 0;
+
+        if (arg == "-h" || arg == "--help") {
+            std::cout << kUsage;
+            return 0;
+        } else if (arg.size() == 2 && arg[0] == '-' && arg[1] >= '1' && arg[1] <= '9') {
+            if (!validLevel(uint64_t(arg[1] - '0'))) return levelError();
+            options.codec.level = arg[1] - '0';
+            options.levelGiven = true;
+        } else if (arg == "--level") {
+            if (!value(text) || !parseSize(text, number)) return usageError("--level needs a number");
+            if (!validLevel(number)) return levelError();
+            options.codec.level = static_cast<int>(number);
+            options.levelGiven = true;
+        } else if (arg == "-b" || arg == "--backend") {
+            if (!value(text) || !backendFromName(text, options.codec.backend)) {
+                return usageError("--backend must be arithmetic or binary");
+            }
+            options.backendGiven = true;
+        } else if (arg == "-T" || arg == "--threads") {
+            // Streams hold threads x blockSize bytes, and int must not wrap
+            if (!value(text) || !parseSize(text, number) || number > 1024) {
+                return usageError("--threads must be between 0 and 1024");
+            }
+            options.codec.threads = static_cast<int>(number);
+        } else if (arg == "-B" || arg == "--block-size") {
+            if (!value(text) || !parseSize(text, number) || number == 0 || number > (1ull << 30)) {
+                return usageError("--block-size must be between 1 and 1G");
+            }
+            options.codec.blockSize = static_cast<uint32_t>(number);
+        } else if (arg == "-o" || arg == "--output") {
+            if (!value(options.output)) return usageError("--output needs a path");
+        } else if (arg == "-c" || arg == "--stdout") {
+            options.toStdout = true;
+        } else if (arg == "-f" || arg == "--force") {
+            options.force = true;
+        } else if (arg == "-v" || arg == "--verbose") {
+            options.verbose = true;
+        } else if (arg == "--verify") {
+            options.codec.verifyAfterWrite = true;
+        } else if (arg == "--no-prime") {
+            options.codec.usePrimers = false;
+        } else if (arg == "--no-transform") {
+            options.codec.useTransforms = false;
+        } else if (arg == "--perf") {
+            options.perf = true;
+            options.codec.perfCounters = true;
+        } else if (arg == "--offset") {
+            if (!value(text) || !parseSize(text, options.offset)) return usageError("--offset needs a size");
+        } else if (arg == "--length") {
+            if (!value(text) || !parseSize(text, options.length)) return usageError("--length needs a size");
+        } else if (arg.size() > 1 && arg[0] == '-') {
+            return usageError("unknown option '" + arg + "'");
+        } else {
+            options.inputs.push_back(arg);
+        }
+    }
+
+    if (options.command == "list") return runList(options);
+    if (options.command == "range") return runRange(options);
+    return runCodec(options);
+}
@@ -0,0 +1,379 @@
+#include "codecengine.h"
+
+#include "blockcodec.h"
+#include "codecsession.h"
+#include "parallel.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <memory>
+
+namespace {
+
+const size_t kStreamChunk = 1 << 16;
+
+// Feed a stream to a session in chunks; false if the session rejects data
+template <typename Session>
+bool pump(std::istream &in, Session &session, size_t chunkSize)
+{
+    std::vector<uint8_t> chunk(chunkSize);
+    while (in) {
+        TraceScope trace("io", "read");
+        PerfStageScope stage(session.perfRecorder(), PerfStage::Read);
+        in.read(reinterpret_cast<char *>(chunk.data()), static_cast<std::streamsize>(chunk.size()));
+        const size_t got = static_cast<size_t>(in.gcount());
+        stage.close();
+        trace.close();
+        if (got > 0 && !session.update(chunk.data(), got)) return false;
+    }
+    return true;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+}
+
+uint32_t containerFlags(const CodecOptions &options)
+{
+    uint32_t flags = ContainerHeader::kFlagBlockChecksums;
+    // Types without a primer record set 0, so their files stay readable by
+    // builds that predate priming
+    if (options.usePrimers && !findPrimer(currentPrimerSet(), options.fileType).empty()) {
+        flags |= uint32_t(currentPrimerSet()) << ContainerHeader::kPrimerSetShift;
+    }
+    const TypeCodec &codec = typeCodec(options.fileType);
+    if (options.useTransforms && codec.forward) {
+        flags |= uint32_t(codec.transformVersion) << ContainerHeader::kTransformShift;
+    }
+    return flags;
+}
+
+// 1) CodecEngine Implementation
+CodecEngine::CodecEngine(const CodecOptions &options)
+    : codecOptions(options)
+{
+    codecOptions.level = std::max(kMinLevel, std::min(kMaxLevel, codecOptions.level));
+    if (codecOptions.blockSize == 0) {
+        codecOptions.blockSize = CodecOptions().blockSize;
+    }
+}
+
+template <typename Session>
+bool CodecEngine::finishSession(Session &session, bool fed)
+{
+    const bool ok = fed && session.finish();
+    jobStats = session.stats();
+    error = session.errorString();
+    return ok;
+}
+
+bool CodecEngine::compress(const std::vector<uint8_t> &input, std::vector<uint8_t> &output)
+{
+    output.clear();
+    CompressionSession session(codecOptions, [&](const uint8_t *data, size_t size) {
+        output.insert(output.end(), data, data + size);
+        return true;
+    });
+    if (!finishSession(session, session.update(input.data(), input.size()))) return false;
+    if (!codecOptions.verifyAfterWrite) return true;
+
+    // Decode into nothing; the session checks each block's checksum
+    ARITHMA_TRACE_SCOPE("job", "verify");
+    const auto started = std::chrono::steady_clock::now();
+    DecompressionSession check(codecOptions.threads, [](const uint8_t *, size_t) { return true; });
+    const bool ok = check.update(output.data(), output.size()) && check.finish();
+    jobStats.verifySeconds = secondsSince(started);
+    if (!ok) {
+        error = "Verification failed: " + check.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool CodecEngine::decompress(const std::vector<uint8_t> &input, std::vector<uint8_t> &output)
+{
+    output.clear();
+    DecompressionSession session(codecOptions.threads, [&](const uint8_t *data, size_t size) {
+        output.insert(output.end(), data, data + size);
+        return true;
+    }, codecOptions.perfCounters);
+    return finishSession(session, session.update(input.data(), input.size()));
+}
+
+bool CodecEngine::compressStream(std::istream &in, std::ostream &out)
+{
+    CompressionSession session(codecOptions, [&](const uint8_t *data, size_t size) {
+        out.write(reinterpret_cast<const char *>(data), static_cast<std::streamsize>(size));
+        return static_cast<bool>(out);
+    });
+    return finishSession(session, pump(in, session, codecOptions.blockSize));
+}
+
+bool CodecEngine::decompressStream(std::istream &in, std::ostream &out)
+{
+    DecompressionSession session(codecOptions.threads, [&](const uint8_t *data, size_t size) {
+        out.write(reinterpret_cast<const char *>(data), static_cast<std::streamsize>(size));
+        return static_cast<bool>(out);
+    }, codecOptions.perfCounters);
+    return finishSession(session, pump(in, session, kStreamChunk));
+}
+
+bool CodecEngine::compressFile(const std::string &inputPath, const std::string &outputPath)
+{
+    std::ifstream in(inputPath, std::ios::binary);
+    if (!in) {
+        error = "Could not open " + inputPath;
+        return false;
+    }
+    std::ofstream out(outputPath, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        error = "Could not create " + outputPath;
+        return false;
+    }
+    if (!compressStream(in, out)) return false;
+    if (!codecOptions.verifyAfterWrite) return true;
+
+    out.close();
+    if (!out) {
+        error = "Could not write " + outputPath;
+        return false;
+    }
+    return verifyFile(outputPath);
+}
+
+bool CodecEngine::decompressFile(const std::string &inputPath, const std::string &outputPath)
+{
+    std::ifstream in(inputPath, std::ios::binary);
+    if (!in) {
+        error = "Could not open " + inputPath;
+        return false;
+    }
+    std::ofstream out(outputPath, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        error = "Could not create " + outputPath;
+        return false;
+    }
+    return decompressStream(in, out);
+}
+
+bool CodecEngine::decompressRange(const std::string &containerPath, uint64_t offset,
+                                  uint64_t length, std::vector<uint8_t> &output)
+{
+    const auto started = std::chrono::steady_clock::now();
+    const double cpuStarted = readProcessUsage().cpuSeconds;
+    output.clear();
+    std::unique_ptr<PerfRecorder> perf(codecOptions.perfCounters ? new PerfRecorder : nullptr);
+
+    ContainerReader reader;
+    if (!reader.open(containerPath)) {
+        error = reader.errorString();
+        return false;
+    }
+
+    jobStats = JobStats();
+    const uint64_t originalSize = reader.footer().originalSize;
+    if (offset >= originalSize || length == 0) {
+        return true;
+    }
+    const uint64_t end = offset + std::min(length, originalSize - offset);
+
+    // Blocks of a transformed container hold no original offsets, so it is
+    // decoded from the start and the range kept as it goes by. The sink
+    // refuses more once the range is complete, which stops the session
+    // there rather than at the end of the file.
+    if (transformVersion(reader.header()) != 0) {
+        uint64_t position = 0;
+        DecompressionSession session(codecOptions.threads, [&](const uint8_t *data, size_t size) {
+            const uint64_t from = std::max(offset, position);
+            const uint64_t to   = std::min(end, position + size);
+            if (from < to) output.insert(output.end(), data + (from - position), data + (to - position));
+            position += size;
+            return position < end;
+        }, codecOptions.perfCounters);
+        std::ifstream in(containerPath, std::ios::binary);
+        const bool fed = pump(in, session, kStreamChunk);
+        const bool finished = position >= end || finishSession(session, fed);
+        // Inverse transforms that emit their output when finished meet the
+        // refusal there; only a range left short is a failure
+        if (!finished && position < end) return false;
+        jobStats = session.stats();
+        jobStats.outputBytes = output.size();
+        jobStats.wallSeconds = secondsSince(started);
+        return true;
+    }
+
+    const int64_t first = reader.blockForOffset(offset);
+    const int64_t last  = reader.blockForOffset(end - 1);
+    if (first < 0 || last < first) {
+        error = "Seek index does not cover the requested range";
+        return false;
+    }
+
+    // Fetch the covering blocks, then decode them in parallel
+    const size_t count = static_cast<size_t>(last - first + 1);
+    std::vector<BlockIndexEntry> entries(count);
+    std::vector<BlockHeader> blockHeaders(count);
+    std::vector<std::vector<uint8_t>> payload(count);
+    std::vector<std::vector<uint8_t>> raw(count);
+    std::vector<char> ok(count);
+    PerfStageScope reading(perf.get(), PerfStage::Read);
+    for (size_t i = 0; i < count; ++i) {
+        if (!reader.readIndexEntry(static_cast<uint32_t>(first + i), entries[i])
+            || !reader.readBlock(entries[i], blockHeaders[i], payload[i])) {
+            error = reader.errorString();
+            return false;
+        }
+        raw[i].resize(entries[i].rawSize);
+    }
+    reading.close();
+
+    const ContainerHeader &header = reader.header();
+    Primer primer;
+    if (!containerPrimer(header, primer, error)) return false;
+    {
+        PerfStageScope coding(perf.get(), PerfStage::Code);
+        parallelFor(count, resolveThreadCount(codecOptions.threads), [&](size_t i) {
+            ok[i] = decodeBlock(header.backend, header.level, primer, payload[i].data(), payload[i].size(),
+                                raw[i].data(), raw[i].size())
+                    && (!hasBlockChecksums(header) || blockChecksumMatches(raw[i], blockHeaders[i].checksum));
+        });
+    }
+
+    output.reserve(static_cast<size_t>(end - offset));
+    for (size_t i = 0; i < count; ++i) {
+        if (!ok[i]) {
+            error = "Block " + std::to_string(first + i) + " is corrupt";
+            return false;
+        }
+        const uint64_t blockStart = entries[i].rawOffset;
+        const uint64_t from = std::max(offset, blockStart) - blockStart;
+        const uint64_t to   = std::min(end, blockStart + entries[i].rawSize) - blockStart;
+        output.insert(output.end(), raw[i].begin() + from, raw[i].begin() + to);
+        jobStats.inputBytes += blockHeaderSize(header) + entries[i].payloadSize;
+    }
+
+    jobStats.outputBytes = output.size();
+    jobStats.blocks      = static_cast<uint32_t>(count);
+    jobStats.wallSeconds = secondsSince(started);
+    const ProcessUsage usage = readProcessUsage();
+    jobStats.cpuSeconds  = usage.cpuSeconds - cpuStarted;
+    jobStats.peakRssKB   = usage.peakRssKB;
+    jobStats.level       = header.level;
+    jobStats.backend     = header.backend;
+    if (perf) jobStats.perf = perf->stats();
+    return true;
+}
+
+bool CodecEngine::verifyFile(const std::string &containerPath)
+{
+    ARITHMA_TRACE_SCOPE("job", "verify");
+    const auto started = std::chrono::steady_clock::now();
+    ContainerReader reader;
+    if (!reader.open(containerPath)) {
+        error = reader.errorString();
+        return false;
+    }
+
+    // One batch of blocks per round, as in decoding, so memory stays at
+    // threads x blockSize whatever the file size
+    const ContainerHeader &header = reader.header();
+    const int threads = resolveThreadCount(codecOptions.threads);
+    Primer primer;
+    std::unique_ptr<TypeTransform> inverse;
+    if (!containerPrimer(header, primer, error) || !containerTransform(header, primer, threads, inverse, error)) {
+        error = "Verification failed: " + error;
+        return false;
+    }
+    const uint32_t blockCount = reader.footer().blockCount;
+    const size_t batchSize = static_cast<size_t>(threads);
+    std::vector<BlockIndexEntry> entries(batchSize);
+    std::vector<BlockHeader> blockHeaders(batchSize);
+    std::vector<std::vector<uint8_t>> payload(batchSize);
+    std::vector<std::vector<uint8_t>> raw(batchSize);
+    std::vector<char> decoded(batchSize);
+    std::vector<char> intact(batchSize);
+
+    std::vector<uint32_t> corrupt;
+    std::vector<uint32_t> mismatched;
+    uint64_t rawTotal = 0;
+    uint64_t rebuilt = 0;      // inverse transform output, when there is one
+    bool rebuildFailed = false;
+    std::vector<uint8_t> scratch;
+    for (uint32_t first = 0; first < blockCount; first += static_cast<uint32_t>(batchSize)) {
+        const size_t count = std::min<size_t>(batchSize, blockCount - first);
+        for (size_t i = 0; i < count; ++i) {
+            if (!reader.readIndexEntry(first + static_cast<uint32_t>(i), entries[i])
+                || !reader.readBlock(entries[i], blockHeaders[i], payload[i])) {
+                error = "Verification failed: " + reader.errorString();
+                return false;
+            }
+            raw[i].resize(entries[i].rawSize);
+        }
+
+        parallelFor(count, threads, [&](size_t i) {
+            ARITHMA_TRACE_SCOPE("code", "verify block");
+            decoded[i] = decodeBlock(header.backend, header.level, primer, payload[i].data(),
+                                     payload[i].size(), raw[i].data(), raw[i].size());
+            intact[i] = !decoded[i] || !hasBlockChecksums(header)
+                        || blockChecksumMatches(raw[i], blockHeaders[i].checksum);
+        });
+
+        for (size_t i = 0; i < count; ++i) {
+            if (!decoded[i]) corrupt.push_back(first + static_cast<uint32_t>(i));
+            else if (!intact[i]) mismatched.push_back(first + static_cast<uint32_t>(i));
+            rawTotal += entries[i].rawSize;
+        }
+
+        // The inverse transform must also accept every block, in order
+        if (inverse && !rebuildFailed && corrupt.empty() && mismatched.empty()) {
+            for (size_t i = 0; i < count && !rebuildFailed; ++i) {
+                size_t size = raw[i].size();
+                do {
+                    scratch.clear();
+                    rebuildFailed = !inverse->update(raw[i].data(), size, scratch);
+                    rebuilt += scratch.size();
+                    size = 0;
+                } while (!rebuildFailed && inverse->moreOutput());
+            }
+        }
+    }
+    if (inverse && !rebuildFailed && corrupt.empty() && mismatched.empty()) {
+        scratch.clear();
+        rebuildFailed = !inverse->finish(scratch);
+        rebuilt += scratch.size();
+    }
+    jobStats.verifySeconds = secondsSince(started);
+
+    // Name every bad block rather than stopping at the first
+    auto describe = [](const std::vector<uint32_t> &blocks, const char *what) {
+        std::string text = blocks.size() == 1 ? "block" : "blocks";
+        const size_t shown = std::min<size_t>(blocks.size(), 8);
+        for (size_t i = 0; i < shown; ++i) {
+            text += (i ? ", " : " ") + std::to_string(blocks[i]);
+        }
+        if (blocks.size() > shown) text += " and " + std::to_string(blocks.size() - shown) + " more";
+        return text + " " + what;
+    };
+    std::string problems;
+    if (!corrupt.empty()) problems = describe(corrupt, "could not be decoded");
+    if (!mismatched.empty()) {
+        problems += (problems.empty() ? "" : "; ") + describe(mismatched, "failed the checksum");
+    }
+    if (problems.empty() && rebuildFailed) {
+        problems = std::string("the ") + fileTypeName(header.fileType) + " data could not be rebuilt: "
+                   + inverse->errorString();
+    }
+    if (problems.empty() && (inverse ? rebuilt : rawTotal) != reader.footer().originalSize) {
+        problems = "blocks do not add up to the original size";
+    }
+    if (!problems.empty()) {
+        error = "Verification failed: " + problems;
+        return false;
+    }
+    return true;
+}
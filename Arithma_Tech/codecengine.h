@@ -0,0 +1,117 @@
+#ifndef CODECENGINE_H
+#define CODECENGINE_H
+
+#include "container.h"
+#include "perfcounters.h"
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+/**
+ * @brief CodecOptions
+ *        Knobs for a compression job. Decompression takes everything it
+ *        needs from the container header and only honours threads.
+ */
+struct CodecOptions
+{
+    int      level     = 2;          // 1..3, higher is slower and stronger
+    int      threads   = 0;          // 0 picks the hardware concurrency
+    uint32_t blockSize = 1u << 20;   // bytes per independently coded block
+    FileType fileType  = FileType::Binary;
+    Backend  backend   = Backend::Arithmetic;
+    bool     perfCounters = false;   // collect hardware counters into JobStats
+    bool     verifyAfterWrite = false;   // compress() and compressFile() decode
+                                         // their output and check every block
+    bool     usePrimers = true;      // start blocks from the trained model for
+                                     // fileType (see primer.h)
+    bool     useTransforms = true;   // run fileType's preprocessing, if it has
+                                     // one (see typeregistry.h)
+};
+
+/**
+ * @brief JobStats
+ *        Figures for the most recent compress/decompress call.
+ */
+struct JobStats
+{
+    uint64_t inputBytes  = 0;
+    uint64_t outputBytes = 0;
+    uint32_t blocks      = 0;
+    double   wallSeconds = 0.0;
+    double   cpuSeconds  = 0.0;          // all threads of the process
+    uint64_t peakRssKB   = 0;            // process peak, not just this job
+    int      level       = 0;            // as written to / read from the header
+    Backend  backend     = Backend::Arithmetic;
+    double   verifySeconds = 0.0;        // verify-after-write, when it ran
+    PerfStats perf;                  // when CodecOptions::perfCounters is set
+    std::vector<double> frameSeconds;    // each frame of an animation, when
+                                         // its type's transform codes frames
+    uint64_t framePixels     = 0;        // pixels of the frames it modelled
+    uint64_t unchangedPixels = 0;        // of those, copied from the frame
+                                         // before rather than modelled
+};
+
+/**
+ * @brief CodecEngine
+ *        Adaptive arithmetic coding over independently coded blocks.
+ *        Blocks are coded in parallel and recorded in a seek index, so any
+ *        byte range can be restored by decoding just the blocks covering it.
+ *        Every call returns false on failure and leaves a message in
+ *        errorString().
+ */
+class CodecEngine
+{
+public:
+    static constexpr int kMinLevel = 1;
+    static constexpr int kMaxLevel = 3;
+
+    explicit CodecEngine(const CodecOptions &options = CodecOptions());
+
+    const CodecOptions &options() const { return codecOptions; }
+
+    // In-memory buffers
+    bool compress(const std::vector<uint8_t> &input, std::vector<uint8_t> &output);
+    bool decompress(const std::vector<uint8_t> &input, std::vector<uint8_t> &output);
+
+    // Streams; only threads x blockSize bytes are held in memory at a time
+    bool compressStream(std::istream &in, std::ostream &out);
+    bool decompressStream(std::istream &in, std::ostream &out);
+
+    // Files
+    bool compressFile(const std::string &inputPath, const std::string &outputPath);
+    bool decompressFile(const std::string &inputPath, const std::string &outputPath);
+
+    // Restore bytes [offset, offset + length) of the original data from a
+    // container file. Only the covering blocks are read and decoded, or
+    // for a transformed container the blocks up to the range's end; the
+    // result is shorter than length when the range runs past the end.
+    bool decompressRange(const std::string &containerPath, uint64_t offset,
+                         uint64_t length, std::vector<uint8_t> &output);
+
+    // Decode every block of a container file in parallel and check it
+    // against its checksum, without writing anything. All failing blocks
+    // are named in errorString(). stats() keeps the previous job's figures
+    // and gains verifySeconds.
+    bool verifyFile(const std::string &containerPath);
+
+    const JobStats &stats() const { return jobStats; }
+
+    const std::string &errorString() const { return error; }
+
+private:
+    // Finish a session fed by update() calls and collect its results
+    template <typename Session>
+    bool finishSession(Session &session, bool fed);
+
+    CodecOptions codecOptions;
+    JobStats     jobStats;
+    std::string  error;
+};
+
+// Flags word of the container a compression with options writes: block
+// checksums, the primer set and the transform version (see container.h)
+uint32_t containerFlags(const CodecOptions &options);
+
+#endif // CODECENGINE_H
@@ -0,0 +1,422 @@
+#include "codecsession.h"
+
+#include "blockcodec.h"
+#include "crc32c.h"
+#include "parallel.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Timing, resource and format figures common to both directions
+void recordJobFigures(JobStats &stats, std::chrono::steady_clock::time_point started,
+                      double cpuStarted, const ContainerHeader &header)
+{
+    const ProcessUsage usage = readProcessUsage();
+    stats.wallSeconds = secondsSince(started);
+    stats.cpuSeconds  = usage.cpuSeconds - cpuStarted;
+    stats.peakRssKB   = usage.peakRssKB;
+    stats.level       = header.level;
+    stats.backend     = header.backend;
+}
+}
+
+bool blockChecksumMatches(const std::vector<uint8_t> &raw, uint32_t checksum)
+{
+    ARITHMA_TRACE_SCOPE("checksum", "crc32c");
+    return crc32c(0, raw.data(), raw.size()) == checksum;
+}
+
+bool containerPrimer(const ContainerHeader &header, Primer &primer, std::string &error)
+{
+    const uint8_t set = primerSet(header);
+    if (!primerSetKnown(set)) {
+        error = "Container needs primer set " + std::to_string(set)
+                + ", which this version does not have";
+        return false;
+    }
+    primer = findPrimer(set, header.fileType);
+    return true;
+}
+
+// 1) CompressionSession Implementation
+CompressionSession::CompressionSession(const CodecOptions &options, ByteSink sink)
+    : codecOptions(options),
+    sink(std::move(sink)),
+    threads(resolveThreadCount(options.threads)),
+    headerWritten(false),
+    finished(false),
+    sinkFailed(false),
+    raw(threads),
+    coded(threads),
+    checksums(threads),
+    filled(0),
+    rawOffset(0),
+    blockOffset(ContainerHeader::kSize),
+    started(std::chrono::steady_clock::now()),
+    cpuStarted(readProcessUsage().cpuSeconds)
+{
+    codecOptions.level = std::max(CodecEngine::kMinLevel,
+                                  std::min(CodecEngine::kMaxLevel, codecOptions.level));
+    if (codecOptions.blockSize == 0) {
+        codecOptions.blockSize = CodecOptions().blockSize;
+    }
+
+    header.fileType  = codecOptions.fileType;
+    header.level     = static_cast<uint8_t>(codecOptions.level);
+    header.backend   = codecOptions.backend;
+    header.blockSize = codecOptions.blockSize;
+    header.flags     = containerFlags(codecOptions);
+    if (codecOptions.usePrimers) primer = findPrimer(currentPrimerSet(), codecOptions.fileType);
+    const TypeCodec &codec = typeCodec(codecOptions.fileType);
+    if (codecOptions.useTransforms && codec.forward) transform = codec.forward(primer, threads);
+    if (codecOptions.perfCounters) perf.reset(new PerfRecorder);
+}
+
+bool CompressionSession::update(const uint8_t *data, size_t size)
+{
+    if (finished) {
+        error = "Session is already finished";
+        return false;
+    }
+    jobStats.inputBytes += size;
+    if (!transform) return append(data, size);
+
+    staged.clear();
+    if (!transform->update(data, size, staged)) {
+        error = transform->errorString();
+        return false;
+    }
+    return append(staged.data(), staged.size());
+}
+
+bool CompressionSession::append(const uint8_t *data, size_t size)
+{
+    const size_t blockSize = codecOptions.blockSize;
+    while (size > 0) {
+        std::vector<uint8_t> &block = raw[filled];
+        const size_t take = std::min(size, blockSize - block.size());
+        block.insert(block.end(), data, data + take);
+        data += take;
+        size -= take;
+
+        if (block.size() == blockSize) {
+            // Code a batch once every worker has a full block
+            if (++filled == raw.size()) {
+                if (!flushBatch(filled)) return false;
+                filled = 0;
+            }
+        }
+    }
+    return true;
+}
+
+bool CompressionSession::finish()
+{
+    if (finished) {
+        error = "Session is already finished";
+        return false;
+    }
+    finished = true;
+    if (transform) {
+        staged.clear();
+        if (!transform->finish(staged)) {
+            error = transform->errorString();
+            return false;
+        }
+        transform->addStats(jobStats);
+        if (!append(staged.data(), staged.size())) return false;
+    }
+
+    const size_t count = filled + (filled < raw.size() && !raw[filled].empty() ? 1 : 0);
+    if (!flushBatch(count)) return false;
+    if (!headerWritten) {
+        std::vector<uint8_t> buffer;
+        writeContainerHeader(header, buffer);
+        if (!emit(buffer.data(), buffer.size())) return false;
+        headerWritten = true;
+    }
+
+    // End marker, seek index and footer
+    std::vector<uint8_t> buffer;
+    writeBlockHeader(BlockHeader(), hasBlockChecksums(header), buffer);
+    for (const BlockIndexEntry &entry : index) {
+        writeIndexEntry(entry, buffer);
+    }
+    ContainerFooter footer;
+    footer.originalSize = jobStats.inputBytes;
+    footer.indexOffset  = blockOffset + blockHeaderSize(header);
+    footer.blockCount   = static_cast<uint32_t>(index.size());
+    writeContainerFooter(footer, buffer);
+    if (!emit(buffer.data(), buffer.size())) return false;
+
+    jobStats.blocks = footer.blockCount;
+    recordJobFigures(jobStats, started, cpuStarted, header);
+    if (perf) jobStats.perf = perf->stats();
+    return true;
+}
+
+bool CompressionSession::flushBatch(size_t count)
+{
+    ARITHMA_TRACE_SCOPE("job", "encode batch");
+    std::vector<uint8_t> buffer;
+    if (!headerWritten) {
+        writeContainerHeader(header, buffer);
+        headerWritten = true;
+    }
+
+    // Output the transform already entropy coded is only framed
+    const bool store = transform && transform->entropyCoded();
+    {
+        PerfStageScope stage(perf.get(), PerfStage::Code);
+        parallelFor(count, threads, [&](size_t i) {
+            ARITHMA_TRACE_SCOPE("code", "encode block");
+            {
+                // Checksum the raw block while the worker has it in cache
+                ARITHMA_TRACE_SCOPE("checksum", "crc32c");
+                checksums[i] = crc32c(0, raw[i].data(), raw[i].size());
+            }
+            if (store) {
+                coded[i] = raw[i];
+            } else {
+                coded[i].clear();
+                encodeBlock(header.backend, header.level, primer, raw[i].data(), raw[i].size(), coded[i]);
+            }
+        });
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        BlockIndexEntry entry;
+        entry.rawOffset   = rawOffset;
+        entry.blockOffset = blockOffset;
+        entry.rawSize     = static_cast<uint32_t>(raw[i].size());
+        entry.payloadSize = static_cast<uint32_t>(coded[i].size());
+        index.push_back(entry);
+
+        BlockHeader blockHeader;
+        blockHeader.rawSize     = entry.rawSize;
+        blockHeader.payloadSize = entry.payloadSize;
+        blockHeader.checksum    = checksums[i];
+        writeBlockHeader(blockHeader, hasBlockChecksums(header), buffer);
+        buffer.insert(buffer.end(), coded[i].begin(), coded[i].end());
+
+        rawOffset   += entry.rawSize;
+        blockOffset += blockHeaderSize(header) + entry.payloadSize;
+        raw[i].clear();
+    }
+    return buffer.empty() || emit(buffer.data(), buffer.size());
+}
+
+bool CompressionSession::emit(const uint8_t *data, size_t size)
+{
+    ARITHMA_TRACE_SCOPE("io", "write");
+    PerfStageScope stage(perf.get(), PerfStage::Write);
+    if (!sink(data, size)) {
+        error = "Could not write compressed output";
+        sinkFailed = true;
+        return false;
+    }
+    jobStats.outputBytes += size;
+    return true;
+}
+
+// 2) DecompressionSession Implementation
+DecompressionSession::DecompressionSession(int threads, ByteSink sink, bool perfCounters)
+    : sink(std::move(sink)),
+    threads(resolveThreadCount(threads)),
+    state(State::Header),
+    sinkFailed(false),
+    originalSize(0),
+    delivered(0),
+    consumed(0),
+    payload(this->threads),
+    raw(this->threads),
+    checksums(this->threads),
+    ok(this->threads),
+    intact(this->threads),
+    batch(0),
+    blockCount(0),
+    totalRaw(0),
+    indexRemaining(0),
+    started(std::chrono::steady_clock::now()),
+    cpuStarted(readProcessUsage().cpuSeconds),
+    perf(perfCounters ? new PerfRecorder : nullptr)
+{
+}
+
+bool DecompressionSession::update(const uint8_t *data, size_t size)
+{
+    if (state == State::Failed) return false;
+    jobStats.inputBytes += size;
+
+    // Drop parsed bytes before appending so the buffer stays small
+    if (consumed > 0) {
+        input.erase(input.begin(), input.begin() + consumed);
+        consumed = 0;
+    }
+    input.insert(input.end(), data, data + size);
+
+    for (;;) {
+        const size_t available = input.size() - consumed;
+        const uint8_t *p = input.data() + consumed;
+
+        switch (state) {
+        case State::Header:
+            if (available < ContainerHeader::kSize) return true;
+            if (!readContainerHeader(p, containerHeader)) {
+                return fail("Not an Arithma-Tech container");
+            }
+            if (!containerPrimer(containerHeader, primer, error)
+                || !containerTransform(containerHeader, primer, threads, inverse, error)) {
+                return fail(error);
+            }
+            consumed += ContainerHeader::kSize;
+            state = State::BlockHeader;
+            break;
+
+        case State::BlockHeader: {
+            const uint32_t headerSize = blockHeaderSize(containerHeader);
+            if (available < headerSize) return true;
+            readBlockHeader(p, hasBlockChecksums(containerHeader), pendingBlock);
+            consumed += headerSize;
+            if (pendingBlock.rawSize == 0 && pendingBlock.payloadSize == 0) {
+                if (!decodeBatch()) return false;
+                indexRemaining = uint64_t(blockCount) * BlockIndexEntry::kSize;
+                state = State::Index;
+            } else if (pendingBlock.rawSize > containerHeader.blockSize) {
+                return fail("Block is larger than the container's block size");
+            } else {
+                state = State::Payload;
+            }
+            break;
+        }
+
+        case State::Payload:
+            if (available < pendingBlock.payloadSize) return true;
+            payload[batch].assign(p, p + pendingBlock.payloadSize);
+            raw[batch].resize(pendingBlock.rawSize);
+            checksums[batch] = pendingBlock.checksum;
+            consumed += pendingBlock.payloadSize;
+            if (++batch == payload.size() && !decodeBatch()) return false;
+            state = State::BlockHeader;
+            break;
+
+        case State::Index: {
+            // The index only serves random access; a stream decoder skips it
+            const size_t skip = static_cast<size_t>(std::min<uint64_t>(indexRemaining, available));
+            consumed += skip;
+            indexRemaining -= skip;
+            if (indexRemaining > 0) return true;
+            state = State::Footer;
+            break;
+        }
+
+        case State::Footer: {
+            if (available < ContainerFooter::kSize) return true;
+            ContainerFooter footer;
+            // Only the inverse transform knows how long its output will be
+            if (!readContainerFooter(p, footer) || (!inverse && footer.originalSize != totalRaw)
+                || footer.blockCount != blockCount) {
+                return fail("Container footer does not match its blocks");
+            }
+            originalSize = footer.originalSize;
+            consumed += ContainerFooter::kSize;
+            state = State::Done;
+            break;
+        }
+
+        case State::Done:
+            if (available > 0) return fail("Unexpected data after the container footer");
+            return true;
+
+        case State::Failed:
+            return false;
+        }
+    }
+}
+
+bool DecompressionSession::finish()
+{
+    if (state == State::Failed) return false;
+    if (state != State::Done) return fail("Compressed data is truncated");
+    if (inverse) {
+        staged.clear();
+        if (!inverse->finish(staged)) return fail(inverse->errorString());
+        inverse->addStats(jobStats);
+        if (!deliver(staged.data(), staged.size())) return false;
+        if (delivered != originalSize) return fail("Rebuilt data does not match the original size");
+    }
+
+    jobStats.outputBytes = delivered;
+    jobStats.blocks      = blockCount;
+    recordJobFigures(jobStats, started, cpuStarted, containerHeader);
+    if (perf) jobStats.perf = perf->stats();
+    return true;
+}
+
+bool DecompressionSession::decodeBatch()
+{
+    ARITHMA_TRACE_SCOPE("job", "decode batch");
+    const ContainerHeader &header = containerHeader;
+    {
+        PerfStageScope stage(perf.get(), PerfStage::Code);
+        parallelFor(batch, threads, [&](size_t i) {
+            ARITHMA_TRACE_SCOPE("code", "decode block");
+            ok[i] = decodeBlock(header.backend, header.level, primer, payload[i].data(), payload[i].size(),
+                                raw[i].data(), raw[i].size());
+            intact[i] = !ok[i] || !hasBlockChecksums(header)
+                        || blockChecksumMatches(raw[i], checksums[i]);
+        });
+    }
+
+    for (size_t i = 0; i < batch; ++i) {
+        if (!ok[i]) {
+            return fail("Block " + std::to_string(blockCount + i) + " is corrupt");
+        }
+        if (!intact[i]) {
+            return fail("Block " + std::to_string(blockCount + i) + " does not match its checksum");
+        }
+        totalRaw += raw[i].size();
+        if (!inverse) {
+            if (!deliver(raw[i].data(), raw[i].size())) return false;
+            continue;
+        }
+        const uint8_t *data = raw[i].data();
+        size_t size = raw[i].size();
+        do {
+            staged.clear();
+            if (!inverse->update(data, size, staged)) return fail(inverse->errorString());
+            if (!deliver(staged.data(), staged.size())) return false;
+            size = 0;
+        } while (inverse->moreOutput());
+    }
+    blockCount += static_cast<uint32_t>(batch);
+    batch = 0;
+    return true;
+}
+
+bool DecompressionSession::deliver(const uint8_t *data, size_t size)
+{
+    if (size == 0) return true;
+    TraceScope write("io", "write");
+    PerfStageScope stage(perf.get(), PerfStage::Write);
+    if (!sink(data, size)) {
+        sinkFailed = true;
+        return fail("Could not write decompressed output");
+    }
+    delivered += size;
+    return true;
+}
+
+bool DecompressionSession::fail(const std::string &message)
+{
+    error = message;
+    state = State::Failed;
+    return false;
+}
@@ -0,0 +1,148 @@
+#ifndef CODECSESSION_H
+#define CODECSESSION_H
+
+#include "codecengine.h"
+#include "container.h"
+#include "primer.h"
+#include "typeregistry.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Receives produced bytes; returning false aborts the session
+using ByteSink = std::function<bool(const uint8_t *data, size_t size)>;
+
+/**
+ * @brief CompressionSession
+ *        Push-style compressor: feed input with update() in pieces of any
+ *        size, then call finish() once. Container bytes go to the sink as
+ *        soon as a batch of blocks (one per worker) has been coded. Input
+ *        passes through the file type's transform first, if it has one.
+ */
+class CompressionSession
+{
+public:
+    CompressionSession(const CodecOptions &options, ByteSink sink);
+
+    bool update(const uint8_t *data, size_t size);
+    bool finish();
+
+    const JobStats &stats() const { return jobStats; }
+    const std::string &errorString() const { return error; }
+
+    // True when a failure came from the sink rather than the data
+    bool outputFailed() const { return sinkFailed; }
+
+    // Counter collector when CodecOptions::perfCounters is set, else null;
+    // callers attribute their own reads to it
+    PerfRecorder *perfRecorder() { return perf.get(); }
+
+private:
+    bool append(const uint8_t *data, size_t size);
+    bool flushBatch(size_t count);
+    bool emit(const uint8_t *data, size_t size);
+
+    CodecOptions    codecOptions;
+    ByteSink        sink;
+    ContainerHeader header;
+    Primer          primer;
+    std::unique_ptr<TypeTransform> transform;
+    std::vector<uint8_t> staged;               // transform output
+    int             threads;
+    bool            headerWritten;
+    bool            finished;
+    bool            sinkFailed;
+
+    std::vector<std::vector<uint8_t>> raw;    // one pending block per worker
+    std::vector<std::vector<uint8_t>> coded;
+    std::vector<uint32_t> checksums;           // CRC-32C of each raw block
+    size_t          filled;                    // complete blocks in raw
+    std::vector<BlockIndexEntry> index;
+    uint64_t        rawOffset;
+    uint64_t        blockOffset;
+
+    JobStats        jobStats;
+    std::string     error;
+    std::chrono::steady_clock::time_point started;
+    double          cpuStarted;
+    std::unique_ptr<PerfRecorder> perf;
+};
+
+/**
+ * @brief DecompressionSession
+ *        Push-style decompressor: feed container bytes with update() in
+ *        pieces of any size and call finish() after the last one to check
+ *        that the container was complete.
+ */
+class DecompressionSession
+{
+public:
+    DecompressionSession(int threads, ByteSink sink, bool perfCounters = false);
+
+    bool update(const uint8_t *data, size_t size);
+    bool finish();
+
+    // Valid once the first ContainerHeader::kSize bytes have been fed
+    const ContainerHeader &header() const { return containerHeader; }
+
+    const JobStats &stats() const { return jobStats; }
+    const std::string &errorString() const { return error; }
+
+    // True when a failure came from the sink rather than the data
+    bool outputFailed() const { return sinkFailed; }
+
+    PerfRecorder *perfRecorder() { return perf.get(); }
+
+private:
+    enum class State { Header, BlockHeader, Payload, Index, Footer, Done, Failed };
+
+    bool decodeBatch();
+    bool deliver(const uint8_t *data, size_t size);
+    bool fail(const std::string &message);
+
+    ByteSink        sink;
+    int             threads;
+    State           state;
+    bool            sinkFailed;
+    ContainerHeader containerHeader;
+    Primer          primer;
+    std::unique_ptr<TypeTransform> inverse;
+    std::vector<uint8_t> staged;   // inverse transform output
+    uint64_t        originalSize;  // from the footer
+    uint64_t        delivered;
+    BlockHeader     pendingBlock;
+
+    std::vector<uint8_t> input;   // unparsed bytes
+    size_t          consumed;
+
+    std::vector<std::vector<uint8_t>> payload;
+    std::vector<std::vector<uint8_t>> raw;
+    std::vector<uint32_t> checksums;   // as read from the block headers
+    std::vector<char> ok;              // payload decoded
+    std::vector<char> intact;          // and its checksum matched
+    size_t          batch;
+    uint32_t        blockCount;
+    uint64_t        totalRaw;
+    uint64_t        indexRemaining;
+
+    JobStats        jobStats;
+    std::string     error;
+    std::chrono::steady_clock::time_point started;
+    double          cpuStarted;
+    std::unique_ptr<PerfRecorder> perf;
+};
+
+// CRC-32C of a decoded block against the one stored in its header; used by
+// the decoders on their worker threads
+bool blockChecksumMatches(const std::vector<uint8_t> &raw, uint32_t checksum);
+
+// Primer a container's blocks were coded with; false, with a message in
+// error, when this build does not have its set
+bool containerPrimer(const ContainerHeader &header, Primer &primer, std::string &error);
+
+#endif // CODECSESSION_H
@@ -0,0 +1,232 @@
+#include "container.h"
+
+#include "trace.h"
+
+namespace {
+const uint8_t kHeaderMagic[4] = {'A', 'T', 'C', '1'};
+const uint8_t kFooterMagic[4] = {'A', 'T', 'C', 'X'};
+
+void putU32(std::vector<uint8_t> &out, uint32_t v)
+{
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+    }
+}
+
+void putU64(std::vector<uint8_t> &out, uint64_t v)
+{
+    for (int i = 0; i < 8; ++i) {
+        out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+    }
+}
+
+uint32_t getU32(const uint8_t *p)
+{
+    return static_cast<uint32_t>(p[0])
+           | (static_cast<uint32_t>(p[1]) << 8)
+           | (static_cast<uint32_t>(p[2]) << 16)
+           | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+uint64_t getU64(const uint8_t *p)
+{
+    return static_cast<uint64_t>(getU32(p)) | (static_cast<uint64_t>(getU32(p + 4)) << 32);
+}
+}
+
+// 1) File types
+const char *fileTypeName(FileType type)
+{
+    switch (type) {
+    case FileType::Binary: return "binary";
+    case FileType::Text:   return "text";
+    case FileType::Png:    return "png";
+    case FileType::Jpeg:   return "jpeg";
+    case FileType::Bmp:    return "bmp";
+    case FileType::Gif:    return "gif";
+    }
+    return "unknown";
+}
+
+// 2) Serialization
+void writeContainerHeader(const ContainerHeader &header, std::vector<uint8_t> &out)
+{
+    out.insert(out.end(), kHeaderMagic, kHeaderMagic + 4);
+    out.push_back(header.version);
+    out.push_back(static_cast<uint8_t>(header.fileType));
+    out.push_back(header.level);
+    out.push_back(static_cast<uint8_t>(header.backend));
+    putU32(out, header.blockSize);
+    putU32(out, header.flags);
+}
+
+void writeBlockHeader(const BlockHeader &header, bool checksummed, std::vector<uint8_t> &out)
+{
+    putU32(out, header.rawSize);
+    putU32(out, header.payloadSize);
+    if (checksummed) putU32(out, header.checksum);
+}
+
+void writeIndexEntry(const BlockIndexEntry &entry, std::vector<uint8_t> &out)
+{
+    putU64(out, entry.rawOffset);
+    putU64(out, entry.blockOffset);
+    putU32(out, entry.rawSize);
+    putU32(out, entry.payloadSize);
+}
+
+void writeContainerFooter(const ContainerFooter &footer, std::vector<uint8_t> &out)
+{
+    putU64(out, footer.originalSize);
+    putU64(out, footer.indexOffset);
+    putU32(out, footer.blockCount);
+    out.insert(out.end(), kFooterMagic, kFooterMagic + 4);
+}
+
+bool readContainerHeader(const uint8_t *data, ContainerHeader &header)
+{
+    for (int i = 0; i < 4; ++i) {
+        if (data[i] != kHeaderMagic[i]) return false;
+    }
+    header.version   = data[4];
+    header.fileType  = static_cast<FileType>(data[5]);
+    header.level     = data[6];
+    header.backend   = static_cast<Backend>(data[7]);
+    header.blockSize = getU32(data + 8);
+    header.flags     = getU32(data + 12);
+    if (header.version == 1) header.flags = 0;   // reserved before version 2
+    return header.version >= 1 && header.version <= ContainerHeader::kVersion
+           && header.backend <= Backend::Binary;
+}
+
+void readBlockHeader(const uint8_t *data, bool checksummed, BlockHeader &header)
+{
+    header.rawSize     = getU32(data);
+    header.payloadSize = getU32(data + 4);
+    header.checksum    = checksummed ? getU32(data + 8) : 0;
+}
+
+void readIndexEntry(const uint8_t *data, BlockIndexEntry &entry)
+{
+    entry.rawOffset   = getU64(data);
+    entry.blockOffset = getU64(data + 8);
+    entry.rawSize     = getU32(data + 16);
+    entry.payloadSize = getU32(data + 20);
+}
+
+bool readContainerFooter(const uint8_t *data, ContainerFooter &footer)
+{
+    for (int i = 0; i < 4; ++i) {
+        if (data[20 + i] != kFooterMagic[i]) return false;
+    }
+    footer.originalSize = getU64(data);
+    footer.indexOffset  = getU64(data + 8);
+    footer.blockCount   = getU32(data + 16);
+    return true;
+}
+
+// 3) ContainerReader Implementation
+ContainerReader::ContainerReader()
+{
+}
+
+bool ContainerReader::open(const std::string &path)
+{
+    file.open(path, std::ios::binary);
+    if (!file) {
+        error = "Could not open " + path;
+        return false;
+    }
+
+    uint8_t buffer[ContainerFooter::kSize];
+    if (!file.read(reinterpret_cast<char *>(buffer), ContainerHeader::kSize)
+        || !readContainerHeader(buffer, containerHeader)) {
+        error = "Not an Arithma-Tech container";
+        return false;
+    }
+
+    file.seekg(-static_cast<std::streamoff>(ContainerFooter::kSize), std::ios::end);
+    if (!file.read(reinterpret_cast<char *>(buffer), ContainerFooter::kSize)
+        || !readContainerFooter(buffer, containerFooter)) {
+        error = "Container footer is missing or damaged";
+        return false;
+    }
+    return true;
+}
+
+int64_t ContainerReader::blockForOffset(uint64_t offset)
+{
+    if (offset >= containerFooter.originalSize || containerFooter.blockCount == 0) {
+        return -1;
+    }
+
+    // Every block but the last holds exactly blockSize bytes, so the
+    // covering block can be computed without touching the index
+    uint64_t guess = containerHeader.blockSize ? offset / containerHeader.blockSize : 0;
+    if (guess >= containerFooter.blockCount) {
+        guess = containerFooter.blockCount - 1;
+    }
+
+    BlockIndexEntry entry;
+    if (readIndexEntry(static_cast<uint32_t>(guess), entry)
+        && offset >= entry.rawOffset && offset < entry.rawOffset + entry.rawSize) {
+        return static_cast<int64_t>(guess);
+    }
+
+    // Fall back to a binary search for irregular block sizes
+    uint32_t lo = 0;
+    uint32_t hi = containerFooter.blockCount;
+    while (lo < hi) {
+        const uint32_t mid = lo + (hi - lo) / 2;
+        if (!readIndexEntry(mid, entry)) return -1;
+        if (offset < entry.rawOffset) {
+            hi = mid;
+        } else if (offset >= entry.rawOffset + entry.rawSize) {
+            lo = mid + 1;
+        } else {
+            return mid;
+        }
+    }
+    return -1;
+}
+
+bool ContainerReader::readIndexEntry(uint32_t block, BlockIndexEntry &entry)
+{
+    if (block >= containerFooter.blockCount) {
+        error = "Block index out of range";
+        return false;
+    }
+
+    uint8_t buffer[BlockIndexEntry::kSize];
+    file.clear();
+    file.seekg(static_cast<std::streamoff>(containerFooter.indexOffset
+                                           + uint64_t(block) * BlockIndexEntry::kSize));
+    if (!file.read(reinterpret_cast<char *>(buffer), BlockIndexEntry::kSize)) {
+        error = "Could not read the seek index";
+        return false;
+    }
+    ::readIndexEntry(buffer, entry);
+    return true;
+}
+
+bool ContainerReader::readBlock(const BlockIndexEntry &entry, BlockHeader &blockHeader,
+                                std::vector<uint8_t> &payload)
+{
+    ARITHMA_TRACE_SCOPE("io", "read block");
+    const bool checksummed = hasBlockChecksums(containerHeader);
+    uint8_t buffer[BlockHeader::kSize + BlockHeader::kChecksumSize];
+    payload.resize(entry.payloadSize);
+    file.clear();
+    file.seekg(static_cast<std::streamoff>(entry.blockOffset));
+    if (!file.read(reinterpret_cast<char *>(buffer), blockHeaderSize(containerHeader))
+        || !file.read(reinterpret_cast<char *>(payload.data()), entry.payloadSize)) {
+        error = "Could not read block data";
+        return false;
+    }
+    ::readBlockHeader(buffer, checksummed, blockHeader);
+    if (blockHeader.rawSize != entry.rawSize || blockHeader.payloadSize != entry.payloadSize) {
+        error = "Block header does not match the seek index";
+        return false;
+    }
+    return true;
+}
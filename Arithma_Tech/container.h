@@ -0,0 +1,180 @@
+#ifndef CONTAINER_H
+#define CONTAINER_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/*
+ * Arithma-Tech container layout (all integers little-endian):
+ *
+ *   Header        "ATC1", version, file type, level, backend, block size, flags
+ *   Block 0..n-1  u32 raw size, u32 payload size, [u32 CRC-32C of raw], payload
+ *   End marker    a block header with both sizes zero
+ *   Seek index    one BlockIndexEntry per block
+ *   Footer        original size, index offset, block count, "ATCX"
+ *
+ * The index sits at the end so a compressor can stream blocks out before it
+ * knows how many there will be; the fixed-size footer lets a reader find it
+ * with a single seek.
+ *
+ * Version 2 gave the flags word a meaning: kFlagBlockChecksums puts the
+ * CRC-32C of each block's uncompressed bytes in its header (the end marker
+ * included, as zero). Bits 8-15 name the primer set the block models
+ * start from (see primer.h), 0 for none. Bits 16-23 give the version of
+ * the file type's preprocessing transform (see typeregistry.h), 0 when the
+ * blocks hold the original bytes. With a transform the blocks and seek
+ * index describe the transformed stream, while the footer's original size
+ * stays that of the data handed in. Version 1 files, whose flags are
+ * always zero, still read.
+ */
+
+/**
+ * @brief FileType
+ *        What the encoded data should be decoded into (requirement 1.2.1).
+ */
+enum class FileType : uint8_t
+{
+    Binary = 0,
+    Text   = 1,
+    Png    = 2,
+    Jpeg   = 3,
+    Bmp    = 4,
+    Gif    = 5
+};
+
+/**
+ * @brief Backend
+ *        Entropy coder used for the blocks of a container.
+ */
+enum class Backend : uint8_t
+{
+    Arithmetic = 0,   // multi-symbol arithmetic coding over context models
+    Binary     = 1    // bitwise arithmetic coding with context mixing
+};
+
+// Lower-case display name ("png", "text", ...); see typeregistry.h for detection
+const char *fileTypeName(FileType type);
+
+struct ContainerHeader
+{
+    static constexpr uint32_t kSize    = 16;
+    static constexpr uint8_t  kVersion = 2;
+
+    static constexpr uint32_t kFlagBlockChecksums = 1u << 0;
+    static constexpr uint32_t kPrimerSetShift     = 8;    // flags bits 8-15
+    static constexpr uint32_t kTransformShift     = 16;   // flags bits 16-23
+
+    uint8_t  version   = kVersion;
+    FileType fileType  = FileType::Binary;
+    uint8_t  level     = 0;
+    Backend  backend   = Backend::Arithmetic;
+    uint32_t blockSize = 0;
+    uint32_t flags     = 0;
+};
+
+struct BlockHeader
+{
+    static constexpr uint32_t kSize         = 8;   // without the checksum
+    static constexpr uint32_t kChecksumSize = 4;
+
+    uint32_t rawSize     = 0;
+    uint32_t payloadSize = 0;
+    uint32_t checksum    = 0;   // CRC-32C of the raw bytes, when present
+};
+
+// Whether blocks carry a checksum, and their header size in this container
+inline bool hasBlockChecksums(const ContainerHeader &header)
+{
+    return (header.flags & ContainerHeader::kFlagBlockChecksums) != 0;
+}
+
+inline uint8_t primerSet(const ContainerHeader &header)
+{
+    return static_cast<uint8_t>(header.flags >> ContainerHeader::kPrimerSetShift);
+}
+
+inline uint8_t transformVersion(const ContainerHeader &header)
+{
+    return static_cast<uint8_t>(header.flags >> ContainerHeader::kTransformShift);
+}
+
+inline uint32_t blockHeaderSize(const ContainerHeader &header)
+{
+    return BlockHeader::kSize + (hasBlockChecksums(header) ? BlockHeader::kChecksumSize : 0);
+}
+
+/**
+ * @brief BlockIndexEntry
+ *        Seek index record mapping an uncompressed offset to a block.
+ *        blockOffset points at the block's BlockHeader.
+ */
+struct BlockIndexEntry
+{
+    static constexpr uint32_t kSize = 24;
+
+    uint64_t rawOffset   = 0;
+    uint64_t blockOffset = 0;
+    uint32_t rawSize     = 0;
+    uint32_t payloadSize = 0;
+};
+
+struct ContainerFooter
+{
+    static constexpr uint32_t kSize = 24;
+
+    uint64_t originalSize = 0;
+    uint64_t indexOffset  = 0;
+    uint32_t blockCount   = 0;
+};
+
+// Serialization helpers; each appends its fixed-size encoding to out
+void writeContainerHeader(const ContainerHeader &header, std::vector<uint8_t> &out);
+void writeBlockHeader(const BlockHeader &header, bool checksummed, std::vector<uint8_t> &out);
+void writeIndexEntry(const BlockIndexEntry &entry, std::vector<uint8_t> &out);
+void writeContainerFooter(const ContainerFooter &footer, std::vector<uint8_t> &out);
+
+// Parsers; each expects at least kSize bytes (a checksummed block header,
+// blockHeaderSize()) and returns false on bad data
+bool readContainerHeader(const uint8_t *data, ContainerHeader &header);
+void readBlockHeader(const uint8_t *data, bool checksummed, BlockHeader &header);
+void readIndexEntry(const uint8_t *data, BlockIndexEntry &entry);
+bool readContainerFooter(const uint8_t *data, ContainerFooter &footer);
+
+/**
+ * @brief ContainerReader
+ *        Random-access view of a container file. Only the header and footer
+ *        are read on open; index entries and blocks are fetched on demand, so
+ *        locating a block costs the same regardless of file size.
+ */
+class ContainerReader
+{
+public:
+    ContainerReader();
+
+    bool open(const std::string &path);
+
+    const ContainerHeader &header() const { return containerHeader; }
+    const ContainerFooter &footer() const { return containerFooter; }
+
+    // Index of the block covering an uncompressed offset, or -1 past the end
+    int64_t blockForOffset(uint64_t offset);
+
+    bool readIndexEntry(uint32_t block, BlockIndexEntry &entry);
+
+    // A block's header and compressed payload; fails if the header does
+    // not match the index entry
+    bool readBlock(const BlockIndexEntry &entry, BlockHeader &blockHeader,
+                   std::vector<uint8_t> &payload);
+
+    const std::string &errorString() const { return error; }
+
+private:
+    std::ifstream   file;
+    ContainerHeader containerHeader;
+    ContainerFooter containerFooter;
+    std::string     error;
+};
+
+#endif // CONTAINER_H
@@ -0,0 +1,122 @@
+#include "contenthash.h"
+
+#include <cstring>
+
+namespace {
+const uint64_t kC1 = 0x87c37b91114253d5ULL;
+const uint64_t kC2 = 0x4cf5ad432745937fULL;
+
+inline uint64_t rotl(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+inline uint64_t fmix(uint64_t k)
+{
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+}
+
+// Little-endian load whatever the host order, so hashes match everywhere
+inline uint64_t load64(const uint8_t *p)
+{
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; --i) v = (v << 8) | p[i];
+    return v;
+}
+}
+
+std::string Hash128::hex() const
+{
+    static const char kDigits[] = "0123456789abcdef";
+    std::string text(32, '0');
+    for (int i = 0; i < 16; ++i) {
+        text[15 - i] = kDigits[(high >> (4 * i)) & 0xF];
+        text[31 - i] = kDigits[(low >> (4 * i)) & 0xF];
+    }
+    return text;
+}
+
+// 1) ContentHasher Implementation
+ContentHasher::ContentHasher(uint64_t seed)
+    : h1(seed),
+    h2(seed),
+    total(0),
+    tailSize(0)
+{
+}
+
+void ContentHasher::mixBlock(const uint8_t *block)
+{
+    uint64_t k1 = load64(block);
+    uint64_t k2 = load64(block + 8);
+
+    k1 *= kC1; k1 = rotl(k1, 31); k1 *= kC2; h1 ^= k1;
+    h1 = rotl(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+
+    k2 *= kC2; k2 = rotl(k2, 33); k2 *= kC1; h2 ^= k2;
+    h2 = rotl(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+}
+
+void ContentHasher::update(const void *data, size_t size)
+{
+    const uint8_t *p = static_cast<const uint8_t *>(data);
+    total += size;
+
+    // Top up a partial block left by the previous call
+    if (tailSize > 0) {
+        const size_t take = size < 16 - tailSize ? size : 16 - tailSize;
+        std::memcpy(tail + tailSize, p, take);
+        tailSize += take;
+        p += take;
+        size -= take;
+        if (tailSize < 16) return;
+        mixBlock(tail);
+        tailSize = 0;
+    }
+
+    for (; size >= 16; p += 16, size -= 16) {
+        mixBlock(p);
+    }
+    std::memcpy(tail, p, size);
+    tailSize = size;
+}
+
+Hash128 ContentHasher::finish()
+{
+    uint64_t k1 = 0;
+    uint64_t k2 = 0;
+    for (size_t i = tailSize; i > 8; --i) k2 = (k2 << 8) | tail[i - 1];
+    for (size_t i = tailSize < 8 ? tailSize : 8; i > 0; --i) k1 = (k1 << 8) | tail[i - 1];
+    if (tailSize > 8) {
+        k2 *= kC2; k2 = rotl(k2, 33); k2 *= kC1; h2 ^= k2;
+    }
+    if (tailSize > 0) {
+        k1 *= kC1; k1 = rotl(k1, 31); k1 *= kC2; h1 ^= k1;
+    }
+
+    h1 ^= total;
+    h2 ^= total;
+    h1 += h2;
+    h2 += h1;
+    h1 = fmix(h1);
+    h2 = fmix(h2);
+    h1 += h2;
+    h2 += h1;
+
+    Hash128 hash;
+    hash.high = h1;
+    hash.low  = h2;
+    return hash;
+}
+
+Hash128 hashContent(const void *data, size_t size)
+{
+    ContentHasher hasher;
+    hasher.update(data, size);
+    return hasher.finish();
+}
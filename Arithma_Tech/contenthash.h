@@ -0,0 +1,54 @@
+#ifndef CONTENTHASH_H
+#define CONTENTHASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Hash128
+ *        128-bit content hash, compared and printed as one number.
+ */
+struct Hash128
+{
+    uint64_t high = 0;
+    uint64_t low  = 0;
+
+    bool operator==(const Hash128 &other) const { return high == other.high && low == other.low; }
+    bool operator!=(const Hash128 &other) const { return !(*this == other); }
+
+    // 32 lower-case hex digits, high half first
+    std::string hex() const;
+};
+
+/**
+ * @brief ContentHasher
+ *        Incremental MurmurHash3 x64-128: feed data in pieces of any size
+ *        and call finish() once. Several GB/s and well distributed, which
+ *        is what deduplicating our own files needs; it is not meant to
+ *        resist deliberately crafted collisions.
+ */
+class ContentHasher
+{
+public:
+    explicit ContentHasher(uint64_t seed = 0);
+
+    void update(const void *data, size_t size);
+    Hash128 finish();
+
+    uint64_t length() const { return total; }
+
+private:
+    void mixBlock(const uint8_t *block);
+
+    uint64_t h1;
+    uint64_t h2;
+    uint64_t total;
+    uint8_t  tail[16];
+    size_t   tailSize;
+};
+
+// One-shot helper
+Hash128 hashContent(const void *data, size_t size);
+
+#endif // CONTENTHASH_H
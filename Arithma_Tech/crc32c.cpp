@@ -0,0 +1,130 @@
+#include "crc32c.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define ARITHMA_CRC32C_X86 1
+#include <nmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#include <cstring>
+
+namespace {
+// Reflected Castagnoli polynomial
+const uint32_t kPolynomial = 0x82F63B78u;
+
+// Slicing-by-8 tables: entry [k][b] is the CRC of byte b followed by k zero bytes
+struct Crc32cTables
+{
+    uint32_t table[8][256];
+
+    Crc32cTables()
+    {
+        for (uint32_t b = 0; b < 256; ++b) {
+            uint32_t crc = b;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc >> 1) ^ (kPolynomial & (0u - (crc & 1u)));
+            }
+            table[0][b] = crc;
+        }
+        for (uint32_t b = 0; b < 256; ++b) {
+            for (int k = 1; k < 8; ++k) {
+                table[k][b] = (table[k - 1][b] >> 8) ^ table[0][table[k - 1][b] & 0xFF];
+            }
+        }
+    }
+};
+
+const Crc32cTables &tables()
+{
+    static const Crc32cTables instance;
+    return instance;
+}
+
+uint32_t crc32cTable(uint32_t crc, const uint8_t *p, size_t size)
+{
+    const uint32_t (*t)[256] = tables().table;
+    while (size >= 8) {
+        // Byte-wise loads keep this independent of host byte order
+        const uint32_t lo = crc ^ (uint32_t(p[0]) | uint32_t(p[1]) << 8
+                                   | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24);
+        crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24]
+              ^ t[3][p[4]] ^ t[2][p[5]] ^ t[1][p[6]] ^ t[0][p[7]];
+        p += 8;
+        size -= 8;
+    }
+    while (size-- > 0) {
+        crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xFF];
+    }
+    return crc;
+}
+
+#ifdef ARITHMA_CRC32C_X86
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((target("sse4.2")))
+#endif
+uint32_t crc32cHw(uint32_t crc, const uint8_t *p, size_t size)
+{
+    // Byte steps up to 8-byte alignment, then one instruction per word
+    while (size > 0 && (reinterpret_cast<uintptr_t>(p) & 7) != 0) {
+        crc = _mm_crc32_u8(crc, *p++);
+        --size;
+    }
+#if defined(__x86_64__) || defined(_M_X64)
+    uint64_t crc64 = crc;
+    while (size >= 8) {
+        uint64_t word;
+        std::memcpy(&word, p, 8);
+        crc64 = _mm_crc32_u64(crc64, word);
+        p += 8;
+        size -= 8;
+    }
+    crc = static_cast<uint32_t>(crc64);
+#endif
+    while (size >= 4) {
+        uint32_t word;
+        std::memcpy(&word, p, 4);
+        crc = _mm_crc32_u32(crc, word);
+        p += 4;
+        size -= 4;
+    }
+    while (size-- > 0) {
+        crc = _mm_crc32_u8(crc, *p++);
+    }
+    return crc;
+}
+
+bool detectSse42()
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 20)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.2") != 0;
+#endif
+}
+#endif
+}
+
+bool crc32cHardware()
+{
+#ifdef ARITHMA_CRC32C_X86
+    static const bool supported = detectSse42();
+    return supported;
+#else
+    return false;
+#endif
+}
+
+uint32_t crc32c(uint32_t crc, const void *data, size_t size)
+{
+    const uint8_t *p = static_cast<const uint8_t *>(data);
+    crc = ~crc;
+#ifdef ARITHMA_CRC32C_X86
+    if (crc32cHardware()) return ~crc32cHw(crc, p, size);
+#endif
+    return ~crc32cTable(crc, p, size);
+}
@@ -0,0 +1,18 @@
+#ifndef CRC32C_H
+#define CRC32C_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief crc32c
+ *        CRC-32C (Castagnoli) of data, continuing from a previous result;
+ *        start with 0. Uses the SSE4.2 crc32 instruction when the CPU has
+ *        it and a slicing-by-8 table otherwise; both give the same value.
+ */
+uint32_t crc32c(uint32_t crc, const void *data, size_t size);
+
+// True when crc32c() runs on the hardware instruction
+bool crc32cHardware();
+
+#endif // CRC32C_H
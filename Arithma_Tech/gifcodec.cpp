@@ -0,0 +1,1010 @@
+#include "gifcodec.h"
+
+#include "blockcodec.h"
+#include "imagemodel.h"
+#include "primer.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+// 1) Bytes
+uint32_t get16le(const uint8_t *p)
+{
+    return uint32_t(p[0]) | uint32_t(p[1]) << 8;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Frames that decode to more indices are passed through
+const uint64_t kMaxPixels = uint64_t(1) << 30;
+
+// 2) Blocks
+size_t colorTableSize(uint8_t packed)
+{
+    return packed & 0x80 ? 3 * (size_t(2) << (packed & 7)) : 0;
+}
+
+// Walks the sub-blocks starting at pos: their data is appended to payload,
+// their sizes to sizes, and pos ends up past the terminator. Fails when the
+// file ends first.
+bool readSubBlocks(const uint8_t *file, size_t size, size_t &pos,
+                   std::vector<uint8_t> *payload, std::vector<uint64_t> *sizes)
+{
+    while (pos < size) {
+        const size_t length = file[pos++];
+        if (length == 0) return true;
+        if (size - pos < length) return false;
+        if (payload) payload->insert(payload->end(), file + pos, file + pos + length);
+        if (sizes) sizes->push_back(length);
+        pos += length;
+    }
+    return false;
+}
+
+/**
+ * @brief GifFrame
+ *        What rebuilding one frame's image data takes besides its indices.
+ */
+struct GifFrame
+{
+    uint64_t gap = 0;           // skeleton bytes before the image data
+    uint64_t width = 0;
+    uint64_t count = 0;         // indices the data decodes to
+    uint8_t  flags = 0;
+    uint8_t  minCodeSize = 0;
+    std::vector<uint64_t> clears;       // code numbers of the clear codes
+    std::vector<uint64_t> blockSizes;   // with kFrameBlockSizes
+    std::vector<uint8_t>  trailing;     // with kFrameTrailing
+};
+
+enum : uint8_t {
+    kFrameInterlaced = 1, kFrameEndCode = 2, kFrameBlockSizes = 4, kFrameTrailing = 8,
+    kFrameDifferenced = 16, kFrameTransparentSkip = 32
+};
+
+// Whether sizes are full 255-byte sub-blocks and a shorter last one, which
+// is how nearly every encoder cuts its data
+bool regularBlocks(const std::vector<uint64_t> &sizes, uint64_t total)
+{
+    uint64_t expected = 0;
+    for (size_t i = 0; i < sizes.size(); ++i) {
+        if (i + 1 < sizes.size() ? sizes[i] != 255 : sizes[i] == 0) return false;
+        expected += sizes[i];
+    }
+    return expected == total;
+}
+
+void appendSubBlocks(const std::vector<uint8_t> &payload, const GifFrame &frame, std::vector<uint8_t> &out)
+{
+    size_t pos = 0;
+    auto append = [&](size_t length) {
+        out.push_back(static_cast<uint8_t>(length));
+        out.insert(out.end(), payload.begin() + pos, payload.begin() + pos + length);
+        pos += length;
+    };
+    if (frame.flags & kFrameBlockSizes) {
+        for (uint64_t length : frame.blockSizes) append(static_cast<size_t>(length));
+    } else {
+        while (pos < payload.size()) append(std::min<size_t>(255, payload.size() - pos));
+    }
+    out.push_back(0);
+}
+
+void writeRecord(const GifFrame &frame, std::vector<uint8_t> &out)
+{
+    putVarint(out, frame.gap);
+    putVarint(out, frame.width);
+    putVarint(out, frame.count);
+    out.push_back(frame.flags);
+    out.push_back(frame.minCodeSize);
+    putVarint(out, frame.clears.size());
+    uint64_t previous = 0;
+    for (uint64_t clear : frame.clears) {
+        putVarint(out, clear - previous);
+        previous = clear;
+    }
+    if (frame.flags & kFrameBlockSizes) {
+        putVarint(out, frame.blockSizes.size());
+        for (uint64_t length : frame.blockSizes) putVarint(out, length);
+    }
+    if (frame.flags & kFrameTrailing) {
+        putVarint(out, frame.trailing.size());
+        out.insert(out.end(), frame.trailing.begin(), frame.trailing.end());
+    }
+}
+
+bool readRecord(const uint8_t *&p, const uint8_t *end, GifFrame &frame)
+{
+    uint64_t clears = 0;
+    if (!getVarint(p, end, frame.gap) || !getVarint(p, end, frame.width) || !getVarint(p, end, frame.count)
+        || end - p < 2) {
+        return false;
+    }
+    frame.flags = *p++;
+    frame.minCodeSize = *p++;
+    if (frame.minCodeSize < 2 || frame.minCodeSize > 8 || frame.count > kMaxPixels || frame.width == 0
+        || !getVarint(p, end, clears) || clears > uint64_t(end - p)) {
+        return false;
+    }
+    uint64_t previous = 0;
+    frame.clears.resize(static_cast<size_t>(clears));
+    for (uint64_t &clear : frame.clears) {
+        uint64_t delta = 0;
+        if (!getVarint(p, end, delta)) return false;
+        clear = previous += delta;
+    }
+    if (frame.flags & kFrameBlockSizes) {
+        uint64_t blocks = 0;
+        if (!getVarint(p, end, blocks) || blocks > uint64_t(end - p)) return false;
+        frame.blockSizes.resize(static_cast<size_t>(blocks));
+        for (uint64_t &length : frame.blockSizes) {
+            if (!getVarint(p, end, length) || length == 0 || length > 255) return false;
+        }
+    }
+    if (frame.flags & kFrameTrailing) {
+        uint64_t size = 0;
+        if (!getVarint(p, end, size) || size > uint64_t(end - p)) return false;
+        frame.trailing.assign(p, p + size);
+        p += size;
+    }
+    return true;
+}
+
+// 3) LZW
+const int kMaxCodeBits = 12;
+const int kMaxCodes = 1 << kMaxCodeBits;
+
+// Decodes an LZW payload the way GIF readers do, noting where the clear
+// codes sit; fails on a code the table does not hold yet
+bool decodeLzw(const std::vector<uint8_t> &payload, GifFrame &frame, std::vector<uint8_t> &pixels)
+{
+    const int clear = 1 << frame.minCodeSize;
+    std::vector<uint16_t> prefix(kMaxCodes);
+    std::vector<uint16_t> length(kMaxCodes, 1);
+    std::vector<uint8_t>  suffix(kMaxCodes);
+    for (int code = 0; code < clear; ++code) suffix[code] = static_cast<uint8_t>(code);
+
+    int bits = frame.minCodeSize + 1, next = clear + 2, previous = -1;
+    const uint64_t totalBits = uint64_t(payload.size()) * 8;
+    uint64_t bitPos = 0, codes = 0;
+    while (bitPos + bits <= totalBits) {
+        int code = 0;
+        for (int i = 0; i < bits; ++i, ++bitPos) code |= (payload[bitPos >> 3] >> (bitPos & 7) & 1) << i;
+        if (code == clear) {
+            frame.clears.push_back(codes++);
+            bits = frame.minCodeSize + 1;
+            next = clear + 2;
+            previous = -1;
+            continue;
+        }
+        ++codes;
+        if (code == clear + 1) {
+            frame.flags |= kFrameEndCode;
+            break;
+        }
+        if (previous < 0 ? code > clear : code > next || (code == next && next == kMaxCodes)) return false;
+
+        // The string comes out last character first; a code one past the
+        // table is the previous string plus its own first character
+        const int known = code == next ? previous : code;
+        const size_t start = pixels.size();
+        pixels.resize(start + length[known] + (code == next ? 1 : 0));
+        if (pixels.size() > kMaxPixels) return false;
+        size_t pos = start + length[known];
+        for (int walk = known; ; walk = prefix[walk]) {
+            pixels[--pos] = suffix[walk];
+            if (length[walk] == 1) break;
+        }
+        if (code == next) pixels.back() = pixels[start];
+
+        if (previous >= 0 && next < kMaxCodes) {
+            prefix[next] = static_cast<uint16_t>(previous);
+            suffix[next] = pixels[start];
+            length[next] = static_cast<uint16_t>(length[previous] + 1);
+            ++next;
+        }
+        if (next == 1 << bits && bits < kMaxCodeBits) ++bits;
+        previous = code;
+    }
+    frame.count = pixels.size();
+    return true;
+}
+
+/**
+ * @brief LzwEncoder
+ *        Greedy LZW as GIF writers do it, with clear codes where the frame
+ *        record puts them rather than where a writer of our own would. The
+ *        code width follows the reader's table, which trails the writer's
+ *        by one entry.
+ */
+class LzwEncoder
+{
+public:
+    LzwEncoder(const GifFrame &frame, std::vector<uint8_t> &payload)
+        : frame(frame),
+        payload(payload),
+        clear(1 << frame.minCodeSize),
+        keys(kHashSize),
+        values(kHashSize)
+    {
+        reset();
+    }
+
+    // pixels must all be below the clear code
+    void encode(const uint8_t *pixels, size_t count)
+    {
+        clearsDue();
+        if (count > 0) {
+            int string = pixels[0];
+            for (size_t i = 1; i < count; ++i) {
+                const uint32_t key = uint32_t(string) << 8 | pixels[i];
+                size_t slot = (key * 0x9E3779B1u) >> (32 - kHashBits);
+                while (keys[slot] != 0 && keys[slot] != key + 1) slot = (slot + 1) & (kHashSize - 1);
+                if (keys[slot] != 0) {
+                    string = values[slot];
+                    continue;
+                }
+                emitData(string);
+                if (!clearsDue() && writerNext < kMaxCodes) {
+                    keys[slot] = key + 1;
+                    values[slot] = static_cast<uint16_t>(writerNext++);
+                }
+                string = pixels[i];
+            }
+            emitData(string);
+            clearsDue();
+        }
+        if (frame.flags & kFrameEndCode) emit(clear + 1);
+        if (pending) payload.push_back(static_cast<uint8_t>(accumulator));
+    }
+
+private:
+    static const int    kHashBits = 13;
+    static const size_t kHashSize = size_t(1) << kHashBits;
+
+    void emit(int code)
+    {
+        accumulator |= uint32_t(code) << pending;
+        pending += bits;
+        while (pending >= 8) {
+            payload.push_back(static_cast<uint8_t>(accumulator));
+            accumulator >>= 8;
+            pending -= 8;
+        }
+        ++codes;
+    }
+
+    void emitData(int code)
+    {
+        emit(code);
+        if (readerStarted && readerNext < kMaxCodes) ++readerNext;
+        readerStarted = true;
+        if (readerNext == 1 << bits && bits < kMaxCodeBits) ++bits;
+    }
+
+    void reset()
+    {
+        std::fill(keys.begin(), keys.end(), 0);
+        bits = frame.minCodeSize + 1;
+        writerNext = readerNext = clear + 2;
+        readerStarted = false;
+    }
+
+    // Emits the clear codes due before the next code
+    bool clearsDue()
+    {
+        bool cleared = false;
+        while (nextClear < frame.clears.size() && frame.clears[nextClear] == codes) {
+            emit(clear);
+            reset();
+            ++nextClear;
+            cleared = true;
+        }
+        return cleared;
+    }
+
+    const GifFrame &frame;
+    std::vector<uint8_t> &payload;
+    const int clear;
+    std::vector<uint32_t> keys;     // string << 8 | index, plus one; 0 is free
+    std::vector<uint16_t> values;
+    int      bits = 0;
+    int      writerNext = 0;
+    int      readerNext = 0;
+    bool     readerStarted = false;
+    uint32_t accumulator = 0;
+    int      pending = 0;
+    uint64_t codes = 0;
+    size_t   nextClear = 0;
+};
+
+// 4) Blocks of the file
+/**
+ * @brief GifImage
+ *        One image of the file as its descriptor and the graphic control
+ *        extension before it describe it.
+ */
+struct GifImage
+{
+    uint32_t left = 0;
+    uint32_t top = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    bool     interlaced = false;
+    int      minCodeSize = 0;
+    int      disposal = 0;       // what happens to it before the next image
+    int      transparent = -1;   // index left undrawn, if any
+    size_t   palette = 0;        // offset of the colour table it uses
+    size_t   colors = 0;         // and its entries, 0 for none
+    bool     localPalette = false;
+    size_t   dataStart = 0;      // its first sub-block
+};
+
+/**
+ * @brief GifWalker
+ *        Steps through the blocks of a GIF file up to its trailer, or up
+ *        to the first block it cannot make sense of. The file may grow
+ *        between steps, which is how the decoder follows the file it is
+ *        rebuilding.
+ */
+struct GifWalker
+{
+    explicit GifWalker(const std::vector<uint8_t> &file)
+        : file(file)
+    {
+        readScreen();
+    }
+
+    // The header and logical screen; the decoder calls this again once
+    // they are in the file
+    void readScreen()
+    {
+        ok = file.size() >= 13
+             && (std::memcmp(file.data(), "GIF87a", 6) == 0 || std::memcmp(file.data(), "GIF89a", 6) == 0);
+        if (ok) {
+            screenWidth  = get16le(file.data() + 6);
+            screenHeight = get16le(file.data() + 8);
+            globalColors = colorTableSize(file[10]) / 3;
+            pos = 13 + colorTableSize(file[10]);
+        }
+    }
+
+    // Moves to the next image and its LZW data; false at the end
+    bool nextImage()
+    {
+        int disposal = 0, transparent = -1;
+        while (ok && pos < file.size()) {
+            const uint8_t *data = file.data();
+            const size_t size = file.size(), start = pos;
+            if (data[pos] == 0x21 && size - pos >= 2) {
+                if (data[pos + 1] == 0xF9 && size - pos >= 7 && data[pos + 2] == 4) {
+                    disposal = data[pos + 3] >> 2 & 7;
+                    transparent = data[pos + 3] & 1 ? data[pos + 6] : -1;
+                }
+                pos += 2;
+                if (readSubBlocks(data, size, pos, nullptr, nullptr)) continue;
+            } else if (data[pos] == 0x2C && size - pos >= 10) {
+                const uint8_t packed = data[pos + 9];
+                image.left        = get16le(data + pos + 1);
+                image.top         = get16le(data + pos + 3);
+                image.width       = get16le(data + pos + 5);
+                image.height      = get16le(data + pos + 7);
+                image.interlaced  = (packed & 0x40) != 0;
+                image.disposal    = disposal;
+                image.transparent = transparent;
+                image.palette     = packed & 0x80 ? pos + 10 : 13;
+                image.localPalette = (packed & 0x80) != 0;
+                image.colors      = packed & 0x80 ? colorTableSize(packed) / 3 : globalColors;
+                pos += 10 + colorTableSize(packed);
+                if (pos < size) {
+                    image.minCodeSize = data[pos];
+                    image.dataStart = ++pos;
+                    return true;
+                }
+            }
+            pos = start;
+            break;
+        }
+        ok = false;
+        return false;
+    }
+
+    // Past the current image's data
+    bool skipData() { return ok = readSubBlocks(file.data(), file.size(), pos, nullptr, nullptr); }
+
+    const std::vector<uint8_t> &file;
+    size_t   pos = 0;
+    bool     ok;
+    uint32_t screenWidth = 0;
+    uint32_t screenHeight = 0;
+    size_t   globalColors = 0;
+    GifImage image;
+};
+
+// 5) Pixel model
+// Interlaced frames store rows 0, 8, 16, ... then 4, 12, ... then 2, 6, ...
+// then the odd ones; returns the stored position of each displayed row
+std::vector<size_t> interlacedRows(size_t height)
+{
+    std::vector<size_t> stored(height);
+    size_t row = 0;
+    static const size_t kPasses[4][2] = {{0, 8}, {4, 8}, {2, 4}, {1, 2}};
+    for (const size_t *pass : kPasses) {
+        for (size_t y = pass[0]; y < height; y += pass[1]) stored[y] = row++;
+    }
+    return stored;
+}
+
+void reorderRows(std::vector<uint8_t> &pixels, size_t width, bool toDisplay)
+{
+    const size_t height = pixels.size() / width;
+    const std::vector<size_t> stored = interlacedRows(height);
+    std::vector<uint8_t> reordered(pixels.size());
+    for (size_t y = 0; y < height; ++y) {
+        const size_t from = (toDisplay ? stored[y] : y) * width;
+        const size_t to = (toDisplay ? y : stored[y]) * width;
+        std::memcpy(reordered.data() + to, pixels.data() + from, width);
+    }
+    pixels.swap(reordered);
+}
+
+// Frames are differenced when at least this share of their pixels is
+// unchanged (1/16)
+const int kDifferenceShift = 4;
+
+// Screens larger than this are not tracked, and their frames are coded on
+// their own
+const uint64_t kMaxCanvas = uint64_t(1) << 24;
+
+// Screen pixels nothing has been drawn on, or that were cleared
+const uint32_t kClearColor = uint32_t(1) << 24;
+
+// Shown for a colour the frame's palette does not have
+const uint16_t kNoIndex = 256;
+
+/**
+ * @brief GifStats
+ *        What the transform reports into JobStats.
+ */
+struct GifStats
+{
+    std::vector<double> frameSeconds;
+    uint64_t framePixels     = 0;
+    uint64_t unchangedPixels = 0;
+};
+
+/**
+ * @brief FrameCoder
+ *        Codes the indices of the frames in display order, all through
+ *        models shared across the file. A frame is coded on its own from
+ *        its neighbouring indices, or against the screen as the previous
+ *        frames left it: pixels that repeat what is there (or that are the
+ *        transparent index) cost a mask bit, whole rows of them one bit,
+ *        and only the changed pixels are modelled, under the index shown
+ *        beneath them as well as their neighbours. The screen is kept in
+ *        colours and looked up in each frame's palette, since frames with
+ *        palettes of their own number their colours differently.
+ */
+template <typename Coder>
+class FrameCoder
+{
+public:
+    FrameCoder(Coder &coder, size_t modelSize, const GifWalker &walker)
+        : coder(coder),
+        intra(modelSize, kIndexMixContexts),
+        screenWidth(walker.screenWidth),
+        screenHeight(walker.screenHeight)
+    {
+        if (uint64_t(screenWidth) * screenHeight <= kMaxCanvas) {
+            canvas.assign(size_t(screenWidth) * screenHeight, kClearColor);
+        }
+    }
+
+    // Codes one frame; when encoding, pixels hold the frame and its flags
+    // gain the differencing chosen, when decoding the flags say which.
+    // Fails on flags the decoder cannot follow.
+    bool code(GifFrame &frame, const GifImage &image, const std::vector<uint8_t> &file,
+              std::vector<uint8_t> &pixels, GifStats &stats)
+    {
+        const size_t width = static_cast<size_t>(frame.width);
+        readPalette(image, file);
+        active = image.localPalette ? nullptr : order;
+        std::vector<uint16_t> shown;
+        if (started && !canvas.empty()) {
+            shown = beneath(image, width, pixels.size());
+            if (Coder::kEncoding) chooseDifferencing(frame, image, pixels, shown);
+        }
+        const bool skipTransparent = (frame.flags & kFrameTransparentSkip) != 0;
+        if (skipTransparent || (frame.flags & kFrameDifferenced)) {
+            if (shown.empty() || (skipTransparent && image.transparent < 0)) return false;
+            size_t unchanged = 0;
+            const std::vector<uint16_t> expected =
+                skipTransparent ? std::vector<uint16_t>(pixels.size(), static_cast<uint16_t>(image.transparent)) : shown;
+            codeDifference(pixels, width, shown, expected, unchanged);
+            stats.unchangedPixels += unchanged;
+        } else {
+            codeIntra(pixels, width);
+        }
+        stats.framePixels += pixels.size();
+        started = true;
+        if (!canvas.empty()) draw(image, width, pixels);
+        return true;
+    }
+
+    // Indices of frames on the global colour table are coded in order's
+    // positions from here on; null for the file's own
+    void setOrder(const PaletteOrder *value) { order = value; }
+
+private:
+    // Colours of the frame's palette, and the first index of each
+    void readPalette(const GifImage &image, const std::vector<uint8_t> &file)
+    {
+        palette.assign(256, kClearColor);
+        indexOf.clear();
+        const size_t colors = std::min<size_t>(image.colors, (file.size() - std::min(file.size(), image.palette)) / 3);
+        for (size_t i = 0; i < colors; ++i) {
+            const uint8_t *rgb = file.data() + image.palette + 3 * i;
+            palette[i] = uint32_t(rgb[0]) << 16 | uint32_t(rgb[1]) << 8 | rgb[2];
+            indexOf.emplace(palette[i], static_cast<uint16_t>(i));
+        }
+    }
+
+    // Index of the colour beneath each pixel of the frame in its palette:
+    // cleared screen is the transparent index, colours it lacks kNoIndex.
+    // Pixels off the screen or past the frame's height see cleared screen
+    std::vector<uint16_t> beneath(const GifImage &image, size_t width, size_t count) const
+    {
+        const uint16_t clear = image.transparent >= 0 ? static_cast<uint16_t>(image.transparent) : kNoIndex;
+        std::vector<uint16_t> shown(count, clear);
+        uint32_t lastColor = kClearColor;
+        uint16_t lastIndex = clear;
+        for (size_t i = 0; i < count; ++i) {
+            const size_t x = image.left + i % width, y = image.top + i / width;
+            if (i / width >= image.height || x >= screenWidth || y >= screenHeight) continue;
+            const uint32_t color = canvas[y * screenWidth + x];
+            if (color != lastColor) {
+                const auto found = indexOf.find(color);
+                lastColor = color;
+                lastIndex = color == kClearColor ? clear : found == indexOf.end() ? kNoIndex : found->second;
+            }
+            shown[i] = lastIndex;
+        }
+        return shown;
+    }
+
+    void chooseDifferencing(GifFrame &frame, const GifImage &image, const std::vector<uint8_t> &pixels,
+                            const std::vector<uint16_t> &shown) const
+    {
+        size_t same = 0, transparent = 0;
+        for (size_t i = 0; i < pixels.size(); ++i) {
+            same += pixels[i] == shown[i];
+            transparent += int(pixels[i]) == image.transparent;
+        }
+        const size_t best = std::max(same, transparent);
+        if (best == 0 || best < pixels.size() >> kDifferenceShift) return;
+        frame.flags |= transparent > same ? kFrameTransparentSkip : kFrameDifferenced;
+    }
+
+    void codeIntra(std::vector<uint8_t> &pixels, size_t width)
+    {
+        for (size_t start = 0; start < pixels.size(); start += width) {
+            uint8_t *row = pixels.data() + start;
+            const uint8_t *above = start ? row - width : nullptr;
+            const size_t length = std::min(width, pixels.size() - start);
+            for (size_t i = 0; i < length; ++i) {
+                uint32_t contexts[kImageModelInputs];
+                const int mixContext = indexContexts(row, above, i, width, contexts);
+                row[i] = codeIndex(row[i], contexts, mixContext);
+            }
+        }
+    }
+
+    // Each row starts with whether all its pixels equal expected; those
+    // rows are copied. In the others every pixel that can be unchanged
+    // codes whether it is, from its neighbours' answers, and the changed
+    // ones are modelled. unchanged counts the pixels copied
+    void codeDifference(std::vector<uint8_t> &pixels, size_t width, const std::vector<uint16_t> &shown,
+                        const std::vector<uint16_t> &expected, size_t &unchanged)
+    {
+        std::vector<uint8_t> above(width + 1, 1), mask(width + 1, 1);
+        int rowSame = 1;
+        for (size_t start = 0; start < pixels.size(); start += width) {
+            const size_t length = std::min(width, pixels.size() - start);
+            int same = 1;
+            if (Coder::kEncoding) {
+                for (size_t i = start; i < start + length && same; ++i) same = pixels[i] == expected[i];
+            }
+            same = coder.code(same, sameRow[rowSame]);
+            rowSame = same;
+            if (same) {
+                for (size_t i = start; i < start + length; ++i) pixels[i] = static_cast<uint8_t>(expected[i]);
+                unchanged += length;
+                std::fill(above.begin(), above.end(), 1);
+                continue;
+            }
+
+            for (size_t x = 0; x < length; ++x) {
+                const size_t i = start + x;
+                int kept = 0;
+                if (expected[i] != kNoIndex) {
+                    const int context = (x ? mask[x - 1] : 1) | above[x] << 1 | (x ? above[x - 1] : 1) << 2
+                                        | above[x + 1] << 3 | (x > 1 ? mask[x - 2] : 1) << 4;
+                    kept = coder.code(pixels[i] == expected[i], keptModels[context]);
+                }
+                mask[x] = static_cast<uint8_t>(kept);
+                if (kept) {
+                    pixels[i] = static_cast<uint8_t>(expected[i]);
+                    ++unchanged;
+                } else {
+                    codeChanged(pixels, width, i, shown[i]);
+                }
+            }
+            std::fill(mask.begin() + length, mask.end(), 1);
+            above.swap(mask);
+        }
+    }
+
+    // A changed pixel goes through the same model as whole frames, with the
+    // index beneath it in place of the one to its left alone
+    void codeChanged(std::vector<uint8_t> &pixels, size_t width, size_t i, uint32_t under)
+    {
+        const size_t x = i % width;
+        uint8_t *row = pixels.data() + (i - x);
+        uint32_t contexts[kImageModelInputs];
+        const int mixContext = indexContexts(row, i >= width ? row - width : nullptr, x, width, contexts);
+        contexts[0] = hashOf(under << 8 | (x ? row[x - 1] : 0), 0x400) << 8;
+        row[x] = codeIndex(row[x], contexts, mixContext);
+    }
+
+    // Indices go through the model as their position in the order chosen
+    uint8_t codeIndex(uint8_t value, const uint32_t *contexts, int mixContext)
+    {
+        if (!active) return static_cast<uint8_t>(intra.codeByte(coder, value, contexts, mixContext));
+        const int coded = intra.codeByte(coder, active->toCoded(value), contexts, mixContext);
+        return active->toIndex(static_cast<uint8_t>(coded));
+    }
+
+    // Draws the frame onto the screen, then disposes of it as its graphic
+    // control extension asks
+    void draw(const GifImage &image, size_t width, const std::vector<uint8_t> &pixels)
+    {
+        const size_t rows = std::min<size_t>(image.height, (pixels.size() + width - 1) / width);
+        const size_t left = std::min<size_t>(image.left, screenWidth);
+        const size_t top = std::min<size_t>(image.top, screenHeight);
+        const size_t right = std::min<size_t>(left + width, screenWidth);
+        const size_t bottom = std::min<size_t>(top + rows, screenHeight);
+
+        std::vector<uint32_t> saved;
+        if (image.disposal == 3) {
+            for (size_t y = top; y < bottom; ++y) {
+                saved.insert(saved.end(), canvas.begin() + y * screenWidth + left, canvas.begin() + y * screenWidth + right);
+            }
+        }
+        for (size_t y = top; y < bottom; ++y) {
+            for (size_t x = left; x < right; ++x) {
+                const size_t i = (y - image.top) * width + (x - image.left);
+                if (i < pixels.size() && int(pixels[i]) != image.transparent) {
+                    canvas[y * screenWidth + x] = palette[pixels[i]];
+                }
+            }
+        }
+        if (image.disposal == 2 || image.disposal == 3) {
+            auto from = saved.begin();
+            for (size_t y = top; y < bottom; ++y) {
+                uint32_t *line = canvas.data() + y * screenWidth;
+                if (image.disposal == 2) {
+                    std::fill(line + left, line + right, kClearColor);
+                } else {
+                    std::copy(from, from + (right - left), line + left);
+                    from += right - left;
+                }
+            }
+        }
+    }
+
+    Coder     &coder;
+    ImageModel intra;
+    BitModel   sameRow[2];         // by the row above's
+    BitModel   keptModels[32];     // by the mask to the left and above
+    std::vector<uint32_t> canvas;           // colours on screen
+    std::vector<uint32_t> palette;          // of the current frame
+    std::unordered_map<uint32_t, uint16_t> indexOf;
+    uint32_t   screenWidth;
+    uint32_t   screenHeight;
+    bool       started = false;
+    const PaletteOrder *order = nullptr;
+    const PaletteOrder *active = nullptr;   // for the current frame
+};
+
+// 6) Transforms
+enum : uint8_t { kModeStored = 0, kModeCoded = 1, kModeOrdered = 2 };
+
+void addGifStats(const GifStats &gif, JobStats &stats)
+{
+    stats.frameSeconds    = gif.frameSeconds;
+    stats.framePixels     = gif.framePixels;
+    stats.unchangedPixels = gif.unchangedPixels;
+}
+
+// Everything but the image data is coded as bytes, from the container's
+// primer since version 2 and from set 1's before
+Primer skeletonPrimer(uint8_t version, const Primer &primer)
+{
+    return version < 2 ? findPrimer(1, FileType::Gif) : primer;
+}
+
+// RGB triples of the global colour table; empty without one
+std::vector<uint8_t> globalPalette(const std::vector<uint8_t> &file)
+{
+    if (file.size() < 13) return std::vector<uint8_t>();
+    const size_t size = std::min(colorTableSize(file[10]), file.size() - 13);
+    return std::vector<uint8_t>(file.begin() + 13, file.begin() + 13 + size);
+}
+
+// Sum of the frame areas, which sizes the models
+uint64_t totalArea(const std::vector<uint8_t> &input)
+{
+    GifWalker walker(input);
+    uint64_t area = 0;
+    while (walker.nextImage() && walker.skipData()) area += uint64_t(walker.image.width) * walker.image.height;
+    return std::min(area, kMaxPixels);
+}
+
+bool encodeGif(const std::vector<uint8_t> &input, const Primer &primer, std::vector<uint8_t> &out,
+               GifStats &stats)
+{
+    const uint64_t modelSize = totalArea(input);
+    std::vector<uint8_t> skeleton, records, stream;
+    PixelEncoder encoder{{BinaryEncoder(stream)}};
+    GifWalker walker(input);
+    FrameCoder<PixelEncoder> frames(encoder, static_cast<size_t>(modelSize), walker);
+    const std::vector<uint8_t> palette = globalPalette(input);
+    PaletteOrder order;
+    bool sampled = false;
+    size_t copied = 0, coded = 0;
+
+    while (walker.nextImage()) {
+        const auto started = std::chrono::steady_clock::now();
+        const GifImage &image = walker.image;
+        std::vector<uint8_t> payload, pixels, rebuilt;
+        GifFrame frame;
+        if (!readSubBlocks(input.data(), input.size(), walker.pos, &payload, &frame.blockSizes)) break;
+        frame.width = std::max<uint32_t>(1, image.width);
+        frame.minCodeSize = static_cast<uint8_t>(image.minCodeSize);
+        if (regularBlocks(frame.blockSizes, payload.size())) frame.blockSizes.clear();
+        else frame.flags |= kFrameBlockSizes;
+
+        bool reproduced = false;
+        if (frame.minCodeSize >= 2 && frame.minCodeSize <= 8) {
+            ARITHMA_TRACE_SCOPE("transform", "gif lzw");
+            reproduced = decodeLzw(payload, frame, pixels);
+            if (reproduced) {
+                LzwEncoder(frame, rebuilt).encode(pixels.data(), pixels.size());
+                // Some writers leave bytes after the last code
+                reproduced = rebuilt.size() <= payload.size()
+                             && std::equal(rebuilt.begin(), rebuilt.end(), payload.begin());
+                if (reproduced && rebuilt.size() < payload.size()) {
+                    frame.flags |= kFrameTrailing;
+                    frame.trailing.assign(payload.begin() + rebuilt.size(), payload.end());
+                }
+            }
+        }
+        if (reproduced) {
+            if (image.interlaced && frame.count == uint64_t(frame.width) * image.height) {
+                frame.flags |= kFrameInterlaced;
+                reorderRows(pixels, static_cast<size_t>(frame.width), true);
+            }
+            frame.gap = image.dataStart - copied;
+            skeleton.insert(skeleton.end(), input.begin() + copied, input.begin() + image.dataStart);
+            copied = walker.pos;
+
+            // The first frame on the global colour table is the sample that
+            // picks the order
+            if (!sampled && !image.localPalette && !palette.empty()) {
+                sampled = true;
+                const size_t width = static_cast<size_t>(frame.width);
+                order = choosePaletteOrder(pixels.data(), width, width, pixels.size() / width, 8, palette, false);
+                if (order.method() != PaletteOrder::kAsIs) frames.setOrder(&order);
+            }
+
+            ARITHMA_TRACE_SCOPE("transform", "gif model encode");
+            if (!frames.code(frame, image, input, pixels, stats)) return false;
+            writeRecord(frame, records);
+            ++coded;
+        }
+        stats.frameSeconds.push_back(secondsSince(started));
+    }
+    if (coded == 0) return false;
+    encoder.coder.finish();
+    skeleton.insert(skeleton.end(), input.begin() + copied, input.end());
+
+    const size_t skeletonSize = skeleton.size();
+    skeleton.insert(skeleton.end(), records.begin(), records.end());
+    std::vector<uint8_t> packed;
+    encodeBlock(Backend::Arithmetic, 2, primer, skeleton.data(), skeleton.size(), packed);
+
+    const bool ordered = order.method() != PaletteOrder::kAsIs;
+    out.push_back(ordered ? kModeOrdered : kModeCoded);
+    putVarint(out, modelSize);
+    putVarint(out, skeletonSize);
+    putVarint(out, records.size());
+    putVarint(out, packed.size());
+    out.insert(out.end(), packed.begin(), packed.end());
+    if (ordered) order.write(out);
+    out.insert(out.end(), stream.begin(), stream.end());
+    return true;
+}
+
+bool decodeGif(const std::vector<uint8_t> &input, const Primer &primer, std::vector<uint8_t> &out,
+               GifStats &stats)
+{
+    const uint8_t *p = input.data() + 1;
+    const uint8_t *end = input.data() + input.size();
+    uint64_t modelSize = 0, skeletonSize = 0, recordSize = 0, packedSize = 0;
+    if (!getVarint(p, end, modelSize) || modelSize > kMaxPixels || !getVarint(p, end, skeletonSize)
+        || !getVarint(p, end, recordSize) || !getVarint(p, end, packedSize) || packedSize > uint64_t(end - p)
+        || skeletonSize + recordSize > (uint64_t(1) << 32)) {
+        return false;
+    }
+    std::vector<uint8_t> skeleton(static_cast<size_t>(skeletonSize + recordSize));
+    if (!decodeBlock(Backend::Arithmetic, 2, primer, p, static_cast<size_t>(packedSize),
+                     skeleton.data(), skeleton.size())) {
+        return false;
+    }
+    p += packedSize;
+    PaletteOrder order;
+    const bool ordered = input[0] == kModeOrdered;
+    if (ordered && !order.read(p, end, globalPalette(skeleton), 8)) return false;
+
+    // The walker reads the screen and each image's blocks from the file as
+    // it is rebuilt, up to the data being decoded
+    std::vector<uint8_t> file;
+    GifWalker walker(file);
+    PixelDecoder decoder{{BinaryDecoder(p, static_cast<size_t>(end - p))}};
+    FrameCoder<PixelDecoder> frames(decoder, static_cast<size_t>(modelSize), GifWalker(skeleton));
+    if (ordered) frames.setOrder(&order);
+
+    const uint8_t *record = skeleton.data() + skeletonSize;
+    const uint8_t *recordEnd = skeleton.data() + skeleton.size();
+    size_t copied = 0;
+    while (record < recordEnd) {
+        const auto started = std::chrono::steady_clock::now();
+        GifFrame frame;
+        if (!readRecord(record, recordEnd, frame) || frame.gap > skeletonSize - copied) return false;
+        file.insert(file.end(), skeleton.begin() + copied, skeleton.begin() + copied + frame.gap);
+        copied += static_cast<size_t>(frame.gap);
+        if (walker.pos == 0) walker.readScreen();
+        while (walker.nextImage() && walker.image.dataStart < file.size()) {
+            if (!walker.skipData()) return false;
+        }
+        if (!walker.ok || walker.image.dataStart != file.size()) return false;
+
+        std::vector<uint8_t> pixels(static_cast<size_t>(frame.count));
+        {
+            ARITHMA_TRACE_SCOPE("transform", "gif model decode");
+            if (!frames.code(frame, walker.image, file, pixels, stats)) return false;
+        }
+        const int clear = 1 << frame.minCodeSize;
+        for (uint8_t index : pixels) {
+            if (index >= clear) return false;
+        }
+        if (frame.flags & kFrameInterlaced) reorderRows(pixels, static_cast<size_t>(frame.width), false);
+
+        ARITHMA_TRACE_SCOPE("transform", "gif lzw");
+        std::vector<uint8_t> payload;
+        LzwEncoder(frame, payload).encode(pixels.data(), pixels.size());
+        payload.insert(payload.end(), frame.trailing.begin(), frame.trailing.end());
+        if (frame.flags & kFrameBlockSizes) {
+            uint64_t total = 0;
+            for (uint64_t length : frame.blockSizes) total += length;
+            if (total != payload.size()) return false;
+        }
+        appendSubBlocks(payload, frame, file);
+        walker.pos = file.size();
+        stats.frameSeconds.push_back(secondsSince(started));
+    }
+    file.insert(file.end(), skeleton.begin() + copied, skeleton.begin() + skeletonSize);
+    out.insert(out.end(), file.begin(), file.end());
+    return true;
+}
+
+class GifEncoder : public TypeTransform
+{
+public:
+    explicit GifEncoder(const Primer &primer)
+        : primer(skeletonPrimer(kGifTransformVersion, primer))
+    {
+    }
+
+    bool update(const uint8_t *data, size_t size, std::vector<uint8_t> &) override
+    {
+        input.insert(input.end(), data, data + size);
+        return true;
+    }
+
+    bool finish(std::vector<uint8_t> &out) override
+    {
+        ARITHMA_TRACE_SCOPE("transform", "gif encode");
+        const size_t start = out.size();
+        coded = encodeGif(input, primer, out, gifStats) && out.size() - start < input.size();
+        if (!coded) {
+            gifStats.framePixels = gifStats.unchangedPixels = 0;
+            out.resize(start);
+            out.push_back(kModeStored);
+            out.insert(out.end(), input.begin(), input.end());
+        }
+        return true;
+    }
+
+    bool entropyCoded() const override { return coded; }
+
+    void addStats(JobStats &stats) const override { addGifStats(gifStats, stats); }
+
+private:
+    std::vector<uint8_t> input;
+    Primer   primer;
+    GifStats gifStats;
+    bool coded = false;
+};
+
+class GifDecoder : public TypeTransform
+{
+public:
+    GifDecoder(uint8_t version, const Primer &primer)
+        : primer(skeletonPrimer(version, primer))
+    {
+    }
+
+    bool update(const uint8_t *data, size_t size, std::vector<uint8_t> &) override
+    {
+        input.insert(input.end(), data, data + size);
+        return true;
+    }
+
+    bool finish(std::vector<uint8_t> &out) override
+    {
+        ARITHMA_TRACE_SCOPE("transform", "gif decode");
+        if (!input.empty() && input[0] == kModeStored) {
+            out.insert(out.end(), input.begin() + 1, input.end());
+            return true;
+        }
+        const size_t start = out.size();
+        if (input.empty() || (input[0] != kModeCoded && input[0] != kModeOrdered)
+            || !decodeGif(input, primer, out, gifStats)) {
+            out.resize(start);
+            return false;
+        }
+        return true;
+    }
+
+    void addStats(JobStats &stats) const override { addGifStats(gifStats, stats); }
+
+    std::string errorString() const override { return "GIF data could not be rebuilt"; }
+
+private:
+    std::vector<uint8_t> input;
+    Primer   primer;
+    GifStats gifStats;
+};
+
+}
+
+std::unique_ptr<TypeTransform> newGifEncoder(const Primer &primer, int)
+{
+    return std::unique_ptr<TypeTransform>(new GifEncoder(primer));
+}
+
+std::unique_ptr<TypeTransform> newGifDecoder(uint8_t version, const Primer &primer, int)
+{
+    return std::unique_ptr<TypeTransform>(new GifDecoder(version, primer));
+}
@@ -0,0 +1,51 @@
+#ifndef GIFCODEC_H
+#define GIFCODEC_H
+
+#include "typeregistry.h"
+
+#include <cstdint>
+#include <memory>
+
+/*
+ * GIF transform, version 2.
+ *
+ * The LZW data of every frame is decoded to its palette indices, which are
+ * coded with context models keyed on the indices above and to the left;
+ * the rest of the file is kept as a skeleton. Rebuilding a frame means
+ * compressing the indices again to the very same codes, so the encoder
+ * checks that a greedy LZW coder, told where the original clear codes
+ * were, gives back the frame's bytes exactly, and records what it needs.
+ *
+ * Later frames of an animation may instead be coded against the screen the
+ * frames before them left, in colours mapped back through the frame's
+ * palette: a row that repeats it costs one bit, and in other rows a mask
+ * bit per pixel says which pixels repeat it (or which are the transparent
+ * index). Only the others are modelled.
+ *
+ *   u8 mode   0: the original bytes follow unchanged
+ *             1: varint model size, varint skeleton size, varint record
+ *                size, varint coded size, the skeleton followed by the
+ *                frame records coded as one block, pixel stream
+ *             2: as 1, with the palette order before the pixel stream
+ *
+ * Each frame record holds: varint skeleton bytes before the frame's data,
+ * varint width, varint index count, u8 flags (1 interlaced, 2 end code
+ * present, 4 irregular sub-blocks, 8 bytes after the last code, 16 coded
+ * against the screen, 32 coded against the transparent index), u8 minimum
+ * code size, varint clear code count, varint codes before each clear code
+ * since the previous one; with flag 4 varint sub-block count and varint
+ * size of each; with flag 8 varint byte count and the bytes. Frames the
+ * greedy coder does not reproduce keep their data in the skeleton; files
+ * where it reproduces none, or that do not shrink, use mode 0. The order,
+ * chosen from the first frame, applies only to frames on the global table.
+ *
+ * The skeleton and frame records are coded from the container's block
+ * primer, or from none when it is unprimed; version 1, otherwise the same,
+ * always used set 1's GIF primer.
+ */
+constexpr uint8_t kGifTransformVersion = 2;
+
+std::unique_ptr<TypeTransform> newGifEncoder(const Primer &primer, int threads);
+std::unique_ptr<TypeTransform> newGifDecoder(uint8_t version, const Primer &primer, int threads);
+
+#endif // GIFCODEC_H
@@ -0,0 +1,396 @@
+#include "historymodel.h"
+
+#include "snippetcodec.h"
+
+#include <QDebug>
+#include <QRegularExpression>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QStringList>
+#include <QtGlobal>
+
+#include <algorithm>
+#include <functional>
+
+namespace {
+// Rows fetched per page; a screenful or two
+const int kPageSize = 256;
+
+// Characters of a pre-compression text_content shown in the table
+const int kTextPreviewChars = 256;
+
+struct ColumnSpec
+{
+    const char *title;
+    const char *select;    // expression in the SELECT list
+    const char *sortKey;   // expression ORDER BY and the keyset compare use
+};
+
+// NULL metrics from rows logged before they existed sort as -1 / ''
+// because a compare against NULL would drop them from pages. The name and
+// operation keys have matching expression indexes (see HistoryStore).
+// Timestamps follow insertion order, so that column sorts on the key.
+const ColumnSpec kColumns[HistoryModel::ColumnCount] = {
+    {"Name",           "name",                  "IFNULL(name, '')"},
+    {"Operation",      "operation",             "IFNULL(operation, '')"},
+    {"Type",           "data_type",             "IFNULL(data_type, '')"},
+    {"File Path",      "file_path",             "IFNULL(file_path, '')"},
+    {"Text Content",   nullptr,                 "IFNULL(text_size, IFNULL(length(text_content), -1))"},
+    {"Timestamp",      "timestamp",             "id"},
+    {"Original (B)",   "original_size",         "IFNULL(original_size, -1)"},
+    {"Compressed (B)", "compressed_size",       "IFNULL(compressed_size, -1)"},
+    {"Ratio %",        "ratio",                 "IFNULL(ratio, -1)"},
+    {"Wall ms",        "wall_ms",               "IFNULL(wall_ms, -1)"},
+    {"CPU ms",         "cpu_ms",                "IFNULL(cpu_ms, -1)"},
+    {"MB/s",           "throughput_mbps",       "IFNULL(throughput_mbps, -1)"},
+    {"Peak RSS (KB)",  "peak_rss_kb",           "IFNULL(peak_rss_kb, -1)"},
+    {"Level",          "level",                 "IFNULL(level, -1)"},
+    {"Backend",        "backend",               "IFNULL(backend, '')"},
+};
+
+QString selectList()
+{
+    QString list = "id";
+    for (const ColumnSpec &column : kColumns) {
+        list += ", ";
+        // Compressed text is only a size here; fullText() decodes it on demand
+        list += column.select ? QString(column.select)
+                              : QString("CASE WHEN text_size IS NULL THEN substr(text_content, 1, %1) "
+                                        "ELSE text_size || ' bytes (compressed)' END").arg(kTextPreviewChars);
+    }
+    return list;
+}
+
+// Qt::SplitBehavior arrived in 5.14; QString's own enum is gone in Qt 6
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+const auto kSkipEmptyParts = Qt::SkipEmptyParts;
+#else
+const auto kSkipEmptyParts = QString::SkipEmptyParts;
+#endif
+
+// Space-separated words of text, dropping those under minChars
+QStringList searchWords(const QString &text, int minChars)
+{
+    QStringList words;
+    for (const QString &word : text.split(QRegularExpression("\\s+"), kSkipEmptyParts)) {
+        if (word.size() >= minChars) words << word;
+    }
+    return words;
+}
+
+// Each word as a quoted FTS5 phrase, so punctuation in paths is literal;
+// space-separated phrases must all match
+QString matchExpression(const QStringList &words)
+{
+    QStringList phrases;
+    for (QString word : words) phrases << QString("\"%1\"").arg(word.replace('"', "\"\""));
+    return phrases.join(' ');
+}
+
+// Each word as a LIKE pattern matching it anywhere, wildcards escaped
+QStringList likePatterns(const QStringList &words)
+{
+    QStringList patterns;
+    for (QString word : words) {
+        word.replace('\\', "\\\\").replace('%', "\\%").replace('_', "\\_");
+        patterns << '%' + word + '%';
+    }
+    return patterns;
+}
+
+// The same columns the search index holds; compressed text is not in
+// text_content, so without the index it cannot be searched
+const char *const kLikeTarget =
+    "(IFNULL(name, '') || char(10) || IFNULL(file_path, '') || char(10) "
+    "|| substr(IFNULL(text_content, ''), 1, 1024))";
+}
+
+// 1) HistoryModel Implementation
+HistoryModel::HistoryModel(QObject *parent)
+    : QAbstractTableModel(parent),
+    sortColumn(Timestamp),
+    sortOrder(Qt::DescendingOrder),
+    useIndex(true),
+    loaded(false),
+    atEnd(true),
+    newestId(0)
+{
+}
+
+int HistoryModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : rows.size();
+}
+
+int HistoryModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant HistoryModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= rows.size()) return QVariant();
+
+    const int column = index.column();
+    if (role == Qt::TextAlignmentRole && column >= OriginalSize && column != Backend) {
+        return int(Qt::AlignRight | Qt::AlignVCenter);
+    }
+    if (role != Qt::DisplayRole) return QVariant();
+
+    const QVariant &value = rows[index.row()].values[column];
+    if (value.isNull()) return QVariant();
+    switch (column) {
+    case Ratio:
+    case WallMs:
+    case CpuMs:
+    case Throughput:
+        return QString::number(value.toDouble(), 'f', 2);
+    default:
+        return value;
+    }
+}
+
+QVariant HistoryModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role != Qt::DisplayRole || orientation != Qt::Horizontal
+        || section < 0 || section >= ColumnCount) {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+    return QString(kColumns[section].title);
+}
+
+bool HistoryModel::canFetchMore(const QModelIndex &parent) const
+{
+    return !parent.isValid() && !atEnd;
+}
+
+void HistoryModel::fetchMore(const QModelIndex &parent)
+{
+    if (parent.isValid() || atEnd) return;
+
+    // With every held row removed the next page is the first one
+    const QVector<Row> page = rows.isEmpty() ? fetchPage(QVariant(), 0, kPageSize)
+                                             : fetchPage(rows.last().sortKey, rows.last().id, kPageSize);
+    atEnd = page.size() < kPageSize;
+    if (page.isEmpty()) return;
+
+    beginInsertRows(QModelIndex(), rows.size(), rows.size() + page.size() - 1);
+    rows += page;
+    endInsertRows();
+}
+
+void HistoryModel::sort(int column, Qt::SortOrder order)
+{
+    if (column < 0 || column >= ColumnCount) column = Timestamp;
+    if (column == sortColumn && order == sortOrder) return;
+    sortColumn = column;
+    sortOrder  = order;
+
+    // The view sorts once when attached, before the database may be open
+    if (loaded) reload();
+}
+
+void HistoryModel::reload()
+{
+    beginResetModel();
+    loaded = true;
+    rows  = fetchPage(QVariant(), 0, kPageSize);
+    atEnd = rows.size() < kPageSize;
+
+    QSqlQuery query("SELECT MAX(id) FROM file_history");
+    newestId = query.next() ? query.value(0).toLongLong() : 0;
+    endResetModel();
+}
+
+bool HistoryModel::setFilter(const QString &text)
+{
+    // Without FTS5 trigram support HistoryStore leaves history_search out
+    const bool indexed = QSqlDatabase::database().tables().contains("history_search");
+    const QStringList words = searchWords(text, kMinSearchChars);
+    const QString expression = matchExpression(words);
+    if (expression == match && indexed == useIndex) return false;
+    match = expression;
+    useIndex = indexed;
+    patterns = useIndex ? QStringList() : likePatterns(words);
+    if (loaded) reload();
+    return true;
+}
+
+void HistoryModel::fetchNewRows()
+{
+    // Anywhere but the top the new rows would land between held pages
+    if (!newestFirst()) {
+        reload();
+        return;
+    }
+
+    const QString key = sortExpression();
+    const QStringList conditions = QStringList(QString("%1 > :newest").arg(key)) + filterConditions();
+    const QString sql = QString("SELECT %1 FROM %2 WHERE %3 ORDER BY %4 DESC")
+                            .arg(selectList(), fromClause(), conditions.join(" AND "), key);
+
+    QSqlQuery query;
+    query.prepare(sql);
+    query.bindValue(":newest", newestId);
+    bindFilter(query);
+    if (!query.exec()) {
+        qDebug() << "History fetch error:" << query.lastError().text();
+        return;
+    }
+
+    QVector<Row> fresh;
+    while (query.next()) {
+        Row row;
+        row.id      = query.value(0).toLongLong();
+        row.sortKey = row.id;
+        for (int col = 0; col < ColumnCount; ++col) row.values[col] = query.value(col + 1);
+        fresh.append(row);
+    }
+    if (fresh.isEmpty()) return;
+
+    newestId = fresh.first().id;
+    beginInsertRows(QModelIndex(), 0, fresh.size() - 1);
+    rows = fresh + rows;
+    endInsertRows();
+}
+
+void HistoryModel::removeHeldRows(QList<int> rowNumbers)
+{
+    // Bottom up so earlier removals do not shift later ones
+    std::sort(rowNumbers.begin(), rowNumbers.end(), std::greater<int>());
+    for (int row : rowNumbers) {
+        if (row < 0 || row >= rows.size()) continue;
+        beginRemoveRows(QModelIndex(), row, row);
+        rows.remove(row);
+        endRemoveRows();
+    }
+
+    // An empty table gives the view nothing to scroll to fetch the rest
+    if (rows.isEmpty()) fetchMore(QModelIndex());
+}
+
+bool HistoryModel::fullText(int row, QString &text) const
+{
+    text.clear();
+    QSqlQuery query;
+    query.prepare("SELECT text_content, text_blob FROM file_history WHERE id = :id");
+    query.bindValue(":id", rowId(row));
+    if (!query.exec() || !query.next()) return false;
+
+    if (query.value(1).isNull()) {
+        text = query.value(0).toString();
+        return true;
+    }
+    const QByteArray blob = query.value(1).toByteArray();
+    std::vector<uint8_t> utf8;
+    if (!decompressSnippet(reinterpret_cast<const uint8_t *>(blob.constData()), size_t(blob.size()), utf8)) {
+        return false;
+    }
+    text = QString::fromUtf8(reinterpret_cast<const char *>(utf8.data()), int(utf8.size()));
+    return true;
+}
+
+qint64 HistoryModel::rowId(int row) const
+{
+    return row >= 0 && row < rows.size() ? rows[row].id : -1;
+}
+
+QVector<HistoryModel::Row> HistoryModel::fetchPage(const QVariant &key, qint64 id, int limit) const
+{
+    // Seek past the last held (key, id) instead of OFFSET, so every page
+    // costs the same however deep the view has scrolled. Rows tied on the
+    // key and rows beyond it are fetched separately: SQLite seeks an index
+    // on plain comparisons but scans it for a row-value (key, id) compare.
+    // The id key has no ties, and an id tiebreak would keep a filtered
+    // query from walking the search index in rowid order.
+    const QString expr   = sortExpression();
+    const QString order  = sortOrder == Qt::DescendingOrder ? "DESC" : "ASC";
+    const QString past   = sortOrder == Qt::DescendingOrder ? "<" : ">";
+    const bool    unique = sortColumn == Timestamp;
+    const QString byKey  = unique ? QString("%1 %2").arg(expr, order)
+                                  : QString("%1 %2, id %2").arg(expr, order);
+
+    QVector<Row> page;
+    page.reserve(limit);
+    if (!key.isValid()) {
+        appendPage(QString(), byKey, key, id, limit, page);
+        return page;
+    }
+    if (!unique) {
+        appendPage(QString("%1 = :key AND id %2 :id").arg(expr, past), "id " + order, key, id, limit, page);
+    }
+    if (page.size() < limit) {
+        appendPage(QString("%1 %2 :key").arg(expr, past), byKey, key, id, limit - page.size(), page);
+    }
+    return page;
+}
+
+void HistoryModel::appendPage(const QString &where, const QString &orderBy, const QVariant &key,
+                              qint64 id, int limit, QVector<Row> &page) const
+{
+    QStringList conditions = filterConditions();
+    if (!where.isEmpty()) conditions << where;
+
+    QString sql = "SELECT " + selectList() + ", " + sortExpression() + " FROM " + fromClause();
+    if (!conditions.isEmpty()) sql += " WHERE " + conditions.join(" AND ");
+    sql += QString(" ORDER BY %1 LIMIT %2").arg(orderBy).arg(limit);
+
+    QSqlQuery query;
+    query.setForwardOnly(true);
+    query.prepare(sql);
+    bindFilter(query);
+    if (where.contains(":key")) query.bindValue(":key", key);
+    if (where.contains(":id")) query.bindValue(":id", id);
+    if (!query.exec()) {
+        qDebug() << "History fetch error:" << query.lastError().text();
+        return;
+    }
+    while (query.next()) {
+        Row row;
+        row.id = query.value(0).toLongLong();
+        for (int col = 0; col < ColumnCount; ++col) row.values[col] = query.value(col + 1);
+        row.sortKey = query.value(ColumnCount + 1);
+        page.append(row);
+    }
+}
+
+QString HistoryModel::sortExpression() const
+{
+    // Filtered rows come from the search index, which hands them out in
+    // rowid (= id) order without a sort
+    if (sortColumn == Timestamp && searchesIndex()) return "history_search.rowid";
+    return kColumns[sortColumn].sortKey;
+}
+
+QString HistoryModel::fromClause() const
+{
+    if (!searchesIndex()) return "file_history";
+    return "history_search JOIN file_history ON file_history.id = history_search.rowid";
+}
+
+QStringList HistoryModel::filterConditions() const
+{
+    QStringList conditions;
+    if (searchesIndex()) conditions << "history_search MATCH :match";
+    for (int i = 0; i < patterns.size(); ++i) {
+        conditions << QString("%1 LIKE :like%2 ESCAPE '\\'").arg(kLikeTarget).arg(i);
+    }
+    return conditions;
+}
+
+void HistoryModel::bindFilter(QSqlQuery &query) const
+{
+    if (searchesIndex()) query.bindValue(":match", match);
+    for (int i = 0; i < patterns.size(); ++i) query.bindValue(QString(":like%1").arg(i), patterns[i]);
+}
+
+bool HistoryModel::searchesIndex() const
+{
+    return useIndex && !match.isEmpty();
+}
+
+bool HistoryModel::newestFirst() const
+{
+    return sortColumn == Timestamp && sortOrder == Qt::DescendingOrder;
+}
@@ -0,0 +1,102 @@
+#ifndef HISTORYMODEL_H
+#define HISTORYMODEL_H
+
+#include <QAbstractTableModel>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+#include <QVector>
+
+/**
+ * @brief HistoryModel
+ *        Read-only view of file_history fetched lazily in keyset pages, so
+ *        opening the dialog costs one page however large the table is.
+ *        Rows logged while the view is sorted newest first are prepended
+ *        without reloading what is already held. A filter restricts rows
+ *        to those matching the history_search full-text index, or when
+ *        SQLite could not build it, to a LIKE scan that skips compressed
+ *        text.
+ */
+class QSqlQuery;
+
+class HistoryModel : public QAbstractTableModel
+{
+    Q_OBJECT
+public:
+    // Same order as the dialog's columns
+    enum Column {
+        Name, Operation, DataType, FilePath, TextContent, Timestamp,
+        OriginalSize, CompressedSize, Ratio, WallMs, CpuMs, Throughput,
+        PeakRss, Level, Backend,
+        ColumnCount
+    };
+
+    explicit HistoryModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation,
+                        int role = Qt::DisplayRole) const override;
+
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+    // Drop every held row and fetch the first page again
+    void reload();
+
+    // Show only rows whose name, path or text contains every word of text
+    // (words under kMinSearchChars are ignored); empty shows all rows.
+    // Returns false when that leaves the filter unchanged.
+    bool setFilter(const QString &text);
+    bool isFiltered() const { return !match.isEmpty(); }
+
+    // Shortest word the trigram index can look up
+    static const int kMinSearchChars = 3;
+
+    // Pick up rows inserted since the last fetch
+    void fetchNewRows();
+
+    // Drop rows already deleted from the table without reloading
+    void removeHeldRows(QList<int> rowNumbers);
+
+    // Whole text of a held row, decompressed; false if it cannot be read
+    bool fullText(int row, QString &text) const;
+
+    // Primary key of a held row, -1 when out of range
+    qint64 rowId(int row) const;
+
+private:
+    struct Row
+    {
+        qint64   id = 0;
+        QVariant sortKey;
+        QVariant values[ColumnCount];
+    };
+
+    // Rows after (key, id) in the current order, or from the top when key is invalid
+    QVector<Row> fetchPage(const QVariant &key, qint64 id, int limit) const;
+    void appendPage(const QString &where, const QString &orderBy, const QVariant &key,
+                    qint64 id, int limit, QVector<Row> &page) const;
+
+    QString sortExpression() const;
+    QString fromClause() const;
+    QStringList filterConditions() const;
+    void bindFilter(QSqlQuery &query) const;
+    bool searchesIndex() const;
+    bool newestFirst() const;
+
+    QVector<Row>  rows;
+    int           sortColumn;
+    Qt::SortOrder sortOrder;
+    QString       match;           // FTS5 query, empty when unfiltered
+    QStringList   patterns;        // LIKE patterns, used instead without the index
+    bool          useIndex;
+    bool          loaded;
+    bool          atEnd;
+    qint64        newestId;
+};
+
+#endif // HISTORYMODEL_H
@@ -0,0 +1,414 @@
+#include "historystore.h"
+
+#include "blockcodec.h"
+#include "snippetcodec.h"
+#include "trace.h"
+
+#include <QDebug>
+#include <QSqlError>
+#include <QVariant>
+
+#include <algorithm>
+
+namespace {
+// Per-connection tuning. WAL turns each commit into an append to the log,
+// and NORMAL syncs only at checkpoints, which stays crash-safe under WAL
+// (a power cut can lose the last commits, not corrupt the file).
+const char *const kPragmas[] = {
+    "PRAGMA journal_mode = WAL",
+    "PRAGMA synchronous = NORMAL",
+    "PRAGMA mmap_size = 268435456",   // read pages through a 256 MB mapping
+};
+
+// file_history schema changes in order; PRAGMA user_version is the number
+// of versions applied. Add new steps at the end, never edit old ones.
+struct SchemaStep
+{
+    int         version;
+    const char *sql;
+    bool        search = false;   // builds the search index (see migrate())
+};
+
+const SchemaStep kSchemaSteps[] = {
+    // 1: compression metrics, NULL for rows logged before them
+    {1, "ALTER TABLE file_history ADD COLUMN original_size INTEGER"},
+    {1, "ALTER TABLE file_history ADD COLUMN compressed_size INTEGER"},
+    {1, "ALTER TABLE file_history ADD COLUMN ratio REAL"},            // compressed / original, %
+    {1, "ALTER TABLE file_history ADD COLUMN wall_ms REAL"},
+    {1, "ALTER TABLE file_history ADD COLUMN cpu_ms REAL"},           // all codec threads
+    {1, "ALTER TABLE file_history ADD COLUMN throughput_mbps REAL"},  // original bytes per wall second
+    {1, "ALTER TABLE file_history ADD COLUMN peak_rss_kb INTEGER"},
+    {1, "ALTER TABLE file_history ADD COLUMN level INTEGER"},
+    {1, "ALTER TABLE file_history ADD COLUMN backend TEXT"},
+    // 2: indexes. Name and operation are indexed on the expressions the
+    // history view sorts and seeks on (HistoryModel's sort keys).
+    {2, "CREATE INDEX IF NOT EXISTS file_history_timestamp ON file_history(timestamp)"},
+    {2, "CREATE INDEX IF NOT EXISTS file_history_name ON file_history(IFNULL(name, ''))"},
+    {2, "CREATE INDEX IF NOT EXISTS file_history_operation ON file_history(IFNULL(operation, ''))"},
+    // 3: text kept as a compressed snippet (see snippetcodec.h); rows
+    // from before keep it in text_content
+    {3, "ALTER TABLE file_history ADD COLUMN text_blob BLOB"},
+    {3, "ALTER TABLE file_history ADD COLUMN text_size INTEGER"},     // UTF-8 bytes before coding
+    // 4: content-addressed compressed outputs (see ArtifactStore)
+    {4, "CREATE TABLE IF NOT EXISTS artifacts ("
+        "id INTEGER PRIMARY KEY AUTOINCREMENT,"
+        "content_hash BLOB NOT NULL,"          // 128-bit hash of the input
+        "original_size INTEGER NOT NULL,"
+        "level INTEGER NOT NULL,"
+        "backend INTEGER NOT NULL,"
+        "file_type INTEGER NOT NULL,"
+        "block_size INTEGER NOT NULL,"
+        "pack_offset INTEGER NOT NULL,"
+        "packed_size INTEGER NOT NULL,"
+        "created DATETIME DEFAULT CURRENT_TIMESTAMP,"
+        "UNIQUE (content_hash, level, backend, file_type, block_size))"},
+    {4, "ALTER TABLE file_history ADD COLUMN artifact_id INTEGER"},
+    // 5: full-text search (see HistoryModel::setFilter). Trigram tokens
+    // match any substring of three or more characters, like the LIKE scan
+    // it replaces. The triggers keep names and paths in step; text goes in
+    // compressed, so insert() and the migration fill text_terms from C++.
+    // 1024 is kSearchTextChars. SQLite without FTS5 or its trigram
+    // tokenizer (before 3.34) skips these and the view scans with LIKE;
+    // the index is built on the first open by one that has them.
+    {5, "CREATE VIRTUAL TABLE IF NOT EXISTS history_search USING fts5("
+        "name_terms, path_terms, text_terms, tokenize = 'trigram')", true},
+    {5, "INSERT INTO history_search (rowid, name_terms, path_terms, text_terms) "
+        "SELECT id, name, file_path, substr(text_content, 1, 1024) FROM file_history", true},
+    {5, "CREATE TRIGGER IF NOT EXISTS history_search_insert AFTER INSERT ON file_history BEGIN "
+        "INSERT INTO history_search (rowid, name_terms, path_terms, text_terms) "
+        "VALUES (new.id, new.name, new.file_path, substr(new.text_content, 1, 1024)); END", true},
+    {5, "CREATE TRIGGER IF NOT EXISTS history_search_update AFTER UPDATE OF name, file_path ON file_history BEGIN "
+        "UPDATE history_search SET name_terms = new.name, path_terms = new.file_path "
+        "WHERE rowid = old.id; END", true},
+    {5, "CREATE TRIGGER IF NOT EXISTS history_search_delete AFTER DELETE ON file_history BEGIN "
+        "DELETE FROM history_search WHERE rowid = old.id; END", true},
+    // 6: 128-bit hash of each stored container, checked when it is copied
+    // out; NULL for artifacts stored before it, which are not trusted
+    {6, "ALTER TABLE artifacts ADD COLUMN container_hash BLOB"},
+    // 7: the container's flags word (primer set, transform version) joins
+    // the artifact key. SQLite cannot change a UNIQUE constraint in place,
+    // so the table is rebuilt, keeping ids and the AUTOINCREMENT high-water
+    // mark. Rows stored before have NULL flags and are never matched.
+    {7, "CREATE TABLE artifacts_keyed ("
+        "id INTEGER PRIMARY KEY AUTOINCREMENT,"
+        "content_hash BLOB NOT NULL,"
+        "original_size INTEGER NOT NULL,"
+        "level INTEGER NOT NULL,"
+        "backend INTEGER NOT NULL,"
+        "file_type INTEGER NOT NULL,"
+        "block_size INTEGER NOT NULL,"
+        "pack_offset INTEGER NOT NULL,"
+        "packed_size INTEGER NOT NULL,"
+        "created DATETIME DEFAULT CURRENT_TIMESTAMP,"
+        "container_hash BLOB,"
+        "container_flags INTEGER,"
+        "UNIQUE (content_hash, level, backend, file_type, block_size, container_flags))"},
+    {7, "INSERT INTO artifacts_keyed ("
+        "id, content_hash, original_size, level, backend, file_type, block_size,"
+        "pack_offset, packed_size, created, container_hash"
+        ") SELECT "
+        "id, content_hash, original_size, level, backend, file_type, block_size,"
+        "pack_offset, packed_size, created, container_hash FROM artifacts"},
+    {7, "DELETE FROM sqlite_sequence WHERE name = 'artifacts_keyed'"},
+    {7, "INSERT INTO sqlite_sequence (name, seq) "
+        "SELECT 'artifacts_keyed', seq FROM sqlite_sequence WHERE name = 'artifacts'"},
+    {7, "DROP TABLE artifacts"},
+    {7, "ALTER TABLE artifacts_keyed RENAME TO artifacts"},
+};
+
+// Characters of a row's text that are searchable
+const int kSearchTextChars = 1024;
+
+QString decodeSnippet(const QByteArray &blob, bool &ok)
+{
+    std::vector<uint8_t> utf8;
+    ok = decompressSnippet(reinterpret_cast<const uint8_t *>(blob.constData()), size_t(blob.size()), utf8);
+    return QString::fromUtf8(reinterpret_cast<const char *>(utf8.data()), int(utf8.size()));
+}
+}
+
+// 1) HistoryStore Implementation
+HistoryStore::HistoryStore()
+    : batchOpen(false),
+    searchIndexed(false)
+{
+}
+
+HistoryStore::~HistoryStore()
+{
+    close();
+}
+
+bool HistoryStore::open(const QString &path, const QString &connectionName)
+{
+    close();
+    connection = connectionName.isEmpty() ? QString(QSqlDatabase::defaultConnection) : connectionName;
+    db = QSqlDatabase::addDatabase("QSQLITE", connection);
+    db.setDatabaseName(path);
+    if (!db.open()) {
+        return fail("Could not open " + path, db.lastError());
+    }
+    if (!configure() || !migrate()) {
+        return false;
+    }
+
+    insertQuery = QSqlQuery(db);
+    if (!insertQuery.prepare("INSERT INTO file_history ("
+                             "name, operation, data_type, file_path, text_blob, text_size,"
+                             "original_size, compressed_size, ratio, wall_ms, cpu_ms,"
+                             "throughput_mbps, peak_rss_kb, level, backend, artifact_id"
+                             ") VALUES ("
+                             ":name, :operation, :data_type, :file_path, :text_blob, :text_size,"
+                             ":original_size, :compressed_size, :ratio, :wall_ms, :cpu_ms,"
+                             ":throughput_mbps, :peak_rss_kb, :level, :backend, :artifact_id)")) {
+        return fail("Could not prepare the history insert", insertQuery.lastError());
+    }
+    searchTextQuery = QSqlQuery(db);
+    if (searchIndexed
+        && !searchTextQuery.prepare("UPDATE history_search SET text_terms = :text WHERE rowid = :id")) {
+        return fail("Could not prepare the search index update", searchTextQuery.lastError());
+    }
+    deleteQuery = QSqlQuery(db);
+    if (!deleteQuery.prepare("DELETE FROM file_history WHERE id = :id")) {
+        return fail("Could not prepare the history delete", deleteQuery.lastError());
+    }
+    return true;
+}
+
+void HistoryStore::close()
+{
+    if (connection.isEmpty()) return;
+    if (batchOpen) commitBatch();
+    insertQuery = QSqlQuery();
+    searchTextQuery = QSqlQuery();
+    deleteQuery = QSqlQuery();
+    db.close();
+    db = QSqlDatabase();
+    QSqlDatabase::removeDatabase(connection);
+    connection.clear();
+}
+
+bool HistoryStore::insert(const HistoryRecord &record)
+{
+    ARITHMA_TRACE_SCOPE("db", "history insert");
+    insertQuery.bindValue(":name", record.name);
+    insertQuery.bindValue(":operation", record.operation);
+    insertQuery.bindValue(":data_type", record.dataType);
+    insertQuery.bindValue(":file_path", record.filePath);
+
+    // Text goes in compressed; NULL rather than an empty snippet when there is none
+    QVariant textBlob, textSize;
+    if (!record.textContent.isEmpty()) {
+        const QByteArray utf8 = record.textContent.toUtf8();
+        std::vector<uint8_t> snippet;
+        compressSnippet(reinterpret_cast<const uint8_t *>(utf8.constData()), size_t(utf8.size()), snippet);
+        textBlob = QByteArray(reinterpret_cast<const char *>(snippet.data()), int(snippet.size()));
+        textSize = qint64(utf8.size());
+    }
+    insertQuery.bindValue(":text_blob", textBlob);
+    insertQuery.bindValue(":text_size", textSize);
+
+    // Metrics stay NULL when no codec job ran
+    QVariant originalSize, compressedSize, ratio, wallMs, cpuMs, throughput, peakRss, level, backend;
+    if (record.hasStats) {
+        const JobStats &stats = record.stats;
+        const bool compressing = record.operation == "Compress";
+        const quint64 raw    = compressing ? stats.inputBytes : stats.outputBytes;
+        const quint64 packed = compressing ? stats.outputBytes : stats.inputBytes;
+        originalSize   = raw;
+        compressedSize = packed;
+        if (raw > 0) ratio = 100.0 * double(packed) / double(raw);
+        wallMs = stats.wallSeconds * 1000.0;
+        cpuMs  = stats.cpuSeconds * 1000.0;
+        if (stats.wallSeconds > 0) throughput = double(raw) / stats.wallSeconds / 1e6;
+        peakRss = quint64(stats.peakRssKB);
+        level   = stats.level;
+        backend = QString(backendName(stats.backend));
+    }
+    insertQuery.bindValue(":original_size", originalSize);
+    insertQuery.bindValue(":compressed_size", compressedSize);
+    insertQuery.bindValue(":ratio", ratio);
+    insertQuery.bindValue(":wall_ms", wallMs);
+    insertQuery.bindValue(":cpu_ms", cpuMs);
+    insertQuery.bindValue(":throughput_mbps", throughput);
+    insertQuery.bindValue(":peak_rss_kb", peakRss);
+    insertQuery.bindValue(":level", level);
+    insertQuery.bindValue(":backend", backend);
+    insertQuery.bindValue(":artifact_id", record.artifactId > 0 ? QVariant(record.artifactId) : QVariant());
+
+    // The row and its searchable text commit together
+    const bool indexText = searchIndexed && !record.textContent.isEmpty();
+    const bool ownTransaction = indexText && !batchOpen;
+    if (ownTransaction && !beginBatch()) return false;
+    bool ok = insertQuery.exec();
+    QSqlError insertError = insertQuery.lastError();
+    if (ok && indexText) {
+        // The insert trigger has added the row with no text
+        searchTextQuery.bindValue(":text", record.textContent.left(kSearchTextChars));
+        searchTextQuery.bindValue(":id", insertQuery.lastInsertId());
+        ok = searchTextQuery.exec();
+        insertError = searchTextQuery.lastError();
+    }
+    if (!ok) {
+        if (ownTransaction) {
+            batchOpen = false;
+            db.rollback();
+        }
+        return fail("Could not insert the history row", insertError);
+    }
+    return !ownTransaction || commitBatch();
+}
+
+bool HistoryStore::remove(const QVector<qint64> &ids)
+{
+    if (ids.isEmpty()) return true;
+
+    // One transaction for the whole selection, joining an open batch
+    const bool ownTransaction = !batchOpen;
+    if (ownTransaction && !beginBatch()) return false;
+    for (qint64 id : ids) {
+        deleteQuery.bindValue(":id", id);
+        if (!deleteQuery.exec()) {
+            const QSqlError deleteError = deleteQuery.lastError();
+            if (ownTransaction) {
+                batchOpen = false;
+                db.rollback();
+            }
+            return fail("Could not delete the history row", deleteError);
+        }
+    }
+    return !ownTransaction || commitBatch();
+}
+
+bool HistoryStore::beginBatch()
+{
+    if (batchOpen) return true;
+    if (!db.transaction()) {
+        return fail("Could not start a history batch", db.lastError());
+    }
+    batchOpen = true;
+    return true;
+}
+
+bool HistoryStore::commitBatch()
+{
+    if (!batchOpen) return true;
+    batchOpen = false;
+    if (!db.commit()) {
+        const QSqlError commitError = db.lastError();
+        db.rollback();
+        return fail("Could not commit the history batch", commitError);
+    }
+    return true;
+}
+
+bool HistoryStore::configure()
+{
+    // Tuning is best effort: a database on a filesystem without shared
+    // memory keeps its rollback journal and still works
+    QSqlQuery query(db);
+    for (const char *pragma : kPragmas) {
+        if (!query.exec(pragma)) {
+            qDebug() << "History pragma failed:" << pragma << query.lastError().text();
+        }
+    }
+    return true;
+}
+
+bool HistoryStore::migrate()
+{
+    QSqlQuery query(db);
+    if (!query.exec("CREATE TABLE IF NOT EXISTS file_history ("
+                    "id INTEGER PRIMARY KEY AUTOINCREMENT,"
+                    "name TEXT,"
+                    "operation TEXT,"
+                    "data_type TEXT,"
+                    "file_path TEXT,"
+                    "text_content TEXT,"
+                    "timestamp DATETIME DEFAULT CURRENT_TIMESTAMP)")) {
+        return fail("Could not create file_history", query.lastError());
+    }
+
+    if (!query.exec("PRAGMA user_version") || !query.next()) {
+        return fail("Could not read the schema version", query.lastError());
+    }
+    const int current = query.value(0).toInt();
+    int target = current;
+    for (const SchemaStep &step : kSchemaSteps) target = std::max(target, step.version);
+
+    // The search index is built whenever SQLite can and it is missing,
+    // which also covers a database upgraded by a build that could not
+    searchIndexed = searchAvailable();
+    const bool buildIndex = searchIndexed && !db.tables().contains("history_search");
+    if (!searchIndexed) {
+        qDebug() << "SQLite lacks FTS5 trigram search; history search scans the table instead";
+    }
+    if (target == current && !buildIndex) return true;
+
+    // All pending steps or none, so a failed upgrade can simply be retried
+    db.transaction();
+    for (const SchemaStep &step : kSchemaSteps) {
+        if (step.search ? !buildIndex : step.version <= current) continue;
+        if (!query.exec(step.sql)) {
+            const QSqlError stepError = query.lastError();
+            db.rollback();
+            return fail("Schema migration failed", stepError);
+        }
+    }
+    if (buildIndex && !indexStoredText()) {
+        db.rollback();
+        return false;
+    }
+    if (!query.exec(QString("PRAGMA user_version = %1").arg(target))) {
+        const QSqlError versionError = query.lastError();
+        db.rollback();
+        return fail("Could not record the schema version", versionError);
+    }
+    if (!db.commit()) {
+        return fail("Could not commit the schema migration", db.lastError());
+    }
+    return true;
+}
+
+bool HistoryStore::searchAvailable()
+{
+    QSqlQuery query(db);
+    if (!query.exec("CREATE VIRTUAL TABLE temp.search_probe USING fts5(terms, tokenize = 'trigram')")) {
+        return false;
+    }
+    query.exec("DROP TABLE temp.search_probe");
+    return true;
+}
+
+bool HistoryStore::indexStoredText()
+{
+    // SQL cannot decode snippets, so rows stored compressed before the
+    // search index existed are added to it here
+    QSqlQuery rows(db);
+    rows.setForwardOnly(true);
+    if (!rows.exec("SELECT id, text_blob FROM file_history WHERE text_blob IS NOT NULL")) {
+        return fail("Could not read stored text for the search index", rows.lastError());
+    }
+    QSqlQuery update(db);
+    update.prepare("UPDATE history_search SET text_terms = :text WHERE rowid = :id");
+    while (rows.next()) {
+        bool decoded = false;
+        const QString text = decodeSnippet(rows.value(1).toByteArray(), decoded);
+        if (!decoded) {
+            qDebug() << "History row" << rows.value(0).toLongLong() << "has unreadable text; not indexed";
+            continue;
+        }
+        update.bindValue(":text", text.left(kSearchTextChars));
+        update.bindValue(":id", rows.value(0));
+        if (!update.exec()) {
+            return fail("Could not index stored text", update.lastError());
+        }
+    }
+    return true;
+}
+
+bool HistoryStore::fail(const QString &context, const QSqlError &sqlError)
+{
+    error = context + ": " + sqlError.text();
+    return false;
+}
@@ -0,0 +1,88 @@
+#ifndef HISTORYSTORE_H
+#define HISTORYSTORE_H
+
+#include "codecengine.h"
+
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QString>
+#include <QVector>
+
+class QSqlError;
+
+/**
+ * @brief HistoryRecord
+ *        One file_history row. The metric columns are filled from stats
+ *        when hasStats is set and left NULL otherwise.
+ */
+struct HistoryRecord
+{
+    QString  name;
+    QString  operation;        // "Compress" or "Decompress"
+    QString  dataType;         // "Text" or "File"
+    QString  filePath;
+    QString  textContent;
+    bool     hasStats = false;
+    JobStats stats;
+    qint64   artifactId = 0;   // stored compressed output, 0 for none
+};
+
+/**
+ * @brief HistoryStore
+ *        Owns the SQLite history database: connection tuning, schema
+ *        migrations and inserts. The insert statement is prepared once per
+ *        connection, and rows written between beginBatch() and
+ *        commitBatch() share one transaction. The history_search FTS5
+ *        table follows file_history through triggers, when SQLite has
+ *        FTS5's trigram tokenizer. Calls return false on failure and leave
+ *        a message in errorString().
+ */
+class HistoryStore
+{
+public:
+    HistoryStore();
+    ~HistoryStore();
+
+    // Open (creating if needed) and migrate the database at path. An empty
+    // connection name makes it Qt's default connection.
+    bool open(const QString &path, const QString &connectionName = QString());
+    void close();
+    bool isOpen() const { return db.isOpen(); }
+
+    bool insert(const HistoryRecord &record);
+
+    // Delete rows by primary key, all or none
+    bool remove(const QVector<qint64> &ids);
+
+    // Group the inserts in between into a single transaction
+    bool beginBatch();
+    bool commitBatch();
+    bool inBatch() const { return batchOpen; }
+
+    // Whether history_search exists; without it HistoryModel filters with LIKE
+    bool hasSearchIndex() const { return searchIndexed; }
+
+    QSqlDatabase database() const { return db; }
+    const QString &errorString() const { return error; }
+
+    HistoryStore(const HistoryStore &) = delete;
+    HistoryStore &operator=(const HistoryStore &) = delete;
+
+private:
+    bool configure();
+    bool migrate();
+    bool searchAvailable();
+    bool indexStoredText();
+    bool fail(const QString &context, const QSqlError &sqlError);
+
+    QSqlDatabase db;
+    QString      connection;
+    QSqlQuery    insertQuery;      // prepared once, rebound per row
+    QSqlQuery    searchTextQuery;
+    QSqlQuery    deleteQuery;
+    bool         batchOpen;
+    bool         searchIndexed;
+    QString      error;
+};
+
+#endif // HISTORYSTORE_H
@@ -0,0 +1,138 @@
+#include "historywriter.h"
+
+#include "trace.h"
+
+#include <QMutexLocker>
+
+namespace {
+// The writer's own connection; the GUI thread keeps the default one for reads
+const char *const kWriterConnection = "history-writer";
+}
+
+// 1) HistoryWriter Implementation
+HistoryWriter::HistoryWriter(QObject *parent)
+    : QThread(parent),
+    accepting(false),
+    stopping(false),
+    openDone(false)
+{
+}
+
+HistoryWriter::~HistoryWriter()
+{
+    stopWriting();
+}
+
+bool HistoryWriter::startWriting(const QString &path)
+{
+    if (isRunning()) return true;
+    {
+        QMutexLocker lock(&mutex);
+        databasePath = path;
+        stopping = false;
+        openDone = false;
+        error.clear();
+    }
+    start();
+
+    // Opening is quick once the GUI connection has migrated the schema
+    QMutexLocker lock(&mutex);
+    while (!openDone) openFinished.wait(&mutex);
+    return accepting;
+}
+
+void HistoryWriter::stopWriting()
+{
+    {
+        QMutexLocker lock(&mutex);
+        accepting = false;
+        stopping = true;
+        changesQueued.wakeAll();
+        roomFreed.wakeAll();
+    }
+    wait();
+}
+
+bool HistoryWriter::insert(const HistoryRecord &record)
+{
+    Change change;
+    change.record = record;
+    return enqueue(change);
+}
+
+bool HistoryWriter::remove(const QVector<qint64> &ids)
+{
+    if (ids.isEmpty()) return true;
+    Change change;
+    change.removeIds = ids;
+    return enqueue(change);
+}
+
+QString HistoryWriter::errorString() const
+{
+    QMutexLocker lock(&mutex);
+    return error;
+}
+
+bool HistoryWriter::enqueue(const Change &change)
+{
+    QMutexLocker lock(&mutex);
+    while (accepting && queue.size() >= kQueueCapacity) roomFreed.wait(&mutex);
+    if (!accepting) return false;
+    queue.enqueue(change);
+    changesQueued.wakeOne();
+    return true;
+}
+
+void HistoryWriter::run()
+{
+    HistoryStore store;
+    const bool opened = store.open(databasePath, kWriterConnection);
+    {
+        QMutexLocker lock(&mutex);
+        accepting = opened && !stopping;
+        if (!opened) error = store.errorString();
+        openDone = true;
+        openFinished.wakeAll();
+    }
+    if (!opened) return;
+
+    for (;;) {
+        // Take whatever has queued up, so a burst becomes one transaction
+        QVector<Change> batch;
+        {
+            QMutexLocker lock(&mutex);
+            while (queue.isEmpty() && !stopping) changesQueued.wait(&mutex);
+            if (queue.isEmpty()) break;   // stopping, and nothing left
+            while (!queue.isEmpty() && batch.size() < kBatchSize) batch.append(queue.dequeue());
+            roomFreed.wakeAll();
+        }
+        writeBatch(store, batch);
+    }
+    store.close();
+}
+
+void HistoryWriter::writeBatch(HistoryStore &store, const QVector<Change> &batch)
+{
+    ARITHMA_TRACE_SCOPE("db", "history batch");
+    // A failed change is reported and skipped; the rest still commit
+    if (!store.beginBatch()) emit writeFailed(store.errorString());
+
+    int inserted = 0, removed = 0;
+    for (const Change &change : batch) {
+        bool ok;
+        if (!change.removeIds.isEmpty()) {
+            ok = store.remove(change.removeIds);
+            if (ok) removed += change.removeIds.size();
+        } else {
+            ok = store.insert(change.record);
+            if (ok) ++inserted;
+        }
+        if (!ok) emit writeFailed(store.errorString());
+    }
+    if (!store.commitBatch()) {
+        emit writeFailed(store.errorString());
+        return;
+    }
+    emit batchWritten(inserted, removed);
+}
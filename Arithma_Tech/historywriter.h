@@ -0,0 +1,75 @@
+#ifndef HISTORYWRITER_H
+#define HISTORYWRITER_H
+
+#include "historystore.h"
+
+#include <QMutex>
+#include <QQueue>
+#include <QString>
+#include <QThread>
+#include <QVector>
+#include <QWaitCondition>
+
+/**
+ * @brief HistoryWriter
+ *        Runs every file_history write on its own thread and connection,
+ *        so the GUI never waits on SQLite. insert() and remove() only
+ *        queue the change; the thread commits whatever is queued as one
+ *        batch and reports it through batchWritten(). The queue is
+ *        bounded: a producer blocks only when kQueueCapacity changes are
+ *        still waiting.
+ */
+class HistoryWriter : public QThread
+{
+    Q_OBJECT
+public:
+    static const int kQueueCapacity = 1024;
+    static const int kBatchSize     = 256;   // changes per transaction at most
+
+    explicit HistoryWriter(QObject *parent = nullptr);
+    ~HistoryWriter() override;
+
+    // Open the database at path on the writer thread; false, with a
+    // message in errorString(), when it could not be opened
+    bool startWriting(const QString &path);
+
+    // Write everything still queued, then close and join the thread
+    void stopWriting();
+
+    // Queue a change; false when the writer is not running
+    bool insert(const HistoryRecord &record);
+    bool remove(const QVector<qint64> &ids);
+
+    QString errorString() const;
+
+signals:
+    // Emitted from the writer thread after each committed batch
+    void batchWritten(int inserted, int removed);
+    void writeFailed(const QString &message);
+
+protected:
+    void run() override;
+
+private:
+    struct Change
+    {
+        HistoryRecord   record;
+        QVector<qint64> removeIds;   // a delete when not empty
+    };
+
+    bool enqueue(const Change &change);
+    void writeBatch(HistoryStore &store, const QVector<Change> &batch);
+
+    QString        databasePath;
+    mutable QMutex mutex;
+    QWaitCondition changesQueued;   // the writer waits for work
+    QWaitCondition roomFreed;       // producers wait for space
+    QWaitCondition openFinished;
+    QQueue<Change> queue;
+    bool           accepting;
+    bool           stopping;
+    bool           openDone;
+    QString        error;
+};
+
+#endif // HISTORYWRITER_H
@@ -0,0 +1,213 @@
+#include "imagemodel.h"
+
+#include <algorithm>
+#include <cstring>
+
+// 1) ImageModel Implementation
+ImageModel::ImageModel(size_t size, int mixContexts)
+    : mixer(kImageModelInputs, mixContexts)
+{
+    // Twice as many models as bytes, up to 8 MB a table
+    int bits = 12;
+    while (bits < 21 && (size_t(1) << bits) < size * 2) ++bits;
+    for (int k = 0; k < kImageModelInputs; ++k) {
+        tables[k].resize(size_t(1) << bits);
+        shifts[k] = 32 - bits;
+    }
+}
+
+// 2) PaletteOrder Implementation
+PaletteOrder::PaletteOrder()
+{
+    for (int i = 0; i < 256; ++i) order[i] = coded[i] = index[i] = static_cast<uint8_t>(i);
+}
+
+void PaletteOrder::set(Method method, const std::vector<uint8_t> &indices, int bitsPerIndex)
+{
+    const int size = 1 << bitsPerIndex;
+    bool placed[256] = {};
+    int filled = 0;
+    listed.clear();
+    for (uint8_t value : indices) {
+        if (value >= size || placed[value]) continue;
+        placed[value] = true;
+        listed.push_back(value);
+        order[filled++] = value;
+    }
+    for (int value = 0; value < size; ++value) {
+        if (!placed[value]) order[filled++] = static_cast<uint8_t>(value);
+    }
+    how = method;
+
+    // Position of each index, then every byte field by field
+    uint8_t rank[256];
+    for (int k = 0; k < size; ++k) rank[order[k]] = static_cast<uint8_t>(k);
+    const int mask = size - 1;
+    for (int value = 0; value < 256; ++value) {
+        int mapped = 0;
+        for (int shift = 8 - bitsPerIndex; shift >= 0; shift -= bitsPerIndex) {
+            mapped |= rank[(value >> shift) & mask] << shift;
+        }
+        coded[value] = static_cast<uint8_t>(mapped);
+        index[mapped] = static_cast<uint8_t>(value);
+    }
+}
+
+void PaletteOrder::write(std::vector<uint8_t> &out) const
+{
+    out.push_back(how);
+    if (how != kListed) return;
+    out.push_back(static_cast<uint8_t>(listed.size() - 1));
+    out.insert(out.end(), listed.begin(), listed.end());
+}
+
+bool PaletteOrder::read(const uint8_t *&p, const uint8_t *end, const std::vector<uint8_t> &palette, int bitsPerIndex)
+{
+    if (p >= end || *p > kListed) return false;
+    const Method method = static_cast<Method>(*p++);
+    if (method == kAsIs) {
+        set(kAsIs, std::vector<uint8_t>(), bitsPerIndex);
+    } else if (method == kLuminance) {
+        set(kLuminance, luminanceOrder(palette), bitsPerIndex);
+    } else {
+        if (p >= end) return false;
+        const size_t count = size_t(*p++) + 1;
+        if (size_t(end - p) < count) return false;
+        const std::vector<uint8_t> indices(p, p + count);
+        p += count;
+        set(kListed, indices, bitsPerIndex);
+        if (listed.size() != count) return false;
+    }
+    return true;
+}
+
+std::vector<uint8_t> luminanceOrder(const std::vector<uint8_t> &palette)
+{
+    const size_t colors = std::min<size_t>(palette.size() / 3, 256);
+    std::vector<uint8_t> indices(colors);
+    std::vector<uint32_t> luma(colors);
+    for (size_t i = 0; i < colors; ++i) {
+        const uint8_t *rgb = palette.data() + 3 * i;
+        indices[i] = static_cast<uint8_t>(i);
+        luma[i] = 299u * rgb[0] + 587u * rgb[1] + 114u * rgb[2];
+    }
+    std::stable_sort(indices.begin(), indices.end(), [&](uint8_t a, uint8_t b) { return luma[a] < luma[b]; });
+    return indices;
+}
+
+// 3) Choosing an order
+namespace {
+
+// Samples are about this size, in runs of consecutive rows spread over
+// the image
+const size_t kOrderSampleBytes = size_t(1) << 16;
+const size_t kOrderSampleRun = 8;
+
+// Greedy chain through the indices: the most common first, then each
+// time the one seen most often next to the last placed
+std::vector<uint8_t> cooccurrenceOrder(const std::vector<uint8_t> &sample, size_t rowBytes, int bitsPerIndex)
+{
+    const int perByte = 8 / bitsPerIndex;
+    const size_t width = rowBytes * perByte;
+    const int mask = (1 << bitsPerIndex) - 1;
+    std::vector<uint8_t> pixels(sample.size() * perByte);
+    for (size_t i = 0; i < sample.size(); ++i) {
+        for (int k = 0; k < perByte; ++k) {
+            pixels[i * perByte + k] = static_cast<uint8_t>(sample[i] >> (8 - bitsPerIndex * (k + 1)) & mask);
+        }
+    }
+
+    std::vector<uint64_t> count(256), together(256 * 256);
+    for (size_t i = 0; i < pixels.size(); ++i) {
+        const uint8_t value = pixels[i];
+        ++count[value];
+        if (i % width && pixels[i - 1] != value) {
+            ++together[value * 256 + pixels[i - 1]];
+            ++together[pixels[i - 1] * 256 + value];
+        }
+        if (i >= width && pixels[i - width] != value) {
+            ++together[value * 256 + pixels[i - width]];
+            ++together[pixels[i - width] * 256 + value];
+        }
+    }
+
+    std::vector<uint8_t> indices;
+    std::vector<bool> placed(256);
+    int last = -1;
+    for (;;) {
+        int best = -1;
+        for (int value = 0; value < 256; ++value) {
+            if (placed[value] || count[value] == 0) continue;
+            if (best < 0) {
+                best = value;
+                continue;
+            }
+            const uint64_t a = last >= 0 ? together[last * 256 + value] : 0;
+            const uint64_t b = last >= 0 ? together[last * 256 + best] : 0;
+            if (a > b || (a == b && count[value] > count[best])) best = value;
+        }
+        if (best < 0) break;
+        placed[best] = true;
+        indices.push_back(static_cast<uint8_t>(best));
+        last = best;
+    }
+    return indices;
+}
+
+// Size of the sample coded in order
+size_t sampleCost(const std::vector<uint8_t> &sample, size_t rowBytes, bool runs, const PaletteOrder *order)
+{
+    std::vector<uint8_t> stream;
+    PixelEncoder encoder{{BinaryEncoder(stream)}};
+    RowCoder<PixelEncoder> rows(encoder, sample.size(), 1, false, false, runs);
+    rows.setOrder(order);
+    rows.start(rowBytes);
+    for (size_t pos = 0; pos + rowBytes <= sample.size(); pos += rowBytes) {
+        std::memcpy(rows.row(), sample.data() + pos, rowBytes);
+        rows.code();
+        rows.next();
+    }
+    encoder.coder.finish();
+    return stream.size();
+}
+
+}
+
+PaletteOrder choosePaletteOrder(const uint8_t *rows, size_t stride, size_t rowBytes, size_t count,
+                                int bitsPerIndex, const std::vector<uint8_t> &palette, bool runs)
+{
+    PaletteOrder chosen;
+    if (rowBytes == 0 || count == 0) return chosen;
+
+    // Runs of rows spread evenly, up to the sample size
+    const size_t wanted = std::min(count, std::max<size_t>(1, kOrderSampleBytes / rowBytes));
+    const size_t pieces = std::max<size_t>(1, wanted / kOrderSampleRun);
+    const size_t perPiece = (wanted + pieces - 1) / pieces;
+    std::vector<uint8_t> sample;
+    for (size_t piece = 0; piece < pieces; ++piece) {
+        const size_t first = piece * count / pieces;
+        const size_t last = std::min(first + perPiece, (piece + 1) * count / pieces);
+        for (size_t row = first; row < last; ++row) {
+            sample.insert(sample.end(), rows + row * stride, rows + row * stride + rowBytes);
+        }
+    }
+
+    // Costs are scaled up to the whole image, and include writing the order
+    const uint64_t sampled = sample.size() / rowBytes;
+    const uint64_t plain = sampleCost(sample, rowBytes, runs, nullptr) * count / sampled;
+    uint64_t best = plain - (plain >> kOrderGainShift);
+    std::vector<PaletteOrder> candidates(2);
+    candidates[0].set(PaletteOrder::kListed, cooccurrenceOrder(sample, rowBytes, bitsPerIndex), bitsPerIndex);
+    if (!palette.empty()) candidates[1].set(PaletteOrder::kLuminance, luminanceOrder(palette), bitsPerIndex);
+    for (const PaletteOrder &candidate : candidates) {
+        if (candidate.method() == PaletteOrder::kAsIs) continue;
+        std::vector<uint8_t> written;
+        candidate.write(written);
+        const uint64_t cost = sampleCost(sample, rowBytes, runs, &candidate) * count / sampled + written.size();
+        if (cost < best) {
+            best = cost;
+            chosen = candidate;
+        }
+    }
+    return chosen;
+}
@@ -0,0 +1,340 @@
+#ifndef IMAGEMODEL_H
+#define IMAGEMODEL_H
+
+#include "bitmodel.h"
+#include "mixingmodel.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+constexpr int kImageModelInputs = 4;
+
+inline uint32_t hashOf(uint32_t a, uint32_t b)
+{
+    const uint32_t h = (a * 0x9E3779B1u) ^ (b + 0x7F4A7C15u);
+    return (h * 0x85EBCA6Bu) ^ (h >> 13);
+}
+
+/**
+ * @brief ImageModel
+ *        Codes pixel bytes bit by bit from kImageModelInputs hashed
+ *        contexts, mixed by a Mixer whose weight set the caller picks.
+ *        The image transforms build their contexts from the pixels
+ *        already coded and share this to turn them into bits.
+ */
+class ImageModel
+{
+public:
+    // size is roughly how many bytes will be coded; mixContexts is the
+    // number of weight sets
+    ImageModel(size_t size, int mixContexts);
+
+    // Codes the byte bit by bit and returns it; value is ignored when
+    // decoding. The contexts must leave their low 8 bits clear. Each nibble
+    // is coded within one 16-model block per context, so a byte costs two
+    // table lookups per context rather than eight
+    template <typename Coder>
+    int codeByte(Coder &coder, int value, const uint32_t *contexts, int mixContext)
+    {
+        BitModel *blocks[kImageModelInputs];
+        int node = 1;
+        int slot = 1;
+        for (int b = 7; b >= 0; --b) {
+            if (b == 7 || b == 3) {
+                for (int k = 0; k < kImageModelInputs; ++k) {
+                    const size_t index = ((contexts[k] + node) * 0x9E3779B1u) >> shifts[k];
+                    blocks[k] = &tables[k][index & ~size_t(15)];
+                }
+                slot = 1;
+            }
+            for (int k = 0; k < kImageModelInputs; ++k) {
+                mixer.add(stretch(static_cast<int>(probabilityOf(blocks[k][slot]))));
+            }
+            const int bit = coder.code((value >> b) & 1, static_cast<uint32_t>(mixer.mix(mixContext)));
+            mixer.update(bit);
+            for (int k = 0; k < kImageModelInputs; ++k) adapt(blocks[k][slot], bit);
+            node = node << 1 | bit;
+            slot = slot << 1 | bit;
+        }
+        return node & 255;
+    }
+
+private:
+    std::vector<BitModel> tables[kImageModelInputs];
+    int   shifts[kImageModelInputs];
+    Mixer mixer;
+};
+
+// Contexts for the palette index (or packed pixel byte) at i of row, from
+// the ones before it and those of the row above (null for the first row).
+// Returns the weight set, one of kIndexMixContexts.
+constexpr int kIndexMixContexts = 8;
+
+inline int indexContexts(const uint8_t *row, const uint8_t *above, size_t i, size_t width, uint32_t *contexts)
+{
+    const uint32_t w  = i ? row[i - 1] : 0;
+    const uint32_t ww = i > 1 ? row[i - 2] : 0;
+    const uint32_t n  = above ? above[i] : 0;
+    const uint32_t nw = above && i ? above[i - 1] : 0;
+    const uint32_t ne = above && i + 1 < width ? above[i + 1] : 0;
+
+    contexts[0] = hashOf(w, 0) << 8;
+    contexts[1] = hashOf(w << 16 | n << 8 | nw, ne + 0x100) << 8;
+    contexts[2] = hashOf(w << 8 | n, 0x200) << 8;
+    contexts[3] = hashOf(w << 8 | ww, 0x300) << 8;
+    return static_cast<int>(w >> 5);
+}
+
+/**
+ * @brief PaletteOrder
+ *        Order palette indices are coded in. Each index is coded as its
+ *        position in the order, so sorting the palette by luminance, or so
+ *        that indices seen next to each other sit together, lets the
+ *        bitwise models share what they learn between indices that behave
+ *        alike. The rows themselves keep the file's indices. The maps work
+ *        on whole bytes, a field at a time for indices under 8 bits.
+ *
+ *        Written as u8 method: 0 as they are, 1 by luminance (recomputed
+ *        from the palette), 2 listed, followed by u8 count - 1 and the
+ *        first count indices in order; the rest follow in their own order.
+ */
+class PaletteOrder
+{
+public:
+    enum Method : uint8_t { kAsIs = 0, kLuminance = 1, kListed = 2 };
+
+    PaletteOrder();
+
+    // indices lists them in coding order, from first to last
+    void set(Method method, const std::vector<uint8_t> &indices, int bitsPerIndex);
+
+    Method method() const { return how; }
+
+    uint8_t toCoded(uint8_t value) const { return coded[value]; }
+    uint8_t toIndex(uint8_t value) const { return index[value]; }
+
+    void write(std::vector<uint8_t> &out) const;
+
+    // palette holds RGB triples; false on a malformed order
+    bool read(const uint8_t *&p, const uint8_t *end, const std::vector<uint8_t> &palette, int bitsPerIndex);
+
+private:
+    Method  how = kAsIs;
+    std::vector<uint8_t> listed;   // the leading entries of order chosen
+    uint8_t order[256];
+    uint8_t coded[256];
+    uint8_t index[256];
+};
+
+// Indices by the luminance of their colours, palette holding RGB triples
+std::vector<uint8_t> luminanceOrder(const std::vector<uint8_t> &palette);
+
+// Picks the order for the count rows of stride bytes at rows, whose first
+// rowBytes hold packed indices: by luminance (with a palette of RGB
+// triples), by which indices are seen together, or as they are. Each is
+// tried on a sample of the rows, coded by a RowCoder with or without runs,
+// and one is kept only when it saves at least 1/2^kOrderGainShift of the
+// image's estimated size, writing the order included.
+constexpr int kOrderGainShift = 6;
+
+PaletteOrder choosePaletteOrder(const uint8_t *rows, size_t stride, size_t rowBytes, size_t count,
+                                int bitsPerIndex, const std::vector<uint8_t> &palette, bool runs);
+
+constexpr int kActivityBuckets = 10;
+
+/**
+ * @brief RowCoder
+ *        Codes an image a row at a time, keeping only the row above, so it
+ *        needs memory for two rows whatever the image's height. Samples
+ *        are coded bytewise as the residual of a median edge predictor,
+ *        under the local gradient and under hashes of the exact
+ *        neighbouring values, which is what finds repeated shapes such as
+ *        text; with correlated channels, the second and third follow what
+ *        the predictor missed on the one before. Palette indices and
+ *        packed low-depth pixels are coded as they are, under hashes of
+ *        their neighbours.
+ *
+ *        With runs on, a pixel that repeats the one before it is followed
+ *        by the number of further repeats, which are then copied rather
+ *        than modelled.
+ */
+template <typename Coder>
+class RowCoder
+{
+public:
+    // size is roughly how many bytes will be coded; bytesPerPixel is the
+    // distance to the same channel of the pixel to the left
+    RowCoder(Coder &coder, size_t size, int bytesPerPixel, bool samples, bool correlated, bool runs = false)
+        : coder(coder),
+        model(size, 8 * kActivityBuckets),
+        bpp(static_cast<size_t>(std::max(1, bytesPerPixel))),
+        samples(samples),
+        correlated(correlated),
+        runs(runs)
+    {
+    }
+
+    // Packed pixels are coded in order's positions; null for the indices
+    // as they are
+    void setOrder(const PaletteOrder *value) { order = value; }
+
+    // Starts over with a blank row above, for rows of length bytes
+    void start(size_t length)
+    {
+        prior.assign(length, 0);
+        current.assign(length, 0);
+        havePrior = false;
+    }
+
+    // The row being coded, read when encoding and written when decoding,
+    // and the one above it
+    uint8_t *row() { return current.data(); }
+    const uint8_t *above() const { return prior.data(); }
+
+    void code()
+    {
+        repeatEnd = SIZE_MAX;
+        if (samples) codeSamples();
+        else codePacked();
+    }
+
+    // The row just coded becomes the one above
+    void next()
+    {
+        prior.swap(current);
+        havePrior = true;
+    }
+
+private:
+    void codeSamples()
+    {
+        const size_t length = current.size();
+        int lastPrediction = 0, lastResidual = 0;
+        for (size_t i = 0; i < length; ++i) {
+            if (runs && i % bpp == 0 && codeRepeats(i)) {
+                if (i == length) break;
+                lastPrediction = lastResidual = 0;
+            }
+            const size_t channel = i % bpp;
+            const int w  = i >= bpp ? current[i - bpp] : (havePrior ? prior[i] : 0);
+            const int n  = havePrior ? prior[i] : w;
+            const int nw = havePrior && i >= bpp ? prior[i - bpp] : n;
+            const int ne = havePrior && i + bpp < length ? prior[i + bpp] : n;
+            const int before = channel ? current[i - 1] : 0;
+
+            int predicted = std::max(std::min(w, n), std::min(std::max(w, n), w + n - nw));
+            if (correlated && (channel == 1 || channel == 2)) {
+                predicted = std::min(255, std::max(0, predicted + before - lastPrediction));
+            }
+            const int activity = std::min(kActivityBuckets - 1,
+                                          bitLength(static_cast<uint32_t>(std::abs(w - nw) + std::abs(n - nw)
+                                                                          + std::abs(n - ne))));
+            const uint32_t cls = static_cast<uint32_t>(channel & 7);
+            const uint32_t flat = (w == n) | (n == nw) << 1 | (n == ne) << 2;
+
+            uint32_t contexts[kImageModelInputs];
+            contexts[0] = (((cls * kActivityBuckets + activity) << 3 | flat) << 1 | (lastResidual == 0)) << 8;
+            contexts[1] = hashOf(cls << 24 | w << 16 | n << 8 | nw, ne << 8 | before) << 8;
+            contexts[2] = hashOf(cls << 16 | w << 8 | n, before + 0x100) << 8;
+            contexts[3] = hashOf(cls << 16 | activity, (lastResidual & 0xFF) + 0x10000) << 8;
+
+            // Residuals as 0, -1, 1, -2, ... so small ones share leading zeros
+            const int residual = static_cast<int8_t>(current[i] - predicted);
+            const int folded = residual >= 0 ? 2 * residual : -2 * residual - 1;
+            const int coded = model.codeByte(coder, folded, contexts, static_cast<int>(cls) * kActivityBuckets + activity);
+            const int unfolded = coded & 1 ? -((coded + 1) >> 1) : coded >> 1;
+            current[i] = static_cast<uint8_t>(predicted + unfolded);
+            lastPrediction = predicted;
+            lastResidual = unfolded;
+        }
+    }
+
+    void codePacked()
+    {
+        const size_t length = current.size();
+        const uint8_t *above = havePrior ? prior.data() : nullptr;
+        for (size_t i = 0; i < length; ++i) {
+            if (runs && codeRepeats(i) && i == length) break;
+            uint32_t contexts[kImageModelInputs];
+            const int mixContext = indexContexts(current.data(), above, i, length, contexts);
+            if (order) {
+                const int value = model.codeByte(coder, order->toCoded(current[i]), contexts, mixContext);
+                current[i] = order->toIndex(static_cast<uint8_t>(value));
+            } else {
+                current[i] = static_cast<uint8_t>(model.codeByte(coder, current[i], contexts, mixContext));
+            }
+        }
+    }
+
+    // At a pixel boundary i after two equal pixels, codes how many more
+    // repeat them, copies those and moves i past them. Returns whether it
+    // did; a run of none is coded too, and then i is left to be coded.
+    bool codeRepeats(size_t &i)
+    {
+        const size_t pixel = samples ? bpp : 1;
+        if (i < 2 * pixel || i == repeatEnd) return false;
+        const uint8_t *w = current.data() + i - pixel;
+        if (std::memcmp(w, w - pixel, pixel) != 0) return false;
+
+        const size_t available = (current.size() - i) / pixel;
+        size_t count = 0;
+        if (Coder::kEncoding) {
+            while (count < available && std::memcmp(current.data() + i + count * pixel, w, pixel) == 0) ++count;
+        }
+        const int aboveSame = havePrior && std::memcmp(prior.data() + i - pixel, prior.data() + i, pixel) == 0;
+        count = std::min<size_t>(available, static_cast<size_t>(codeCount(count + 1, aboveSame) - 1));
+        for (size_t k = 0; k < count; ++k) std::memcpy(current.data() + i + k * pixel, w, pixel);
+        i += count * pixel;
+        repeatEnd = i;
+        return true;
+    }
+
+    // Count >= 1 as its bit length in unary, then the bits below the
+    // leading one
+    uint64_t codeCount(uint64_t count, int context)
+    {
+        int bits = 0;
+        while (count >> bits) ++bits;
+        int length = 1;
+        while (length < kMaxCountBits && coder.code(length < bits, countLength[context][length - 1])) ++length;
+        uint64_t result = 1;
+        for (int b = length - 2; b >= 0; --b) {
+            result = result << 1 | uint64_t(coder.code(int(count >> b & 1), countBits[length - 1]));
+        }
+        return result;
+    }
+
+    static const int kMaxCountBits = 40;
+
+    Coder     &coder;
+    ImageModel model;
+    BitModel   countLength[2][kMaxCountBits];   // by whether the row above repeats there
+    BitModel   countBits[kMaxCountBits];
+    std::vector<uint8_t> prior;
+    std::vector<uint8_t> current;
+    size_t bpp;
+    bool   samples;
+    bool   correlated;
+    bool   runs;
+    bool   havePrior = false;
+    size_t repeatEnd = 0;
+    const PaletteOrder *order = nullptr;
+};
+
+// Coders for the image transforms, which tell the two directions apart
+// through kEncoding
+struct PixelEncoder : ModelEncoder
+{
+    static constexpr bool kEncoding = true;
+};
+
+struct PixelDecoder : ModelDecoder
+{
+    static constexpr bool kEncoding = false;
+};
+
+#endif // IMAGEMODEL_H
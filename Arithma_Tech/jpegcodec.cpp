@@ -0,0 +1,972 @@
+#include "jpegcodec.h"
+
+#include "bitmodel.h"
+#include "blockcodec.h"
+#include "parallel.h"
+#include "primer.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+// 1) Bytes
+uint16_t get16(const uint8_t *p)
+{
+    return static_cast<uint16_t>(p[0] << 8 | p[1]);
+}
+
+// Larger frames are passed through rather than held as coefficients
+const size_t kMaxCoefficients = size_t(1) << 27;
+
+// 2) Huffman tables
+const int kLookupBits = 9;
+
+struct HuffmanTable
+{
+    bool    defined = false;
+    uint8_t counts[17] = {};      // codes of each length 1..16
+    uint8_t symbols[256] = {};
+
+    int32_t  maxCode[17];                  // largest code of each length, -1 if none
+    int32_t  valueOffset[17];              // symbol index minus code, per length
+    uint16_t lookup[1 << kLookupBits];     // (length << 8) | symbol; 0 for longer codes
+    uint16_t code[256];
+    uint8_t  codeLength[256];              // 0 for symbols the table lacks
+
+    bool build();
+};
+
+// Canonical codes as in Annex C of the standard
+bool HuffmanTable::build()
+{
+    std::memset(lookup, 0, sizeof lookup);
+    std::memset(codeLength, 0, sizeof codeLength);
+    uint32_t next = 0;
+    int index = 0;
+    for (int length = 1; length <= 16; ++length) {
+        valueOffset[length] = index - static_cast<int32_t>(next);
+        for (int i = 0; i < counts[length]; ++i, ++index, ++next) {
+            const uint8_t symbol = symbols[index];
+            if (codeLength[symbol] == 0) {
+                code[symbol]       = static_cast<uint16_t>(next);
+                codeLength[symbol] = static_cast<uint8_t>(length);
+            }
+            if (length <= kLookupBits) {
+                const int spare = kLookupBits - length;
+                for (uint32_t fill = 0; fill < (1u << spare); ++fill) {
+                    lookup[(next << spare) | fill] = static_cast<uint16_t>(length << 8 | symbol);
+                }
+            }
+        }
+        maxCode[length] = counts[length] ? static_cast<int32_t>(next) - 1 : -1;
+        if (next > (1u << length)) return false;   // more codes than fit
+        next <<= 1;
+    }
+    defined = true;
+    return true;
+}
+
+// 3) Entropy-coded segment I/O
+class ScanReader
+{
+public:
+    ScanReader(const uint8_t *data, size_t size)
+        : data(data),
+        size(size),
+        position(0),
+        bits(0),
+        count(0),
+        atMarker(false),
+        overrun(false)
+    {
+    }
+
+    int decode(const HuffmanTable &table)
+    {
+        if (count < 16) fill();
+        const uint16_t entry = table.lookup[bits >> (64 - kLookupBits)];
+        if (entry) {
+            consume(entry >> 8);
+            return entry & 0xFF;
+        }
+        for (int length = kLookupBits + 1; length <= 16; ++length) {
+            const int32_t code = static_cast<int32_t>(bits >> (64 - length));
+            if (code <= table.maxCode[length]) {
+                consume(length);
+                return table.symbols[table.valueOffset[length] + code];
+            }
+        }
+        return -1;
+    }
+
+    // n raw bits, 0 <= n <= 16
+    int receive(int n)
+    {
+        if (n == 0) return 0;
+        if (count < n) fill();
+        const int value = static_cast<int>(bits >> (64 - n));
+        consume(n);
+        return value;
+    }
+
+    // Skip the padding of the current byte and step over RSTn
+    bool restart(uint8_t marker)
+    {
+        const int spare = count % 8;
+        bits <<= spare;
+        count -= spare;
+        if (count != 0 || !atMarker || position + 1 >= size || data[position + 1] != marker) {
+            return false;
+        }
+        position += 2;
+        atMarker = false;
+        bits = 0;
+        return true;
+    }
+
+    bool failed() const { return overrun; }
+
+private:
+    // Keep at least 57 bits buffered, unstuffing FF 00 and stopping at markers
+    void fill()
+    {
+        while (count <= 56 && !atMarker && position < size) {
+            const uint8_t byte = data[position];
+            if (byte == 0xFF) {
+                if (position + 1 < size && data[position + 1] == 0x00) {
+                    position += 2;
+                } else {
+                    atMarker = true;
+                    break;
+                }
+            } else {
+                ++position;
+            }
+            bits |= uint64_t(byte) << (56 - count);
+            count += 8;
+        }
+    }
+
+    void consume(int n)
+    {
+        if (n > count) {
+            overrun = true;
+            n = count;
+        }
+        bits = n == 64 ? 0 : bits << n;
+        count -= n;
+    }
+
+    const uint8_t *data;
+    size_t   size;
+    size_t   position;
+    uint64_t bits;        // next bit in the top position
+    int      count;
+    bool     atMarker;
+    bool     overrun;
+};
+
+class ScanWriter
+{
+public:
+    explicit ScanWriter(std::vector<uint8_t> &out)
+        : out(out),
+        bits(0),
+        count(0)
+    {
+    }
+
+    void put(uint32_t value, int n)
+    {
+        bits = (bits << n) | value;
+        count += n;
+        while (count >= 8) {
+            count -= 8;
+            const uint8_t byte = static_cast<uint8_t>(bits >> count);
+            out.push_back(byte);
+            if (byte == 0xFF) out.push_back(0x00);
+        }
+    }
+
+    // Returns whether any padding was needed
+    bool pad(int bit)
+    {
+        if (count == 0) return false;
+        put(bit ? (1u << (8 - count)) - 1 : 0, 8 - count);
+        return true;
+    }
+
+    void marker(uint8_t code)
+    {
+        out.push_back(0xFF);
+        out.push_back(code);
+    }
+
+private:
+    std::vector<uint8_t> &out;
+    uint64_t bits;
+    int      count;
+};
+
+int extend(int value, int size)
+{
+    return size && value < (1 << (size - 1)) ? value - (1 << size) + 1 : value;
+}
+
+// 4) Frame and scans
+struct Component
+{
+    uint8_t id = 0;
+    int     h = 1;
+    int     v = 1;
+    int     blocksWide = 0;   // stored layout, whole MCUs
+    int     blocksHigh = 0;
+    int     codedWide  = 0;   // blocks a scan of this component alone covers
+    int     codedHigh  = 0;
+    bool    scanned = false;
+    std::vector<int16_t> coefficients;   // 64 per block, in zigzag order
+};
+
+struct ScanComponent
+{
+    Component          *component;
+    const HuffmanTable *dc;
+    const HuffmanTable *ac;
+};
+
+/**
+ * @brief JpegImage
+ *        Marker walk shared by both directions. split() keeps every byte
+ *        outside the entropy-coded segments as the skeleton and decodes
+ *        the coefficients; join() walks the skeleton and writes the
+ *        segments back from them.
+ */
+class JpegImage
+{
+public:
+    bool split(const uint8_t *file, size_t size, std::vector<uint8_t> &skeleton);
+
+    // Lay out the skeleton's frame, ready for its coefficients
+    bool layout(const uint8_t *skeleton, size_t size);
+    bool join(const uint8_t *skeleton, size_t size, std::vector<uint8_t> &out);
+
+    int mcuRows() const { return mcusHigh; }
+
+    std::vector<Component> components;
+    int padBit = 1;
+
+private:
+    enum class Pass { Split, Layout, Join };
+
+    bool walk(const uint8_t *data, size_t size, Pass pass, std::vector<uint8_t> *out);
+    bool readFrame(const uint8_t *p, size_t length, bool allocate);
+    bool readTables(const uint8_t *p, size_t length);
+    bool readScan(const uint8_t *p, size_t length, std::vector<ScanComponent> &scan);
+    bool decodeScan(const uint8_t *data, size_t size, const std::vector<ScanComponent> &scan);
+    bool encodeScan(const std::vector<ScanComponent> &scan, int pad, std::vector<uint8_t> &out);
+    bool checkScan(const std::vector<ScanComponent> &scan, const uint8_t *data, size_t size);
+
+    template <typename Visit>
+    void forEachBlock(const std::vector<ScanComponent> &scan, Visit visit);
+
+    HuffmanTable dcTables[4];
+    HuffmanTable acTables[4];
+    int  restartInterval = 0;
+    int  mcusWide = 0;
+    int  mcusHigh = 0;
+    bool haveFrame = false;
+    bool padKnown  = false;
+};
+
+bool JpegImage::split(const uint8_t *file, size_t size, std::vector<uint8_t> &skeleton)
+{
+    return walk(file, size, Pass::Split, &skeleton);
+}
+
+bool JpegImage::layout(const uint8_t *skeleton, size_t size)
+{
+    return walk(skeleton, size, Pass::Layout, nullptr);
+}
+
+bool JpegImage::join(const uint8_t *skeleton, size_t size, std::vector<uint8_t> &out)
+{
+    return walk(skeleton, size, Pass::Join, &out);
+}
+
+// End of the entropy-coded segment starting at pos: the first marker
+// other than a stuffed zero or RSTn
+size_t scanEnd(const uint8_t *data, size_t size, size_t pos)
+{
+    while (pos + 1 < size) {
+        const uint8_t *found = static_cast<const uint8_t *>(std::memchr(data + pos, 0xFF, size - pos - 1));
+        if (!found) break;
+        pos = static_cast<size_t>(found - data);
+        const uint8_t next = data[pos + 1];
+        if (next != 0x00 && (next < 0xD0 || next > 0xD7)) return pos;
+        pos += 2;
+    }
+    return size;
+}
+
+bool JpegImage::walk(const uint8_t *data, size_t size, Pass pass, std::vector<uint8_t> *out)
+{
+    auto copy = [&](size_t from, size_t count) {
+        if (out) out->insert(out->end(), data + from, data + from + count);
+    };
+    if (size < 4 || data[0] != 0xFF || data[1] != 0xD8) return false;
+    for (HuffmanTable &table : dcTables) table.defined = false;
+    for (HuffmanTable &table : acTables) table.defined = false;
+    restartInterval = 0;
+    haveFrame = false;
+
+    copy(0, 2);
+    size_t pos = 2;
+    for (;;) {
+        if (pos + 1 >= size || data[pos] != 0xFF) return false;
+        const uint8_t marker = data[pos + 1];
+        if (marker == 0xFF) {   // fill byte
+            copy(pos, 1);
+            ++pos;
+            continue;
+        }
+        if (marker == 0xD9) {
+            // EOI; anything after it is kept as it is
+            copy(pos, size - pos);
+            if (pass != Pass::Split) return haveFrame;
+            for (const Component &component : components) {
+                if (!component.scanned) return false;
+            }
+            return haveFrame;
+        }
+        if (marker == 0x00 || marker == 0x01 || (marker >= 0xD0 && marker <= 0xD8) || pos + 4 > size) {
+            return false;
+        }
+
+        const size_t length = get16(data + pos + 2);
+        if (length < 2 || pos + 2 + length > size) return false;
+        const uint8_t *body = data + pos + 4;
+        const size_t bodySize = length - 2;
+        copy(pos, 2 + length);
+        pos += 2 + length;
+
+        switch (marker) {
+        case 0xC0:   // baseline
+        case 0xC1:   // extended sequential, Huffman
+            if (!readFrame(body, bodySize, pass != Pass::Join)) return false;
+            break;
+        case 0xC4:
+            if (!readTables(body, bodySize)) return false;
+            break;
+        case 0xDD:
+            if (bodySize < 2) return false;
+            restartInterval = get16(body);
+            break;
+        case 0xDA: {
+            std::vector<ScanComponent> scan;
+            if (!readScan(body, bodySize, scan)) return false;
+            if (pass == Pass::Split) {
+                const size_t end = scanEnd(data, size, pos);
+                if (!decodeScan(data + pos, end - pos, scan) || !checkScan(scan, data + pos, end - pos)) {
+                    return false;
+                }
+                pos = end;
+            } else if (pass == Pass::Join) {
+                encodeScan(scan, padBit, *out);
+            }
+            break;
+        }
+        default:
+            // Progressive, lossless and arithmetic-coded frames, DAC and DNL
+            if ((marker >= 0xC2 && marker <= 0xCF) || marker == 0xDC) return false;
+            break;
+        }
+    }
+}
+
+bool JpegImage::readFrame(const uint8_t *p, size_t length, bool allocate)
+{
+    if (haveFrame || length < 6 || p[0] != 8) return false;
+    const int height = get16(p + 1);
+    const int width  = get16(p + 3);
+    const int count  = p[5];
+    if (width == 0 || height == 0 || count < 1 || count > 4 || length < size_t(6 + 3 * count)) return false;
+
+    std::vector<Component> parsed(count);
+    int hmax = 1, vmax = 1;
+    for (int i = 0; i < count; ++i) {
+        Component &component = parsed[i];
+        component.id = p[6 + 3 * i];
+        component.h  = p[7 + 3 * i] >> 4;
+        component.v  = p[7 + 3 * i] & 15;
+        if (component.h < 1 || component.h > 4 || component.v < 1 || component.v > 4) return false;
+        for (int j = 0; j < i; ++j) {
+            if (parsed[j].id == component.id) return false;
+        }
+        hmax = std::max(hmax, component.h);
+        vmax = std::max(vmax, component.v);
+    }
+
+    const int wide = (width + 8 * hmax - 1) / (8 * hmax);
+    const int high = (height + 8 * vmax - 1) / (8 * vmax);
+    size_t total = 0;
+    for (Component &component : parsed) {
+        component.blocksWide = wide * component.h;
+        component.blocksHigh = high * component.v;
+        const int componentWidth  = (width * component.h + hmax - 1) / hmax;
+        const int componentHeight = (height * component.v + vmax - 1) / vmax;
+        component.codedWide = (componentWidth + 7) / 8;
+        component.codedHigh = (componentHeight + 7) / 8;
+        total += size_t(component.blocksWide) * component.blocksHigh * 64;
+    }
+    if (total > kMaxCoefficients) return false;
+
+    if (allocate) {
+        for (Component &component : parsed) {
+            component.coefficients.assign(size_t(component.blocksWide) * component.blocksHigh * 64, 0);
+        }
+        components.swap(parsed);
+    } else if (components.size() != parsed.size()) {
+        return false;
+    }
+    mcusWide = wide;
+    mcusHigh = high;
+    haveFrame = true;
+    return true;
+}
+
+bool JpegImage::readTables(const uint8_t *p, size_t length)
+{
+    while (length > 0) {
+        if (length < 17) return false;
+        const int tableClass = p[0] >> 4;
+        const int slot       = p[0] & 15;
+        if (tableClass > 1 || slot > 3) return false;
+        HuffmanTable &table = tableClass ? acTables[slot] : dcTables[slot];
+
+        size_t symbols = 0;
+        table.counts[0] = 0;
+        for (int i = 1; i <= 16; ++i) {
+            table.counts[i] = p[i];
+            symbols += p[i];
+        }
+        if (symbols > 256 || length < 17 + symbols) return false;
+        std::memcpy(table.symbols, p + 17, symbols);
+        if (!table.build()) return false;
+        p += 17 + symbols;
+        length -= 17 + symbols;
+    }
+    return true;
+}
+
+bool JpegImage::readScan(const uint8_t *p, size_t length, std::vector<ScanComponent> &scan)
+{
+    if (!haveFrame || length < 1) return false;
+    const int count = p[0];
+    if (count < 1 || count > 4 || length < size_t(4 + 2 * count)) return false;
+
+    for (int i = 0; i < count; ++i) {
+        const uint8_t id = p[1 + 2 * i];
+        const int dc = p[2 + 2 * i] >> 4;
+        const int ac = p[2 + 2 * i] & 15;
+        if (dc > 3 || ac > 3 || !dcTables[dc].defined || !acTables[ac].defined) return false;
+        Component *component = nullptr;
+        for (Component &candidate : components) {
+            if (candidate.id == id) component = &candidate;
+        }
+        if (!component) return false;
+        scan.push_back({component, &dcTables[dc], &acTables[ac]});
+    }
+
+    // Sequential scans cover the whole spectrum at full precision
+    const uint8_t *spectral = p + 1 + 2 * count;
+    return spectral[0] == 0 && spectral[1] == 63 && spectral[2] == 0;
+}
+
+// Calls visit(index, block) in coding order, with index the position of
+// the block's component in the scan; visit(-1, nullptr) marks a restart
+template <typename Visit>
+void JpegImage::forEachBlock(const std::vector<ScanComponent> &scan, Visit visit)
+{
+    const bool single = scan.size() == 1;
+    const Component &first = *scan[0].component;
+    const int units = single ? first.codedWide * first.codedHigh : mcusWide * mcusHigh;
+    for (int unit = 0; unit < units; ++unit) {
+        if (restartInterval && unit > 0 && unit % restartInterval == 0) visit(-1, nullptr);
+        if (single) {
+            const int x = unit % first.codedWide;
+            const int y = unit / first.codedWide;
+            visit(0, scan[0].component->coefficients.data() + (size_t(y) * first.blocksWide + x) * 64);
+            continue;
+        }
+        const int mx = unit % mcusWide;
+        const int my = unit / mcusWide;
+        for (size_t i = 0; i < scan.size(); ++i) {
+            Component &component = *scan[i].component;
+            for (int y = 0; y < component.v; ++y) {
+                for (int x = 0; x < component.h; ++x) {
+                    const size_t block = size_t(my * component.v + y) * component.blocksWide
+                                         + mx * component.h + x;
+                    visit(static_cast<int>(i), component.coefficients.data() + block * 64);
+                }
+            }
+        }
+    }
+}
+
+bool JpegImage::decodeScan(const uint8_t *data, size_t size, const std::vector<ScanComponent> &scan)
+{
+    ARITHMA_TRACE_SCOPE("transform", "jpeg huffman decode");
+    for (const ScanComponent &entry : scan) {
+        if (entry.component->scanned) return false;   // sequential: one scan each
+        entry.component->scanned = true;
+    }
+
+    ScanReader reader(data, size);
+    int predictions[4] = {0, 0, 0, 0};
+    int restarts = 0;
+    bool ok = true;
+    forEachBlock(scan, [&](int index, int16_t *block) {
+        if (!ok) return;
+        if (index < 0) {
+            ok = reader.restart(static_cast<uint8_t>(0xD0 + (restarts++ & 7)));
+            std::fill(predictions, predictions + 4, 0);
+            return;
+        }
+        const ScanComponent &entry = scan[index];
+        const int dcSize = reader.decode(*entry.dc);
+        if (dcSize < 0 || dcSize > 11) {
+            ok = false;
+            return;
+        }
+        predictions[index] += extend(reader.receive(dcSize), dcSize);
+        if (std::abs(predictions[index]) > 32767) {
+            ok = false;
+            return;
+        }
+        block[0] = static_cast<int16_t>(predictions[index]);
+
+        for (int k = 1; k < 64;) {
+            const int symbol = reader.decode(*entry.ac);
+            if (symbol < 0) {
+                ok = false;
+                return;
+            }
+            const int run  = symbol >> 4;
+            const int bits = symbol & 15;
+            if (bits == 0) {
+                if (run != 15) break;   // EOB
+                k += 16;
+                continue;
+            }
+            k += run;
+            if (k > 63) {
+                ok = false;
+                return;
+            }
+            block[k++] = static_cast<int16_t>(extend(reader.receive(bits), bits));
+        }
+    });
+    return ok && !reader.failed();
+}
+
+// Returns whether the scan has padding, so whether pad shows in it
+bool JpegImage::encodeScan(const std::vector<ScanComponent> &scan, int pad, std::vector<uint8_t> &out)
+{
+    ARITHMA_TRACE_SCOPE("transform", "jpeg huffman encode");
+    ScanWriter writer(out);
+    int predictions[4] = {0, 0, 0, 0};
+    int restarts = 0;
+    bool padded = false;
+    auto putValue = [&writer](int value, int bits) {
+        if (bits) writer.put(static_cast<uint32_t>(value < 0 ? value + (1 << bits) - 1 : value), bits);
+    };
+    forEachBlock(scan, [&](int index, int16_t *block) {
+        if (index < 0) {
+            padded |= writer.pad(pad);
+            writer.marker(static_cast<uint8_t>(0xD0 + (restarts++ & 7)));
+            std::fill(predictions, predictions + 4, 0);
+            return;
+        }
+        const HuffmanTable &dc = *scan[index].dc;
+        const HuffmanTable &ac = *scan[index].ac;
+        const int diff = block[0] - predictions[index];
+        predictions[index] = block[0];
+        const int dcSize = bitLength(static_cast<uint32_t>(std::abs(diff)));
+        writer.put(dc.code[dcSize], dc.codeLength[dcSize]);
+        putValue(diff, dcSize);
+
+        int run = 0;
+        for (int k = 1; k < 64; ++k) {
+            const int value = block[k];
+            if (value == 0) {
+                ++run;
+                continue;
+            }
+            while (run > 15) {
+                writer.put(ac.code[0xF0], ac.codeLength[0xF0]);
+                run -= 16;
+            }
+            const int bits = bitLength(static_cast<uint32_t>(std::abs(value)));
+            const int symbol = run << 4 | bits;
+            writer.put(ac.code[symbol], ac.codeLength[symbol]);
+            putValue(value, bits);
+            run = 0;
+        }
+        if (run > 0) writer.put(ac.code[0x00], ac.codeLength[0x00]);
+    });
+    return writer.pad(pad) || padded;
+}
+
+// Whether the scan re-encodes to exactly the original bytes. The padding
+// bit is settled by the first scan whose padding shows.
+bool JpegImage::checkScan(const std::vector<ScanComponent> &scan, const uint8_t *data, size_t size)
+{
+    std::vector<uint8_t> again;
+    again.reserve(size);
+    auto matches = [&](int pad, bool &padded) {
+        again.clear();
+        padded = encodeScan(scan, pad, again);
+        return again.size() == size && std::memcmp(again.data(), data, size) == 0;
+    };
+    bool padded = false;
+    if (matches(padBit, padded)) {
+        padKnown |= padded;
+        return true;
+    }
+    if (padKnown || !padded || !matches(1 - padBit, padded)) return false;
+    padBit = 1 - padBit;
+    padKnown = true;
+    return true;
+}
+
+// 5) Coefficient model
+const int kCountBuckets = 10;
+const int kLeftBuckets  = 7;
+const int kBands        = 9;
+
+// Luma and chroma (any later component) learn separately
+struct CoefficientModel
+{
+    BitModel count[2][kCountBuckets][64];       // nonzero AC coefficients in a block
+    BitModel zero[2][64][kLeftBuckets][4];      // whether coefficient k is nonzero
+    BitModel exponent[2][kBands][8][15];        // magnitude length in unary
+    BitModel mantissa[2][16][15];               // magnitude bits below the leading one
+    BitModel sign[2][kBands][3][3];
+    BitModel dcZero[2][12];
+    BitModel dcSign[2][12];
+    BitModel dcExponent[2][12][15];
+    BitModel dcMantissa[2][16][15];
+};
+
+int countBucket(int predicted)
+{
+    static const uint8_t kBuckets[64] = {
+        0, 1, 2, 3, 4, 5, 5, 6, 6, 6, 7, 7, 7, 7, 7, 8,
+        8, 8, 8, 8, 8, 8, 8, 9, 9, 9, 9, 9, 9, 9, 9, 9,
+        9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9,
+        9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9};
+    return kBuckets[predicted];
+}
+
+int leftBucket(int remaining)
+{
+    static const uint8_t kBuckets[16] = {0, 0, 1, 2, 3, 3, 4, 4, 4, 5, 5, 5, 5, 5, 5, 6};
+    return kBuckets[std::min(remaining, 15)];
+}
+
+int band(int k)
+{
+    static const uint8_t kBandOf[64] = {
+        0, 0, 1, 1, 1, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 4,
+        4, 4, 4, 4, 4, 5, 5, 5, 5, 5, 5, 5, 6, 6, 6, 6,
+        6, 6, 6, 6, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+        8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8};
+    return kBandOf[k];
+}
+
+int signClass(int value)
+{
+    return value > 0 ? 1 : (value < 0 ? 2 : 0);
+}
+
+// Codes block rows [rowBegin, rowEnd) of component, reading the
+// coefficients when encoding and writing them when decoding. Blocks above
+// rowBegin belong to another slice and are not looked at.
+template <typename Coder>
+void codeComponent(Coder &coder, CoefficientModel &model, Component &component, int cls,
+                   int rowBegin, int rowEnd)
+{
+    const int wide = component.blocksWide;
+    std::vector<uint8_t> counts(size_t(wide) * (rowEnd - rowBegin));
+
+    for (int y = rowBegin; y < rowEnd; ++y) {
+        for (int x = 0; x < wide; ++x) {
+            const size_t index = size_t(y - rowBegin) * wide + x;
+            int16_t *block = component.coefficients.data() + (size_t(y) * wide + x) * 64;
+            const int16_t *above = y > rowBegin ? block - size_t(wide) * 64 : nullptr;
+            const int16_t *left  = x ? block - 64 : nullptr;
+
+            // DC against the median edge predictor of its three neighbours
+            int predicted = 0, gradient = 0;
+            if (above && left) {
+                const int a = above[0], l = left[0], c = (above - 64)[0];
+                predicted = std::max(std::min(a, l), std::min(std::max(a, l), a + l - c));
+                gradient  = std::min(11, bitLength(static_cast<uint32_t>(std::abs(a - l))));
+            } else if (above || left) {
+                predicted = (above ? above : left)[0];
+            }
+            const int residual = block[0] - predicted;
+            int dc = predicted;
+            if (coder.code(residual != 0, model.dcZero[cls][gradient])) {
+                const int negative = coder.code(residual < 0, model.dcSign[cls][gradient]);
+                const int magnitude = codeMagnitude(coder, std::abs(residual), model.dcExponent[cls][gradient],
+                                                    model.dcMantissa[cls]);
+                dc += negative ? -magnitude : magnitude;
+            }
+            block[0] = static_cast<int16_t>(dc);
+
+            // How many AC coefficients are nonzero, predicted from the neighbours
+            int expected = 0;
+            if (above && left) expected = (counts[index - wide] + counts[index - 1] + 1) / 2;
+            else if (above) expected = counts[index - wide];
+            else if (left) expected = counts[index - 1];
+            int actual = 0;
+            for (int k = 1; k < 64; ++k) actual += block[k] != 0;
+            BitModel *tree = model.count[cls][countBucket(expected)];
+            int node = 1;
+            for (int b = 5; b >= 0; --b) node = node << 1 | coder.code((actual >> b) & 1, tree[node]);
+            int remaining = node - 64;
+            counts[index] = static_cast<uint8_t>(remaining);
+
+            for (int k = 1; k < 64 && remaining > 0; ++k) {
+                const int a = above ? std::abs(above[k]) : 0;
+                const int l = left ? std::abs(left[k]) : 0;
+                const int neighbour = above && left ? (a + l + 1) >> 1 : a + l;
+                int value = block[k];
+                // Once every position left must be nonzero there is nothing to code
+                const bool nonzero = remaining == 64 - k
+                                     || coder.code(value != 0,
+                                                   model.zero[cls][k][leftBucket(remaining)][std::min(neighbour, 3)]);
+                if (!nonzero) {
+                    block[k] = 0;
+                    continue;
+                }
+                const int b = band(k);
+                const int magnitude = codeMagnitude(coder, std::abs(value),
+                                                    model.exponent[cls][b][std::min(bitLength(neighbour), 7)],
+                                                    model.mantissa[cls]);
+                const int negative = coder.code(value < 0, model.sign[cls][b][signClass(above ? above[k] : 0)]
+                                                                           [signClass(left ? left[k] : 0)]);
+                block[k] = static_cast<int16_t>(negative ? -magnitude : magnitude);
+                --remaining;
+            }
+        }
+    }
+}
+
+// Headers, tables and metadata are coded as bytes, from the container's
+// primer since version 2 and from set 1's before
+Primer skeletonPrimer(uint8_t version, const Primer &primer)
+{
+    return version < 2 ? findPrimer(1, FileType::Jpeg) : primer;
+}
+
+// The coefficients are cut into slices of whole MCU rows, each coded with
+// its own model so they can be coded in parallel. Their number depends on
+// the image alone.
+const size_t kSliceBlocks = size_t(1) << 15;
+const int    kMaxSlices   = 64;
+
+int sliceCount(const JpegImage &image)
+{
+    size_t blocks = 0;
+    for (const Component &component : image.components) {
+        blocks += size_t(component.blocksWide) * component.blocksHigh;
+    }
+    const size_t wanted = std::max<size_t>(1, blocks / kSliceBlocks);
+    return static_cast<int>(std::min<size_t>({wanted, size_t(kMaxSlices), size_t(image.mcuRows())}));
+}
+
+template <typename Coder>
+void codeSlice(Coder &coder, JpegImage &image, int slice, int slices)
+{
+    const int begin = static_cast<int>(int64_t(image.mcuRows()) * slice / slices);
+    const int end   = static_cast<int>(int64_t(image.mcuRows()) * (slice + 1) / slices);
+    std::unique_ptr<CoefficientModel> model(new CoefficientModel);
+    for (size_t i = 0; i < image.components.size(); ++i) {
+        Component &component = image.components[i];
+        codeComponent(coder, *model, component, i ? 1 : 0, begin * component.v, end * component.v);
+    }
+}
+
+bool encodeJpeg(const std::vector<uint8_t> &input, const Primer &primer, int threads, std::vector<uint8_t> &out)
+{
+    JpegImage image;
+    std::vector<uint8_t> skeleton;
+    if (!image.split(input.data(), input.size(), skeleton)) return false;
+
+    ARITHMA_TRACE_SCOPE("transform", "jpeg model encode");
+    std::vector<uint8_t> packed;
+    encodeBlock(Backend::Arithmetic, 2, primer, skeleton.data(), skeleton.size(), packed);
+    out.push_back(1);
+    out.push_back(static_cast<uint8_t>(image.padBit));
+    putVarint(out, skeleton.size());
+    putVarint(out, packed.size());
+    out.insert(out.end(), packed.begin(), packed.end());
+
+    const int slices = sliceCount(image);
+    std::vector<std::vector<uint8_t>> streams(slices);
+    parallelFor(streams.size(), threads, [&](size_t i) {
+        ModelEncoder encoder{BinaryEncoder(streams[i])};
+        codeSlice(encoder, image, static_cast<int>(i), slices);
+        encoder.coder.finish();
+    });
+    putVarint(out, static_cast<uint64_t>(slices));
+    for (int i = 0; i + 1 < slices; ++i) putVarint(out, streams[i].size());
+    for (const std::vector<uint8_t> &stream : streams) out.insert(out.end(), stream.begin(), stream.end());
+    return true;
+}
+
+bool decodeJpeg(const std::vector<uint8_t> &input, const Primer &primer, int threads, std::vector<uint8_t> &out)
+{
+    const uint8_t *p = input.data() + 2;
+    const uint8_t *end = input.data() + input.size();
+    uint64_t skeletonSize = 0, packedSize = 0;
+    if (input.size() < 2 || input[1] > 1 || !getVarint(p, end, skeletonSize) || !getVarint(p, end, packedSize)
+        || packedSize > uint64_t(end - p) || skeletonSize > (uint64_t(1) << 32)) {
+        return false;
+    }
+    std::vector<uint8_t> skeleton(static_cast<size_t>(skeletonSize));
+    if (!decodeBlock(Backend::Arithmetic, 2, primer, p, static_cast<size_t>(packedSize),
+                     skeleton.data(), skeleton.size())) {
+        return false;
+    }
+    p += packedSize;
+
+    JpegImage image;
+    image.padBit = input[1];
+    uint64_t slices = 0;
+    if (!image.layout(skeleton.data(), skeleton.size()) || !getVarint(p, end, slices)
+        || slices != uint64_t(sliceCount(image))) {
+        return false;
+    }
+
+    // Slice streams, the last running to the end
+    std::vector<const uint8_t *> streams(slices);
+    std::vector<size_t> sizes(slices);
+    for (uint64_t i = 0; i + 1 < slices; ++i) {
+        uint64_t size = 0;
+        if (!getVarint(p, end, size)) return false;
+        sizes[i] = static_cast<size_t>(size);
+    }
+    for (uint64_t i = 0; i < slices; ++i) {
+        if (i + 1 == slices) sizes[i] = static_cast<size_t>(end - p);
+        if (sizes[i] > size_t(end - p)) return false;
+        streams[i] = p;
+        p += sizes[i];
+    }
+    {
+        ARITHMA_TRACE_SCOPE("transform", "jpeg model decode");
+        parallelFor(streams.size(), threads, [&](size_t i) {
+            ModelDecoder decoder{BinaryDecoder(streams[i], sizes[i])};
+            codeSlice(decoder, image, static_cast<int>(i), static_cast<int>(slices));
+        });
+    }
+    return image.join(skeleton.data(), skeleton.size(), out);
+}
+
+// 6) Transforms
+enum : uint8_t { kModeStored = 0, kModeCoded = 1 };
+
+class JpegEncoder : public TypeTransform
+{
+public:
+    JpegEncoder(const Primer &primer, int threads)
+        : primer(skeletonPrimer(kJpegTransformVersion, primer)),
+        threads(threads)
+    {
+    }
+
+    bool update(const uint8_t *data, size_t size, std::vector<uint8_t> &) override
+    {
+        input.insert(input.end(), data, data + size);
+        return true;
+    }
+
+    bool finish(std::vector<uint8_t> &out) override
+    {
+        ARITHMA_TRACE_SCOPE("transform", "jpeg encode");
+        const size_t start = out.size();
+        coded = encodeJpeg(input, primer, threads, out) && out.size() - start < input.size();
+        if (!coded) {
+            out.resize(start);
+            out.push_back(kModeStored);
+            out.insert(out.end(), input.begin(), input.end());
+        }
+        return true;
+    }
+
+    bool entropyCoded() const override { return coded; }
+
+private:
+    std::vector<uint8_t> input;   // a JPEG is split as a whole
+    Primer primer;
+    int    threads;
+    bool   coded = false;
+};
+
+class JpegDecoder : public TypeTransform
+{
+public:
+    JpegDecoder(uint8_t version, const Primer &primer, int threads)
+        : primer(skeletonPrimer(version, primer)),
+        threads(threads)
+    {
+    }
+
+    bool update(const uint8_t *data, size_t size, std::vector<uint8_t> &) override
+    {
+        input.insert(input.end(), data, data + size);
+        return true;
+    }
+
+    bool finish(std::vector<uint8_t> &out) override
+    {
+        ARITHMA_TRACE_SCOPE("transform", "jpeg decode");
+        if (!input.empty() && input[0] == kModeStored) {
+            out.insert(out.end(), input.begin() + 1, input.end());
+            return true;
+        }
+        const size_t start = out.size();
+        if (input.empty() || input[0] != kModeCoded || !decodeJpeg(input, primer, threads, out)) {
+            out.resize(start);
+            return false;
+        }
+        return true;
+    }
+
+    std::string errorString() const override { return "JPEG data could not be rebuilt"; }
+
+private:
+    std::vector<uint8_t> input;
+    Primer primer;
+    int    threads;
+};
+
+}
+
+std::unique_ptr<TypeTransform> newJpegEncoder(const Primer &primer, int threads)
+{
+    return std::unique_ptr<TypeTransform>(new JpegEncoder(primer, threads));
+}
+
+std::unique_ptr<TypeTransform> newJpegDecoder(uint8_t version, const Primer &primer, int threads)
+{
+    return std::unique_ptr<TypeTransform>(new JpegDecoder(version, primer, threads));
+}
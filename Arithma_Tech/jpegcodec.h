@@ -0,0 +1,40 @@
+#ifndef JPEGCODEC_H
+#define JPEGCODEC_H
+
+#include "typeregistry.h"
+
+#include <cstdint>
+#include <memory>
+
+/*
+ * JPEG transform, version 2.
+ *
+ * Baseline and extended sequential Huffman JPEGs are split into their
+ * marker segments, kept byte for byte, and the quantized DCT coefficients
+ * of every scan. The coefficients are coded with binary context models keyed
+ * on coefficient position and on the same coefficient in the blocks above
+ * and to the left; the inverse re-emits the Huffman scans from them.
+ *
+ *   u8 mode   0: the original bytes follow unchanged
+ *             1: u8 padding bit, varint skeleton size, varint coded skeleton
+ *                size, coded skeleton, varint slice count, varint size of
+ *                every slice stream but the last, the slice streams
+ *
+ * The skeleton is coded from the container's block primer, or from no
+ * primer when it is unprimed; version 1, otherwise the same, always used
+ * set 1's JPEG primer.
+ *
+ * Slices are bands of whole MCU rows, each coded from a fresh model so they
+ * can be coded and decoded in parallel; their count follows from the image
+ * size alone.
+ *
+ * A file is only split when re-encoding its scans gives back exactly the
+ * original bytes; progressive, arithmetic-coded, lossless and 12-bit files,
+ * and anything malformed, use mode 0.
+ */
+constexpr uint8_t kJpegTransformVersion = 2;
+
+std::unique_ptr<TypeTransform> newJpegEncoder(const Primer &primer, int threads);
+std::unique_ptr<TypeTransform> newJpegDecoder(uint8_t version, const Primer &primer, int threads);
+
+#endif // JPEGCODEC_H
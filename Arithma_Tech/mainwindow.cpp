@@ -1,4 +1,7 @@
 #include "mainwindow.h"
+#include "codecengine.h"
+#include "typeregistry.h"
+#include "historymodel.h"
 
 #include <QApplication>
 #include <QStyleFactory>
@@ -28,6 +31,58 @@
 #include <QSqlError>
 #include <QSqlDatabase>
 #include <QMetaType>
+#include <QFile>
+#include <QPlainTextEdit>
+#include <QItemSelectionModel>
+#include <QLineEdit>
+
+#include <chrono>
+
+namespace {
+// Extension given to compressed output files
+const QString kArchiveSuffix = "atc";
+
+// Bytes restored for a history preview
+const quint64 kPreviewBytes = 4096;
+
+// Typing pause before the history search runs; a query takes a few ms,
+// this only keeps a burst of keystrokes from queueing several
+const int kSearchDelayMs = 120;
+
+std::string toNativePath(const QString &filePath)
+{
+    return QFile::encodeName(filePath).toStdString();
+}
+
+// Printable text as-is, anything else as a hex dump
+QString formatPreview(const std::vector<uint8_t> &data)
+{
+    const QByteArray bytes(reinterpret_cast<const char *>(data.data()), int(data.size()));
+    bool printable = true;
+    for (char c : bytes) {
+        const uchar u = static_cast<uchar>(c);
+        if (u < 0x20 && c != '\n' && c != '\r' && c != '\t') {
+            printable = false;
+            break;
+        }
+    }
+    if (printable) {
+        return QString::fromUtf8(bytes);
+    }
+
+    QString dump;
+    for (int row = 0; row < bytes.size(); row += 16) {
+        QString hex, ascii;
+        for (int i = row; i < row + 16 && i < bytes.size(); ++i) {
+            const uchar u = static_cast<uchar>(bytes[i]);
+            hex += QString("%1 ").arg(uint(u), 2, 16, QChar('0'));
+            ascii += (u >= 0x20 && u < 0x7f) ? QLatin1Char(char(u)) : QLatin1Char('.');
+        }
+        dump += QString("%1  %2 %3\n").arg(row, 8, 16, QChar('0')).arg(hex, -48).arg(ascii);
+    }
+    return dump;
+}
+}
 
 // 1) CIS476Project Implementation
 DropZone::DropZone(QWidget *parent)
@@ -99,74 +154,163 @@ void DropZone::dropEvent(QDropEvent *event)
 }
 
 // 2) FileHistoryDialog Implementation
-FileHistoryDialog::FileHistoryDialog(QWidget *parent)
-    : QDialog(parent)
+FileHistoryDialog::FileHistoryDialog(HistoryWriter *writer, QWidget *parent)
+    : QDialog(parent),
+    writer(writer)
 {
     setWindowTitle("File History");
-    resize(600, 400);
+    resize(1000, 450);
 
     QVBoxLayout *layout = new QVBoxLayout(this);
 
-    historyTable = new QTableWidget(this);
-    historyTable->setColumnCount(6);
-    //store name, operation, data_type, file_path, text_content, timestamp
-    historyTable->setHorizontalHeaderLabels(
-        QStringList() << "Name" << "Operation" << "Type"
-                      << "File Path" << "Text Content" << "Timestamp");
-    historyTable->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+    // Results follow the search box as it is typed in
+    searchBox = new QLineEdit(this);
+    searchBox->setPlaceholderText(QString("Search names, paths and text (%1+ characters)")
+                                      .arg(HistoryModel::kMinSearchChars));
+    searchBox->setClearButtonEnabled(true);
+    searchTimer = new QTimer(this);
+    searchTimer->setSingleShot(true);
+    searchTimer->setInterval(kSearchDelayMs);
+    connect(searchBox, &QLineEdit::textChanged, searchTimer, static_cast<void (QTimer::*)()>(&QTimer::start));
+    connect(searchTimer, &QTimer::timeout, this, &FileHistoryDialog::applySearch);
+
+    // Rows are fetched a page at a time as the view scrolls
+    historyModel = new HistoryModel(this);
+    historyTable = new QTableView(this);
+    historyTable->setModel(historyModel);
+    historyTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+    historyTable->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    historyTable->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    historyTable->horizontalHeader()->setSectionResizeMode(QHeaderView::Interactive);
+    historyTable->horizontalHeader()->setStretchLastSection(true);
+
+    // Click a header to sort; newest first until then
+    historyTable->horizontalHeader()->setSortIndicator(HistoryModel::Timestamp, Qt::DescendingOrder);
+    historyTable->setSortingEnabled(true);
 
     deleteButton = new QPushButton("Delete Selected", this);
-    connect(deleteButton, &QPushButton::clicked, this, &FileHistoryDialog::deleteSelectedRow);
+    connect(deleteButton, &QPushButton::clicked, this, &FileHistoryDialog::deleteSelectedRows);
 
+    previewButton = new QPushButton("Preview", this);
+    previewButton->setToolTip("Show the selected text, or decode the first bytes of its compressed file");
+    connect(previewButton, &QPushButton::clicked, this, &FileHistoryDialog::previewSelectedRow);
+
+    QHBoxLayout *buttonLayout = new QHBoxLayout;
+    buttonLayout->addWidget(previewButton);
+    buttonLayout->addWidget(deleteButton);
+
+    layout->addWidget(searchBox);
     layout->addWidget(historyTable);
-    layout->addWidget(deleteButton);
+    layout->addLayout(buttonLayout);
 
     setModal(false);
 }
 
 void FileHistoryDialog::refreshHistory()
 {
-    historyTable->setRowCount(0);
-
-    // SELECT from file_history table
-    QSqlQuery query("SELECT name, operation, data_type, file_path, text_content, timestamp "
-                    "FROM file_history ORDER BY id DESC");
-
-    int row = 0;
-    while (query.next()) {
-        historyTable->insertRow(row);
-        for (int col = 0; col < 6; ++col) {
-            QTableWidgetItem *item = new QTableWidgetItem(query.value(col).toString());
-            historyTable->setItem(row, col, item);
-        }
-        row++;
+    historyModel->reload();
+}
+
+void FileHistoryDialog::historyAppended()
+{
+    // A hidden dialog reloads when it is next shown
+    if (isVisible()) {
+        historyModel->fetchNewRows();
     }
 }
 
-void FileHistoryDialog::deleteSelectedRow()
+void FileHistoryDialog::applySearch()
 {
-    int row = historyTable->currentRow();
-    if (row < 0) {
-        QMessageBox::information(this, "No Selection", "Please select an entry to delete.");
+    if (historyModel->setFilter(searchBox->text())) {
+        historyTable->scrollToTop();
+    }
+}
+
+void FileHistoryDialog::deleteSelectedRows()
+{
+    const QModelIndexList selected = historyTable->selectionModel()->selectedRows();
+    if (selected.isEmpty()) {
+        QMessageBox::information(this, "No Selection", "Please select the entries to delete.");
         return;
     }
 
-    //last column is the timestamp
-    QString ts = historyTable->item(row, 5)->text();
-    if (ts.isEmpty()) return;
+    QList<int> rows;
+    QVector<qint64> ids;
+    for (const QModelIndex &index : selected) {
+        rows.append(index.row());
+        ids.append(historyModel->rowId(index.row()));
+    }
 
-    // Delete from DB
-    QSqlQuery query;
-    query.prepare("DELETE FROM file_history WHERE timestamp = :ts");
-    query.bindValue(":ts", ts);
-    if (!query.exec()) {
+    // Deleted by primary key in one transaction on the writer thread; the
+    // rows leave the view now, and a failure reloads it (see MainWindow)
+    if (!writer || !writer->remove(ids)) {
         QMessageBox::warning(this, "Delete Failed",
-                             "Could not delete the entry.\n" + query.lastError().text());
+                             "Could not delete the entries.\n"
+                             + (writer ? writer->errorString() : QString("No database")));
         return;
     }
 
-    // Refresh table
-    refreshHistory();
+    // Drop them from the view without reloading the rest
+    historyModel->removeHeldRows(rows);
+}
+
+void FileHistoryDialog::previewSelectedRow()
+{
+    int row = historyTable->currentIndex().row();
+    if (row < 0) {
+        QMessageBox::information(this, "No Selection", "Please select an entry to preview.");
+        return;
+    }
+
+    // Text rows keep their input in the database, decoded only now
+    if (historyModel->index(row, HistoryModel::DataType).data().toString() == "Text") {
+        QString text;
+        if (!historyModel->fullText(row, text)) {
+            QMessageBox::warning(this, "Preview Failed", "Could not read the stored text.");
+            return;
+        }
+        showPreview("Preview - Text Data", text);
+        return;
+    }
+
+    // Compress rows log the input file; the archive sits next to it
+    QString path = historyModel->index(row, HistoryModel::FilePath).data().toString();
+    if (path.isEmpty()) {
+        QMessageBox::information(this, "No File", "This entry has no compressed file to preview.");
+        return;
+    }
+    if (QFileInfo(path).suffix().toLower() != kArchiveSuffix) {
+        path += "." + kArchiveSuffix;
+    }
+    if (!QFileInfo::exists(path)) {
+        QMessageBox::information(this, "No File", "Compressed file not found:\n" + path);
+        return;
+    }
+
+    // Only the block(s) covering the preview are read and decoded
+    CodecEngine engine;
+    std::vector<uint8_t> data;
+    if (!engine.decompressRange(toNativePath(path), 0, kPreviewBytes, data)) {
+        QMessageBox::warning(this, "Preview Failed",
+                             "Could not decode the file.\n" + QString::fromStdString(engine.errorString()));
+        return;
+    }
+
+    showPreview("Preview - " + QFileInfo(path).fileName(), formatPreview(data));
+}
+
+void FileHistoryDialog::showPreview(const QString &title, const QString &text)
+{
+    QDialog preview(this);
+    preview.setWindowTitle(title);
+    preview.resize(640, 420);
+    QVBoxLayout *previewLayout = new QVBoxLayout(&preview);
+    QPlainTextEdit *view = new QPlainTextEdit(&preview);
+    view->setReadOnly(true);
+    view->setFont(QFont("Consolas", 9));
+    view->setPlainText(text);
+    previewLayout->addWidget(view);
+    preview.exec();
 }
 
 //UserGuideDialog Implementation
@@ -200,8 +344,11 @@ UserGuideDialog::UserGuideDialog(QWidget *parent)
               (PNG, JPG, BMP, GIF). Or choose <b>Text Input</b> to compress raw text.</li>
           <li>Either drag-and-drop your image or click <b>Browse...</b> to choose one.
               For text, simply type or paste it.</li>
-          <li>Click <b>Compress</b> to encode your data, or <b>Decompress</b> to restore it.</li>
-          <li>Open the <b>File History</b> dialog from the menu to review and manage logs.</li>
+          <li>Click <b>Compress</b> to encode your data. Files are saved next to the
+              original with a <b>.atc</b> extension; select an .atc file and click
+              <b>Decompress</b> to restore it.</li>
+          <li>Open the <b>File History</b> dialog from the menu to review and manage logs.
+              <b>Preview</b> decodes just the start of a compressed file.</li>
         </ol>
     )");
     layout->addWidget(browser);
@@ -262,7 +409,7 @@ MainWindow::MainWindow(QWidget *parent)
     setStyleSheet("QMainWindow { background-color: #2e2e2e; }");
 
     //popup dialogs
-    fileHistoryDialog = new FileHistoryDialog(this);
+    fileHistoryDialog = new FileHistoryDialog(&historyWriter, this);
     userGuideDialog   = new UserGuideDialog(this);
 
     //menu with "File History" and "User Guide"a
@@ -598,80 +745,88 @@ MainWindow::~MainWindow()
     if (progressTimer->isActive()) {
         progressTimer->stop();
     }
+
+    // Rows still queued are written before the window goes
+    historyWriter.stopWriting();
+
+    // The dialog's model reads through history and holds historyWriter, and
+    // QObject would only delete it after those members are gone
+    delete fileHistoryDialog;
+    fileHistoryDialog = nullptr;
 }
 
 // 4.1) Database Setup
 void MainWindow::initializeDatabase()
 {
-    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE");
-    db.setDatabaseName("arithma_tech.db");
-
-    if (!db.open()) {
-        qDebug() << "Failed to open database:" << db.lastError().text();
+    // Opened as the default connection, which the history dialog reads
+    if (!history.open("arithma_tech.db")) {
+        qDebug() << "Failed to open database:" << history.errorString();
         QMessageBox::critical(this, "Database Error", "Could not open the SQLite database.");
         return;
     }
 
-    // Create table if not exists
-    QSqlQuery query;
-    if (!query.exec("CREATE TABLE IF NOT EXISTS file_history ("
-                    "id INTEGER PRIMARY KEY AUTOINCREMENT,"
-                    "name TEXT,"
-                    "operation TEXT,"
-                    "data_type TEXT,"
-                    "file_path TEXT,"
-                    "text_content TEXT,"
-                    "timestamp DATETIME DEFAULT CURRENT_TIMESTAMP)"))
-    {
-        qDebug() << "Create table error:" << query.lastError().text();
+    // Compressed outputs live in a pack file beside the database
+    if (!artifacts.open(history.database(), "arithma_artifacts.pack")) {
+        qDebug() << "Artifact store unavailable:" << artifacts.errorString();
+    }
+
+    // History rows are written on their own thread and connection; WAL
+    // lets the dialog read through the connection above meanwhile
+    connect(&historyWriter, &HistoryWriter::batchWritten, this, &MainWindow::historyWritten);
+    connect(&historyWriter, &HistoryWriter::writeFailed, this, [this](const QString &message) {
+        qDebug() << "History write failed:" << message;
+        if (fileHistoryDialog && fileHistoryDialog->isVisible()) {
+            fileHistoryDialog->refreshHistory();
+        }
+    });
+    if (!historyWriter.startWriting("arithma_tech.db")) {
+        qDebug() << "History writer unavailable:" << historyWriter.errorString();
     }
 }
 
-// Insert a record into DB
-void MainWindow::addHistoryEntry(const QString &fileName, const QString &operation)
+void MainWindow::historyWritten()
 {
-    QSqlQuery query;
-    query.prepare("INSERT INTO file_history ("
-                  "name, operation, data_type, file_path, text_content"
-                  ") VALUES ("
-                  ":name, :operation, :data_type, :file_path, :text_content)"
-                  );
+    // Show the new rows if the File History is open
+    if (fileHistoryDialog) {
+        fileHistoryDialog->historyAppended();
+    }
+}
+
+// Queue a record for the DB
+void MainWindow::addHistoryEntry(const QString &fileName, const QString &operation,
+                                 const JobStats *stats, qint64 artifactId)
+{
+    HistoryRecord record;
+    record.operation  = operation;
+    record.artifactId = artifactId;
 
     bool isText = textModeRadio->isChecked();
     if (isText) {
-        query.bindValue(":name", "Text Data");
-        query.bindValue(":operation", operation);
-        query.bindValue(":data_type", "Text");
-        query.bindValue(":file_path", QString());  // store an empty string for file_path
-
-        // For text_content, store the actual text
-        query.bindValue(":text_content", textInput->toPlainText());
-
+        record.name     = "Text Data";
+        record.dataType = "Text";
+        // For text_content, store the actual text; file_path stays empty
+        record.textContent = textInput->toPlainText();
     } else {
-        query.bindValue(":name", fileName);
-        query.bindValue(":operation", operation);
-        query.bindValue(":data_type", "File");
-        query.bindValue(":file_path", currentFilePath);
-        query.bindValue(":text_content", QString());
+        record.name     = fileName;
+        record.dataType = "File";
+        record.filePath = currentFilePath;
     }
-
-    if (!query.exec()) {
-        qDebug() << "Error inserting row in DB:" << query.lastError().text();
+    if (stats) {
+        record.hasStats = true;
+        record.stats    = *stats;
     }
 
-    // Refresh the File History if open
-    if (fileHistoryDialog) {
-        fileHistoryDialog->refreshHistory();
+    // Only queued here; historyWritten() shows the row once it is committed
+    if (!historyWriter.insert(record)) {
+        qDebug() << "Error queueing history row:" << historyWriter.errorString();
     }
 }
 
 // Utility: isImageFile
 bool MainWindow::isImageFile(const QString &filePath)
 {
-    static QStringList allowedExtensions = {"png","jpg","jpeg","bmp","gif"};
-    QFileInfo fi(filePath);
-    QString suffix = fi.suffix().toLower();
-    return allowedExtensions.contains(suffix);
+    // The signature decides, so a renamed or extensionless image still counts
+    return typeCodec(detectFileType(toNativePath(filePath))).image;
 }
 
 // Switch input modes
@@ -700,7 +855,7 @@ void MainWindow::browseFile()
         this,
         "Select Image",
         "",
-        "Images (*.png *.jpg *.jpeg *.bmp *.gif)" // only images
+        "Images (*.png *.jpg *.jpeg *.bmp *.gif);;Arithma-Tech Archives (*.atc);;All Files (*)"
         );
     if (!filePath.isEmpty()) {
         handleDroppedFile(filePath);
@@ -710,10 +865,11 @@ void MainWindow::browseFile()
 // Drag-and-drop or browsed file
 void MainWindow::handleDroppedFile(const QString &filePath)
 {
-    if (!isImageFile(filePath)) {
+    const bool isArchive = QFileInfo(filePath).suffix().toLower() == kArchiveSuffix;
+    if (!isImageFile(filePath) && !isArchive) {
         QMessageBox::warning(this, "Unsupported File",
                              "This is not a recognized image format.\n"
-                             "Supported formats: PNG, JPG, JPEG, BMP, GIF.");
+                             "Supported formats: PNG, JPG, JPEG, BMP, GIF, ATC.");
         return;
     }
 
@@ -745,6 +901,7 @@ void MainWindow::compressFile()
     if (operationInProgress) return;
 
     bool isText = textModeRadio->isChecked();
+    lastResultMessage.clear();
 
     if (isText) {
         QString text = textInput->toPlainText();
@@ -752,20 +909,83 @@ void MainWindow::compressFile()
             QMessageBox::warning(this, "Empty Input", "Please enter text to compress");
             return;
         }
+
+        const QByteArray utf8 = text.toUtf8();
+        CodecOptions options;
+        applyTypeDefaults(FileType::Text, options);
+        options.verifyAfterWrite = true;   // before anything is logged
+        CodecEngine engine(options);
+        std::vector<uint8_t> input(utf8.begin(), utf8.end());
+        std::vector<uint8_t> output;
+        if (!engine.compress(input, output)) {
+            QMessageBox::warning(this, "Compression Failed", QString::fromStdString(engine.errorString()));
+            return;
+        }
+        lastResultMessage = QString("%1 bytes -> %2 bytes").arg(input.size()).arg(output.size());
+
         operationInProgress = true;
         statusLabel->setText("⚙️ Compressing text...");
 
-        addHistoryEntry("Text Data", "Compress");
+        addHistoryEntry("Text Data", "Compress", &engine.stats());
     } else {
         // file mode
         if (currentFilePath.isEmpty()) {
             QMessageBox::warning(this, "No File Selected", "Please select an image to compress");
             return;
         }
+
+        const QString outputPath = currentFilePath + "." + kArchiveSuffix;
+        CodecOptions options;
+        applyTypeDefaults(detectFileType(toNativePath(currentFilePath)), options);
+        options.verifyAfterWrite = true;   // before anything is logged
+        CodecEngine engine(options);
+
+        // An identical input coded the same way is copied out of the store
+        const auto started = std::chrono::steady_clock::now();
+        Hash128 content;
+        quint64 inputSize = 0;
+        const bool hashed = artifacts.isOpen() && artifacts.hashFile(currentFilePath, content, inputSize);
+        qint64 artifactId = hashed ? artifacts.find(content, engine.options()) : 0;
+        quint64 packedSize = 0;
+        JobStats stats;
+        // The copy is checked against the container's hash from when it was
+        // stored; a stale or damaged artifact is dropped and the input
+        // compressed afresh, which stores it again
+        if (artifactId > 0 && !artifacts.restore(artifactId, outputPath, packedSize)) {
+            qDebug() << "Artifact store error:" << artifacts.errorString();
+            if (!artifacts.discard(artifactId)) {
+                qDebug() << "Artifact store error:" << artifacts.errorString();
+            }
+            artifactId = 0;
+        }
+        if (artifactId > 0) {
+            stats.inputBytes  = inputSize;
+            stats.outputBytes = packedSize;
+            stats.level       = engine.options().level;
+            stats.backend     = engine.options().backend;
+            stats.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+            lastResultMessage = "Identical input: reused the stored result\n";
+        } else {
+            if (!engine.compressFile(toNativePath(currentFilePath), toNativePath(outputPath))) {
+                QFile::remove(outputPath);
+                QMessageBox::warning(this, "Compression Failed", QString::fromStdString(engine.errorString()));
+                return;
+            }
+            stats = engine.stats();
+            artifactId = hashed ? artifacts.add(content, inputSize, engine.options(), outputPath) : 0;
+            if (hashed && artifactId == 0) {
+                qDebug() << "Artifact store error:" << artifacts.errorString();
+            }
+        }
+        lastResultMessage += QString("Saved to %1 (%2 bytes -> %3 bytes)")
+                                 .arg(QFileInfo(outputPath).fileName())
+                                 .arg(QFileInfo(currentFilePath).size())
+                                 .arg(QFileInfo(outputPath).size());
+
         operationInProgress = true;
         statusLabel->setText("⚙️ Compressing: " + QFileInfo(currentFilePath).fileName());
 
-        addHistoryEntry(QFileInfo(currentFilePath).fileName(), "Compress");
+        addHistoryEntry(QFileInfo(currentFilePath).fileName(), "Compress", &stats, artifactId);
     }
 
     compressButton->setEnabled(false);
@@ -782,6 +1002,8 @@ void MainWindow::decompressFile()
 
     bool isText = textModeRadio->isChecked();
 
+    lastResultMessage.clear();
+
     if (isText) {
         QString text = textInput->toPlainText();
         if (text.isEmpty()) {
@@ -797,10 +1019,36 @@ void MainWindow::decompressFile()
             QMessageBox::warning(this, "No File Selected", "Please select an image to decompress");
             return;
         }
+
+        QFileInfo fi(currentFilePath);
+        if (fi.suffix().toLower() != kArchiveSuffix) {
+            QMessageBox::warning(this, "Not an Archive",
+                                 "Please select a compressed ." + kArchiveSuffix + " file to decompress");
+            return;
+        }
+
+        // photo.png.atc -> photo.png, or photo_restored.png if that exists
+        QString outputPath = fi.path() + "/" + fi.completeBaseName();
+        if (QFileInfo::exists(outputPath)) {
+            QFileInfo target(outputPath);
+            outputPath = target.path() + "/" + target.completeBaseName() + "_restored";
+            if (!target.suffix().isEmpty()) {
+                outputPath += "." + target.suffix();
+            }
+        }
+
+        CodecEngine engine;
+        if (!engine.decompressFile(toNativePath(currentFilePath), toNativePath(outputPath))) {
+            QFile::remove(outputPath);
+            QMessageBox::warning(this, "Decompression Failed", QString::fromStdString(engine.errorString()));
+            return;
+        }
+        lastResultMessage = "Restored to " + QFileInfo(outputPath).fileName();
+
         operationInProgress = true;
         statusLabel->setText("⚙️ Decompressing: " + QFileInfo(currentFilePath).fileName());
 
-        addHistoryEntry(QFileInfo(currentFilePath).fileName(), "Decompress");
+        addHistoryEntry(QFileInfo(currentFilePath).fileName(), "Decompress", &engine.stats());
     }
 
     compressButton->setEnabled(false);
@@ -840,6 +1088,9 @@ void MainWindow::updateProgressBar()
             QString msg = isTextMode
                               ? "Your text has been compressed successfully!"
                               : "Your image has been compressed successfully!";
+            if (!lastResultMessage.isEmpty()) {
+                msg += "\n" + lastResultMessage;
+            }
             QMessageBox::information(this, "Compression Complete", msg);
 
         } else if (statusLabel->text().contains("Decompressing")) {
@@ -858,6 +1109,9 @@ void MainWindow::updateProgressBar()
             QString msg = isTextMode
                               ? "Your text has been decompressed successfully!"
                               : "Your image has been decompressed successfully!";
+            if (!lastResultMessage.isEmpty()) {
+                msg += "\n" + lastResultMessage;
+            }
             QMessageBox::information(this, "Decompression Complete", msg);
         }
     }
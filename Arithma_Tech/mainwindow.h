@@ -4,7 +4,7 @@
 #include <QMainWindow>
 #include <QLabel>
 #include <QDialog>
-#include <QTableWidget>
+#include <QTableView>
 #include <QRadioButton>
 #include <QGroupBox>
 #include <QTextEdit>
@@ -13,14 +13,16 @@
 #include <QProgressBar>
 #include <QTimer>
 
-#include <QSqlDatabase>
-#include <QSqlQuery>
-#include <QSqlError>
+#include "artifactstore.h"
+#include "historystore.h"
+#include "historywriter.h"
 
 class QDropEvent;
 class QDragEnterEvent;
 class QDragMoveEvent;
 class QMimeData;
+class QLineEdit;
+class HistoryModel;
 
 /**
  * @brief DropZone
@@ -49,18 +51,35 @@ class FileHistoryDialog : public QDialog
 {
     Q_OBJECT
 public:
-    explicit FileHistoryDialog(QWidget *parent = nullptr);
+    // Deletions are queued on writer, which must outlive the dialog
+    explicit FileHistoryDialog(HistoryWriter *writer, QWidget *parent = nullptr);
 
     // Refresh the table from database
     void refreshHistory();
 
+    // Show rows logged since the last refresh without reloading the rest
+    void historyAppended();
+
 private slots:
-    // Delete currently selected row
-    void deleteSelectedRow();
+    // Delete every selected row
+    void deleteSelectedRows();
+
+    // Show the first bytes of the selected row's compressed file
+    void previewSelectedRow();
+
+    // Filter the table on the search box once typing pauses
+    void applySearch();
 
 private:
-    QTableWidget *historyTable;
-    QPushButton  *deleteButton;
+    void showPreview(const QString &title, const QString &text);
+
+    HistoryWriter *writer;
+    HistoryModel  *historyModel;
+    QLineEdit     *searchBox;
+    QTimer        *searchTimer;
+    QTableView    *historyTable;
+    QPushButton   *deleteButton;
+    QPushButton   *previewButton;
 };
 
 /**
@@ -111,16 +130,27 @@ private slots:
     void showFileHistory();
     void showUserGuide();
 
+    // The history writer committed a batch
+    void historyWritten();
+
 private:
     // Database initialization
     void initializeDatabase();
 
-    // Insert a record into the DB's history
-    void addHistoryEntry(const QString &fileName, const QString &operation);
+    // Queue a record for the DB's history; stats is null when no codec
+    // job ran, artifactId 0 when no output was stored
+    void addHistoryEntry(const QString &fileName, const QString &operation,
+                         const JobStats *stats = nullptr, qint64 artifactId = 0);
 
     // Utility
     bool isImageFile(const QString &filePath);
 
+    // The GUI thread's connection: schema migrations, the history dialog's
+    // reads and the artifact index. file_history writes go to historyWriter.
+    HistoryStore  history;
+    HistoryWriter historyWriter;
+    ArtifactStore artifacts;
+
     // Instances of dialogs
     FileHistoryDialog *fileHistoryDialog;
     UserGuideDialog   *userGuideDialog;
@@ -150,6 +180,7 @@ private:
 
     QTimer       *progressTimer;
     QString       currentFilePath;
+    QString       lastResultMessage;
     bool          operationInProgress;
 };
 
@@ -0,0 +1,159 @@
+#include "mixingmodel.h"
+
+// 1) Logistic helpers
+int squash(int d)
+{
+    static const int table[33] = {
+        1, 2, 3, 6, 10, 16, 27, 45, 73, 120, 194, 310, 488, 747, 1101, 1546, 2047,
+        2549, 2994, 3348, 3607, 3785, 3901, 3975, 4024, 4050, 4068, 4079, 4085,
+        4089, 4092, 4093, 4094};
+    if (d > 2047) return 4095;
+    if (d < -2047) return 1;
+    const int w = d & 127;
+    d = (d >> 7) + 16;
+    return (table[d] * (128 - w) + table[d + 1] * w + 64) >> 7;
+}
+
+namespace {
+struct StretchTable
+{
+    int values[4096];
+
+    StretchTable()
+    {
+        int pi = 0;
+        for (int x = -2047; x <= 2047; ++x) {
+            const int v = squash(x);
+            for (int i = pi; i <= v; ++i) values[i] = x;
+            pi = v + 1;
+        }
+        for (int i = pi; i < 4096; ++i) values[i] = 2047;
+    }
+};
+}
+
+int stretch(int p)
+{
+    static const StretchTable table;
+    return table.values[p];
+}
+
+// 2) Mixer Implementation
+Mixer::Mixer(int inputs, int contexts)
+    : inputCount(inputs),
+    count(0),
+    selected(0),
+    lastProbability(2048),
+    inputs(inputs),
+    weights(static_cast<size_t>(inputs) * contexts, 1 << 14)
+{
+}
+
+int Mixer::mix(int context)
+{
+    selected = context * inputCount;
+    const int *w = &weights[selected];
+    int64_t dot = 0;
+    for (int i = 0; i < count; ++i) {
+        dot += static_cast<int64_t>(inputs[i]) * w[i];
+    }
+    int p = squash(static_cast<int>(dot >> 16));
+    if (p < 1) p = 1;
+    if (p > 4095) p = 4095;
+    lastProbability = p;
+    return p;
+}
+
+void Mixer::update(int bit)
+{
+    const int err = ((bit << 12) - lastProbability) * 7;
+    int *w = &weights[selected];
+    for (int i = 0; i < count; ++i) {
+        w[i] += (inputs[i] * err + 0x8000) >> 16;
+    }
+    count = 0;
+}
+
+// 3) MixingPredictor Implementation
+namespace {
+const int kCounterShift = 4;
+
+uint32_t hashOrder(uint64_t history, int order)
+{
+    uint32_t h = static_cast<uint32_t>(order) * 0x3C6EF372u;
+    for (int i = 0; i < order; ++i) {
+        h = (h + static_cast<uint32_t>((history >> (8 * i)) & 0xFF) + 1) * 0x9E3779B1u;
+        h ^= h >> 15;
+    }
+    return h;
+}
+}
+
+MixingPredictor::MixingPredictor(int level, size_t sizeHint)
+    : order0(256, 1 << 15),
+    order1(1 << 16, 1 << 15),
+    mixer(8, 256),
+    hashBits(16),
+    c0(1),
+    history(0)
+{
+    // About two slots per input bit is plenty; more only costs clearing time
+    const uint32_t maxBits = level <= 1 ? 20 : 22;
+    while (hashBits < maxBits && (uint64_t(1) << hashBits) < uint64_t(sizeHint) * 2) {
+        hashBits++;
+    }
+
+    if (level <= 1) {
+        orders = {2};
+    } else if (level == 2) {
+        orders = {2, 3, 4};
+    } else {
+        orders = {2, 3, 4, 6};
+    }
+
+    hashed.assign(orders.size(), std::vector<uint16_t>(size_t(1) << hashBits, 1 << 15));
+    hashes.resize(orders.size());
+    for (size_t i = 0; i < orders.size(); ++i) {
+        hashes[i] = hashOrder(history, orders[i]);
+    }
+    slots.assign(orders.size() + 2, nullptr);
+    updateContexts();
+}
+
+int MixingPredictor::predict()
+{
+    for (uint16_t *slot : slots) {
+        mixer.add(stretch(*slot >> 4));
+    }
+    mixer.add(256);
+    return mixer.mix(static_cast<int>(c0));
+}
+
+void MixingPredictor::update(int bit)
+{
+    for (uint16_t *slot : slots) {
+        const int p = *slot;
+        *slot = static_cast<uint16_t>(p + (((bit << 16) - bit - p) >> kCounterShift));
+    }
+    mixer.update(bit);
+
+    c0 = (c0 << 1) | static_cast<uint32_t>(bit);
+    if (c0 >= 256) {
+        history = (history << 8) | (c0 & 0xFF);
+        c0 = 1;
+        for (size_t i = 0; i < orders.size(); ++i) {
+            hashes[i] = hashOrder(history, orders[i]);
+        }
+    }
+    updateContexts();
+}
+
+void MixingPredictor::updateContexts()
+{
+    slots[0] = &order0[c0];
+    slots[1] = &order1[((history & 0xFF) << 8) | c0];
+    for (size_t i = 0; i < orders.size(); ++i) {
+        const uint32_t index = ((hashes[i] ^ (c0 * 0x9E3779B1u)) * 0x85EBCA6Bu) >> (32 - hashBits);
+        slots[i + 2] = &hashed[i][index];
+    }
+}
@@ -0,0 +1,72 @@
+#ifndef MIXINGMODEL_H
+#define MIXINGMODEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Logistic helpers on 12-bit probabilities: stretch(p) = ln(p / (1 - p))
+// and squash() its inverse, both scaled to integers in [-2047, 2047]
+int squash(int d);
+int stretch(int p);
+
+/**
+ * @brief Mixer
+ *        Online logistic mixing of several bit predictions. Inputs are
+ *        stretched probabilities; a weight set is selected per call to mix()
+ *        and trained towards the coded bit in update().
+ */
+class Mixer
+{
+public:
+    Mixer(int inputs, int contexts);
+
+    void add(int input) { this->inputs[count++] = input; }
+
+    // 12-bit probability of a 1 using the weight set for context
+    int mix(int context);
+
+    void update(int bit);
+
+private:
+    int inputCount;
+    int count;
+    int selected;
+    int lastProbability;
+    std::vector<int> inputs;
+    std::vector<int> weights;
+};
+
+/**
+ * @brief MixingPredictor
+ *        Bitwise context-mixing model for the binary backend. Order 0 and 1
+ *        use direct tables; higher orders are hashed. The level picks how many
+ *        orders take part and the largest hash table size.
+ */
+class MixingPredictor
+{
+public:
+    // sizeHint (the block length) caps the hash tables for small blocks
+    MixingPredictor(int level, size_t sizeHint);
+
+    // 12-bit probability that the next bit is 1
+    int predict();
+
+    void update(int bit);
+
+private:
+    void updateContexts();
+
+    std::vector<int>       orders;
+    std::vector<uint16_t>  order0;
+    std::vector<uint16_t>  order1;
+    std::vector<std::vector<uint16_t>> hashed;
+    std::vector<uint32_t>  hashes;
+    std::vector<uint16_t *> slots;
+    Mixer    mixer;
+    uint32_t hashBits;
+    uint32_t c0;       // partial byte with a leading 1
+    uint64_t history;  // previous whole bytes
+};
+
+#endif // MIXINGMODEL_H
@@ -0,0 +1,46 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include "trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Run fn(0..count-1) on up to threads workers; the caller's thread joins in
+template <typename Fn>
+void parallelFor(size_t count, int threads, Fn fn)
+{
+    if (count <= 1 || threads <= 1) {
+        for (size_t i = 0; i < count; ++i) fn(i);
+        return;
+    }
+
+    std::atomic<size_t> next(0);
+    auto work = [&]() {
+        for (size_t i = next++; i < count; i = next++) fn(i);
+    };
+
+    std::vector<std::thread> workers;
+    const size_t workerCount = std::min<size_t>(count, static_cast<size_t>(threads));
+    for (size_t w = 1; w < workerCount; ++w) {
+        workers.emplace_back([&work, w]() {
+            traceSetWorker(static_cast<int>(w));
+            work();
+        });
+    }
+    work();
+    for (std::thread &t : workers) t.join();
+}
+
+// Hardware concurrency, or requested when positive
+inline int resolveThreadCount(int requested)
+{
+    if (requested > 0) return requested;
+    const unsigned hw = std::thread::hardware_concurrency();
+    return hw > 0 ? static_cast<int>(hw) : 1;
+}
+
+#endif // PARALLEL_H
@@ -0,0 +1,212 @@
+#include "perfcounters.h"
+
+#include <cstdio>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstring>
+#endif
+
+namespace {
+
+// In PerfRecorder::Counter bit order
+uint64_t PerfCounts::*const kFields[] = {
+    &PerfCounts::cycles, &PerfCounts::instructions, &PerfCounts::l1dMisses,
+    &PerfCounts::llcMisses, &PerfCounts::branchMisses, &PerfCounts::taskClockNs
+};
+const int kFieldCount = sizeof(kFields) / sizeof(kFields[0]);
+
+#ifdef __linux__
+struct CounterSpec
+{
+    uint32_t type;
+    uint64_t config;
+};
+
+const CounterSpec kSpecs[] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                         | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK},
+};
+
+int openCounter(const CounterSpec &spec)
+{
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size           = sizeof(attr);
+    attr.type           = spec.type;
+    attr.config         = spec.config;
+    attr.inherit        = 1;   // include threads started later
+    attr.exclude_kernel = 1;   // allowed at the default paranoia level
+    attr.exclude_hv     = 1;
+    attr.read_format    = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+#endif
+
+}
+
+const char *perfStageName(PerfStage stage)
+{
+    switch (stage) {
+    case PerfStage::Read:  return "read";
+    case PerfStage::Code:  return "code";
+    case PerfStage::Write: return "write";
+    }
+    return "unknown";
+}
+
+ProcessUsage readProcessUsage()
+{
+    ProcessUsage usage;
+#ifdef _WIN32
+    FILETIME created, exited, kernel, user;
+    if (GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user)) {
+        auto ticks = [](const FILETIME &t) {
+            return (uint64_t(t.dwHighDateTime) << 32) | t.dwLowDateTime;
+        };
+        usage.cpuSeconds = (ticks(kernel) + ticks(user)) / 1e7;   // 100 ns units
+    }
+    PROCESS_MEMORY_COUNTERS memory;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &memory, sizeof(memory))) {
+        usage.peakRssKB = memory.PeakWorkingSetSize / 1024;
+    }
+#else
+    rusage self;
+    if (getrusage(RUSAGE_SELF, &self) == 0) {
+        usage.cpuSeconds = self.ru_utime.tv_sec + self.ru_stime.tv_sec
+                           + (self.ru_utime.tv_usec + self.ru_stime.tv_usec) / 1e6;
+#ifdef __APPLE__
+        usage.peakRssKB = static_cast<uint64_t>(self.ru_maxrss) / 1024;   // bytes on macOS
+#else
+        usage.peakRssKB = static_cast<uint64_t>(self.ru_maxrss);
+#endif
+    }
+#endif
+    return usage;
+}
+
+void PerfCounts::add(const PerfCounts &other)
+{
+    for (int i = 0; i < kFieldCount; ++i) this->*kFields[i] += other.*kFields[i];
+}
+
+PerfCounts PerfCounts::minus(const PerfCounts &other) const
+{
+    PerfCounts result = *this;
+    for (int i = 0; i < kFieldCount; ++i) {
+        uint64_t &value = result.*kFields[i];
+        value = value > other.*kFields[i] ? value - other.*kFields[i] : 0;
+    }
+    return result;
+}
+
+std::string formatPerfStats(const PerfStats &stats)
+{
+    if (!stats.available) return std::string();
+
+    const char *const headings[] = {"cycles", "instructions", "L1d miss", "LLC miss", "br miss", "cpu ms"};
+    char cell[64];
+    std::string text = "  stage ";
+    for (const char *heading : headings) {
+        std::snprintf(cell, sizeof(cell), " %14s", heading);
+        text += cell;
+    }
+    text += "     IPC\n";
+
+    auto row = [&](const char *name, const PerfCounts &counts) {
+        std::snprintf(cell, sizeof(cell), "  %-6s", name);
+        text += cell;
+        for (int i = 0; i < kFieldCount; ++i) {
+            if (!(stats.available & (1u << i))) {
+                std::snprintf(cell, sizeof(cell), " %14s", "-");
+            } else if (kFields[i] == &PerfCounts::taskClockNs) {
+                std::snprintf(cell, sizeof(cell), " %14.2f", counts.taskClockNs / 1e6);
+            } else {
+                std::snprintf(cell, sizeof(cell), " %14llu", static_cast<unsigned long long>(counts.*kFields[i]));
+            }
+            text += cell;
+        }
+        const bool haveIpc = (stats.available & PerfRecorder::Cycles) && counts.cycles > 0;
+        if (haveIpc) std::snprintf(cell, sizeof(cell), " %7.2f\n", double(counts.instructions) / counts.cycles);
+        else std::snprintf(cell, sizeof(cell), " %7s\n", "-");
+        text += cell;
+    };
+    row("job", stats.job);
+    for (int i = 0; i < kPerfStageCount; ++i) row(perfStageName(static_cast<PerfStage>(i)), stats.stages[i]);
+    return text;
+}
+
+// 1) PerfRecorder Implementation
+PerfRecorder::PerfRecorder()
+    : available(0)
+{
+    for (int i = 0; i < kCounterCount; ++i) {
+        fds[i] = -1;
+#ifdef __linux__
+        fds[i] = openCounter(kSpecs[i]);
+        if (fds[i] >= 0) available |= 1u << i;
+#endif
+    }
+    origin = read();
+}
+
+PerfRecorder::~PerfRecorder()
+{
+#ifdef __linux__
+    for (int fd : fds) {
+        if (fd >= 0) close(fd);
+    }
+#endif
+}
+
+PerfCounts PerfRecorder::read() const
+{
+    PerfCounts counts;
+#ifdef __linux__
+    for (int i = 0; i < kCounterCount; ++i) {
+        uint64_t values[3];   // value, time enabled, time running
+        if (fds[i] < 0 || ::read(fds[i], values, sizeof(values)) != sizeof(values)) continue;
+        // Scale up when the kernel multiplexed the counter
+        counts.*kFields[i] = values[2] > 0 && values[2] < values[1]
+                               ? static_cast<uint64_t>(double(values[0]) * values[1] / values[2])
+                               : values[0];
+    }
+#endif
+    return counts;
+}
+
+void PerfRecorder::beginStage(PerfStage stage)
+{
+    stageStart[static_cast<int>(stage)] = read();
+}
+
+void PerfRecorder::endStage(PerfStage stage)
+{
+    const int i = static_cast<int>(stage);
+    stageTotals[i].add(read().minus(stageStart[i]));
+}
+
+PerfStats PerfRecorder::stats() const
+{
+    PerfStats result;
+    result.available = available;
+    if (!available) return result;
+    result.job = read().minus(origin);
+    for (int i = 0; i < kPerfStageCount; ++i) result.stages[i] = stageTotals[i];
+    return result;
+}
@@ -0,0 +1,135 @@
+#ifndef PERFCOUNTERS_H
+#define PERFCOUNTERS_H
+
+#include <cstdint>
+#include <string>
+
+// Pipeline stages the counters are split by
+enum class PerfStage : int { Read = 0, Code = 1, Write = 2 };
+constexpr int kPerfStageCount = 3;
+
+const char *perfStageName(PerfStage stage);
+
+/**
+ * @brief PerfCounts
+ *        Counter values for a stretch of work, scaled for multiplexing.
+ */
+struct PerfCounts
+{
+    uint64_t cycles       = 0;
+    uint64_t instructions = 0;
+    uint64_t l1dMisses    = 0;
+    uint64_t llcMisses    = 0;
+    uint64_t branchMisses = 0;
+    uint64_t taskClockNs  = 0;   // CPU time across all threads
+
+    void add(const PerfCounts &other);
+    PerfCounts minus(const PerfCounts &other) const;
+};
+
+/**
+ * @brief PerfStats
+ *        Counters for a whole job and for each stage. available has one bit
+ *        per counter (see PerfRecorder) and is 0 when nothing was collected.
+ */
+struct PerfStats
+{
+    uint32_t   available = 0;
+    PerfCounts job;
+    PerfCounts stages[kPerfStageCount];
+};
+
+/**
+ * @brief ProcessUsage
+ *        CPU time of every thread in the process so far and its peak
+ *        resident set; cheap enough to sample around every job.
+ */
+struct ProcessUsage
+{
+    double   cpuSeconds = 0.0;
+    uint64_t peakRssKB  = 0;
+};
+
+ProcessUsage readProcessUsage();
+
+// Job and stage rows as a text table, "-" for counters that were not
+// available; empty when nothing was collected
+std::string formatPerfStats(const PerfStats &stats);
+
+/**
+ * @brief PerfRecorder
+ *        Hardware counters through Linux perf_event_open, following the
+ *        creating thread and every thread it starts afterwards, so block
+ *        workers are included once they have been joined. Counters the
+ *        kernel or CPU refuses are left out silently; on other platforms
+ *        nothing is ever available.
+ */
+class PerfRecorder
+{
+public:
+    enum Counter {
+        Cycles       = 1 << 0,
+        Instructions = 1 << 1,
+        L1dMisses    = 1 << 2,
+        LlcMisses    = 1 << 3,
+        BranchMisses = 1 << 4,
+        TaskClock    = 1 << 5
+    };
+
+    PerfRecorder();
+    ~PerfRecorder();
+
+    bool active() const { return available != 0; }
+
+    void beginStage(PerfStage stage);
+    void endStage(PerfStage stage);
+
+    // Totals since construction plus the per-stage sums
+    PerfStats stats() const;
+
+    PerfRecorder(const PerfRecorder &) = delete;
+    PerfRecorder &operator=(const PerfRecorder &) = delete;
+
+private:
+    static const int kCounterCount = 6;
+
+    PerfCounts read() const;
+
+    int        fds[kCounterCount];
+    uint32_t   available;
+    PerfCounts origin;
+    PerfCounts stageStart[kPerfStageCount];
+    PerfCounts stageTotals[kPerfStageCount];
+};
+
+/**
+ * @brief PerfStageScope
+ *        Attributes the work up to close() or the end of the scope to a
+ *        stage; a null recorder makes it a no-op.
+ */
+class PerfStageScope
+{
+public:
+    PerfStageScope(PerfRecorder *recorder, PerfStage stage)
+        : recorder(recorder && recorder->active() ? recorder : nullptr), stage(stage)
+    {
+        if (this->recorder) this->recorder->beginStage(stage);
+    }
+
+    ~PerfStageScope() { close(); }
+
+    void close()
+    {
+        if (recorder) recorder->endStage(stage);
+        recorder = nullptr;
+    }
+
+    PerfStageScope(const PerfStageScope &) = delete;
+    PerfStageScope &operator=(const PerfStageScope &) = delete;
+
+private:
+    PerfRecorder *recorder;
+    PerfStage     stage;
+};
+
+#endif // PERFCOUNTERS_H
@@ -0,0 +1,628 @@
+#include "pngcodec.h"
+
+#ifdef ARITHMA_HAVE_ZLIB
+
+#include "blockcodec.h"
+#include "crc32c.h"
+#include "imagemodel.h"
+#include "parallel.h"
+#include "primer.h"
+#include "trace.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+// 1) Bytes
+uint32_t get32be(const uint8_t *p)
+{
+    return uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | uint32_t(p[3]);
+}
+
+void put32be(std::vector<uint8_t> &out, uint32_t value)
+{
+    for (int shift = 24; shift >= 0; shift -= 8) out.push_back(static_cast<uint8_t>(value >> shift));
+}
+
+void put32le(std::vector<uint8_t> &out, uint32_t value)
+{
+    for (int shift = 0; shift < 32; shift += 8) out.push_back(static_cast<uint8_t>(value >> shift));
+}
+
+uint32_t get32le(const uint8_t *p)
+{
+    return uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24;
+}
+
+// Larger images are passed through
+const uint64_t kMaxScanlines = uint64_t(1) << 30;
+
+// 2) Chunks
+const uint8_t kSignature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+
+/**
+ * @brief PngLayout
+ *        What splitting a file found: the file without its IDAT chunks,
+ *        where they went, their data sizes and the joined zlib stream.
+ */
+struct PngLayout
+{
+    std::vector<uint8_t>  skeleton;
+    uint64_t              idatOffset = 0;
+    std::vector<uint64_t> idatSizes;
+    std::vector<uint8_t>  stream;
+
+    // From IHDR
+    uint32_t width = 0;
+    uint32_t height = 0;
+    int      bitsPerPixel = 0;
+    bool     palette = false;
+    bool     interlaced = false;
+};
+
+// The image header, which must be the first chunk
+bool readHeader(const uint8_t *file, size_t size, PngLayout &layout)
+{
+    if (size < 8 + 25 || std::memcmp(file, kSignature, 8) != 0 || get32be(file + 8) != 13
+        || std::memcmp(file + 12, "IHDR", 4) != 0) {
+        return false;
+    }
+    static const int kChannels[7] = {1, 0, 3, 1, 2, 0, 4};
+    const uint8_t *data = file + 16;
+    const int depth = data[8], colorType = data[9];
+    if (colorType > 6 || kChannels[colorType] == 0 || depth == 0 || depth > 16 || data[12] > 1) return false;
+    layout.width        = get32be(data);
+    layout.height       = get32be(data + 4);
+    layout.bitsPerPixel = kChannels[colorType] * depth;
+    layout.palette      = colorType == 3;
+    layout.interlaced   = data[12] == 1;
+    return layout.width > 0 && layout.height > 0;
+}
+
+bool splitChunks(const uint8_t *file, size_t size, PngLayout &layout)
+{
+    if (!readHeader(file, size, layout)) return false;
+    size_t pos = 8;
+    bool seenIdat = false, inIdat = false, seenEnd = false;
+    layout.skeleton.assign(file, file + 8);
+
+    while (!seenEnd) {
+        if (size - pos < 12) return false;
+        const uint32_t length = get32be(file + pos);
+        if (length > 0x7FFFFFFFu || size - pos - 12 < length) return false;
+        const uint8_t *type = file + pos + 4;
+        const uint8_t *data = file + pos + 8;
+        const size_t chunkSize = 12 + size_t(length);
+
+        if (std::memcmp(type, "IDAT", 4) == 0) {
+            // All image data sits in one run of chunks with intact CRCs
+            if (seenIdat && !inIdat) return false;
+            if (uint32_t(crc32(0, type, length + 4)) != get32be(data + length)) return false;
+            if (!seenIdat) layout.idatOffset = layout.skeleton.size();
+            seenIdat = inIdat = true;
+            layout.idatSizes.push_back(length);
+            layout.stream.insert(layout.stream.end(), data, data + length);
+        } else {
+            inIdat = false;
+            layout.skeleton.insert(layout.skeleton.end(), file + pos, file + pos + chunkSize);
+        }
+        seenEnd = std::memcmp(type, "IEND", 4) == 0;
+        pos += chunkSize;
+    }
+
+    // Whatever follows IEND is kept as it is
+    layout.skeleton.insert(layout.skeleton.end(), file + pos, file + size);
+    return seenIdat;
+}
+
+void appendIdat(std::vector<uint8_t> &out, const uint8_t *data, size_t size)
+{
+    put32be(out, static_cast<uint32_t>(size));
+    const size_t start = out.size();
+    out.insert(out.end(), {'I', 'D', 'A', 'T'});
+    out.insert(out.end(), data, data + size);
+    put32be(out, uint32_t(crc32(0, out.data() + start, static_cast<uInt>(size + 4))));
+}
+
+// RGB triples of the PLTE chunk in the skeleton; empty without one
+std::vector<uint8_t> paletteOf(const std::vector<uint8_t> &skeleton)
+{
+    size_t pos = 8;
+    while (skeleton.size() - pos >= 12) {
+        const uint32_t length = get32be(skeleton.data() + pos);
+        if (skeleton.size() - pos - 12 < length) break;
+        if (std::memcmp(skeleton.data() + pos + 4, "PLTE", 4) == 0) {
+            return std::vector<uint8_t>(skeleton.begin() + pos + 8, skeleton.begin() + pos + 8 + length);
+        }
+        pos += 12 + size_t(length);
+    }
+    return std::vector<uint8_t>();
+}
+
+// Byte length of each scanline, filter byte included, in stream order
+std::vector<uint64_t> rowSizes(const PngLayout &layout)
+{
+    std::vector<uint64_t> rows;
+    auto addPass = [&](uint64_t width, uint64_t height) {
+        if (width == 0 || height == 0) return;
+        const uint64_t bytes = 1 + (width * layout.bitsPerPixel + 7) / 8;
+        rows.insert(rows.end(), static_cast<size_t>(height), bytes);
+    };
+    if (!layout.interlaced) {
+        addPass(layout.width, layout.height);
+        return rows;
+    }
+    // Adam7: start and step of each pass along x and y
+    static const int kPasses[7][4] = {
+        {0, 8, 0, 8}, {4, 8, 0, 8}, {0, 4, 4, 8}, {2, 4, 0, 4}, {0, 2, 2, 4}, {1, 2, 0, 2}, {0, 1, 1, 2}};
+    for (const int *pass : kPasses) {
+        addPass((uint64_t(layout.width) + pass[1] - pass[0] - 1) / pass[1],
+                (uint64_t(layout.height) + pass[3] - pass[2] - 1) / pass[3]);
+    }
+    return rows;
+}
+
+// 3) zlib
+bool inflateStream(const std::vector<uint8_t> &stream, std::vector<uint8_t> &out)
+{
+    z_stream z;
+    std::memset(&z, 0, sizeof z);
+    if (inflateInit(&z) != Z_OK) return false;
+    z.next_in  = const_cast<Bytef *>(stream.data());
+    z.avail_in = static_cast<uInt>(stream.size());
+
+    int status = Z_OK;
+    uint8_t buffer[64 * 1024];
+    while (status == Z_OK) {
+        z.next_out  = buffer;
+        z.avail_out = sizeof buffer;
+        status = inflate(&z, Z_NO_FLUSH);
+        out.insert(out.end(), buffer, buffer + (sizeof buffer - z.avail_out));
+        if (out.size() > kMaxScanlines) status = Z_MEM_ERROR;
+    }
+    // The stream must fill the IDAT data exactly
+    const bool ok = status == Z_STREAM_END && z.avail_in == 0;
+    inflateEnd(&z);
+    return ok;
+}
+
+struct DeflateParams
+{
+    int level;
+    int windowBits;
+    int memLevel;
+    int strategy;
+};
+
+// Deflates raw, handing each piece of output to sink until it returns
+// false; returns whether the stream was finished
+template <typename Sink>
+bool deflateStream(const std::vector<uint8_t> &raw, const DeflateParams &params, Sink sink)
+{
+    z_stream z;
+    std::memset(&z, 0, sizeof z);
+    if (deflateInit2(&z, params.level, Z_DEFLATED, params.windowBits, params.memLevel, params.strategy) != Z_OK) {
+        return false;
+    }
+    z.next_in  = const_cast<Bytef *>(raw.data());
+    z.avail_in = static_cast<uInt>(raw.size());
+
+    int status = Z_OK;
+    uint8_t buffer[16 * 1024];
+    while (status == Z_OK) {
+        z.next_out  = buffer;
+        z.avail_out = sizeof buffer;
+        status = deflate(&z, Z_FINISH);
+        if (!sink(buffer, sizeof buffer - z.avail_out)) break;
+    }
+    deflateEnd(&z);
+    return status == Z_STREAM_END;
+}
+
+// Whether params rebuild stream from raw; stops at the first difference
+bool reproduces(const std::vector<uint8_t> &raw, const DeflateParams &params, const std::vector<uint8_t> &stream)
+{
+    size_t produced = 0;
+    bool same = true;
+    const bool finished = deflateStream(raw, params, [&](const uint8_t *data, size_t size) {
+        same = size <= stream.size() - produced && std::memcmp(data, stream.data() + produced, size) == 0;
+        produced += size;
+        return same;
+    });
+    return finished && same && produced == stream.size();
+}
+
+// Settings worth trying, most likely first. The zlib header narrows the
+// window and the level group; zlib writes level group 0 for the Huffman-only
+// and RLE strategies too.
+std::vector<DeflateParams> candidates(const std::vector<uint8_t> &stream)
+{
+    std::vector<DeflateParams> list;
+    if (stream.size() < 2 || (stream[0] & 15) != Z_DEFLATED || (stream[0] >> 4) > 7) return list;
+    const int windowBits = (stream[0] >> 4) + 8;
+    static const int kLevels[4][4] = {{1, 0, -1, -1}, {2, 3, 4, 5}, {6, -1, -1, -1}, {9, 7, 8, -1}};
+    const int *levels = kLevels[stream[1] >> 6];
+    static const int kMemLevels[] = {8, 9, 7, 6, 5, 4, 3, 2, 1};
+
+    for (int memLevel : kMemLevels) {
+        for (int i = 0; i < 4 && levels[i] >= 0; ++i) {
+            list.push_back({levels[i], windowBits, memLevel, Z_DEFAULT_STRATEGY});
+            // Z_FILTERED only changes the lazy matcher of levels 4 and up
+            if (levels[i] >= 4) list.push_back({levels[i], windowBits, memLevel, Z_FILTERED});
+        }
+        if (stream[1] >> 6 == 0) {
+            list.push_back({1, windowBits, memLevel, Z_HUFFMAN_ONLY});
+            list.push_back({1, windowBits, memLevel, Z_RLE});
+        }
+    }
+    return list;
+}
+
+// 4) Scanline model
+int paeth(int a, int b, int c)
+{
+    const int p = a + b - c;
+    const int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc) return a;
+    return pb <= pc ? b : c;
+}
+
+// Filter prediction of byte i of a row; prior is all zeros above the
+// first row of a pass
+inline int filterPrediction(int type, const uint8_t *row, const uint8_t *prior, size_t i, size_t bpp)
+{
+    const int a = i >= bpp ? row[i - bpp] : 0;
+    const int b = prior[i];
+    const int c = i >= bpp ? prior[i - bpp] : 0;
+    switch (type) {
+    case 1: return a;
+    case 2: return b;
+    case 3: return (a + b) >> 1;
+    case 4: return paeth(a, b, c);
+    }
+    return 0;
+}
+
+// The first rows of a plain image with their filters undone, enough for
+// a palette order's sample
+std::vector<uint8_t> leadingRows(const uint8_t *raw, const std::vector<uint64_t> &rows, size_t bpp)
+{
+    const size_t length = static_cast<size_t>(rows[0]) - 1;
+    const size_t count = std::min(rows.size(), std::max<size_t>(1, (size_t(1) << 16) / length));
+    std::vector<uint8_t> pixels((count + 1) * length);
+    for (size_t y = 0; y < count; ++y) {
+        const uint8_t *row = raw + y * (length + 1);
+        uint8_t *current = pixels.data() + (y + 1) * length;
+        const uint8_t *prior = current - length;
+        for (size_t i = 0; i < length; ++i) {
+            current[i] = static_cast<uint8_t>(row[i + 1] + filterPrediction(row[0], current, prior, i, bpp));
+        }
+    }
+    pixels.erase(pixels.begin(), pixels.begin() + length);
+    return pixels;
+}
+
+/**
+ * @brief ScanlineCoder
+ *        Codes the inflated image data row by row. Encoding reads the
+ *        filtered rows, undoes the filter and codes the pixels; decoding
+ *        codes the pixels back and filters them again with the row's
+ *        original filter type.
+ */
+template <typename Coder>
+class ScanlineCoder
+{
+public:
+    ScanlineCoder(Coder &coder, const PngLayout &layout, size_t rawSize, const PaletteOrder *order)
+        : coder(coder),
+        pixels(coder, rawSize, layout.bitsPerPixel / 8, layout.bitsPerPixel >= 8 && !layout.palette,
+               layout.bitsPerPixel == 24 || layout.bitsPerPixel == 32),
+        bpp(std::max(1, layout.bitsPerPixel / 8))
+    {
+        pixels.setOrder(order);
+    }
+
+    // rows gives each row's length with its filter byte; raw holds the
+    // filtered rows, read when encoding and written when decoding
+    bool code(const std::vector<uint64_t> &rows, uint8_t *raw)
+    {
+        size_t pos = 0;
+        size_t passLength = 0;
+        int previousFilter = 5;
+        for (uint64_t length64 : rows) {
+            const size_t length = static_cast<size_t>(length64) - 1;
+            if (length != passLength) {
+                // A new Adam7 pass starts from a blank row above
+                passLength = length;
+                pixels.start(length);
+                previousFilter = 5;
+            }
+            const int filter = codeFilter(raw[pos], previousFilter);
+            if (filter > 4) return false;
+            uint8_t *row = raw + pos + 1;
+            uint8_t *current = pixels.row();
+            const uint8_t *prior = pixels.above();
+
+            if (Coder::kEncoding) {
+                for (size_t i = 0; i < length; ++i) {
+                    current[i] = static_cast<uint8_t>(row[i] + filterPrediction(filter, current, prior, i, bpp));
+                }
+            }
+            pixels.code();
+            if (!Coder::kEncoding) {
+                raw[pos] = static_cast<uint8_t>(filter);
+                for (size_t i = 0; i < length; ++i) {
+                    row[i] = static_cast<uint8_t>(current[i] - filterPrediction(filter, current, prior, i, bpp));
+                }
+            }
+
+            pixels.next();
+            previousFilter = filter;
+            pos += length + 1;
+        }
+        return true;
+    }
+
+private:
+    int codeFilter(int filter, int previous)
+    {
+        int node = 1;
+        for (int b = 2; b >= 0; --b) node = node << 1 | coder.code((filter >> b) & 1, filters[previous][node]);
+        return node - 8;
+    }
+
+    Coder &coder;
+    RowCoder<Coder> pixels;
+    BitModel filters[6][8];   // filter type, by the row above's
+    size_t   bpp;
+};
+
+// 5) Transforms
+enum : uint8_t { kModeStored = 0, kModeCoded = 1, kModeOrdered = 2 };
+
+// Chunks other than IDAT are coded as bytes, from the container's primer
+// since version 2 and from set 1's before
+Primer skeletonPrimer(uint8_t version, const Primer &primer)
+{
+    return version < 2 ? findPrimer(1, FileType::Png) : primer;
+}
+
+bool totalMatches(const std::vector<uint64_t> &rows, size_t size)
+{
+    uint64_t total = 0;
+    for (uint64_t row : rows) total += row;
+    return !rows.empty() && total == size;
+}
+
+bool encodePng(const std::vector<uint8_t> &input, const Primer &primer, int threads, std::vector<uint8_t> &out)
+{
+    PngLayout layout;
+    std::vector<uint8_t> raw;
+    {
+        ARITHMA_TRACE_SCOPE("transform", "png inflate");
+        if (!splitChunks(input.data(), input.size(), layout) || !inflateStream(layout.stream, raw)) return false;
+    }
+    const std::vector<uint64_t> rows = rowSizes(layout);
+    if (!totalMatches(rows, raw.size())) return false;
+
+    // Lowest-numbered setting that works, so the choice does not depend on
+    // how the threads ran
+    const std::vector<DeflateParams> tries = candidates(layout.stream);
+    std::atomic<size_t> found(tries.size());
+    {
+        ARITHMA_TRACE_SCOPE("transform", "png deflate search");
+        parallelFor(tries.size(), threads, [&](size_t i) {
+            if (i > found.load()) return;
+            if (!reproduces(raw, tries[i], layout.stream)) return;
+            size_t current = found.load();
+            while (i < current && !found.compare_exchange_weak(current, i)) {
+            }
+        });
+    }
+    if (found.load() == tries.size()) return false;
+    const DeflateParams &params = tries[found.load()];
+
+    PaletteOrder order;
+    if (layout.palette && !layout.interlaced) {
+        const std::vector<uint8_t> sample = leadingRows(raw.data(), rows, 1);
+        const size_t length = static_cast<size_t>(rows[0]) - 1;
+        order = choosePaletteOrder(sample.data(), length, length, sample.size() / length,
+                                   layout.bitsPerPixel, paletteOf(layout.skeleton), false);
+    }
+    const bool ordered = order.method() != PaletteOrder::kAsIs;
+
+    out.push_back(ordered ? kModeOrdered : kModeCoded);
+    out.push_back(static_cast<uint8_t>(params.level));
+    out.push_back(static_cast<uint8_t>(params.windowBits));
+    out.push_back(static_cast<uint8_t>(params.memLevel));
+    out.push_back(static_cast<uint8_t>(params.strategy));
+    put32le(out, crc32c(0, layout.stream.data(), layout.stream.size()));
+    std::vector<uint8_t> packed;
+    encodeBlock(Backend::Arithmetic, 2, primer, layout.skeleton.data(), layout.skeleton.size(), packed);
+    putVarint(out, layout.skeleton.size());
+    putVarint(out, packed.size());
+    out.insert(out.end(), packed.begin(), packed.end());
+    putVarint(out, layout.idatOffset);
+    putVarint(out, layout.idatSizes.size());
+    for (uint64_t size : layout.idatSizes) putVarint(out, size);
+    if (ordered) order.write(out);
+
+    ARITHMA_TRACE_SCOPE("transform", "png model encode");
+    PixelEncoder encoder{{BinaryEncoder(out)}};
+    ScanlineCoder<PixelEncoder> scanlines(encoder, layout, raw.size(), ordered ? &order : nullptr);
+    if (!scanlines.code(rows, raw.data())) return false;
+    encoder.coder.finish();
+    return true;
+}
+
+bool decodePng(const std::vector<uint8_t> &input, const Primer &primer, std::vector<uint8_t> &out)
+{
+    const uint8_t *p = input.data() + 1;
+    const uint8_t *end = input.data() + input.size();
+    if (end - p < 8) return false;
+    const DeflateParams params = {p[0], p[1], p[2], p[3]};
+    const uint32_t checksum = get32le(p + 4);
+    p += 8;
+
+    uint64_t skeletonSize = 0, packedSize = 0;
+    if (!getVarint(p, end, skeletonSize) || !getVarint(p, end, packedSize) || packedSize > uint64_t(end - p)
+        || skeletonSize > (uint64_t(1) << 32)) {
+        return false;
+    }
+    PngLayout layout;
+    layout.skeleton.resize(static_cast<size_t>(skeletonSize));
+    if (!decodeBlock(Backend::Arithmetic, 2, primer, p, static_cast<size_t>(packedSize),
+                     layout.skeleton.data(), layout.skeleton.size())) {
+        return false;
+    }
+    p += packedSize;
+
+    uint64_t chunks = 0;
+    if (!getVarint(p, end, layout.idatOffset) || layout.idatOffset > skeletonSize
+        || !getVarint(p, end, chunks) || chunks > uint64_t(end - p)) {
+        return false;
+    }
+    layout.idatSizes.resize(static_cast<size_t>(chunks));
+    for (uint64_t &size : layout.idatSizes) {
+        if (!getVarint(p, end, size) || size > 0x7FFFFFFFu) return false;
+    }
+    if (!readHeader(layout.skeleton.data(), layout.skeleton.size(), layout)) return false;
+    PaletteOrder order;
+    const bool ordered = input[0] == kModeOrdered;
+    if (ordered && (!layout.palette || !order.read(p, end, paletteOf(layout.skeleton), layout.bitsPerPixel))) {
+        return false;
+    }
+
+    const std::vector<uint64_t> rows = rowSizes(layout);
+    uint64_t rawSize = 0;
+    for (uint64_t row : rows) rawSize += row;
+    if (rawSize > kMaxScanlines) return false;
+    std::vector<uint8_t> raw(static_cast<size_t>(rawSize));
+    {
+        ARITHMA_TRACE_SCOPE("transform", "png model decode");
+        PixelDecoder decoder{{BinaryDecoder(p, static_cast<size_t>(end - p))}};
+        ScanlineCoder<PixelDecoder> scanlines(decoder, layout, raw.size(), ordered ? &order : nullptr);
+        if (!scanlines.code(rows, raw.data())) return false;
+    }
+
+    ARITHMA_TRACE_SCOPE("transform", "png deflate");
+    std::vector<uint8_t> stream;
+    if (!deflateStream(raw, params, [&](const uint8_t *data, size_t size) {
+            stream.insert(stream.end(), data, data + size);
+            return true;
+        })) {
+        return false;
+    }
+    // A zlib that deflates differently would otherwise go unnoticed
+    if (crc32c(0, stream.data(), stream.size()) != checksum) return false;
+
+    uint64_t total = 0;
+    for (uint64_t size : layout.idatSizes) total += size;
+    if (total != stream.size()) return false;
+
+    const size_t offset = static_cast<size_t>(layout.idatOffset);
+    out.insert(out.end(), layout.skeleton.begin(), layout.skeleton.begin() + offset);
+    size_t pos = 0;
+    for (uint64_t size : layout.idatSizes) {
+        appendIdat(out, stream.data() + pos, static_cast<size_t>(size));
+        pos += static_cast<size_t>(size);
+    }
+    out.insert(out.end(), layout.skeleton.begin() + offset, layout.skeleton.end());
+    return true;
+}
+
+class PngEncoder : public TypeTransform
+{
+public:
+    PngEncoder(const Primer &primer, int threads)
+        : primer(skeletonPrimer(kPngTransformVersion, primer)),
+        threads(threads)
+    {
+    }
+
+    bool update(const uint8_t *data, size_t size, std::vector<uint8_t> &) override
+    {
+        input.insert(input.end(), data, data + size);
+        return true;
+    }
+
+    bool finish(std::vector<uint8_t> &out) override
+    {
+        ARITHMA_TRACE_SCOPE("transform", "png encode");
+        const size_t start = out.size();
+        coded = encodePng(input, primer, threads, out) && out.size() - start < input.size();
+        if (!coded) {
+            out.resize(start);
+            out.push_back(kModeStored);
+            out.insert(out.end(), input.begin(), input.end());
+        }
+        return true;
+    }
+
+    bool entropyCoded() const override { return coded; }
+
+private:
+    std::vector<uint8_t> input;   // the IDAT run can be anywhere in the file
+    Primer primer;
+    int    threads;
+    bool   coded = false;
+};
+
+class PngDecoder : public TypeTransform
+{
+public:
+    PngDecoder(uint8_t version, const Primer &primer)
+        : primer(skeletonPrimer(version, primer))
+    {
+    }
+
+    bool update(const uint8_t *data, size_t size, std::vector<uint8_t> &) override
+    {
+        input.insert(input.end(), data, data + size);
+        return true;
+    }
+
+    bool finish(std::vector<uint8_t> &out) override
+    {
+        ARITHMA_TRACE_SCOPE("transform", "png decode");
+        if (!input.empty() && input[0] == kModeStored) {
+            out.insert(out.end(), input.begin() + 1, input.end());
+            return true;
+        }
+        const size_t start = out.size();
+        if (input.empty() || (input[0] != kModeCoded && input[0] != kModeOrdered)
+            || !decodePng(input, primer, out)) {
+            out.resize(start);
+            return false;
+        }
+        return true;
+    }
+
+    std::string errorString() const override { return "PNG data could not be rebuilt"; }
+
+private:
+    std::vector<uint8_t> input;
+    Primer primer;
+};
+
+}
+
+std::unique_ptr<TypeTransform> newPngEncoder(const Primer &primer, int threads)
+{
+    return std::unique_ptr<TypeTransform>(new PngEncoder(primer, threads));
+}
+
+std::unique_ptr<TypeTransform> newPngDecoder(uint8_t version, const Primer &primer, int)
+{
+    return std::unique_ptr<TypeTransform>(new PngDecoder(version, primer));
+}
+
+#endif // ARITHMA_HAVE_ZLIB
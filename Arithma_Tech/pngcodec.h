@@ -0,0 +1,40 @@
+#ifndef PNGCODEC_H
+#define PNGCODEC_H
+
+#include "typeregistry.h"
+
+#include <cstdint>
+#include <memory>
+
+/*
+ * PNG transform, version 2. Needs zlib; builds without it have no PNG
+ * transform and refuse containers written with one.
+ *
+ * The IDAT chunks are joined and inflated, and the scanlines are coded
+ * here in place of the deflate stream: filters are undone and every byte
+ * is coded bit by bit from the pixels above and to the left, mixing
+ * several context models. Rebuilding the file means deflating the rows
+ * again to the very same bytes, so the encoder searches zlib's settings
+ * for the ones that reproduce the original stream and records them.
+ *
+ *   u8 mode   0: the original bytes follow unchanged
+ *             1: u8 level, u8 window bits, u8 memory level, u8 strategy,
+ *                u32 CRC-32C of the deflate stream (little endian), varint
+ *                skeleton size, varint coded skeleton size, coded skeleton,
+ *                varint IDAT offset in the skeleton, varint IDAT chunk
+ *                count, varint data size of each IDAT chunk, pixel stream
+ *             2: as 1, with the palette order before the pixel stream
+ *
+ * The skeleton is the file without its IDAT chunks, coded from the
+ * container's block primer or, when it is unprimed, from none; version 1,
+ * otherwise the same, always used set 1's PNG primer. Streams no setting
+ * reproduces, and files the model does not shrink, use mode 0. Palette
+ * images that are not interlaced may code their indices through a
+ * PaletteOrder (imagemodel.h) when sampled rows say it pays.
+ */
+constexpr uint8_t kPngTransformVersion = 2;
+
+std::unique_ptr<TypeTransform> newPngEncoder(const Primer &primer, int threads);
+std::unique_ptr<TypeTransform> newPngDecoder(uint8_t version, const Primer &primer, int threads);
+
+#endif // PNGCODEC_H
@@ -0,0 +1,60 @@
+#include "primer.h"
+
+namespace {
+struct PrimerEntry
+{
+    FileType       type;
+    const uint8_t *data;
+    size_t         size;
+};
+
+struct PrimerSet
+{
+    uint8_t            version;
+    const PrimerEntry *entries;
+    size_t             count;
+};
+
+// Generated by arithma_primetrain; one file per released set, never edited
+#include "primerset1.inc"
+#include "primerset2.inc"
+
+// Set 2 is trained on generated files only (see arithma_primetrain)
+const PrimerSet kPrimerSets[] = {
+    {1, kPrimerSet1, sizeof(kPrimerSet1) / sizeof(kPrimerSet1[0])},
+    {2, kPrimerSet2, sizeof(kPrimerSet2) / sizeof(kPrimerSet2[0])},
+};
+
+const PrimerSet *findSet(uint8_t version)
+{
+    for (const PrimerSet &set : kPrimerSets) {
+        if (set.version == version) return &set;
+    }
+    return nullptr;
+}
+}
+
+uint8_t currentPrimerSet()
+{
+    return kPrimerSets[sizeof(kPrimerSets) / sizeof(kPrimerSets[0]) - 1].version;
+}
+
+bool primerSetKnown(uint8_t set)
+{
+    return set == 0 || findSet(set) != nullptr;
+}
+
+Primer findPrimer(uint8_t set, FileType type)
+{
+    Primer primer;
+    const PrimerSet *found = set ? findSet(set) : nullptr;
+    if (!found) return primer;
+    for (size_t i = 0; i < found->count; ++i) {
+        if (found->entries[i].type == type) {
+            primer.data = found->entries[i].data;
+            primer.size = found->entries[i].size;
+            break;
+        }
+    }
+    return primer;
+}
@@ -0,0 +1,36 @@
+#ifndef PRIMER_H
+#define PRIMER_H
+
+#include "container.h"
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Primer
+ *        Trained starting state for a block's model, kept as the sample
+ *        that produces it: both coders replay the bytes through a fresh
+ *        model before the first real one, so headers, palettes and common
+ *        words a file type shares start out cheap. A sample of a few KB
+ *        stands in for order-2 and mixing tables that run to megabytes.
+ */
+struct Primer
+{
+    const uint8_t *data = nullptr;
+    size_t         size = 0;
+
+    bool empty() const { return size == 0; }
+};
+
+// Primer set new containers are written with. A container records its set
+// in the header (see primerSet()), 0 meaning unprimed; every released set
+// stays compiled in so old files decode identically.
+uint8_t currentPrimerSet();
+
+// Whether this build can decode containers primed with set
+bool primerSetKnown(uint8_t set);
+
+// Sample for type in set; empty for set 0, Binary or an unknown set
+Primer findPrimer(uint8_t set, FileType type);
+
+#endif // PRIMER_H
@@ -0,0 +1,136 @@
+#include "snippetcodec.h"
+
+#include "adaptivemodel.h"
+#include "arithmeticcoder.h"
+#include "codecengine.h"
+
+namespace {
+
+enum Method : uint8_t
+{
+    Stored    = 0,
+    Primed    = 1,   // order-1 arithmetic coding after the primer
+    Container = 2    // an ordinary container, level 3
+};
+
+// Sample of what people paste into the text box: prose, log lines, JSON
+// and code. Both sides feed it through the model before the first real
+// byte, so common letters and pairs start out cheap instead of costing
+// eight bits on first sight. Changing it breaks existing snippets.
+const char kPrimer[] =
+    "The history of the file shows that the text was compressed and then restored. "
+    "This is a short note about what we did and why, and it is one of many in the log. "
+    "Please send the report to the team by Monday; we will review it at the meeting. "
+    "ERROR WARN INFO DEBUG 2024-01-01 12:00:00 server started on port 8080, "
+    "request GET /api/v1/items took 12 ms.\n"
+    "{\"id\": 1, \"name\": \"value\", \"type\": \"text\", \"size\": 1024}\n"
+    "for (int i = 0; i < count; ++i) { return value; } if (x == null) else while\n"
+    "Arithmetic coding is a form of entropy encoding used in lossless data compression.\n";
+
+void prime(ContextModel &context)
+{
+    for (const char *c = kPrimer; *c; ++c) {
+        const uint8_t byte = static_cast<uint8_t>(*c);
+        context.current().update(byte);
+        context.push(byte);
+    }
+    context.push('\n');   // start from a line boundary whatever the primer ends with
+}
+
+void encodePrimed(const uint8_t *data, size_t size, std::vector<uint8_t> &out)
+{
+    ContextModel context(1);
+    prime(context);
+    ArithmeticEncoder encoder(out);
+    uint32_t cumLow, cumHigh;
+
+    for (size_t i = 0; i < size; ++i) {
+        AdaptiveModel &model = context.current();
+        model.symbolRange(data[i], cumLow, cumHigh);
+        encoder.encode(cumLow, cumHigh, model.total());
+        model.update(data[i]);
+        context.push(data[i]);
+    }
+
+    AdaptiveModel &model = context.current();
+    model.symbolRange(AdaptiveModel::kEofSymbol, cumLow, cumHigh);
+    encoder.encode(cumLow, cumHigh, model.total());
+    encoder.finish();
+}
+
+bool decodePrimed(const uint8_t *payload, size_t size, std::vector<uint8_t> &out)
+{
+    ContextModel context(1);
+    prime(context);
+    ArithmeticDecoder decoder(payload, size);
+    uint32_t cumLow, cumHigh;
+
+    while (true) {
+        AdaptiveModel &model = context.current();
+        const uint32_t total = model.total();
+        const int symbol = model.findSymbol(decoder.decodeTarget(total), cumLow, cumHigh);
+        decoder.consume(cumLow, cumHigh, total);
+
+        if (symbol == AdaptiveModel::kEofSymbol) {
+            return true;
+        }
+        // Only short inputs are coded this way, so longer output is garbage
+        if (out.size() == kSnippetShortLimit) {
+            return false;
+        }
+        out.push_back(static_cast<uint8_t>(symbol));
+        model.update(symbol);
+        context.push(static_cast<uint8_t>(symbol));
+    }
+}
+
+}
+
+void compressSnippet(const uint8_t *data, size_t size, std::vector<uint8_t> &out)
+{
+    out.clear();
+    bool coded = false;
+    if (size < kSnippetShortLimit) {
+        out.push_back(Primed);
+        encodePrimed(data, size, out);
+        coded = true;
+    } else {
+        CodecOptions options;
+        options.level    = CodecEngine::kMaxLevel;
+        options.fileType = FileType::Text;
+        CodecEngine engine(options);
+        std::vector<uint8_t> container;
+        const std::vector<uint8_t> input(data, data + size);
+        if (engine.compress(input, container)) {
+            out.push_back(Container);
+            out.insert(out.end(), container.begin(), container.end());
+            coded = true;
+        }
+    }
+
+    // Never longer than the input plus the method byte
+    if (!coded || out.size() > size + 1) {
+        out.assign(1, Stored);
+        out.insert(out.end(), data, data + size);
+    }
+}
+
+bool decompressSnippet(const uint8_t *data, size_t size, std::vector<uint8_t> &out)
+{
+    out.clear();
+    if (size == 0) return false;
+
+    switch (data[0]) {
+    case Stored:
+        out.assign(data + 1, data + size);
+        return true;
+    case Primed:
+        return decodePrimed(data + 1, size - 1, out);
+    case Container: {
+        CodecEngine engine;
+        const std::vector<uint8_t> container(data + 1, data + size);
+        return engine.decompress(container, out);
+    }
+    }
+    return false;
+}
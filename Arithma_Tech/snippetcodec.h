@@ -0,0 +1,25 @@
+#ifndef SNIPPETCODEC_H
+#define SNIPPETCODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Compact coding of small payloads such as the text kept in the history
+ * database. A container spends about 80 bytes on headers, index and
+ * footer, more than a short note compresses to, so inputs under
+ * kSnippetShortLimit are coded with a bare order-1 arithmetic coder whose
+ * models are primed with typical text first. Larger inputs go into an
+ * ordinary container. Either way the result starts with one method byte.
+ */
+
+constexpr size_t kSnippetShortLimit = 4096;
+
+// Replace out with the coded form of data
+void compressSnippet(const uint8_t *data, size_t size, std::vector<uint8_t> &out);
+
+// Replace out with the original bytes; false if the snippet is corrupt
+bool decompressSnippet(const uint8_t *data, size_t size, std::vector<uint8_t> &out);
+
+#endif // SNIPPETCODEC_H
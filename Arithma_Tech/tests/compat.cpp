@@ -0,0 +1,104 @@
+// arithma_compat_test: decodes containers written by earlier builds, which
+// are checked in under tests/data next to the files they hold. Each one is
+// decompressed and compared, range decoded and verified, and its header is
+// checked so a fixture rewritten by a newer build is caught. Never
+// regenerate these files; add new ones when a format changes.
+
+#include "codecengine.h"
+#include "testutil.h"
+#include "typeregistry.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief Fixture
+ *        One old container and the header fields it was written with.
+ *        The inputs are outputs of the bench/corpus.cpp generators.
+ */
+struct Fixture
+{
+    const char *container;
+    const char *original;
+    uint8_t     formatVersion;   // ContainerHeader::version
+    uint8_t     primerSet;
+    uint8_t     transformVersion;
+};
+
+const Fixture kFixtures[] = {
+    // Container format 1: no block checksums, no primers
+    {"text.txt.format1.atc",  "text.txt",     1, 0, 0},
+    // Format 2 with primer set 1 and the first version of each transform
+    {"text.txt.set1.atc",     "text.txt",     2, 1, 0},
+    {"photo.png.set1.atc",    "photo.png",    2, 1, 1},
+    {"photo.jpg.set1.atc",    "photo.jpg",    2, 1, 1},
+    {"anim.gif.set1.atc",     "anim.gif",     2, 1, 1},
+    // BMP version 1 rows, before column strips; 24-bit and palette order
+    {"photo24.bmp.set1.atc",  "photo24.bmp",  2, 1, 1},
+    {"indexed8.bmp.set1.atc", "indexed8.bmp", 2, 1, 1},
+    // BMP version 2 under primer set 2, whose header still codes with set 1
+    {"photo24.bmp.set2.atc",  "photo24.bmp",  2, 2, 2},
+    {"indexed8.bmp.set2.atc", "indexed8.bmp", 2, 2, 2},
+};
+
+void runFixture(TestLog &log, const std::string &directory, const Fixture &fixture)
+{
+    const std::string name = fixture.container;
+    const std::string containerPath = directory + "/" + fixture.container;
+    std::vector<uint8_t> container, original, restored;
+    if (!log.check(readFile(containerPath, container), name, "cannot read " + containerPath)) return;
+    if (!log.check(readFile(directory + "/" + fixture.original, original), name,
+                   std::string("cannot read ") + fixture.original)) {
+        return;
+    }
+
+    ContainerHeader header;
+    if (!log.check(container.size() >= ContainerHeader::kSize && readContainerHeader(container.data(), header),
+                   name, "unreadable container header")) {
+        return;
+    }
+    log.check(header.version == fixture.formatVersion && primerSet(header) == fixture.primerSet
+                  && transformVersion(header) == fixture.transformVersion,
+              name, "header does not match the fixture table; was the file rewritten?");
+
+    // Builds without zlib leave the PNG transform out and cannot read these
+    if (fixture.transformVersion != 0 && !typeCodec(header.fileType).inverse) {
+        std::cout << "skipped " << name << ": this build has no " << fileTypeName(header.fileType)
+                  << " transform\n";
+        return;
+    }
+
+    // Each call runs before its message reads errorString()
+    CodecEngine engine;
+    bool ok = engine.decompress(container, restored);
+    if (log.check(ok, name, "decompress: " + engine.errorString())) {
+        log.check(restored == original, name, "decompressed bytes differ from " + std::string(fixture.original));
+    }
+
+    const uint64_t offset = original.size() / 3, length = original.size() / 3;
+    std::vector<uint8_t> part;
+    ok = engine.decompressRange(containerPath, offset, length, part);
+    if (log.check(ok, name, "decompressRange: " + engine.errorString())) {
+        log.check(part.size() == length && std::equal(part.begin(), part.end(), original.begin() + offset),
+                  name, "range differs");
+    }
+
+    ok = engine.verifyFile(containerPath);
+    log.check(ok, name, "verifyFile: " + engine.errorString());
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 2) {
+        std::cerr << "Usage: arithma_compat_test DATA_DIR\n";
+        return 2;
+    }
+    TestLog log;
+    for (const Fixture &fixture : kFixtures) runFixture(log, argv[1], fixture);
+    return log.exitCode();
+}
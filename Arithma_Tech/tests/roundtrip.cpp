@@ -0,0 +1,160 @@
+// arithma_roundtrip_test: every file type of the generated corpus through
+// the engine, with and without its primer and transform and on the other
+// backend. Each case compresses, decompresses and compares, restores byte
+// ranges from the container file, verifies it, and expects verification to
+// fail once a payload byte is damaged.
+
+#include "codecengine.h"
+#include "corpus.h"
+#include "testutil.h"
+#include "typeregistry.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <initializer_list>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// The benchmark's corpus at a smaller size, in small blocks so its files
+// span several and ranges cross them
+const uint32_t kBlockSize = 8192;
+const size_t   kCorpusSize = 32768;
+
+struct Variant
+{
+    const char *name;
+    bool usePrimers;
+    bool useTransforms;
+    bool otherBackend;
+};
+
+const Variant kVariants[] = {
+    {"default",        true,  true,  false},
+    {"no-prime",       false, true,  false},
+    {"no-transform",   true,  false, false},
+    {"other-backend",  true,  true,  true},
+};
+
+std::vector<uint8_t> slice(const std::vector<uint8_t> &data, uint64_t offset, uint64_t length)
+{
+    const size_t begin = static_cast<size_t>(std::min<uint64_t>(offset, data.size()));
+    const size_t end = static_cast<size_t>(std::min<uint64_t>(offset + length, data.size()));
+    return std::vector<uint8_t>(data.begin() + begin, data.begin() + end);
+}
+
+// Scratch files for the file and range calls, in the working directory
+const char *const kInputPath     = "roundtrip.in";
+const char *const kContainerPath = "roundtrip.atc";
+const char *const kOutputPath    = "roundtrip.out";
+
+// Flip a byte in the middle of the first block's payload
+bool damageFirstBlock(std::vector<uint8_t> &container)
+{
+    ContainerHeader header;
+    if (container.size() < ContainerHeader::kSize || !readContainerHeader(container.data(), header)) {
+        return false;
+    }
+    const size_t blockStart = ContainerHeader::kSize;
+    if (container.size() < blockStart + blockHeaderSize(header)) return false;
+    BlockHeader block;
+    readBlockHeader(container.data() + blockStart, hasBlockChecksums(header), block);
+    if (block.payloadSize == 0) return false;
+    const size_t target = blockStart + blockHeaderSize(header) + block.payloadSize / 2;
+    if (target >= container.size()) return false;
+    container[target] ^= 0x5A;
+    return true;
+}
+
+void runCase(TestLog &log, const CorpusFile &file, const Variant &variant)
+{
+    const std::string name = file.name + " (" + variant.name + ")";
+    CodecOptions options;
+    options.threads = 2;
+    applyTypeDefaults(file.type, options);
+    options.blockSize     = kBlockSize;
+    options.usePrimers    = variant.usePrimers;
+    options.useTransforms = variant.useTransforms;
+    if (variant.otherBackend) {
+        options.backend = options.backend == Backend::Arithmetic ? Backend::Binary : Backend::Arithmetic;
+    }
+    CodecEngine engine(options);
+
+    // 1) Buffers
+    // Each call runs before its message reads errorString()
+    std::vector<uint8_t> container, restored;
+    bool ok = engine.compress(file.data, container);
+    if (!log.check(ok, name, "compress: " + engine.errorString())) return;
+    ok = engine.decompress(container, restored);
+    if (!log.check(ok, name, "decompress: " + engine.errorString())) return;
+    log.check(restored == file.data, name, "decompressed bytes differ from the input");
+    // Beyond the fixed framing every type but noise must shrink
+    if (std::string(variant.name) == "default" && file.name != "random.bin" && file.data.size() >= 1024) {
+        log.check(container.size() < file.data.size(), name,
+                  "container is not smaller than the input (" + std::to_string(container.size()) + " bytes)");
+    }
+    ContainerHeader header;
+    if (log.check(readContainerHeader(container.data(), header), name, "unreadable container header")) {
+        log.check(header.flags == containerFlags(options), name, "header flags differ from containerFlags()");
+    }
+
+    // 2) Files; the container must not depend on the path it took
+    const std::string inputPath = kInputPath;
+    const std::string containerPath = kContainerPath;
+    const std::string outputPath = kOutputPath;
+    std::vector<uint8_t> fileContainer, fileRestored;
+    if (!log.check(writeFile(inputPath, file.data), name, "cannot write " + inputPath)) return;
+    ok = engine.compressFile(inputPath, containerPath);
+    if (!log.check(ok, name, "compressFile: " + engine.errorString())) return;
+    log.check(readFile(containerPath, fileContainer) && fileContainer == container, name,
+              "compressFile output differs from compress()");
+    ok = engine.decompressFile(containerPath, outputPath);
+    if (log.check(ok, name, "decompressFile: " + engine.errorString())) {
+        log.check(readFile(outputPath, fileRestored) && fileRestored == file.data, name,
+                  "decompressFile output differs from the input");
+    }
+
+    // 3) Ranges: the head, one across a block boundary, one running past
+    // the end, and one starting at it
+    const uint64_t size = file.data.size();
+    const std::pair<uint64_t, uint64_t> ranges[] = {
+        {0, 100},
+        {kBlockSize - 50, 100},
+        {size / 2, size},
+        {size, 10},
+    };
+    for (const auto &range : ranges) {
+        std::vector<uint8_t> part;
+        const std::string what = "range " + std::to_string(range.first) + "+" + std::to_string(range.second);
+        ok = engine.decompressRange(containerPath, range.first, range.second, part);
+        if (log.check(ok, name, what + ": " + engine.errorString())) {
+            log.check(part == slice(file.data, range.first, range.second), name, what + " differs");
+        }
+    }
+
+    // 4) Verification, then of a damaged copy
+    ok = engine.verifyFile(containerPath);
+    log.check(ok, name, "verifyFile: " + engine.errorString());
+    std::vector<uint8_t> damaged = container;
+    if (damageFirstBlock(damaged) && writeFile(containerPath, damaged)) {
+        log.check(!engine.verifyFile(containerPath), name, "verifyFile accepted a damaged block");
+    }
+}
+
+}
+
+int main()
+{
+    TestLog log;
+    std::vector<CorpusFile> corpus = generateCorpus(kCorpusSize, 1);
+    corpus.push_back({"empty.bin", FileType::Binary, {}});
+    corpus.push_back({"one.bin", FileType::Binary, {0x42}});
+
+    for (const CorpusFile &file : corpus) {
+        for (const Variant &variant : kVariants) runCase(log, file, variant);
+    }
+    for (const char *path : {kInputPath, kContainerPath, kOutputPath}) std::remove(path);
+    return log.exitCode();
+}
@@ -0,0 +1,55 @@
+#ifndef TESTUTIL_H
+#define TESTUTIL_H
+
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+/**
+ * @brief TestLog
+ *        Failure count of a test executable. check() prints each failed
+ *        condition with the case it belongs to; main returns exitCode().
+ */
+class TestLog
+{
+public:
+    bool check(bool ok, const std::string &testCase, const std::string &what)
+    {
+        if (!ok) {
+            std::cerr << "FAIL " << testCase << ": " << what << "\n";
+            ++failed;
+        }
+        ++checked;
+        return ok;
+    }
+
+    int exitCode() const
+    {
+        std::cout << checked - failed << " of " << checked << " checks passed\n";
+        return failed == 0 ? 0 : 1;
+    }
+
+private:
+    int checked = 0;
+    int failed  = 0;
+};
+
+inline bool readFile(const std::string &path, std::vector<uint8_t> &data)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return !in.bad();
+}
+
+inline bool writeFile(const std::string &path, const std::vector<uint8_t> &data)
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+    return bool(out.flush());
+}
+
+#endif // TESTUTIL_H
@@ -0,0 +1,151 @@
+#include "trace.h"
+
+#ifndef ARITHMA_NO_TRACE
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct TraceEvent
+{
+    const char *category;
+    const char *name;
+    uint64_t    start;
+    uint64_t    end;
+    int         lane;
+};
+
+// Events stay in a per-thread buffer so recording takes no lock
+struct ThreadBuffer
+{
+    std::vector<TraceEvent> events;
+    int lane = -1;
+};
+
+class TraceLog
+{
+public:
+    TraceLog()
+        : origin(std::chrono::steady_clock::now())
+    {
+        const char *value = std::getenv("ARITHMA_TRACE");
+        if (value && *value && std::string(value) != "0") {
+            path = std::string(value) == "1" ? "arithma-trace.json" : value;
+        }
+    }
+
+    ~TraceLog() { write(); }
+
+    bool active() const { return !path.empty(); }
+
+    uint64_t now() const
+    {
+        // Offset by one so a live scope never has a zero start
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now() - origin).count()) + 1;
+    }
+
+    ThreadBuffer &buffer()
+    {
+        thread_local std::shared_ptr<ThreadBuffer> local;
+        if (!local) {
+            local = std::make_shared<ThreadBuffer>();
+            std::lock_guard<std::mutex> lock(mutex);
+            local->lane = nextLane++;
+            buffers.push_back(local);
+        }
+        return *local;
+    }
+
+    void nameLane(int lane, const std::string &name)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        laneNames.emplace(lane, name);
+    }
+
+private:
+    void write()
+    {
+        if (!active()) return;
+        FILE *out = std::fopen(path.c_str(), "w");
+        if (!out) return;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        std::fprintf(out, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n");
+        bool first = true;
+        std::map<int, bool> named;
+        for (const std::shared_ptr<ThreadBuffer> &buffer : buffers) {
+            for (const TraceEvent &event : buffer->events) {
+                if (!named[event.lane]) {
+                    const auto found = laneNames.find(event.lane);
+                    const std::string name = found != laneNames.end() ? found->second
+                                           : event.lane == 0 ? std::string("main")
+                                           : "thread " + std::to_string(event.lane);
+                    std::fprintf(out, "%s{\"ph\": \"M\", \"name\": \"thread_name\", \"pid\": 1, "
+                                      "\"tid\": %d, \"args\": {\"name\": \"%s\"}}",
+                                 first ? "" : ",\n", event.lane, name.c_str());
+                    named[event.lane] = true;
+                    first = false;
+                }
+                std::fprintf(out, "%s{\"ph\": \"X\", \"cat\": \"%s\", \"name\": \"%s\", \"pid\": 1, "
+                                  "\"tid\": %d, \"ts\": %.3f, \"dur\": %.3f}",
+                             first ? "" : ",\n", event.category, event.name, event.lane,
+                             event.start / 1000.0, (event.end - event.start) / 1000.0);
+                first = false;
+            }
+        }
+        std::fprintf(out, "\n]}\n");
+        std::fclose(out);
+    }
+
+    std::chrono::steady_clock::time_point origin;
+    std::string path;
+    std::mutex  mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    std::map<int, std::string> laneNames;
+    int nextLane = 0;
+};
+
+// Worker lanes are numbered apart from ordinary threads
+const int kWorkerLaneBase = 1000;
+
+TraceLog &traceLog()
+{
+    static TraceLog log;
+    return log;
+}
+
+}
+
+bool traceStartup()
+{
+    return traceLog().active();
+}
+
+uint64_t traceNow()
+{
+    return traceLog().now();
+}
+
+void traceRecord(const char *category, const char *name, uint64_t start, uint64_t end)
+{
+    ThreadBuffer &buffer = traceLog().buffer();
+    buffer.events.push_back({category, name, start, end, buffer.lane});
+}
+
+void traceSetWorker(int worker)
+{
+    if (!traceEnabled()) return;
+    const int lane = kWorkerLaneBase + worker;
+    traceLog().buffer().lane = lane;
+    traceLog().nameLane(lane, "worker " + std::to_string(worker));
+}
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstdint>
+
+/*
+ * Hot-path tracing in Chrome trace-event JSON, viewable in chrome://tracing
+ * or ui.perfetto.dev. Set ARITHMA_TRACE to an output path (or to 1 for
+ * arithma-trace.json) and every TraceScope becomes a complete event on its
+ * thread's timeline; the file is written when the process exits.
+ *
+ * With ARITHMA_TRACE unset a scope costs a single well-predicted branch.
+ * Building with ARITHMA_NO_TRACE (CMake: ARITHMA_ENABLE_TRACE=OFF) compiles
+ * the scopes out entirely.
+ *
+ * Categories in use: io, model, code, checksum, db, job.
+ */
+
+#ifndef ARITHMA_NO_TRACE
+
+// True when ARITHMA_TRACE was set at startup
+bool traceStartup();
+inline bool traceEnabled()
+{
+    static const bool enabled = traceStartup();
+    return enabled;
+}
+
+// Nanoseconds on the trace clock
+uint64_t traceNow();
+
+void traceRecord(const char *category, const char *name, uint64_t start, uint64_t end);
+
+// Put the calling thread on worker lane n (0 is the thread that started the
+// job), so pooled threads line up as one timeline per worker
+void traceSetWorker(int worker);
+
+/**
+ * @brief TraceScope
+ *        Records the time from construction to close() or destruction.
+ *        Names must be string literals; they are stored by pointer.
+ */
+class TraceScope
+{
+public:
+    TraceScope(const char *category, const char *name)
+        : category(category), name(name), start(traceEnabled() ? traceNow() : 0)
+    {
+    }
+
+    ~TraceScope() { close(); }
+
+    void close()
+    {
+        if (start != 0) {
+            traceRecord(category, name, start, traceNow());
+            start = 0;
+        }
+    }
+
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+
+private:
+    const char *category;
+    const char *name;
+    uint64_t    start;
+};
+
+#else
+
+inline bool traceEnabled() { return false; }
+inline void traceSetWorker(int) {}
+
+class TraceScope
+{
+public:
+    TraceScope(const char *, const char *) {}
+    void close() {}
+};
+
+#endif
+
+#define ARITHMA_TRACE_CONCAT_(a, b) a##b
+#define ARITHMA_TRACE_CONCAT(a, b) ARITHMA_TRACE_CONCAT_(a, b)
+#define ARITHMA_TRACE_SCOPE(category, name) \
+    TraceScope ARITHMA_TRACE_CONCAT(traceScope, __LINE__)(category, name)
+
+#endif // TRACE_H
@@ -0,0 +1,179 @@
+#include "typeregistry.h"
+
+#include "bmpcodec.h"
+#include "gifcodec.h"
+#include "jpegcodec.h"
+#include "pngcodec.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace {
+
+// 1) Signatures
+bool startsWith(const uint8_t *head, size_t size, const char *signature, size_t length)
+{
+    return size >= length && std::memcmp(head, signature, length) == 0;
+}
+
+bool matchesPng(const uint8_t *head, size_t size)
+{
+    return startsWith(head, size, "\x89PNG\r\n\x1a\n", 8);
+}
+
+bool matchesJpeg(const uint8_t *head, size_t size)
+{
+    // SOI followed by the first marker
+    return startsWith(head, size, "\xff\xd8\xff", 3);
+}
+
+bool matchesGif(const uint8_t *head, size_t size)
+{
+    return startsWith(head, size, "GIF87a", 6) || startsWith(head, size, "GIF89a", 6);
+}
+
+bool matchesBmp(const uint8_t *head, size_t size)
+{
+    // "BM" alone is too common, so the DIB header must have a known size
+    if (!startsWith(head, size, "BM", 2) || size < 18) return false;
+    const uint32_t dibSize = uint32_t(head[14]) | uint32_t(head[15]) << 8
+                             | uint32_t(head[16]) << 16 | uint32_t(head[17]) << 24;
+    switch (dibSize) {
+    case 12: case 40: case 52: case 56: case 64: case 108: case 124:
+        return true;
+    }
+    return false;
+}
+
+// Well-formed UTF-8 without NULs or control characters other than the
+// usual whitespace and escape. A sequence cut off by the end of the
+// window still counts.
+bool matchesText(const uint8_t *head, size_t size)
+{
+    if (size == 0) return false;
+    size_t i = 0;
+    while (i < size) {
+        const uint8_t c = head[i];
+        if (c < 0x80) {
+            if (c < 0x20 && c != '\t' && c != '\n' && c != '\r' && c != '\f' && c != 0x1b) return false;
+            if (c == 0x7f) return false;
+            ++i;
+            continue;
+        }
+
+        size_t length;
+        if (c >= 0xc2 && c <= 0xdf) length = 2;
+        else if (c >= 0xe0 && c <= 0xef) length = 3;
+        else if (c >= 0xf0 && c <= 0xf4) length = 4;
+        else return false;
+        for (size_t k = 1; k < length; ++k) {
+            if (i + k == size) return true;
+            if ((head[i + k] & 0xc0) != 0x80) return false;
+        }
+        i += length;
+    }
+    return true;
+}
+
+bool matchesNothing(const uint8_t *, size_t)
+{
+    return false;
+}
+
+// 2) Registry, in detection order; Binary last as the fallback
+const TypeCodec kTypeCodecs[] = {
+    // type             image  matches         backend              level  transform (oldest, current)
+#ifdef ARITHMA_HAVE_ZLIB
+    {FileType::Png,    true,  matchesPng,     Backend::Arithmetic, 2,
+     1, kPngTransformVersion, newPngEncoder, newPngDecoder},
+#else
+    {FileType::Png,    true,  matchesPng,     Backend::Arithmetic, 2,     0, 0, nullptr, nullptr},
+#endif
+    {FileType::Jpeg,   true,  matchesJpeg,    Backend::Arithmetic, 2,
+     1, kJpegTransformVersion, newJpegEncoder, newJpegDecoder},
+    {FileType::Gif,    true,  matchesGif,     Backend::Arithmetic, 2,
+     1, kGifTransformVersion, newGifEncoder, newGifDecoder},
+    {FileType::Bmp,    true,  matchesBmp,     Backend::Arithmetic, 2,
+     1, kBmpTransformVersion, newBmpEncoder, newBmpDecoder},
+    // Text inputs are small enough that the slower mixing backend's
+    // better ratio is worth having
+    {FileType::Text,   false, matchesText,    Backend::Binary,     2,     0, 0, nullptr, nullptr},
+    {FileType::Binary, false, matchesNothing, Backend::Arithmetic, 2,     0, 0, nullptr, nullptr},
+};
+
+const size_t kTypeCodecCount = sizeof(kTypeCodecs) / sizeof(kTypeCodecs[0]);
+}
+
+// 3) Lookup
+FileType detectFileType(const uint8_t *head, size_t size)
+{
+    size = std::min(size, kDetectBytes);
+    for (const TypeCodec &codec : kTypeCodecs) {
+        if (codec.matches(head, size)) return codec.type;
+    }
+    return FileType::Binary;
+}
+
+FileType detectFileType(const std::string &path)
+{
+    std::ifstream in(path, std::ios::binary);
+    uint8_t head[kDetectBytes];
+    in.read(reinterpret_cast<char *>(head), sizeof head);
+    return detectFileType(head, static_cast<size_t>(in.gcount()));
+}
+
+const TypeCodec &typeCodec(FileType type)
+{
+    for (const TypeCodec &codec : kTypeCodecs) {
+        if (codec.type == type) return codec;
+    }
+    return kTypeCodecs[kTypeCodecCount - 1];
+}
+
+void applyTypeDefaults(FileType type, CodecOptions &options)
+{
+    const TypeCodec &codec = typeCodec(type);
+    options.fileType = type;
+    options.backend  = codec.backend;
+    options.level    = codec.level;
+}
+
+bool containerTransform(const ContainerHeader &header, const Primer &primer, int threads,
+                        std::unique_ptr<TypeTransform> &inverse, std::string &error)
+{
+    inverse.reset();
+    const uint8_t version = transformVersion(header);
+    if (version == 0) return true;
+
+    const TypeCodec &codec = typeCodec(header.fileType);
+    if (codec.type != header.fileType || version < codec.oldestTransformVersion
+        || version > codec.transformVersion || !codec.inverse) {
+        error = std::string("Container needs version ") + std::to_string(version) + " of the "
+                + fileTypeName(header.fileType) + " transform, which this version does not have";
+        return false;
+    }
+    inverse = codec.inverse(version, primer, threads);
+    return true;
+}
+
+// 4) Transform formats
+void putVarint(std::vector<uint8_t> &out, uint64_t value)
+{
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+bool getVarint(const uint8_t *&p, const uint8_t *end, uint64_t &value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64 && p < end; shift += 7) {
+        const uint8_t byte = *p++;
+        value |= uint64_t(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
@@ -0,0 +1,110 @@
+#ifndef TYPEREGISTRY_H
+#define TYPEREGISTRY_H
+
+#include "codecengine.h"
+#include "container.h"
+#include "primer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief TypeTransform
+ *        One direction of a type's reversible preprocessing. The forward
+ *        direction runs on the input before it is cut into blocks, the
+ *        inverse on the decoded blocks. Both are fed in pieces of any size
+ *        and append whatever output is ready.
+ */
+class TypeTransform
+{
+public:
+    virtual ~TypeTransform() = default;
+
+    virtual bool update(const uint8_t *data, size_t size, std::vector<uint8_t> &out) = 0;
+
+    // No more input: append the rest
+    virtual bool finish(std::vector<uint8_t> &out) = 0;
+
+    // Whether update stopped early to keep its output in bounds; if so it
+    // is called again with no new input until this turns false
+    virtual bool moreOutput() const { return false; }
+
+    // Whether the output so far is already entropy coded, so its blocks
+    // are stored rather than coded again
+    virtual bool entropyCoded() const { return false; }
+
+    // Adds figures of its own, such as per-frame times, once finished
+    virtual void addStats(JobStats &) const {}
+
+    virtual std::string errorString() const { return std::string(); }
+};
+
+// LEB128 lengths for transform formats; getVarint advances p and fails
+// on a truncated or overlong value
+void putVarint(std::vector<uint8_t> &out, uint64_t value);
+bool getVarint(const uint8_t *&p, const uint8_t *end, uint64_t &value);
+
+/**
+ * @brief TypeCodec
+ *        What one file type plugs into the engine: the signature that
+ *        recognises it, the backend and level it codes best with, and an
+ *        optional preprocessing transform. Its model is the primer of the
+ *        same type (see primer.h). Binary is the fallback for anything no
+ *        other entry claims.
+ */
+struct TypeCodec
+{
+    FileType type;
+    bool     image;   // accepted by the GUI's image mode
+
+    // Whether head, the start of a file, carries this type's signature
+    bool (*matches)(const uint8_t *head, size_t size);
+
+    Backend  backend;
+    int      level;
+
+    // Transform format written to the header (see transformVersion()), 0
+    // with null factories for types coded as they are, and the oldest one
+    // the inverse still reads: every version a release has written stays
+    // readable. The factories take the container's block primer, empty
+    // when it is unprimed, for the parts a transform codes as bytes, and
+    // the worker threads it may use; its output must not depend on them.
+    // The inverse also takes the version the container was written with.
+    uint8_t  oldestTransformVersion;
+    uint8_t  transformVersion;
+    std::unique_ptr<TypeTransform> (*forward)(const Primer &primer, int threads);
+    std::unique_ptr<TypeTransform> (*inverse)(uint8_t version, const Primer &primer, int threads);
+};
+
+// Detection never reads more than this much of a file
+constexpr size_t kDetectBytes = 4096;
+
+// A forward transform never adds more than kMaxTransformGrowth to its
+// input's length, plus kTransformGrowthPerMiB for each full MiB, which
+// leaves room for transforms that frame their output as they stream
+constexpr size_t kMaxTransformGrowth = 16;
+constexpr size_t kTransformGrowthPerMiB = 8;
+
+// Type of the data starting with head (up to kDetectBytes are looked at)
+FileType detectFileType(const uint8_t *head, size_t size);
+
+// Same for the start of a file; Binary when it cannot be read
+FileType detectFileType(const std::string &path);
+
+// Entry for type; the Binary entry for values this build does not know
+const TypeCodec &typeCodec(FileType type);
+
+// Record type in options and take its default backend and level
+void applyTypeDefaults(FileType type, CodecOptions &options);
+
+// Inverse transform a container's blocks go through; false, with a message
+// in error, when this build does not have the version it was written with.
+// Leaves inverse empty for containers written without one. primer is the
+// container's own (see containerPrimer()).
+bool containerTransform(const ContainerHeader &header, const Primer &primer, int threads,
+                        std::unique_ptr<TypeTransform> &inverse, std::string &error);
+
+#endif // TYPEREGISTRY_H